@@ -37,6 +37,43 @@ typedef CObjectWrapper::AccessorGeneric AccessorGeneric;
 #define DIV(x, y) ((x) / (y))
 
 // Pre-defined reduction operators
+#define DECLARE_REDUCTION_FUNCTIONS(REG, SRED, SRED_DP, RED, RED_DP, CLASS, T) \
+  extern "C"                                                            \
+  {                                                                     \
+  void REG(legion_reduction_op_id_t redop)                              \
+  {                                                                     \
+    Runtime::register_reduction_op<CLASS>(redop);              \
+  }                                                                     \
+  void SRED(legion_accessor_generic_t accessor_,                        \
+           legion_ptr_t ptr_, T value)                                  \
+  {                                                                     \
+    AccessorGeneric* accessor = CObjectWrapper::unwrap(accessor_);      \
+    ptr_t ptr = CObjectWrapper::unwrap(ptr_);                           \
+    accessor->typeify<T>().convert<ReductionFold<CLASS> >().reduce(ptr, value); \
+  }                                                                     \
+  void SRED_DP(legion_accessor_generic_t accessor_,                     \
+               legion_domain_point_t dp_, T value)                      \
+  {                                                                     \
+    AccessorGeneric* accessor = CObjectWrapper::unwrap(accessor_);      \
+    DomainPoint dp = CObjectWrapper::unwrap(dp_);                       \
+    accessor->typeify<T>()/*.convert<ReductionFold<CLASS> >()*/.reduce<CLASS>(dp, value); \
+  }                                                                     \
+  void RED(legion_accessor_generic_t accessor_,                         \
+           legion_ptr_t ptr_, T value)                                  \
+  {                                                                     \
+    AccessorGeneric* accessor = CObjectWrapper::unwrap(accessor_);      \
+    ptr_t ptr = CObjectWrapper::unwrap(ptr_);                           \
+    accessor->typeify<T>().reduce<CLASS>(ptr, value);                   \
+  }                                                                     \
+  void RED_DP(legion_accessor_generic_t accessor_,                      \
+              legion_domain_point_t dp_, T value)                       \
+  {                                                                     \
+    AccessorGeneric* accessor = CObjectWrapper::unwrap(accessor_);      \
+    DomainPoint dp = CObjectWrapper::unwrap(dp_);                       \
+    accessor->typeify<T>().reduce<CLASS>(dp, value);                    \
+  }                                                                     \
+  }
+
 #define DECLARE_REDUCTION(REG, SRED, SRED_DP, RED, RED_DP, CLASS, T, U, APPLY_OP, FOLD_OP, ID) \
   class CLASS {                                                         \
   public:                                                               \
@@ -82,58 +119,30 @@ typedef CObjectWrapper::AccessorGeneric AccessorGeneric;
     } while(!__sync_bool_compare_and_swap(target, oldval.as_U, newval.as_U)); \
   }                                                                     \
                                                                         \
-  extern "C"                                                            \
-  {                                                                     \
-  void REG(legion_reduction_op_id_t redop)                              \
-  {                                                                     \
-    Runtime::register_reduction_op<CLASS>(redop);              \
-  }                                                                     \
-  void SRED(legion_accessor_generic_t accessor_,                        \
-           legion_ptr_t ptr_, T value)                                  \
-  {                                                                     \
-    AccessorGeneric* accessor = CObjectWrapper::unwrap(accessor_);      \
-    ptr_t ptr = CObjectWrapper::unwrap(ptr_);                           \
-    accessor->typeify<T>().convert<ReductionFold<CLASS> >().reduce(ptr, value); \
-  }                                                                     \
-  void SRED_DP(legion_accessor_generic_t accessor_,                     \
-               legion_domain_point_t dp_, T value)                      \
-  {                                                                     \
-    AccessorGeneric* accessor = CObjectWrapper::unwrap(accessor_);      \
-    DomainPoint dp = CObjectWrapper::unwrap(dp_);                       \
-    accessor->typeify<T>()/*.convert<ReductionFold<CLASS> >()*/.reduce<CLASS>(dp, value); \
-  }                                                                     \
-  void RED(legion_accessor_generic_t accessor_,                         \
-           legion_ptr_t ptr_, T value)                                  \
-  {                                                                     \
-    AccessorGeneric* accessor = CObjectWrapper::unwrap(accessor_);      \
-    ptr_t ptr = CObjectWrapper::unwrap(ptr_);                           \
-    accessor->typeify<T>().reduce<CLASS>(ptr, value);                   \
-  }                                                                     \
-  void RED_DP(legion_accessor_generic_t accessor_,                      \
-              legion_domain_point_t dp_, T value)                       \
-  {                                                                     \
-    AccessorGeneric* accessor = CObjectWrapper::unwrap(accessor_);      \
-    DomainPoint dp = CObjectWrapper::unwrap(dp_);                       \
-    accessor->typeify<T>().reduce<CLASS>(dp, value);                    \
-  }                                                                     \
-  }                                                                     \
+  DECLARE_REDUCTION_FUNCTIONS(REG, SRED, SRED_DP, RED, RED_DP, CLASS, T)
+
+// Realm has built-in versions of these, which come with vectorized
+// kernels for reduction copies
+#define DECLARE_BUILTIN_REDUCTION(REG, SRED, SRED_DP, RED, RED_DP, CLASS, T, BUILTIN) \
+  typedef Realm::BUILTIN<T> CLASS;                                      \
+  DECLARE_REDUCTION_FUNCTIONS(REG, SRED, SRED_DP, RED, RED_DP, CLASS, T)
 
-DECLARE_REDUCTION(register_reduction_plus_float,
+DECLARE_BUILTIN_REDUCTION(register_reduction_plus_float,
                   safe_reduce_plus_float, safe_reduce_plus_float_domain_point,
                   reduce_plus_float, reduce_plus_float_domain_point,
-                  PlusOpFloat, float, int, ADD, ADD, 0.0f)
-DECLARE_REDUCTION(register_reduction_plus_double,
+                  PlusOpFloat, float, SumReduction)
+DECLARE_BUILTIN_REDUCTION(register_reduction_plus_double,
                   safe_reduce_plus_double, safe_reduce_plus_double_domain_point,
                   reduce_plus_double, reduce_plus_double_domain_point,
-                  PlusOpDouble, double, size_t, ADD, ADD, 0.0)
-DECLARE_REDUCTION(register_reduction_plus_int32,
+                  PlusOpDouble, double, SumReduction)
+DECLARE_BUILTIN_REDUCTION(register_reduction_plus_int32,
                   safe_reduce_plus_int32, safe_reduce_plus_int32_domain_point,
                   reduce_plus_int32, reduce_plus_int32_domain_point,
-                  PlusOpInt, int, int, ADD, ADD, 0)
-DECLARE_REDUCTION(register_reduction_plus_int64,
+                  PlusOpInt, int, SumReduction)
+DECLARE_BUILTIN_REDUCTION(register_reduction_plus_int64,
                   safe_reduce_plus_int64, safe_reduce_plus_int64_domain_point,
                   reduce_plus_int64, reduce_plus_int64_domain_point,
-                  PlusOpLongLong, long long int, long long int, ADD, ADD, 0)
+                  PlusOpLongLong, long long int, SumReduction)
 
 DECLARE_REDUCTION(register_reduction_minus_float,
                   safe_reduce_minus_float, safe_reduce_minus_float_domain_point,
@@ -186,37 +195,37 @@ DECLARE_REDUCTION(register_reduction_divide_int64,
                   reduce_divide_int64, reduce_divide_int64_domain_point,
                   DivideOpLongLong, long long int, long long int, DIV, MUL, 1)
 
-DECLARE_REDUCTION(register_reduction_max_float,
+DECLARE_BUILTIN_REDUCTION(register_reduction_max_float,
                   safe_reduce_max_float, safe_reduce_max_float_domain_point,
                   reduce_max_float, reduce_max_float_domain_point,
-                  MaxOPFloat, float, int, std::max, std::max, -std::numeric_limits<float>::infinity())
-DECLARE_REDUCTION(register_reduction_max_double,
+                  MaxOPFloat, float, MaxReduction)
+DECLARE_BUILTIN_REDUCTION(register_reduction_max_double,
                   safe_reduce_max_double, safe_reduce_max_double_domain_point,
                   reduce_max_double, reduce_max_double_domain_point,
-                  MaxOpDouble, double, size_t, std::max, std::max, -std::numeric_limits<double>::infinity())
-DECLARE_REDUCTION(register_reduction_max_int32,
+                  MaxOpDouble, double, MaxReduction)
+DECLARE_BUILTIN_REDUCTION(register_reduction_max_int32,
                   safe_reduce_max_int32, safe_reduce_max_int32_domain_point,
                   reduce_max_int32, reduce_max_int32_domain_point,
-                  MaxOpInt, int, int, std::max, std::max, INT_MIN)
-DECLARE_REDUCTION(register_reduction_max_int64,
+                  MaxOpInt, int, MaxReduction)
+DECLARE_BUILTIN_REDUCTION(register_reduction_max_int64,
                   safe_reduce_max_int64, safe_reduce_max_int64_domain_point,
                   reduce_max_int64, reduce_max_int64_domain_point,
-                  MaxOpLongLong, long long int, long long int, std::max, std::max, LLONG_MIN)
+                  MaxOpLongLong, long long int, MaxReduction)
 
-DECLARE_REDUCTION(register_reduction_min_float,
+DECLARE_BUILTIN_REDUCTION(register_reduction_min_float,
                   safe_reduce_min_float, safe_reduce_min_float_domain_point,
                   reduce_min_float, reduce_min_float_domain_point,
-                  MinOPFloat, float, int, std::min, std::min, std::numeric_limits<float>::infinity())
-DECLARE_REDUCTION(register_reduction_min_double,
+                  MinOPFloat, float, MinReduction)
+DECLARE_BUILTIN_REDUCTION(register_reduction_min_double,
                   safe_reduce_min_double, safe_reduce_min_double_domain_point,
                   reduce_min_double, reduce_min_double_domain_point,
-                  MinOpDouble, double, size_t, std::min, std::min, std::numeric_limits<double>::infinity())
-DECLARE_REDUCTION(register_reduction_min_int32,
+                  MinOpDouble, double, MinReduction)
+DECLARE_BUILTIN_REDUCTION(register_reduction_min_int32,
                   safe_reduce_min_int32, safe_reduce_min_int32_domain_point,
                   reduce_min_int32, reduce_min_int32_domain_point,
-                  MinOpInt, int, int, std::min, std::min, INT_MAX)
-DECLARE_REDUCTION(register_reduction_min_int64,
+                  MinOpInt, int, MinReduction)
+DECLARE_BUILTIN_REDUCTION(register_reduction_min_int64,
                   safe_reduce_min_int64, safe_reduce_min_int64_domain_point,
                   reduce_min_int64, reduce_min_int64_domain_point,
-                  MinOpLongLong, long long int, long long int, std::min, std::min, LLONG_MAX)
+                  MinOpLongLong, long long int, MinReduction)
 
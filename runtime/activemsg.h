@@ -77,6 +77,9 @@
       REMOTE_IB_ALLOC_REQUEST_MSGID,
       REMOTE_IB_ALLOC_RESPONSE_MSGID,
       REMOTE_IB_FREE_REQUEST_MSGID,
+      EVENT_UPDATE_BATCH_MSGID,
+      BARRIER_COMBINE_MSGID,
+      BARRIER_COMBINE_ACK_MSGID,
     };
 
 
@@ -96,6 +96,273 @@ namespace Legion {
       mutation_effects.insert(ev);
     }
 
+    /////////////////////////////////////////////////////////////
+    // RemoteReferenceBatcher 
+    /////////////////////////////////////////////////////////////
+
+    //--------------------------------------------------------------------------
+    RemoteReferenceBatcher::RemoteReferenceBatcher(Runtime *rt, unsigned max)
+      : runtime(rt), max_batch(max), 
+        batch_lock(Reservation::create_reservation()),
+        updates_recorded(0), updates_cancelled(0), messages_sent(0)
+    //--------------------------------------------------------------------------
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    RemoteReferenceBatcher::RemoteReferenceBatcher(
+                                           const RemoteReferenceBatcher &rhs)
+      : runtime(NULL), max_batch(0)
+    //--------------------------------------------------------------------------
+    {
+      // should never be called
+      assert(false);
+    }
+
+    //--------------------------------------------------------------------------
+    RemoteReferenceBatcher::~RemoteReferenceBatcher(void)
+    //--------------------------------------------------------------------------
+    {
+      batch_lock.destroy_reservation();
+      batch_lock = Reservation::NO_RESERVATION;
+    }
+
+    //--------------------------------------------------------------------------
+    RemoteReferenceBatcher& RemoteReferenceBatcher::operator=(
+                                              const RemoteReferenceBatcher &rhs)
+    //--------------------------------------------------------------------------
+    {
+      // should never be called
+      assert(false);
+      return *this;
+    }
+
+    //--------------------------------------------------------------------------
+    void RemoteReferenceBatcher::record_removal(AddressSpaceID target,
+                     ReferenceKind kind, DistributedID did, unsigned count)
+    //--------------------------------------------------------------------------
+    {
+      PendingRemovals to_send;
+      bool send_now = false, launch_flush = false;
+      {
+        AutoLock b_lock(batch_lock);
+        PendingRemovals &batch = pending[target];
+        batch.removals[kind][did] += count;
+        updates_recorded++;
+        if ((batch.removals[GC_REF_KIND].size() + 
+             batch.removals[VALID_REF_KIND].size() +
+             batch.removals[RESOURCE_REF_KIND].size()) >= max_batch)
+        {
+          // Big enough that there is no point in waiting any longer
+          for (unsigned idx = 0; idx <= RESOURCE_REF_KIND; idx++)
+            to_send.removals[idx].swap(batch.removals[idx]);
+          send_now = true;
+        }
+        else if (!batch.flush_scheduled)
+        {
+          batch.flush_scheduled = true;
+          launch_flush = true;
+        }
+      }
+      if (send_now)
+        send_batch(target, to_send);
+      if (launch_flush)
+      {
+        // The flush goes behind the meta-tasks already queued on this
+        // node, which are what release most remote references, so their
+        // removals for this target get folded into the same net update
+        // per distributed ID instead of going out one message each
+        ReferenceFlushArgs args;
+        args.batcher = this;
+        args.target = target;
+        runtime->issue_runtime_meta_task(args, LG_THROUGHPUT_PRIORITY);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    unsigned RemoteReferenceBatcher::cancel_addition(AddressSpaceID target,
+                     ReferenceKind kind, DistributedID did, unsigned count)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock b_lock(batch_lock);
+      std::map<AddressSpaceID,PendingRemovals>::iterator finder = 
+        pending.find(target);
+      if (finder == pending.end())
+        return count;
+      std::map<DistributedID,unsigned> &removals = 
+        finder->second.removals[kind];
+      std::map<DistributedID,unsigned>::iterator it = removals.find(did);
+      if (it == removals.end())
+        return count;
+      // The target still has the references we were going to remove
+      // so we can just keep them instead of sending anything
+      updates_cancelled++;
+      if (it->second > count)
+      {
+        it->second -= count;
+        return 0;
+      }
+      const unsigned remaining = count - it->second;
+      removals.erase(it);
+      return remaining;
+    }
+
+    //--------------------------------------------------------------------------
+    void RemoteReferenceBatcher::flush(AddressSpaceID target)
+    //--------------------------------------------------------------------------
+    {
+      PendingRemovals to_send;
+      {
+        AutoLock b_lock(batch_lock);
+        std::map<AddressSpaceID,PendingRemovals>::iterator finder = 
+          pending.find(target);
+        if (finder == pending.end())
+          return;
+        for (unsigned idx = 0; idx <= RESOURCE_REF_KIND; idx++)
+          to_send.removals[idx].swap(finder->second.removals[idx]);
+        // Anything recorded after this point needs another flush
+        finder->second.flush_scheduled = false;
+      }
+      send_batch(target, to_send);
+    }
+
+    //--------------------------------------------------------------------------
+    bool RemoteReferenceBatcher::flush_all(void)
+    //--------------------------------------------------------------------------
+    {
+      std::map<AddressSpaceID,PendingRemovals> to_send;
+      {
+        AutoLock b_lock(batch_lock);
+        for (std::map<AddressSpaceID,PendingRemovals>::iterator it = 
+              pending.begin(); it != pending.end(); it++)
+        {
+          for (unsigned idx = 0; idx <= RESOURCE_REF_KIND; idx++)
+          {
+            if (it->second.removals[idx].empty())
+              continue;
+            to_send[it->first].removals[idx].swap(it->second.removals[idx]);
+          }
+        }
+      }
+      for (std::map<AddressSpaceID,PendingRemovals>::iterator it = 
+            to_send.begin(); it != to_send.end(); it++)
+        send_batch(it->first, it->second);
+      return !to_send.empty();
+    }
+
+    //--------------------------------------------------------------------------
+    void RemoteReferenceBatcher::send_batch(AddressSpaceID target,
+                                            PendingRemovals &batch)
+    //--------------------------------------------------------------------------
+    {
+      // Everything might have been cancelled or sent already
+      if (batch.removals[GC_REF_KIND].empty() &&
+          batch.removals[VALID_REF_KIND].empty() &&
+          batch.removals[RESOURCE_REF_KIND].empty())
+        return;
+      Serializer rez;
+      {
+        RezCheck z(rez);
+        // Valid references go first and resource references last so
+        // the target is never deleted before the last of them
+        const ReferenceKind order[3] = 
+          { VALID_REF_KIND, GC_REF_KIND, RESOURCE_REF_KIND };
+        for (unsigned idx = 0; idx < 3; idx++)
+        {
+          const std::map<DistributedID,unsigned> &removals = 
+            batch.removals[order[idx]];
+          rez.serialize<size_t>(removals.size());
+          for (std::map<DistributedID,unsigned>::const_iterator it = 
+                removals.begin(); it != removals.end(); it++)
+          {
+            rez.serialize(it->first);
+            rez.serialize(it->second);
+          }
+        }
+      }
+      // This is sent as a batchable message, so with -lg:message_delay
+      // the channel can hold it once more to share an active message with
+      // other traffic to the target. That second wait is bounded by the 
+      // channel's packaging deadline and its message manager's flush task,
+      // and like everything in the batch it only delays removals.
+      runtime->send_did_remote_batch_update(target, rez);
+      __sync_fetch_and_add(&messages_sent, 1);
+    }
+
+    //--------------------------------------------------------------------------
+    void RemoteReferenceBatcher::report_statistics(void) const
+    //--------------------------------------------------------------------------
+    {
+      // Every update that was batched or cancelled would otherwise 
+      // have been a message of its own
+      const unsigned long long saved = 
+        updates_recorded + updates_cancelled - messages_sent;
+      log_garbage.info("Remote reference batching on node %d: %llu removals "
+                       "in %llu messages, %llu additions cancelled, "
+                       "%llu messages saved", runtime->address_space,
+                       updates_recorded, messages_sent, updates_cancelled,
+                       saved);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void RemoteReferenceBatcher::handle_reference_flush(
+                                                               const void *args)
+    //--------------------------------------------------------------------------
+    {
+      const ReferenceFlushArgs *fargs = (const ReferenceFlushArgs*)args;
+      fargs->batcher->flush(fargs->target);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void RemoteReferenceBatcher::handle_batch_update(
+                                         Runtime *runtime, Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+      DerezCheck z(derez);
+      const ReferenceKind order[3] = 
+        { VALID_REF_KIND, GC_REF_KIND, RESOURCE_REF_KIND };
+      for (unsigned idx = 0; idx < 3; idx++)
+      {
+        size_t num_removals;
+        derez.deserialize(num_removals);
+        for (unsigned idx2 = 0; idx2 < num_removals; idx2++)
+        {
+          DistributedID did;
+          derez.deserialize(did);
+          unsigned count;
+          derez.deserialize(count);
+          DistributedCollectable *target = 
+            runtime->find_distributed_collectable(did);
+          bool remove = false;
+          switch (order[idx])
+          {
+            case VALID_REF_KIND:
+              {
+                remove = target->remove_base_valid_ref(REMOTE_DID_REF, 
+                                                       NULL, count);
+                break;
+              }
+            case GC_REF_KIND:
+              {
+                remove = target->remove_base_gc_ref(REMOTE_DID_REF,
+                                                    NULL, count);
+                break;
+              }
+            case RESOURCE_REF_KIND:
+              {
+                remove = target->remove_base_resource_ref(REMOTE_DID_REF,
+                                                          count);
+                break;
+              }
+            default:
+              assert(false);
+          }
+          if (remove)
+            delete target;
+        }
+      }
+    }
+
     /////////////////////////////////////////////////////////////
     // DistributedCollectable 
     /////////////////////////////////////////////////////////////
@@ -1305,6 +1572,19 @@ namespace Legion {
       assert(count != 0);
       assert(registered_with_runtime);
 #endif
+      if (runtime->reference_batcher != NULL)
+      {
+        if (!add)
+        {
+          runtime->reference_batcher->record_removal(target, 
+                                                VALID_REF_KIND, did, count);
+          return;
+        }
+        count = runtime->reference_batcher->cancel_addition(target, 
+                                                VALID_REF_KIND, did, count);
+        if (count == 0)
+          return;
+      }
       int signed_count = count;
       RtUserEvent done_event = RtUserEvent::NO_RT_USER_EVENT;
       if (!add)
@@ -1333,6 +1613,19 @@ namespace Legion {
       assert(count != 0);
       assert(registered_with_runtime);
 #endif
+      if (runtime->reference_batcher != NULL)
+      {
+        if (!add)
+        {
+          runtime->reference_batcher->record_removal(target, 
+                                                GC_REF_KIND, did, count);
+          return;
+        }
+        count = runtime->reference_batcher->cancel_addition(target, 
+                                                GC_REF_KIND, did, count);
+        if (count == 0)
+          return;
+      }
       int signed_count = count;
       RtUserEvent done_event = RtUserEvent::NO_RT_USER_EVENT;
       if (!add)
@@ -1361,6 +1654,19 @@ namespace Legion {
       assert(count != 0);
       assert(registered_with_runtime);
 #endif
+      if (runtime->reference_batcher != NULL)
+      {
+        if (!add)
+        {
+          runtime->reference_batcher->record_removal(target, 
+                                                RESOURCE_REF_KIND, did, count);
+          return;
+        }
+        count = runtime->reference_batcher->cancel_addition(target, 
+                                                RESOURCE_REF_KIND, did, count);
+        if (count == 0)
+          return;
+      }
       int signed_count = count;
       if (!add)
         signed_count = -signed_count;
@@ -193,6 +193,78 @@ namespace Legion {
       virtual void record_reference_mutation_effect(RtEvent event) { }
     };
 
+    /**
+     * \class RemoteReferenceBatcher
+     * Collects the remote reference removals made by the distributed
+     * collectables on this node and sends the net change for each
+     * distributed ID to each node in one message per node. Batches
+     * are sent when a node has too many distributed IDs pending or
+     * when a flush meta-task gets to them, so that removals made by
+     * runtime work already in the queue share the same message.
+     * Removals are safe to delay, additions are not, so additions
+     * are only absorbed when they cancel out a pending removal.
+     * This coalescing by distributed ID is separate from the message
+     * aggregation in the virtual channels: a batch that is sent may
+     * still be held by its channel until the packaging deadline.
+     */
+    class RemoteReferenceBatcher {
+    public:
+      struct ReferenceFlushArgs : public LgTaskArgs<ReferenceFlushArgs> {
+      public:
+        static const LgTaskID TASK_ID = LG_REFERENCE_FLUSH_TASK_ID;
+      public:
+        RemoteReferenceBatcher *batcher;
+        AddressSpaceID target;
+      };
+      struct PendingRemovals {
+      public:
+        PendingRemovals(void) : flush_scheduled(false) { }
+      public:
+        // Net references to remove for each kind of reference
+        std::map<DistributedID,unsigned> removals[RESOURCE_REF_KIND+1];
+        bool flush_scheduled;
+      };
+    public:
+      RemoteReferenceBatcher(Runtime *rt, unsigned max_batch);
+      RemoteReferenceBatcher(const RemoteReferenceBatcher &rhs);
+      ~RemoteReferenceBatcher(void);
+    public:
+      RemoteReferenceBatcher& operator=(const RemoteReferenceBatcher &rhs);
+    public:
+      void record_removal(AddressSpaceID target, ReferenceKind kind,
+                          DistributedID did, unsigned count);
+      // Returns how much of the addition still needs to be sent
+      unsigned cancel_addition(AddressSpaceID target, ReferenceKind kind,
+                               DistributedID did, unsigned count);
+      void flush(AddressSpaceID target);
+      // Send everything now, returns true if anything was sent
+      bool flush_all(void);
+    public:
+      static void handle_reference_flush(const void *args);
+      static void handle_batch_update(Runtime *runtime, Deserializer &derez);
+    public:
+      // Counters for how much batching has saved us, an update that
+      // was cancelled or merged into a batch is a message not sent
+      inline unsigned long long get_updates_recorded(void) const
+        { return updates_recorded; }
+      inline unsigned long long get_updates_cancelled(void) const
+        { return updates_cancelled; }
+      inline unsigned long long get_messages_sent(void) const
+        { return messages_sent; }
+      void report_statistics(void) const;
+    protected:
+      void send_batch(AddressSpaceID target, PendingRemovals &batch);
+    public:
+      Runtime *const runtime;
+      const unsigned max_batch;
+    protected:
+      Reservation batch_lock;
+      std::map<AddressSpaceID,PendingRemovals> pending;
+      unsigned long long updates_recorded;
+      unsigned long long updates_cancelled;
+      unsigned long long messages_sent;
+    };
+
     /**
      * \class Distributed Collectable
      * This is the base class for handling all the reference
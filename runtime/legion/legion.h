@@ -4608,8 +4608,18 @@ namespace Legion {
        * the parallelism available in the physical analysis.
        * The trace ID need only be local to the enclosing context.
        * Traces are currently not permitted to be nested.
-       */
-      void begin_trace(Context ctx, TraceID tid);
+       * If memoize is set the first time a trace is begun, the
+       * runtime will also record the results of the 'map_task' 
+       * calls for tasks in the trace and replay them in later
+       * executions instead of invoking the mapper again, as long
+       * as the chosen instances have not been collected. Mappers
+       * for tasks in memoized traces must therefore be prepared
+       * to not see 'map_task' calls for replayed tasks. Only the
+       * mapping decisions are memoized: the physical analysis
+       * (version state traversal and the copies and fills it 
+       * issues) is still performed on every execution.
+       */
+      void begin_trace(Context ctx, TraceID tid, bool memoize = false);
       /**
        * Mark the end of trace that was being performed.
        */
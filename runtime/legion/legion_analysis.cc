@@ -6899,12 +6899,11 @@ namespace Legion {
                   state_count++;
                 }
                 child_rez.serialize(state_count);
-                child_rez.serialize(state_rez.get_buffer(), 
-                                    state_rez.get_used_bytes());
+                child_rez.splice(state_rez);
                 count++;
               }
               rez.serialize(count);
-              rez.serialize(child_rez.get_buffer(), child_rez.get_used_bytes());
+              rez.splice(child_rez);
             }
             else
               rez.serialize<size_t>(0);
@@ -6947,7 +6946,7 @@ namespace Legion {
                 rez.serialize(it->second);
               }
               rez.serialize(count);
-              rez.serialize(valid_rez.get_buffer(), valid_rez.get_used_bytes());
+              rez.splice(valid_rez);
             }
             else
             {
@@ -6970,7 +6969,7 @@ namespace Legion {
                 count++;
               }
               rez.serialize(count);
-              rez.serialize(reduc_rez.get_buffer(), reduc_rez.get_used_bytes());
+              rez.splice(reduc_rez);
             }
             else
               rez.serialize<size_t>(0);
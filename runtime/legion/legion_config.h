@@ -52,7 +52,7 @@
 #endif
 
 #ifndef MAX_FIELDS
-#define MAX_FIELDS         512 // must be a power of 2
+#define MAX_FIELDS         512 // default field limit, see -lg:fields
 #endif
 
 // Some default values
@@ -133,6 +133,12 @@
 #ifndef DEFAULT_GC_EPOCH_SIZE
 #define DEFAULT_GC_EPOCH_SIZE           64
 #endif
+// Maximum number of distributed IDs with pending remote
+// reference removals for one node before they are sent
+// without waiting for the next reference flush
+#ifndef DEFAULT_MAX_REFERENCE_BATCH
+#define DEFAULT_MAX_REFERENCE_BATCH     1024
+#endif
 
 // Used for debugging memory leaks
 // How often tracing information is dumped
@@ -377,6 +383,7 @@ typedef enum legion_error_t {
   ERROR_REQUEST_FOR_EMPTY_FUTURE = 162,
   ERROR_ILLEGAL_REMAP_IN_STATIC_TRACE = 163,
   ERROR_MISSING_LOCAL_VARIABLE = 164,
+  ERROR_INVALID_FIELD_LIMIT = 165,
 }  legion_error_t;
 
 // enum and namepsaces don't really get along well
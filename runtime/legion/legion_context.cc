@@ -5413,7 +5413,7 @@ namespace Legion {
     }
 
     //--------------------------------------------------------------------------
-    void InnerContext::begin_trace(TraceID tid)
+    void InnerContext::begin_trace(TraceID tid, bool memoize)
     //--------------------------------------------------------------------------
     {
       AutoRuntimeCall call(this);
@@ -5437,7 +5437,7 @@ namespace Legion {
       if (finder == traces.end())
       {
         // Trace does not exist yet, so make one and record it
-        DynamicTrace *dynamic_trace = new DynamicTrace(tid, this);
+        DynamicTrace *dynamic_trace = new DynamicTrace(tid, this, memoize);
         dynamic_trace->add_reference();
         traces[tid] = dynamic_trace;
         current_trace = dynamic_trace;
@@ -8667,7 +8667,7 @@ namespace Legion {
     }
 
     //--------------------------------------------------------------------------
-    void LeafContext::begin_trace(TraceID tid)
+    void LeafContext::begin_trace(TraceID tid, bool memoize)
     //--------------------------------------------------------------------------
     {
       log_task.error("Illegal Legion begin trace call in leaf task %s "
@@ -9834,10 +9834,10 @@ namespace Legion {
     }
 
     //--------------------------------------------------------------------------
-    void InlineContext::begin_trace(TraceID tid)
+    void InlineContext::begin_trace(TraceID tid, bool memoize)
     //--------------------------------------------------------------------------
     {
-      enclosing->begin_trace(tid);
+      enclosing->begin_trace(tid, memoize);
     }
 
     //--------------------------------------------------------------------------
@@ -304,7 +304,7 @@ namespace Legion {
       virtual void perform_fence_analysis(FenceOp *op) = 0;
       virtual void update_current_fence(FenceOp *op) = 0;
     public:
-      virtual void begin_trace(TraceID tid) = 0;
+      virtual void begin_trace(TraceID tid, bool memoize) = 0;
       virtual void end_trace(TraceID tid) = 0;
       virtual void begin_static_trace(
                                      const std::set<RegionTreeID> *managed) = 0;
@@ -877,7 +877,7 @@ namespace Legion {
       virtual void perform_fence_analysis(FenceOp *op);
       virtual void update_current_fence(FenceOp *op);
     public:
-      virtual void begin_trace(TraceID tid);
+      virtual void begin_trace(TraceID tid, bool memoize);
       virtual void end_trace(TraceID tid);
       virtual void begin_static_trace(const std::set<RegionTreeID> *managed);
       virtual void end_static_trace(void);
@@ -1380,7 +1380,7 @@ namespace Legion {
       virtual void perform_fence_analysis(FenceOp *op);
       virtual void update_current_fence(FenceOp *op);
     public:
-      virtual void begin_trace(TraceID tid);
+      virtual void begin_trace(TraceID tid, bool memoize);
       virtual void end_trace(TraceID tid);
       virtual void begin_static_trace(const std::set<RegionTreeID> *managed);
       virtual void end_static_trace(void);
@@ -1679,7 +1679,7 @@ namespace Legion {
       virtual void perform_fence_analysis(FenceOp *op);
       virtual void update_current_fence(FenceOp *op);
     public:
-      virtual void begin_trace(TraceID tid);
+      virtual void begin_trace(TraceID tid, bool memoize);
       virtual void end_trace(TraceID tid);
       virtual void begin_static_trace(const std::set<RegionTreeID> *managed);
       virtual void end_static_trace(void);
@@ -33,18 +33,19 @@ namespace Legion {
     // This is the shit right here: super-cool helper function
 
     //--------------------------------------------------------------------------
-    template<unsigned LOG2MAX>
     static inline void compress_mask(FieldMask &x, FieldMask m)
     //--------------------------------------------------------------------------
     {
+      // The field limit is always a power of two
+      const unsigned log2max = __builtin_ctz(Runtime::max_fields);
       FieldMask mk, mp, mv, t;
       // See hacker's delight 7-4
       x = x & m;
       mk = ~m << 1;
-      for (unsigned i = 0; i < LOG2MAX; i++)
+      for (unsigned i = 0; i < log2max; i++)
       {
         mp = mk ^ (mk << 1);
-        for (unsigned idx = 1; idx < LOG2MAX; idx++)
+        for (unsigned idx = 1; idx < log2max; idx++)
           mp = mp ^ (mp << (1 << idx));
         mv = mp & m;
         m = (m ^ mv) | (mv >> (1 << i));
@@ -78,7 +79,7 @@ namespace Legion {
       if (!found_in_cache)
       {
         compressed = src_mask;
-        compress_mask<STATIC_LOG2(MAX_FIELDS)>(compressed, full_mask);
+        compress_mask(compressed, full_mask);
         compressed_cache.push_back(
             std::pair<FieldMask,FieldMask>(src_mask, compressed));
       }
@@ -227,7 +228,7 @@ namespace Legion {
       if (!found_in_cache)
       {
         compressed = copy_mask;
-        compress_mask<STATIC_LOG2(MAX_FIELDS)>(compressed, allocated_fields);
+        compress_mask(compressed, allocated_fields);
         // Save the result in the cache, duplicates from races here are benign
         AutoLock o_lock(layout_lock);
         comp_cache[hash_key].push_back(
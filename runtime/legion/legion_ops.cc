@@ -92,6 +92,7 @@ namespace Legion {
       if (Runtime::resilient_mode)
         commit_event = Runtime::create_rt_user_event(); 
       trace = NULL;
+      trace_local_id = 0;
       tracing = false;
       must_epoch = NULL;
 #ifdef DEBUG_LEGION
@@ -60,14 +60,16 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     LegionProfInstance::LegionProfInstance(LegionProfiler *own)
-      : owner(own)
+      : owner(own), first_record(0), record_lock(0), back_buffer(NULL), 
+        back_buffer_busy(false)
     //--------------------------------------------------------------------------
     {
     }
 
     //--------------------------------------------------------------------------
     LegionProfInstance::LegionProfInstance(const LegionProfInstance &rhs)
-      : owner(rhs.owner)
+      : owner(rhs.owner), first_record(0), record_lock(0), back_buffer(NULL), 
+        back_buffer_busy(false)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -78,6 +80,8 @@ namespace Legion {
     LegionProfInstance::~LegionProfInstance(void)
     //--------------------------------------------------------------------------
     {
+      if (back_buffer != NULL)
+        delete back_buffer;
     }
 
     //--------------------------------------------------------------------------
@@ -329,6 +333,8 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     void LegionProfInstance::record_message(Processor proc, MessageKind kind, 
+                                            VirtualChannelKind channel,
+                                            size_t size,
                                             unsigned long long start,
                                             unsigned long long stop)
     //--------------------------------------------------------------------------
@@ -339,6 +345,8 @@ namespace Legion {
       info.start = start;
       info.stop = stop;
       info.proc_id = proc.id;
+      info.channel = channel;
+      info.size = size;
     }
 
     //--------------------------------------------------------------------------
@@ -385,6 +393,155 @@ namespace Legion {
     }
 #endif
 
+    //--------------------------------------------------------------------------
+    size_t LegionProfInstance::estimate_footprint(void) const
+    //--------------------------------------------------------------------------
+    {
+      // Wait intervals and task names are not counted, this only
+      // has to be good enough to bound the size of our buffers
+      size_t result = 
+        task_kinds.size() * sizeof(TaskKind) +
+        task_variants.size() * sizeof(TaskVariant) +
+        operation_instances.size() * sizeof(OperationInstance) +
+        multi_tasks.size() * sizeof(MultiTask) +
+        slice_owners.size() * sizeof(SliceOwner) +
+        task_infos.size() * sizeof(TaskInfo) +
+        meta_infos.size() * sizeof(MetaInfo) +
+        copy_infos.size() * sizeof(CopyInfo) +
+        fill_infos.size() * sizeof(FillInfo) +
+        inst_create_infos.size() * sizeof(InstCreateInfo) +
+        inst_usage_infos.size() * sizeof(InstUsageInfo) +
+        inst_timeline_infos.size() * sizeof(InstTimelineInfo) +
+        message_infos.size() * sizeof(MessageInfo) +
+        mapper_call_infos.size() * sizeof(MapperCallInfo) +
+        runtime_call_infos.size() * sizeof(RuntimeCallInfo);
+#ifdef LEGION_PROF_SELF_PROFILE
+      result += prof_task_infos.size() * sizeof(ProfTaskInfo);
+#endif
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfInstance::begin_record(void)
+    //--------------------------------------------------------------------------
+    {
+      // Only the latency sweep ever looks at our records from another
+      // thread, so without a latency bound there's nothing to lock
+      if (owner->target_latency == 0)
+        return;
+      while (__sync_lock_test_and_set(&record_lock, 1) != 0) { }
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfInstance::check_flush(void)
+    //--------------------------------------------------------------------------
+    {
+      bool flush = false, start_sweep = false;
+      const size_t footprint = 
+        owner->is_streaming() ? estimate_footprint() : 0;
+      if (footprint > 0)
+      {
+        if ((owner->footprint_threshold > 0) && 
+            (footprint >= owner->footprint_threshold))
+          flush = true;
+        if (owner->target_latency > 0)
+        {
+          const timestamp_t now = Realm::Clock::current_time_in_nanoseconds();
+          if (first_record == 0)
+          {
+            // If we stop recording the sweep will hand these off for us
+            first_record = now;
+            start_sweep = true;
+          }
+          else if ((now - first_record) >= owner->target_latency)
+            flush = true;
+        }
+        // If the last flush hasn't been written yet then keep recording
+        // here, we'll try again with the next record (or the sweep will)
+        if (flush && !back_buffer_busy)
+          flush_records();
+        else
+          flush = false;
+      }
+      if (owner->target_latency > 0)
+        __sync_lock_release(&record_lock);
+      // Hand things to the profiler only once we've let go of our records
+      // in case that ends up recording something on this thread
+      if (flush)
+        owner->flush_buffer(this);
+      if (start_sweep)
+        owner->start_latency_sweep();
+    }
+
+    //--------------------------------------------------------------------------
+    bool LegionProfInstance::sweep_stale_records(timestamp_t now)
+    //--------------------------------------------------------------------------
+    {
+      // If the owning thread is recording right now it will check for
+      // itself when it is done
+      if (__sync_lock_test_and_set(&record_lock, 1) != 0)
+        return true;
+      bool flush = false;
+      if ((first_record > 0) && (first_record <= now) &&
+          ((now - first_record) >= owner->target_latency) && !back_buffer_busy)
+      {
+        flush_records();
+        flush = true;
+      }
+      const bool pending = (first_record > 0);
+      __sync_lock_release(&record_lock);
+      if (flush)
+        owner->flush_buffer(this);
+      return pending;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfInstance::flush_records(void)
+    //--------------------------------------------------------------------------
+    {
+      // Make sure we see the back buffer emptied by the flush task
+      __sync_synchronize();
+      // Swap our records into the back buffer so this thread can keep
+      // recording while they are written out in the background
+      if (back_buffer == NULL)
+        back_buffer = new LegionProfInstance(owner);
+      LegionProfInstance *buffer = back_buffer;
+      buffer->task_kinds.swap(task_kinds);
+      buffer->task_variants.swap(task_variants);
+      buffer->operation_instances.swap(operation_instances);
+      buffer->multi_tasks.swap(multi_tasks);
+      buffer->slice_owners.swap(slice_owners);
+      buffer->task_infos.swap(task_infos);
+      buffer->meta_infos.swap(meta_infos);
+      buffer->copy_infos.swap(copy_infos);
+      buffer->fill_infos.swap(fill_infos);
+      buffer->inst_create_infos.swap(inst_create_infos);
+      buffer->inst_usage_infos.swap(inst_usage_infos);
+      buffer->inst_timeline_infos.swap(inst_timeline_infos);
+      buffer->message_infos.swap(message_infos);
+      buffer->mapper_call_infos.swap(mapper_call_infos);
+      buffer->runtime_call_infos.swap(runtime_call_infos);
+#ifdef LEGION_PROF_SELF_PROFILE
+      buffer->prof_task_infos.swap(prof_task_infos);
+#endif
+      first_record = 0;
+      back_buffer_busy = true;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfInstance::dump_back_buffer(LegionProfSerializer *serializer)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(back_buffer_busy);
+      assert(back_buffer != NULL);
+#endif
+      back_buffer->dump_state(serializer);
+      // Publish the emptied buffer before handing it back
+      __sync_synchronize();
+      back_buffer_busy = false;
+    }
+
     //--------------------------------------------------------------------------
     void LegionProfInstance::dump_state(LegionProfSerializer *serializer)
     //--------------------------------------------------------------------------
@@ -487,29 +644,41 @@ namespace Legion {
       task_variants.clear();
       operation_instances.clear();
       multi_tasks.clear();
+      slice_owners.clear();
       task_infos.clear();
       meta_infos.clear();
       copy_infos.clear();
+      fill_infos.clear();
       inst_create_infos.clear();
       inst_usage_infos.clear();
       inst_timeline_infos.clear();
       message_infos.clear();
       mapper_call_infos.clear();
+      runtime_call_infos.clear();
+#ifdef LEGION_PROF_SELF_PROFILE
+      prof_task_infos.clear();
+#endif
+      first_record = 0;
     }
 
     //--------------------------------------------------------------------------
     LegionProfiler::LegionProfiler(Processor target, const Machine &machine,
-                                   unsigned num_meta_tasks,
+                                   Runtime *rt, unsigned num_meta_tasks,
                                    const char *const *const task_descriptions,
                                    unsigned num_operation_kinds,
                                    const char *const *const 
                                                   operation_kind_descriptions,
                                    const char *serializer_type,
-                                   const char *prof_logfile)
-      : target_proc(target), total_outstanding_requests(0)
+                                   const char *prof_logfile,
+                                   size_t footprint,
+                                   size_t latency)
+      : target_proc(target), footprint_threshold(footprint), 
+        target_latency(latency), runtime(rt), total_outstanding_requests(0),
+        flush_in_flight(false), sweep_in_flight(false), finalizing(false)
     //--------------------------------------------------------------------------
     {
       profiler_lock = Reservation::create_reservation();
+      serializer_lock = Reservation::create_reservation();
 
       if (!strcmp(serializer_type, "binary")) {
         if (prof_logfile == NULL) {
@@ -584,7 +753,9 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     LegionProfiler::LegionProfiler(const LegionProfiler &rhs)
-      : target_proc(rhs.target_proc)
+      : target_proc(rhs.target_proc), 
+        footprint_threshold(rhs.footprint_threshold),
+        target_latency(rhs.target_latency), runtime(rhs.runtime)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -597,7 +768,10 @@ namespace Legion {
     {
       profiler_lock.destroy_reservation();
       profiler_lock = Reservation::NO_RESERVATION;
+      serializer_lock.destroy_reservation();
+      serializer_lock = Reservation::NO_RESERVATION;
       assert(total_outstanding_requests == 0);
+      assert(pending_buffers.empty());
       for (std::vector<LegionProfInstance*>::const_iterator it = 
             instances.begin(); it != instances.end(); it++)
         delete (*it);
@@ -622,8 +796,10 @@ namespace Legion {
     {
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
+      thread_local_profiling_instance->begin_record();
       thread_local_profiling_instance->register_task_kind(task_id, task_name,
                                                           overwrite);
+      thread_local_profiling_instance->check_flush();
     }
 
     //--------------------------------------------------------------------------
@@ -634,8 +810,10 @@ namespace Legion {
     {
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
+      thread_local_profiling_instance->begin_record();
       thread_local_profiling_instance->register_task_variant(task_id, 
                                                       variant_id, variant_name);
+      thread_local_profiling_instance->check_flush();
     }
 
     //--------------------------------------------------------------------------
@@ -644,7 +822,9 @@ namespace Legion {
     {
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
+      thread_local_profiling_instance->begin_record();
       thread_local_profiling_instance->register_operation(op);
+      thread_local_profiling_instance->check_flush();
     }
 
     //--------------------------------------------------------------------------
@@ -653,7 +833,9 @@ namespace Legion {
     {
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
+      thread_local_profiling_instance->begin_record();
       thread_local_profiling_instance->register_multi_task(op, task_id);
+      thread_local_profiling_instance->check_flush();
     }
 
     //--------------------------------------------------------------------------
@@ -662,7 +844,9 @@ namespace Legion {
     {
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
+      thread_local_profiling_instance->begin_record();
       thread_local_profiling_instance->register_slice_owner(pid, id);
+      thread_local_profiling_instance->check_flush();
     }
 
     //--------------------------------------------------------------------------
@@ -886,6 +1070,7 @@ namespace Legion {
 #endif
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
+      thread_local_profiling_instance->begin_record();
       Realm::ProfilingResponse response(buffer, size);
 #ifdef DEBUG_LEGION
       assert(response.user_data_size() == sizeof(ProfilingInfo));
@@ -1061,18 +1246,161 @@ namespace Legion {
       thread_local_profiling_instance->record_proftask(p, info->op_id, 
                                                        t_start, t_stop);
 #endif
+      thread_local_profiling_instance->check_flush();
     }
 
     //--------------------------------------------------------------------------
     void LegionProfiler::finalize(void)
     //--------------------------------------------------------------------------
     {
+      // Stop launching flush and sweep tasks and wait for any that are
+      // still running to finish since we're about to be deleted
+      while (true)
+      {
+        RtEvent wait_on;
+        {
+          AutoLock p_lock(profiler_lock);
+          finalizing = true;
+          if (flush_in_flight)
+            wait_on = flush_done;
+          else if (sweep_in_flight)
+            wait_on = sweep_done;
+          else
+            break;
+        }
+        wait_on.lg_wait();
+      }
+      // Write out anything that was already handed off first
+      drain_buffers(false/*background*/);
+      AutoLock s_lock(serializer_lock);
       for (std::vector<LegionProfInstance*>::const_iterator it = 
             instances.begin(); it != instances.end(); it++) {
         (*it)->dump_state(serializer);
       }  
     }
 
+    //--------------------------------------------------------------------------
+    void LegionProfiler::flush_buffer(LegionProfInstance *instance)
+    //--------------------------------------------------------------------------
+    {
+      // Each thread has at most one back buffer waiting here, so the
+      // memory we hold is bounded without the recording thread ever 
+      // having to write anything out itself
+      // Once we're finalizing, whatever is handed off gets written out 
+      // by finalize itself
+      AutoLock p_lock(profiler_lock);
+      pending_buffers.push_back(instance);
+      if (flush_in_flight || finalizing)
+        return;
+      flush_in_flight = true;
+      // Launch under the lock so finalize sees the event for it
+      FlushArgs args;
+      args.profiler = this;
+      flush_done = runtime->issue_runtime_meta_task(args, 
+          LG_THROUGHPUT_PRIORITY, NULL, RtEvent::NO_RT_EVENT, target_proc);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void LegionProfiler::handle_flush(const void *args)
+    //--------------------------------------------------------------------------
+    {
+      const FlushArgs *fargs = (const FlushArgs*)args;
+      fargs->profiler->drain_buffers(true/*background*/);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfiler::start_latency_sweep(void)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock p_lock(profiler_lock);
+      if (sweep_in_flight || finalizing)
+        return;
+      sweep_in_flight = true;
+      // Realm has no timers so the sweep serves as one: it runs at 
+      // throughput priority and launches itself again until no thread
+      // has records waiting to be handed off
+      SweepArgs args;
+      args.profiler = this;
+      sweep_done = runtime->issue_runtime_meta_task(args, 
+          LG_THROUGHPUT_PRIORITY, NULL, RtEvent::NO_RT_EVENT, target_proc);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void LegionProfiler::handle_latency_sweep(const void *args)
+    //--------------------------------------------------------------------------
+    {
+      const SweepArgs *sargs = (const SweepArgs*)args;
+      sargs->profiler->sweep_latency();
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfiler::sweep_latency(void)
+    //--------------------------------------------------------------------------
+    {
+      // Instances are only ever added, so we can look at a copy of the
+      // list without holding the lock (which handing off records needs)
+      std::vector<LegionProfInstance*> current;
+      {
+        AutoLock p_lock(profiler_lock);
+        if (!finalizing)
+          current = instances;
+      }
+      const timestamp_t now = Realm::Clock::current_time_in_nanoseconds();
+      for (std::vector<LegionProfInstance*>::const_iterator it = 
+            current.begin(); it != current.end(); it++)
+        (*it)->sweep_stale_records(now);
+      // Decide whether to go again under the lock: a thread that starts
+      // a new batch of records after we look here will see the flag 
+      // cleared and start another sweep itself
+      AutoLock p_lock(profiler_lock);
+      bool pending = false;
+      if (!finalizing)
+      {
+        for (std::vector<LegionProfInstance*>::const_iterator it = 
+              instances.begin(); it != instances.end(); it++)
+        {
+          if (!(*it)->has_unflushed_records())
+            continue;
+          pending = true;
+          break;
+        }
+      }
+      if (!pending)
+      {
+        sweep_in_flight = false;
+        return;
+      }
+      SweepArgs args;
+      args.profiler = this;
+      sweep_done = runtime->issue_runtime_meta_task(args, 
+          LG_THROUGHPUT_PRIORITY, NULL, RtEvent::NO_RT_EVENT, target_proc);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfiler::drain_buffers(bool background)
+    //--------------------------------------------------------------------------
+    {
+      while (true)
+      {
+        LegionProfInstance *next;
+        {
+          AutoLock p_lock(profiler_lock);
+          if (pending_buffers.empty())
+          {
+            // Clear this while holding the lock so that anyone
+            // adding a buffer after this will launch a new flush
+            if (background)
+              flush_in_flight = false;
+            return;
+          }
+          next = pending_buffers.front();
+          pending_buffers.pop_front();
+        }
+        AutoLock s_lock(serializer_lock);
+        next->dump_back_buffer(serializer);
+      }
+    }
+
     //--------------------------------------------------------------------------
     void LegionProfiler::record_instance_creation(PhysicalInstance inst,
                        Memory memory, UniqueID op_id, unsigned long long create)
@@ -1080,7 +1408,9 @@ namespace Legion {
     {
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
+      thread_local_profiling_instance->begin_record();
       thread_local_profiling_instance->process_inst_create(op_id, inst, create);
+      thread_local_profiling_instance->check_flush();
     }
 
     //--------------------------------------------------------------------------
@@ -1099,6 +1429,8 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     void LegionProfiler::record_message(MessageKind kind, 
+                                        VirtualChannelKind channel,
+                                        size_t size,
                                         unsigned long long start,
                                         unsigned long long stop)
     //--------------------------------------------------------------------------
@@ -1106,8 +1438,10 @@ namespace Legion {
       Processor current = Processor::get_executing_processor();
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
-      thread_local_profiling_instance->record_message(current, kind, 
-                                                      start, stop);
+      thread_local_profiling_instance->begin_record();
+      thread_local_profiling_instance->record_message(current, kind, channel,
+                                                      size, start, stop);
+      thread_local_profiling_instance->check_flush();
     }
 
     //--------------------------------------------------------------------------
@@ -1132,8 +1466,10 @@ namespace Legion {
       Processor current = Processor::get_executing_processor();
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
+      thread_local_profiling_instance->begin_record();
       thread_local_profiling_instance->record_mapper_call(current, kind, uid, 
                                                    start, stop);
+      thread_local_profiling_instance->check_flush();
     }
 
     //--------------------------------------------------------------------------
@@ -1158,8 +1494,10 @@ namespace Legion {
       Processor current = Processor::get_executing_processor();
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
+      thread_local_profiling_instance->begin_record();
       thread_local_profiling_instance->record_runtime_call(current, kind, 
                                                            start, stop);
+      thread_local_profiling_instance->check_flush();
     }
 
     //--------------------------------------------------------------------------
@@ -193,6 +193,8 @@ namespace Legion {
         MessageKind kind;
         timestamp_t start, stop;
         ProcID proc_id;
+        VirtualChannelKind channel;
+        unsigned long long size;
       };
       struct MapperCallInfo {
       public:
@@ -255,8 +257,9 @@ namespace Legion {
       void process_inst_timeline(UniqueID op_id,
                   Realm::ProfilingMeasurements::InstanceTimeline *timeline);
     public:
-      void record_message(Processor proc, MessageKind kind, timestamp_t start,
-                          timestamp_t stop);
+      void record_message(Processor proc, MessageKind kind, 
+                          VirtualChannelKind channel, size_t size,
+                          timestamp_t start, timestamp_t stop);
       void record_mapper_call(Processor proc, MappingCallKind kind, 
                               UniqueID uid, timestamp_t start,
                               timestamp_t stop);
@@ -268,9 +271,39 @@ namespace Legion {
                            timestamp_t stop);
 #endif
     public:
+      // The owning thread calls this before recording anything and
+      // check_flush when it is done, so that with a latency bound the
+      // profiler's latency sweep can take the records of a thread that
+      // has gone idle
+      void begin_record(void);
+      // Hand our records off to the profiler if we've exceeded the
+      // footprint or latency bounds for streaming profiles
+      void check_flush(void);
+      // Called by the latency sweep from another thread, returns true
+      // if we still have records that haven't been handed off
+      bool sweep_stale_records(timestamp_t now);
+      inline bool has_unflushed_records(void) const
+        { return (first_record > 0); }
       void dump_state(LegionProfSerializer *serializer);
+      // Write out our back buffer and release it for the next flush
+      void dump_back_buffer(LegionProfSerializer *serializer);
+    protected:
+      size_t estimate_footprint(void) const;
+      // Swap our records into the back buffer and hand it off
+      void flush_records(void);
     private:
       LegionProfiler *const owner;
+      // Time of the oldest record that has not been flushed
+      volatile timestamp_t first_record;
+      // Held by the owning thread while it records and by the latency
+      // sweep while it looks at our records
+      volatile int record_lock;
+      // Streaming profiles double buffer each thread's records: when we
+      // flush, our records are swapped into the back buffer which the
+      // flush meta-task writes out while we keep filling this one. If the
+      // back buffer is still busy we keep recording here until it is free.
+      LegionProfInstance *back_buffer;
+      volatile bool back_buffer_busy;
       std::deque<TaskKind>          task_kinds;
       std::deque<TaskVariant>       task_variants;
       std::deque<OperationInstance> operation_instances;
@@ -313,16 +346,30 @@ namespace Legion {
         size_t id;
         UniqueID op_id;
       };
+      struct FlushArgs : public LgTaskArgs<FlushArgs> {
+      public:
+        static const LgTaskID TASK_ID = LG_PROFILER_FLUSH_TASK_ID;
+      public:
+        LegionProfiler *profiler;
+      };
+      struct SweepArgs : public LgTaskArgs<SweepArgs> {
+      public:
+        static const LgTaskID TASK_ID = LG_PROFILER_SWEEP_TASK_ID;
+      public:
+        LegionProfiler *profiler;
+      };
     public:
       // Statically known information passed through the constructor
       // so that it can be deduplicated
       LegionProfiler(Processor target_proc, const Machine &machine,
-                     unsigned num_meta_tasks,
+                     Runtime *runtime, unsigned num_meta_tasks,
                      const char *const *const meta_task_descriptions,
                      unsigned num_operation_kinds,
                      const char *const *const operation_kind_descriptions,
                      const char *serializer_type,
-                     const char *prof_logname);
+                     const char *prof_logname,
+                     size_t footprint_threshold,
+                     size_t target_latency);
       LegionProfiler(const LegionProfiler &rhs);
       ~LegionProfiler(void);
     public:
@@ -372,14 +419,27 @@ namespace Legion {
     public:
       // Dump all the results
       void finalize(void);
+    public:
+      // Streaming profiles: thread-local instances hand full back buffers
+      // of records to the profiler, which serializes them in the
+      // background on the target processor
+      void flush_buffer(LegionProfInstance *instance);
+      static void handle_flush(const void *args);
+      // With a latency bound, records that are waiting on a thread that 
+      // stopped recording get handed off by a sweep that runs as long as
+      // any thread has records that haven't been
+      void start_latency_sweep(void);
+      static void handle_latency_sweep(const void *args);
+      inline bool is_streaming(void) const
+        { return ((footprint_threshold > 0) || (target_latency > 0)); }
     public:
       void record_instance_creation(PhysicalInstance inst, Memory memory,
                                     UniqueID op_id, timestamp_t create);
     public:
       void record_message_kinds(const char *const *const message_names,
                                 unsigned int num_message_kinds);
-      void record_message(MessageKind kind, timestamp_t start,
-                          timestamp_t stop);
+      void record_message(MessageKind kind, VirtualChannelKind channel,
+                          size_t size, timestamp_t start, timestamp_t stop);
     public:
       void record_mapper_call_kinds(const char *const *const mapper_call_names,
                                     unsigned int num_mapper_call_kinds);
@@ -392,6 +452,10 @@ namespace Legion {
                                timestamp_t stop);
     public:
       const Processor target_proc;
+      // In bytes, zero means no limit
+      const size_t footprint_threshold;
+      // In nanoseconds, zero means no limit
+      const timestamp_t target_latency;
       inline bool has_outstanding_requests(void)
         { return total_outstanding_requests != 0; }
     public:
@@ -401,11 +465,24 @@ namespace Legion {
         { __sync_fetch_and_sub(&total_outstanding_requests,1); }
     private:
       void create_thread_local_profiling_instance(void);
+      void drain_buffers(bool background);
+      void sweep_latency(void);
     private:
+      Runtime *const runtime;
       LegionProfSerializer* serializer;
       Reservation profiler_lock;
       std::vector<LegionProfInstance*> instances;
       unsigned total_outstanding_requests;
+    private:
+      // Only one thread at a time can be writing to the serializer
+      Reservation serializer_lock;
+      // Instances whose back buffers are waiting to be serialized
+      std::deque<LegionProfInstance*> pending_buffers;
+      bool flush_in_flight, sweep_in_flight;
+      // Completion events of the most recent flush and sweep tasks
+      RtEvent flush_done, sweep_done;
+      // Once set no more flush or sweep tasks are launched
+      bool finalizing;
     };
 
     class DetailedProfiler {
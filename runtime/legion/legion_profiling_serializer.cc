@@ -206,7 +206,9 @@ namespace Legion {
               << "kind:MessageKind:"  << sizeof(MessageKind)        << delim
               << "start:timestamp_t:" << sizeof(timestamp_t)        << delim
               << "stop:timestamp_t:"  << sizeof(timestamp_t)        << delim
-              << "proc_id:ProcID:"    << sizeof(ProcID)
+              << "proc_id:ProcID:"    << sizeof(ProcID)             << delim
+              << "channel:VirtualChannelKind:" << sizeof(VirtualChannelKind) << delim
+              << "size:unsigned long long:" << sizeof(unsigned long long)
          << "}" << std::endl;
 
       ss << "MapperCallInfo {"
@@ -450,6 +452,8 @@ namespace Legion {
       lp_fwrite(f, (char*)&(message_info.start),   sizeof(message_info.start));
       lp_fwrite(f, (char*)&(message_info.stop),    sizeof(message_info.stop));
       lp_fwrite(f, (char*)&(message_info.proc_id), sizeof(message_info.proc_id));
+      lp_fwrite(f, (char*)&(message_info.channel), sizeof(message_info.channel));
+      lp_fwrite(f, (char*)&(message_info.size),    sizeof(message_info.size));
     }
     void LegionProfBinarySerializer::serialize(const LegionProfInstance::MapperCallInfo& mapper_call_info)
     {
@@ -628,8 +632,9 @@ namespace Legion {
 
     void LegionProfASCIISerializer::serialize(const LegionProfInstance::MessageInfo& message_info)
     {
-      log_prof.print("Prof Message Info %u " IDFMT " %llu %llu",
-         message_info.kind, message_info.proc_id, message_info.start, message_info.stop);
+      log_prof.print("Prof Message Info %u " IDFMT " %llu %llu %u %llu",
+         message_info.kind, message_info.proc_id, message_info.start, message_info.stop,
+         message_info.channel, message_info.size);
     }
 
     void LegionProfASCIISerializer::serialize(const LegionProfInstance::MapperCallInfo& mapper_call_info)
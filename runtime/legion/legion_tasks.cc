@@ -411,7 +411,8 @@ namespace Legion {
         pack_phase_barrier(arrive_barriers[idx], rez);
       rez.serialize<bool>((arg_manager != NULL));
       rez.serialize(arglen);
-      rez.serialize(args,arglen);
+      // The task stays alive until it has been sent
+      rez.serialize_reference(args,arglen);
       rez.serialize(map_id);
       rez.serialize(tag);
       rez.serialize(is_index_space);
@@ -419,7 +420,7 @@ namespace Legion {
       rez.serialize(index_domain);
       rez.serialize(index_point);
       rez.serialize(local_arglen);
-      rez.serialize(local_args,local_arglen);
+      rez.serialize_reference(local_args,local_arglen);
       rez.serialize(orig_proc);
       // No need to pack current proc, it will get set when we unpack
       rez.serialize(steal_count);
@@ -3492,7 +3493,33 @@ namespace Legion {
       // Now we can invoke the mapper to do the mapping
       if (mapper == NULL)
         mapper = runtime->find_mapper(current_proc, map_id);
-      mapper->invoke_map_task(this, &input, &output);
+      // If we are part of a trace that is memoizing mappings, then see
+      // if we can just reuse the decisions from the first time through
+      unsigned trace_index = 0;
+      bool recording = false;
+      DynamicTrace *memo_trace = (must_epoch_owner == NULL) ?
+        find_memoizing_trace(trace_index, recording) : NULL;
+      bool memoized = false;
+      if ((memo_trace != NULL) && !recording)
+      {
+        Mapper::MapTaskOutput memo_output;
+        if (memo_trace->find_task_mapping(trace_index, index_point,
+                                          this, memo_output) &&
+            acquire_memoized_instances(memo_output))
+        {
+          output = memo_output;
+          memoized = true;
+        }
+      }
+      if (!memoized)
+      {
+        mapper->invoke_map_task(this, &input, &output);
+        if ((memo_trace != NULL) && recording && 
+            output.task_prof_requests.empty() &&
+            output.copy_prof_requests.empty())
+          memo_trace->record_task_mapping(trace_index, index_point,
+                                          this, output);
+      }
       // Sort out any profiling requests that we need to perform
       if (!output.task_prof_requests.empty())
       {
@@ -3558,6 +3585,69 @@ namespace Legion {
                                valid_instances);
     }
 
+    //--------------------------------------------------------------------------
+    DynamicTrace* SingleTask::find_memoizing_trace(unsigned &trace_index,
+                                                   bool &recording)
+    //--------------------------------------------------------------------------
+    {
+      // Traces only exist on the node where the task was launched
+      if (is_remote() || (trace == NULL) || !trace->is_dynamic_trace())
+        return NULL;
+      DynamicTrace *dynamic_trace = trace->as_dynamic_trace();
+      if (!dynamic_trace->is_memoizing())
+        return NULL;
+      trace_index = get_trace_local_id();
+      recording = is_tracing();
+      return dynamic_trace;
+    }
+
+    //--------------------------------------------------------------------------
+    bool SingleTask::acquire_memoized_instances(
+                                          const Mapper::MapTaskOutput &output)
+    //--------------------------------------------------------------------------
+    {
+      // The mapper isn't around to acquire the instances for us, so do it
+      // the same way it would have. If any of them have been collected 
+      // since we recorded the mapping then we have to ask the mapper again.
+      std::map<PhysicalManager*,std::pair<unsigned,bool> > &acquired = 
+        *get_acquired_instances_ref();
+      std::vector<PhysicalManager*> newly_acquired;
+      bool success = true;
+      for (unsigned idx1 = 0; success && 
+            (idx1 < output.chosen_instances.size()); idx1++)
+      {
+        const std::vector<Mapping::PhysicalInstance> &instances = 
+          output.chosen_instances[idx1];
+        for (unsigned idx2 = 0; idx2 < instances.size(); idx2++)
+        {
+          PhysicalManager *manager = instances[idx2].impl;
+          if ((manager == NULL) || manager->is_virtual_manager())
+            continue;
+          if (acquired.find(manager) != acquired.end())
+            continue;
+          if (!manager->try_add_base_valid_ref(MAPPING_ACQUIRE_REF, this,
+                                               !manager->is_owner()))
+          {
+            success = false;
+            break;
+          }
+          acquired[manager] = std::pair<unsigned,bool>(1, false);
+          newly_acquired.push_back(manager);
+        }
+      }
+      if (!success)
+      {
+        for (std::vector<PhysicalManager*>::const_iterator it = 
+              newly_acquired.begin(); it != newly_acquired.end(); it++)
+        {
+          acquired.erase(*it);
+          if ((*it)->remove_base_valid_ref(MAPPING_ACQUIRE_REF, this))
+            delete (*it);
+        }
+      }
+      return success;
+    }
+
     //--------------------------------------------------------------------------
     void SingleTask::map_all_regions(ApEvent local_termination_event,
                                      MustEpochOp *must_epoch_op /*=NULL*/)
@@ -6448,6 +6538,26 @@ namespace Legion {
       }
     }
 
+    //--------------------------------------------------------------------------
+    DynamicTrace* PointTask::find_memoizing_trace(unsigned &trace_index,
+                                                  bool &recording)
+    //--------------------------------------------------------------------------
+    {
+      // Point tasks are memoized as part of their index space launch
+      if (slice_owner->is_remote())
+        return NULL;
+      IndexTask *owner = slice_owner->index_owner;
+      LegionTrace *owner_trace = owner->get_trace();
+      if ((owner_trace == NULL) || !owner_trace->is_dynamic_trace())
+        return NULL;
+      DynamicTrace *dynamic_trace = owner_trace->as_dynamic_trace();
+      if (!dynamic_trace->is_memoizing())
+        return NULL;
+      trace_index = owner->get_trace_local_id();
+      recording = owner->is_tracing();
+      return dynamic_trace;
+    }
+
     //--------------------------------------------------------------------------
     void PointTask::handle_misspeculation(void)
     //--------------------------------------------------------------------------
@@ -416,6 +416,11 @@ namespace Legion {
       void map_all_regions(ApEvent user_event,
                            MustEpochOp *must_epoch_owner = NULL); 
       void perform_post_mapping(void);
+    protected:
+      // Support for replaying memoized mappings from a trace
+      virtual DynamicTrace* find_memoizing_trace(unsigned &trace_index,
+                                                 bool &recording);
+      bool acquire_memoized_instances(const Mapper::MapTaskOutput &output);
     protected:
       void pack_single_task(Serializer &rez, AddressSpaceID target);
       void unpack_single_task(Deserializer &derez, 
@@ -763,6 +768,9 @@ namespace Legion {
                                  size_t res_size, bool owned);
       virtual void handle_post_mapped(RtEvent pre = RtEvent::NO_RT_EVENT);
       virtual void handle_misspeculation(void);
+    protected:
+      virtual DynamicTrace* find_memoizing_trace(unsigned &trace_index,
+                                                 bool &recording);
     public:
       // ProjectionPoint methods
       virtual const DomainPoint& get_domain_point(void) const;
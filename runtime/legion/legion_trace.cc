@@ -362,15 +362,17 @@ namespace Legion {
     /////////////////////////////////////////////////////////////
 
     //--------------------------------------------------------------------------
-    DynamicTrace::DynamicTrace(TraceID t, TaskContext *c)
-      : LegionTrace(c), tid(t), fixed(false), tracing(true)
+    DynamicTrace::DynamicTrace(TraceID t, TaskContext *c, bool m)
+      : LegionTrace(c), tid(t), fixed(false), tracing(true), memoize(m)
     //--------------------------------------------------------------------------
     {
+      if (memoize)
+        memo_lock = Reservation::create_reservation();
     }
 
     //--------------------------------------------------------------------------
     DynamicTrace::DynamicTrace(const DynamicTrace &rhs)
-      : LegionTrace(NULL), tid(0)
+      : LegionTrace(NULL), tid(0), memoize(false)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -381,6 +383,11 @@ namespace Legion {
     DynamicTrace::~DynamicTrace(void)
     //--------------------------------------------------------------------------
     {
+      if (memoize)
+      {
+        memo_lock.destroy_reservation();
+        memo_lock = Reservation::NO_RESERVATION;
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -419,6 +426,61 @@ namespace Legion {
 #endif
     } 
 
+    //--------------------------------------------------------------------------
+    void DynamicTrace::record_task_mapping(unsigned index, 
+                   const DomainPoint &point, const TaskOp *task,
+                   const Mapper::MapTaskOutput &output)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(memoize);
+#endif
+      MemoizedMapping record;
+      record.task_id = task->task_id;
+      record.regions.resize(task->regions.size());
+      for (unsigned idx = 0; idx < task->regions.size(); idx++)
+        record.regions[idx] = task->regions[idx].region;
+      // Profiling requests are per-launch so we never memoize them
+      record.output.chosen_instances = output.chosen_instances;
+      record.output.target_procs = output.target_procs;
+      record.output.chosen_variant = output.chosen_variant;
+      record.output.task_priority = output.task_priority;
+      record.output.postmap_task = output.postmap_task;
+      AutoLock m_lock(memo_lock);
+      mappings[std::pair<unsigned,DomainPoint>(index, point)] = record;
+    }
+
+    //--------------------------------------------------------------------------
+    bool DynamicTrace::find_task_mapping(unsigned index, 
+         const DomainPoint &point, const TaskOp *task, 
+         Mapper::MapTaskOutput &output)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(memoize);
+#endif
+      AutoLock m_lock(memo_lock,1,false/*exclusive*/);
+      std::map<std::pair<unsigned,DomainPoint>,MemoizedMapping>::const_iterator
+        finder = mappings.find(std::pair<unsigned,DomainPoint>(index, point));
+      // The first execution of the trace may not have mapped this task yet
+      if (finder == mappings.end())
+        return false;
+      // Make sure this is still the same task on the same regions
+      const MemoizedMapping &record = finder->second;
+      if ((record.task_id != task->task_id) ||
+          (record.regions.size() != task->regions.size()))
+        return false;
+      for (unsigned idx = 0; idx < record.regions.size(); idx++)
+        if (record.regions[idx] != task->regions[idx].region)
+          return false;
+      output.chosen_instances = record.output.chosen_instances;
+      output.target_procs = record.output.target_procs;
+      output.chosen_variant = record.output.chosen_variant;
+      output.task_priority = record.output.task_priority;
+      output.postmap_task = record.output.postmap_task;
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     bool DynamicTrace::handles_region_tree(RegionTreeID tid) const
     //--------------------------------------------------------------------------
@@ -449,6 +511,7 @@ namespace Legion {
         {
           operations.push_back(key);
           op_map[key] = index;
+          op->set_trace_local_id(index);
           // Add a new vector for storing dependences onto the back
           dependences.push_back(LegionVector<DependenceRecord>::aligned());
           // Record meta-data about the trace for verifying that
@@ -519,6 +582,7 @@ namespace Legion {
           const LegionVector<DependenceRecord>::aligned &deps = 
                                                           dependences[index];
           operations.push_back(key);
+          op->set_trace_local_id(index);
 #ifdef LEGION_SPY
           current_uids.push_back(op->get_unique_op_id());
           num_regions.push_back(op->get_region_count());
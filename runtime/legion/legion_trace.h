@@ -163,7 +163,9 @@ namespace Legion {
      * \class DynamicTrace
      * This class is used for memoizing the dynamic
      * dependence analysis for series of operations
-     * in a given task's context.
+     * in a given task's context. Memoizing traces also
+     * record the 'map_task' output of each task in the
+     * trace so that replays can skip the mapper calls.
      */
     class DynamicTrace : public LegionTrace,
                          public LegionHeapify<DynamicTrace> {
@@ -178,8 +180,14 @@ namespace Legion {
         Operation::OpKind kind;
         unsigned count;
       }; 
+      struct MemoizedMapping {
+      public:
+        TaskID task_id;
+        std::vector<LogicalRegion> regions;
+        Mapper::MapTaskOutput output;
+      };
     public:
-      DynamicTrace(TraceID tid, TaskContext *ctx);
+      DynamicTrace(TraceID tid, TaskContext *ctx, bool memoize);
       DynamicTrace(const DynamicTrace &rhs);
       virtual ~DynamicTrace(void);
     public:
@@ -196,6 +204,14 @@ namespace Legion {
     public:
       // Called by analysis thread
       void end_trace_capture(void);
+    public:
+      // Support for memoizing the mapping decisions of tasks in the trace
+      inline bool is_memoizing(void) const { return memoize; }
+      void record_task_mapping(unsigned index, const DomainPoint &point,
+                               const TaskOp *task, 
+                               const Mapper::MapTaskOutput &output);
+      bool find_task_mapping(unsigned index, const DomainPoint &point,
+                             const TaskOp *task, Mapper::MapTaskOutput &output);
     public:
       virtual void record_static_dependences(Operation *op,
                           const std::vector<StaticDependence> *dependences);
@@ -241,6 +257,14 @@ namespace Legion {
       const TraceID tid;
       bool fixed;
       bool tracing;
+    protected:
+      // TODO: memoize the physical analysis too - record the copies,
+      // fills, and event graph issued for the trace the first time 
+      // through and replay them directly on Realm, validating the
+      // instances and falling back to the full analysis on a mismatch
+      const bool memoize;
+      Reservation memo_lock;
+      std::map<std::pair<unsigned,DomainPoint>,MemoizedMapping> mappings;
     };
 
     /**
@@ -166,6 +166,7 @@ namespace Legion {
   template<unsigned int MAX> class AVXBitMask;
   template<unsigned int MAX> class AVXTLBitMask;
 #endif
+  template<unsigned int MAX> class DynamicBitMask;
   template<typename T, unsigned LOG2MAX> class BitPermutation;
   template<typename IT, typename DT, bool BIDIR = false> class IntegerSet;
 
@@ -320,6 +321,10 @@ namespace Legion {
       LG_MISSPECULATE_TASK_ID,
       LG_DEFER_PHI_VIEW_REF_TASK_ID,
       LG_DEFER_PHI_VIEW_REGISTRATION_TASK_ID,
+      LG_PROFILER_FLUSH_TASK_ID,
+      LG_PROFILER_SWEEP_TASK_ID,
+      LG_MESSAGE_FLUSH_TASK_ID,
+      LG_REFERENCE_FLUSH_TASK_ID,
       LG_MESSAGE_ID, // These two must be the last two
       LG_RETRY_SHUTDOWN_TASK_ID,
       LG_LAST_TASK_ID, // This one should always be last
@@ -416,6 +421,10 @@ namespace Legion {
         "Handle Mapping Misspeculation",                          \
         "Defer Phi View Reference",                               \
         "Defer Phi View Registration",                            \
+        "Profiler Flush",                                         \
+        "Profiler Latency Sweep",                                 \
+        "Message Flush",                                          \
+        "Reference Flush",                                        \
         "Remote Message",                                         \
         "Retry Shutdown",                                         \
       };
@@ -605,6 +614,7 @@ namespace Legion {
       DISTRIBUTED_CREATE_ADD,
       DISTRIBUTED_CREATE_REMOVE,
       DISTRIBUTED_UNREGISTER,
+      DISTRIBUTED_BATCH_UPDATE,
       SEND_ATOMIC_RESERVATION_REQUEST,
       SEND_ATOMIC_RESERVATION_RESPONSE,
       SEND_BACK_LOGICAL_STATE,
@@ -735,6 +745,7 @@ namespace Legion {
         "Distributed Create Add",                                     \
         "Distributed Create Remove",                                  \
         "Distributed Unregister",                                     \
+        "Distributed Batch Update",                                   \
         "Send Atomic Reservation Request",                            \
         "Send Atomic Reservation Response",                           \
         "Send Back Logical State",                                    \
@@ -1275,6 +1286,7 @@ namespace Legion {
     class LocalReferenceMutator;
     class NeverReferenceMutator;
     class DistributedCollectable;
+    class RemoteReferenceBatcher;
     class LayoutDescription;
     class PhysicalManager; // base class for instance and reduction
     class CopyAcrossHelper;
@@ -1526,53 +1538,15 @@ namespace Legion {
     // Pull some of the mapper types into the internal space
     typedef Mapping::Mapper Mapper;
     typedef Mapping::PhysicalInstance MappingInstance;
-    // A little bit of logic here to figure out the 
-    // kind of bit mask to use for FieldMask
+    // Field masks are sized at start-up (-lg:fields) with MAX_FIELDS
+    // as the default, and keep masks with only a few fields inline
 
-// The folowing macros are used in the FieldMask instantiation of BitMask
-// If you change one you probably have to change the others too
+// The following macros are used for the words of the FieldMask
 #define LEGION_FIELD_MASK_FIELD_TYPE          uint64_t 
-#define LEGION_FIELD_MASK_FIELD_SHIFT         6
-#define LEGION_FIELD_MASK_FIELD_MASK          0x3F
 #define LEGION_FIELD_MASK_FIELD_ALL_ONES      0xFFFFFFFFFFFFFFFF
 
-#if defined(__AVX__)
-#if (MAX_FIELDS > 256)
-    typedef AVXTLBitMask<MAX_FIELDS> FieldMask;
-#elif (MAX_FIELDS > 128)
-    typedef AVXBitMask<MAX_FIELDS> FieldMask;
-#elif (MAX_FIELDS > 64)
-    typedef SSEBitMask<MAX_FIELDS> FieldMask;
-#else
-    typedef BitMask<LEGION_FIELD_MASK_FIELD_TYPE,MAX_FIELDS,
-                    LEGION_FIELD_MASK_FIELD_SHIFT,
-                    LEGION_FIELD_MASK_FIELD_MASK> FieldMask;
-#endif
-#elif defined(__SSE2__)
-#if (MAX_FIELDS > 128)
-    typedef SSETLBitMask<MAX_FIELDS> FieldMask;
-#elif (MAX_FIELDS > 64)
-    typedef SSEBitMask<MAX_FIELDS> FieldMask;
-#else
-    typedef BitMask<LEGION_FIELD_MASK_FIELD_TYPE,MAX_FIELDS,
-                    LEGION_FIELD_MASK_FIELD_SHIFT,
-                    LEGION_FIELD_MASK_FIELD_MASK> FieldMask;
-#endif
-#else
-#if (MAX_FIELDS > 64)
-    typedef TLBitMask<LEGION_FIELD_MASK_FIELD_TYPE,MAX_FIELDS,
-                      LEGION_FIELD_MASK_FIELD_SHIFT,
-                      LEGION_FIELD_MASK_FIELD_MASK> FieldMask;
-#else
-    typedef BitMask<LEGION_FIELD_MASK_FIELD_TYPE,MAX_FIELDS,
-                    LEGION_FIELD_MASK_FIELD_SHIFT,
-                    LEGION_FIELD_MASK_FIELD_MASK> FieldMask;
-#endif
-#endif
-    typedef BitPermutation<FieldMask,LEGION_FIELD_LOG2> FieldPermutation;
+    typedef DynamicBitMask<MAX_FIELDS> FieldMask;
     typedef Fraction<unsigned long> InstFrac;
-#undef LEGION_FIELD_MASK_FIELD_SHIFT
-#undef LEGION_FIELD_MASK_FIELD_MASK
 
     // Similar logic as field masks for node masks
 
@@ -355,9 +355,27 @@ namespace Legion {
     /////////////////////////////////////////////////////////////
     class Serializer {
     public:
-      Serializer(size_t base_bytes = 4096)
-        : total_bytes(base_bytes), buffer((char*)malloc(base_bytes)), 
-          index(0) 
+      // Buffers smaller than this are copied even when they are
+      // passed to serialize_reference or splice
+      static const size_t MIN_REFERENCE_BYTES = 1024;
+      // Each thread keeps a few buffers of the default size around
+      // so that short-lived serializers don't have to call malloc
+      static const size_t SLAB_BYTES = 4096;
+      static const unsigned MAX_CACHED_SLABS = 8;
+    public:
+      // A piece of the message that lives outside our buffer,
+      // inserted at 'offset' bytes into the buffer
+      struct Segment {
+      public:
+        const char *ptr;
+        size_t bytes;
+        size_t offset;
+        bool owned;
+      };
+    public:
+      Serializer(size_t base_bytes = SLAB_BYTES)
+        : total_bytes(base_bytes), buffer(allocate_buffer(base_bytes)), 
+          index(0), segments(NULL), segment_bytes(0), copied_bytes(0)
 #ifdef DEBUG_LEGION
           , context_bytes(0)
 #endif
@@ -370,7 +388,8 @@ namespace Legion {
     public:
       ~Serializer(void)
       {
-        free(buffer);
+        free_segments();
+        free_buffer(buffer, total_bytes);
       }
     public:
       inline Serializer& operator=(const Serializer &rhs);
@@ -394,27 +413,64 @@ namespace Legion {
       template<unsigned int MAX>
       inline void serialize(const AVXTLBitMask<MAX> &mask);
 #endif
+      template<unsigned int MAX>
+      inline void serialize(const DynamicBitMask<MAX> &mask);
       template<typename IT, typename DT, bool BIDIR>
       inline void serialize(const IntegerSet<IT,DT,BIDIR> &index_set);
       inline void serialize(const ColorPoint &point);
       inline void serialize(const Domain &domain);
       inline void serialize(const DomainPoint &dp);
       inline void serialize(const void *src, size_t bytes);
+      // Same as serialize(src, bytes) except that large buffers are
+      // referenced rather than copied, so they must not be modified
+      // or freed until the message has been sent
+      inline void serialize_reference(const void *src, size_t bytes);
+      // Appends everything in rhs and leaves it empty, taking over
+      // its buffer rather than copying it when it is large
+      inline void splice(Serializer &rhs);
     public:
       inline void begin_context(void);
       inline void end_context(void);
     public:
-      inline size_t get_index(void) const { return index; }
-      inline const void* get_buffer(void) const { return buffer; }
+      inline size_t get_index(void) const { return index + segment_bytes; }
+      // Flattens any referenced segments into one contiguous buffer
+      inline const void* get_buffer(void);
       inline size_t get_buffer_size(void) const { return total_bytes; }
-      inline size_t get_used_bytes(void) const { return index; }
+      inline size_t get_used_bytes(void) const 
+        { return index + segment_bytes; }
       inline void* reserve_bytes(size_t size);
+      // The message as a list of contiguous pieces, in order
+      inline bool has_segments(void) const { return (segments != NULL); }
+      inline void get_segments(
+                    std::vector<std::pair<const void*,size_t> > &pieces) const;
+      // Bulk bytes copied so far by serialize(src, bytes), by growing
+      // the buffer, and by flattening
+      inline size_t get_copied_bytes(void) const { return copied_bytes; }
+    private:
+      struct SlabCache {
+      public:
+        char *slabs[MAX_CACHED_SLABS];
+        unsigned count;
+      };
+      static inline SlabCache& get_slab_cache(void)
+      {
+        static __thread SlabCache cache;
+        return cache;
+      }
     private:
       inline void resize(void);
+      inline void free_segments(void);
+      inline void add_segment(const void *ptr, size_t bytes, bool owned);
+      static inline char* allocate_buffer(size_t bytes);
+      static inline void free_buffer(char *ptr, size_t bytes);
     private:
       size_t total_bytes;
       char *buffer;
       size_t index;
+      // Only allocated if we reference any external buffers
+      std::vector<Segment> *segments;
+      size_t segment_bytes;
+      size_t copied_bytes;
 #ifdef DEBUG_LEGION
       size_t context_bytes;
 #endif
@@ -467,6 +523,8 @@ namespace Legion {
       template<unsigned int MAX>
       inline void deserialize(AVXTLBitMask<MAX> &mask);
 #endif
+      template<unsigned int MAX>
+      inline void deserialize(DynamicBitMask<MAX> &mask);
       template<typename IT, typename DT, bool BIDIR>
       inline void deserialize(IntegerSet<IT,DT,BIDIR> &index_set);
       inline void deserialize(ColorPoint &color);
@@ -524,7 +582,47 @@ namespace Legion {
     };
 
     /////////////////////////////////////////////////////////////
-    // Fraction 
+    // Deferred Flush
+    /////////////////////////////////////////////////////////////
+    /*
+     * Tracks a batch of messages whose flush is being held back
+     * so that later messages can join it.  The batch is held until
+     * 'delay' nanoseconds after the first flush that was held back,
+     * no matter how many more flushes get folded into it.  Times
+     * are whatever clock the caller uses, they just can't be zero.
+     */
+    class DeferredFlush {
+    public:
+      DeferredFlush(void) : since(0), response(false) { }
+    public:
+      // Returns true if the flush should be held back, false if the
+      // batch has already waited long enough and has to go out now
+      inline bool defer(long long now, long long delay, bool resp)
+        {
+          if (since == 0)
+            since = now;
+          response = response || resp;
+          return ((now - since) < delay);
+        }
+      inline bool is_pending(void) const { return (since != 0); }
+      inline bool has_expired(long long now, long long delay) const
+        { return ((since != 0) && ((now - since) >= delay)); }
+      // Called when the batch is sent, returns whether any of the
+      // deferred flushes were for responses
+      inline bool clear(void)
+        {
+          const bool result = response;
+          since = 0;
+          response = false;
+          return result;
+        }
+    private:
+      long long since;
+      bool response;
+    };
+
+    /////////////////////////////////////////////////////////////
+    // Fraction
     /////////////////////////////////////////////////////////////
     template<typename T>
     class Fraction {
@@ -1107,6 +1205,119 @@ namespace Legion {
       static const int ELEMENT_SIZE = MAX;
     };
 
+    /////////////////////////////////////////////////////////////
+    // Dynamic Bit Mask 
+    /////////////////////////////////////////////////////////////
+    /*
+     * This is a bit mask whose width is picked at start-up
+     * with set_max_bits instead of at compile time (MAX is only
+     * the default width).  A mask with at most SPARSE_MAX bits
+     * set stores the sorted indexes of those bits inline in the
+     * same 16 bytes that otherwise hold a pointer to the dense
+     * words, so the common case of a few fields never touches
+     * the heap.  Dense masks operate on all their words at once
+     * with SSE/AVX when they are available.  Every mask is kept
+     * in its canonical form (dense if and only if more than
+     * SPARSE_MAX bits are set) so comparisons can start with
+     * the form and empty tests never have to look at the words.
+     */
+    template<unsigned int MAX>
+    class DynamicBitMask : 
+      public Internal::LegionHeapify<DynamicBitMask<MAX> > {
+    public:
+      static const int SPARSE_MAX = 7;
+      static const uint16_t DENSE_CNT = 0xFFFF;
+      // Sparse indexes have to fit in 16 bits
+      static const unsigned MAX_BITS_LIMIT = (1U << 16);
+    public:
+      explicit DynamicBitMask(uint64_t init = 0);
+      DynamicBitMask(const DynamicBitMask &rhs);
+      ~DynamicBitMask(void);
+    public:
+      // Must be called before any masks are made and be the same
+      // on every node since masks are serialized at this width
+      static inline void set_max_bits(unsigned max_bits);
+      static inline unsigned get_max_bits(void);
+    public:
+      inline void set_bit(unsigned bit);
+      inline void unset_bit(unsigned bit);
+      inline void assign_bit(unsigned bit, bool val);
+      inline bool is_set(unsigned bit) const;
+      inline int find_first_set(void) const;
+      inline int find_index_set(int index) const;
+      inline int find_next_set(int start) const;
+      inline void clear(void);
+      inline bool is_dense(void) const;
+    public:
+      inline bool operator==(const DynamicBitMask &rhs) const;
+      inline bool operator<(const DynamicBitMask &rhs) const;
+      inline bool operator!=(const DynamicBitMask &rhs) const;
+    public:
+      inline DynamicBitMask& operator=(const DynamicBitMask &rhs);
+    public:
+      inline DynamicBitMask operator~(void) const;
+      inline DynamicBitMask operator|(const DynamicBitMask &rhs) const;
+      inline DynamicBitMask operator&(const DynamicBitMask &rhs) const;
+      inline DynamicBitMask operator^(const DynamicBitMask &rhs) const;
+    public:
+      inline DynamicBitMask& operator|=(const DynamicBitMask &rhs);
+      inline DynamicBitMask& operator&=(const DynamicBitMask &rhs);
+      inline DynamicBitMask& operator^=(const DynamicBitMask &rhs);
+    public:
+      // Use * for disjointness testing
+      inline bool operator*(const DynamicBitMask &rhs) const;
+      // Set difference
+      inline DynamicBitMask operator-(const DynamicBitMask &rhs) const;
+      inline DynamicBitMask& operator-=(const DynamicBitMask &rhs);
+      // Test to see if everything is zeros
+      inline bool operator!(void) const;
+    public:
+      inline DynamicBitMask operator<<(unsigned shift) const;
+      inline DynamicBitMask operator>>(unsigned shift) const;
+    public:
+      inline DynamicBitMask& operator<<=(unsigned shift);
+      inline DynamicBitMask& operator>>=(unsigned shift);
+    public:
+      inline uint64_t get_hash_key(void) const;
+      inline void serialize(Serializer &rez) const;
+      inline void deserialize(Deserializer &derez);
+    public:
+      // Allocates memory that becomes owned by the caller
+      inline char* to_string(void) const;
+    public:
+      inline int pop_count(void) const;
+      static inline int pop_count(const DynamicBitMask<MAX> &mask);
+    protected:
+      inline int get_count(void) const;
+      inline void set_count(int count);
+      // Switch a sparse mask over to dense words (whatever the count)
+      inline void make_dense(void);
+      // Switch a dense mask back to sparse if few enough bits are set
+      inline void normalize(void);
+      inline void set_sparse(const uint16_t *values, int count);
+      inline void set_dense(const uint16_t *values, int count);
+    protected:
+      static inline uint64_t* allocate_words(void);
+      static inline void free_words(uint64_t *words);
+      static inline void dense_or(uint64_t *dst, const uint64_t *src);
+      static inline void dense_and(uint64_t *dst, const uint64_t *src);
+      static inline void dense_xor(uint64_t *dst, const uint64_t *src);
+      static inline void dense_andnot(uint64_t *dst, const uint64_t *src);
+      static inline bool dense_disjoint(const uint64_t *one, 
+                                        const uint64_t *two);
+      static inline void dense_shift_left(uint64_t *words, unsigned shift);
+      static inline void dense_shift_right(uint64_t *words, unsigned shift);
+    protected:
+      // The last slot holds the count (DENSE_CNT for dense masks)
+      union {
+        uint16_t values[SPARSE_MAX+1];
+        uint64_t *dense;
+      } bits;
+    protected:
+      static unsigned max_bits;
+      static unsigned max_words;
+    };
+
     /////////////////////////////////////////////////////////////
     // Bit Permutation 
     /////////////////////////////////////////////////////////////
@@ -1452,6 +1663,14 @@ namespace Legion {
     }
 #endif
 
+    //--------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void Serializer::serialize(const DynamicBitMask<MAX> &mask)
+    //--------------------------------------------------------------------------
+    {
+      mask.serialize(*this);
+    }
+
     //--------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
     inline void Serializer::serialize(const IntegerSet<IT,DT,BIDIR> &int_set)
@@ -1503,11 +1722,173 @@ namespace Legion {
         resize();
       memcpy(buffer+index,src,bytes);
       index += bytes;
+      copied_bytes += bytes;
+#ifdef DEBUG_LEGION
+      context_bytes += bytes;
+#endif
+    }
+
+    //--------------------------------------------------------------------------
+    inline void Serializer::serialize_reference(const void *src, size_t bytes)
+    //--------------------------------------------------------------------------
+    {
+      if (bytes < MIN_REFERENCE_BYTES)
+      {
+        serialize(src, bytes);
+        return;
+      }
+      add_segment(src, bytes, false/*owned*/);
 #ifdef DEBUG_LEGION
       context_bytes += bytes;
 #endif
     }
 
+    //--------------------------------------------------------------------------
+    inline void Serializer::splice(Serializer &rhs)
+    //--------------------------------------------------------------------------
+    {
+      const size_t bytes = rhs.get_used_bytes();
+      if ((bytes < MIN_REFERENCE_BYTES) || (rhs.segments != NULL))
+      {
+        // Not worth a segment (or rhs has segments of its own, which
+        // we could take over, but nobody nests references that way)
+        serialize(rhs.get_buffer(), bytes);
+      }
+      else
+      {
+        add_segment(rhs.buffer, bytes, true/*owned*/);
+        // Give rhs a fresh buffer in case it gets used again
+        rhs.total_bytes = SLAB_BYTES;
+        rhs.buffer = allocate_buffer(SLAB_BYTES);
+#ifdef DEBUG_LEGION
+        context_bytes += bytes;
+#endif
+      }
+      rhs.index = 0;
+#ifdef DEBUG_LEGION
+      rhs.context_bytes = 0;
+#endif
+    }
+
+    //--------------------------------------------------------------------------
+    inline void Serializer::add_segment(const void *ptr, size_t bytes,
+                                        bool owned)
+    //--------------------------------------------------------------------------
+    {
+      if (segments == NULL)
+        segments = new std::vector<Segment>();
+      segments->resize(segments->size() + 1);
+      Segment &segment = segments->back();
+      segment.ptr = (const char*)ptr;
+      segment.bytes = bytes;
+      segment.offset = index;
+      segment.owned = owned;
+      segment_bytes += bytes;
+    }
+
+    //--------------------------------------------------------------------------
+    inline void Serializer::get_segments(
+                     std::vector<std::pair<const void*,size_t> > &pieces) const
+    //--------------------------------------------------------------------------
+    {
+      size_t offset = 0;
+      if (segments != NULL)
+      {
+        for (std::vector<Segment>::const_iterator it = segments->begin();
+              it != segments->end(); it++)
+        {
+          if (it->offset > offset)
+            pieces.push_back(std::pair<const void*,size_t>(buffer + offset,
+                                                     it->offset - offset));
+          pieces.push_back(std::pair<const void*,size_t>(it->ptr, it->bytes));
+          offset = it->offset;
+        }
+      }
+      if (index > offset)
+        pieces.push_back(std::pair<const void*,size_t>(buffer + offset,
+                                                       index - offset));
+    }
+
+    //--------------------------------------------------------------------------
+    inline const void* Serializer::get_buffer(void)
+    //--------------------------------------------------------------------------
+    {
+      if (segments == NULL)
+        return buffer;
+      // Somebody needs a contiguous buffer, so copy everything into one
+      const size_t used = index + segment_bytes;
+      size_t new_total = total_bytes;
+      while (new_total < used)
+        new_total *= 2;
+      char *next = allocate_buffer(new_total);
+      size_t offset = 0, next_index = 0;
+      for (std::vector<Segment>::const_iterator it = segments->begin();
+            it != segments->end(); it++)
+      {
+        memcpy(next + next_index, buffer + offset, it->offset - offset);
+        next_index += (it->offset - offset);
+        memcpy(next + next_index, it->ptr, it->bytes);
+        next_index += it->bytes;
+        offset = it->offset;
+      }
+      memcpy(next + next_index, buffer + offset, index - offset);
+      copied_bytes += used;
+      free_segments();
+      free_buffer(buffer, total_bytes);
+      buffer = next;
+      total_bytes = new_total;
+      index = used;
+      return buffer;
+    }
+
+    //--------------------------------------------------------------------------
+    inline void Serializer::free_segments(void)
+    //--------------------------------------------------------------------------
+    {
+      if (segments == NULL)
+        return;
+      for (std::vector<Segment>::const_iterator it = segments->begin();
+            it != segments->end(); it++)
+        if (it->owned)
+          free(const_cast<char*>(it->ptr));
+      delete segments;
+      segments = NULL;
+      segment_bytes = 0;
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ inline char* Serializer::allocate_buffer(size_t bytes)
+    //--------------------------------------------------------------------------
+    {
+      if (bytes == SLAB_BYTES)
+      {
+        SlabCache &cache = get_slab_cache();
+        if (cache.count > 0)
+          return cache.slabs[--cache.count];
+      }
+      char *result = (char*)malloc(bytes);
+#ifdef DEBUG_LEGION
+      assert(result != NULL);
+#endif
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ inline void Serializer::free_buffer(char *ptr, size_t bytes)
+    //--------------------------------------------------------------------------
+    {
+      if (bytes == SLAB_BYTES)
+      {
+        SlabCache &cache = get_slab_cache();
+        if (cache.count < MAX_CACHED_SLABS)
+        {
+          cache.slabs[cache.count++] = ptr;
+          return;
+        }
+      }
+      free(ptr);
+    }
+
     //--------------------------------------------------------------------------
     inline void Serializer::begin_context(void)
     //--------------------------------------------------------------------------
@@ -1563,6 +1944,7 @@ namespace Legion {
       assert(next != NULL);
 #endif
       buffer = next;
+      copied_bytes += index;
     }
 
     //--------------------------------------------------------------------------
@@ -1658,6 +2040,14 @@ namespace Legion {
     }
 #endif
 
+    //--------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void Deserializer::deserialize(DynamicBitMask<MAX> &mask)
+    //--------------------------------------------------------------------------
+    {
+      mask.deserialize(*this);
+    }
+
     //--------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
     inline void Deserializer::deserialize(IntegerSet<IT,DT,BIDIR> &int_set)
@@ -7950,6 +8340,1110 @@ namespace Legion {
       return count;
     }
 
+    // Until set_max_bits is called we use MAX rounded up to whole words
+    template<unsigned int MAX>
+    /*static*/ unsigned DynamicBitMask<MAX>::max_bits = ((MAX + 63) / 64) * 64;
+    template<unsigned int MAX>
+    /*static*/ unsigned DynamicBitMask<MAX>::max_words = (MAX + 63) / 64;
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    DynamicBitMask<MAX>::DynamicBitMask(uint64_t init /*= 0*/)
+    //-------------------------------------------------------------------------
+    {
+      if (init == 0)
+      {
+        set_count(0);
+      }
+      else
+      {
+        bits.dense = allocate_words();
+        set_count(DENSE_CNT);
+        for (unsigned idx = 0; idx < max_words; idx++)
+          bits.dense[idx] = init;
+        normalize();
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    DynamicBitMask<MAX>::DynamicBitMask(const DynamicBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      if (rhs.get_count() == DENSE_CNT)
+      {
+        bits.dense = allocate_words();
+        set_count(DENSE_CNT);
+        memcpy(bits.dense, rhs.bits.dense, max_words * sizeof(uint64_t));
+      }
+      else
+        bits = rhs.bits;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    DynamicBitMask<MAX>::~DynamicBitMask(void)
+    //-------------------------------------------------------------------------
+    {
+      if (get_count() == DENSE_CNT)
+        free_words(bits.dense);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline void DynamicBitMask<MAX>::set_max_bits(unsigned max)
+    //-------------------------------------------------------------------------
+    {
+      // Always use whole words
+      if (max < 64)
+        max = 64;
+      max = (max + 63) & ~63U;
+      assert(max <= MAX_BITS_LIMIT);
+      max_bits = max;
+      max_words = max >> 6;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline unsigned DynamicBitMask<MAX>::get_max_bits(void)
+    //-------------------------------------------------------------------------
+    {
+      return max_bits;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void DynamicBitMask<MAX>::set_bit(unsigned bit)
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(bit < max_bits);
+#endif
+      const int count = get_count();
+      if (count == DENSE_CNT)
+      {
+        bits.dense[bit >> 6] |= (1ULL << (bit & 0x3F));
+        return;
+      }
+      int idx = 0;
+      while ((idx < count) && (bits.values[idx] < bit))
+        idx++;
+      if ((idx < count) && (bits.values[idx] == bit))
+        return;
+      if (count < SPARSE_MAX)
+      {
+        for (int i = count; i > idx; i--)
+          bits.values[i] = bits.values[i-1];
+        bits.values[idx] = bit;
+        set_count(count+1);
+      }
+      else
+      {
+        make_dense();
+        bits.dense[bit >> 6] |= (1ULL << (bit & 0x3F));
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void DynamicBitMask<MAX>::unset_bit(unsigned bit)
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(bit < max_bits);
+#endif
+      const int count = get_count();
+      if (count == DENSE_CNT)
+      {
+        bits.dense[bit >> 6] &= ~(1ULL << (bit & 0x3F));
+        normalize();
+        return;
+      }
+      for (int idx = 0; idx < count; idx++)
+      {
+        if (bits.values[idx] == bit)
+        {
+          for (int i = idx+1; i < count; i++)
+            bits.values[i-1] = bits.values[i];
+          set_count(count-1);
+          return;
+        }
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void DynamicBitMask<MAX>::assign_bit(unsigned bit, bool val)
+    //-------------------------------------------------------------------------
+    {
+      if (val)
+        set_bit(bit);
+      else
+        unset_bit(bit);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool DynamicBitMask<MAX>::is_set(unsigned bit) const
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(bit < max_bits);
+#endif
+      const int count = get_count();
+      if (count == DENSE_CNT)
+        return (bits.dense[bit >> 6] & (1ULL << (bit & 0x3F)));
+      for (int idx = 0; idx < count; idx++)
+      {
+        if (bits.values[idx] >= bit)
+          return (bits.values[idx] == bit);
+      }
+      return false;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline int DynamicBitMask<MAX>::find_first_set(void) const
+    //-------------------------------------------------------------------------
+    {
+      return find_next_set(0);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline int DynamicBitMask<MAX>::find_index_set(int index) const
+    //-------------------------------------------------------------------------
+    {
+      if (index < 0)
+        return -1;
+      const int count = get_count();
+      if (count != DENSE_CNT)
+        return ((index < count) ? int(bits.values[index]) : -1);
+      for (unsigned idx = 0; idx < max_words; idx++)
+      {
+        uint64_t word = bits.dense[idx];
+        const int local = __builtin_popcountll(word);
+        if (index < local)
+        {
+          // Drop the lower set bits until we get to the one we want
+          for ( ; index > 0; index--)
+            word &= (word - 1);
+          return (idx * 64 + __builtin_ctzll(word));
+        }
+        index -= local;
+      }
+      return -1;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline int DynamicBitMask<MAX>::find_next_set(int start) const
+    //-------------------------------------------------------------------------
+    {
+      if (start < 0)
+        start = 0;
+      const int count = get_count();
+      if (count != DENSE_CNT)
+      {
+        for (int idx = 0; idx < count; idx++)
+          if (bits.values[idx] >= start)
+            return bits.values[idx];
+        return -1;
+      }
+      if (unsigned(start) >= max_bits)
+        return -1;
+      unsigned idx = start >> 6;
+      uint64_t word = bits.dense[idx] & (~0ULL << (start & 0x3F));
+      while (word == 0)
+      {
+        if (++idx == max_words)
+          return -1;
+        word = bits.dense[idx];
+      }
+      return (idx * 64 + __builtin_ctzll(word));
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void DynamicBitMask<MAX>::clear(void)
+    //-------------------------------------------------------------------------
+    {
+      if (get_count() == DENSE_CNT)
+        free_words(bits.dense);
+      set_count(0);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool DynamicBitMask<MAX>::is_dense(void) const
+    //-------------------------------------------------------------------------
+    {
+      return (get_count() == DENSE_CNT);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool DynamicBitMask<MAX>::operator==(
+                                               const DynamicBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      // Masks are canonical so different forms are different masks
+      const int count = get_count();
+      if (count != rhs.get_count())
+        return false;
+      if (count == DENSE_CNT)
+        return (memcmp(bits.dense, rhs.bits.dense, 
+                       max_words * sizeof(uint64_t)) == 0);
+      for (int idx = 0; idx < count; idx++)
+        if (bits.values[idx] != rhs.bits.values[idx])
+          return false;
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool DynamicBitMask<MAX>::operator<(const DynamicBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      const int count = get_count();
+      const int rhs_count = rhs.get_count();
+      if (count != rhs_count)
+        return (count < rhs_count);
+      if (count == DENSE_CNT)
+      {
+        for (unsigned idx = 0; idx < max_words; idx++)
+          if (bits.dense[idx] != rhs.bits.dense[idx])
+            return (bits.dense[idx] < rhs.bits.dense[idx]);
+        return false;
+      }
+      for (int idx = 0; idx < count; idx++)
+        if (bits.values[idx] != rhs.bits.values[idx])
+          return (bits.values[idx] < rhs.bits.values[idx]);
+      return false;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool DynamicBitMask<MAX>::operator!=(
+                                               const DynamicBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      return !(*this == rhs);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX>& DynamicBitMask<MAX>::operator=(
+                                                     const DynamicBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      if (this == &rhs)
+        return *this;
+      if (rhs.get_count() == DENSE_CNT)
+      {
+        // Reuse our words if we already have them
+        if (get_count() != DENSE_CNT)
+        {
+          bits.dense = allocate_words();
+          set_count(DENSE_CNT);
+        }
+        memcpy(bits.dense, rhs.bits.dense, max_words * sizeof(uint64_t));
+      }
+      else
+      {
+        if (get_count() == DENSE_CNT)
+          free_words(bits.dense);
+        bits = rhs.bits;
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX> DynamicBitMask<MAX>::operator~(void) const
+    //-------------------------------------------------------------------------
+    {
+      DynamicBitMask<MAX> result;
+      uint64_t *words = allocate_words();
+      const int count = get_count();
+      if (count == DENSE_CNT)
+      {
+        for (unsigned idx = 0; idx < max_words; idx++)
+          words[idx] = ~bits.dense[idx];
+      }
+      else
+      {
+        for (unsigned idx = 0; idx < max_words; idx++)
+          words[idx] = ~0ULL;
+        for (int idx = 0; idx < count; idx++)
+          words[bits.values[idx] >> 6] &= ~(1ULL << (bits.values[idx] & 0x3F));
+      }
+      result.bits.dense = words;
+      result.set_count(DENSE_CNT);
+      result.normalize();
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX> DynamicBitMask<MAX>::operator|(
+                                               const DynamicBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      DynamicBitMask<MAX> result(*this);
+      result |= rhs;
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX> DynamicBitMask<MAX>::operator&(
+                                               const DynamicBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      // Start from the sparse side if there is one so we never copy words
+      if (get_count() == DENSE_CNT)
+      {
+        DynamicBitMask<MAX> result(rhs);
+        result &= *this;
+        return result;
+      }
+      DynamicBitMask<MAX> result(*this);
+      result &= rhs;
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX> DynamicBitMask<MAX>::operator^(
+                                               const DynamicBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      DynamicBitMask<MAX> result(*this);
+      result ^= rhs;
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX>& DynamicBitMask<MAX>::operator|=(
+                                                     const DynamicBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      const int count = get_count();
+      const int rhs_count = rhs.get_count();
+      if (rhs_count == DENSE_CNT)
+      {
+        if (count == DENSE_CNT)
+          dense_or(bits.dense, rhs.bits.dense);
+        else
+        {
+          // Start from a copy of their words and add in our bits
+          uint16_t values[SPARSE_MAX];
+          for (int idx = 0; idx < count; idx++)
+            values[idx] = bits.values[idx];
+          bits.dense = allocate_words();
+          set_count(DENSE_CNT);
+          memcpy(bits.dense, rhs.bits.dense, max_words * sizeof(uint64_t));
+          for (int idx = 0; idx < count; idx++)
+            bits.dense[values[idx] >> 6] |= (1ULL << (values[idx] & 0x3F));
+        }
+      }
+      else if (count == DENSE_CNT)
+      {
+        for (int idx = 0; idx < rhs_count; idx++)
+          bits.dense[rhs.bits.values[idx] >> 6] |= 
+            (1ULL << (rhs.bits.values[idx] & 0x3F));
+      }
+      else
+      {
+        // Merge the two sorted lists
+        uint16_t merged[2*SPARSE_MAX];
+        int total = 0, i = 0, j = 0;
+        while ((i < count) && (j < rhs_count))
+        {
+          if (bits.values[i] < rhs.bits.values[j])
+            merged[total++] = bits.values[i++];
+          else if (rhs.bits.values[j] < bits.values[i])
+            merged[total++] = rhs.bits.values[j++];
+          else
+          {
+            merged[total++] = bits.values[i++];
+            j++;
+          }
+        }
+        while (i < count)
+          merged[total++] = bits.values[i++];
+        while (j < rhs_count)
+          merged[total++] = rhs.bits.values[j++];
+        if (total <= SPARSE_MAX)
+          set_sparse(merged, total);
+        else
+          set_dense(merged, total);
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX>& DynamicBitMask<MAX>::operator&=(
+                                                     const DynamicBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      const int count = get_count();
+      const int rhs_count = rhs.get_count();
+      if (count == DENSE_CNT)
+      {
+        if (rhs_count == DENSE_CNT)
+        {
+          dense_and(bits.dense, rhs.bits.dense);
+          normalize();
+        }
+        else
+        {
+          // The result is whichever of their bits we have set
+          uint16_t values[SPARSE_MAX];
+          int total = 0;
+          for (int idx = 0; idx < rhs_count; idx++)
+          {
+            const uint16_t bit = rhs.bits.values[idx];
+            if (bits.dense[bit >> 6] & (1ULL << (bit & 0x3F)))
+              values[total++] = bit;
+          }
+          free_words(bits.dense);
+          set_sparse(values, total);
+        }
+      }
+      else
+      {
+        int total = 0;
+        for (int idx = 0; idx < count; idx++)
+          if (rhs.is_set(bits.values[idx]))
+            bits.values[total++] = bits.values[idx];
+        set_count(total);
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX>& DynamicBitMask<MAX>::operator^=(
+                                                     const DynamicBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      const int count = get_count();
+      const int rhs_count = rhs.get_count();
+      if (count == DENSE_CNT)
+      {
+        if (rhs_count == DENSE_CNT)
+          dense_xor(bits.dense, rhs.bits.dense);
+        else
+        {
+          for (int idx = 0; idx < rhs_count; idx++)
+            bits.dense[rhs.bits.values[idx] >> 6] ^= 
+              (1ULL << (rhs.bits.values[idx] & 0x3F));
+        }
+        normalize();
+      }
+      else if (rhs_count == DENSE_CNT)
+      {
+        uint16_t values[SPARSE_MAX];
+        for (int idx = 0; idx < count; idx++)
+          values[idx] = bits.values[idx];
+        bits.dense = allocate_words();
+        set_count(DENSE_CNT);
+        memcpy(bits.dense, rhs.bits.dense, max_words * sizeof(uint64_t));
+        for (int idx = 0; idx < count; idx++)
+          bits.dense[values[idx] >> 6] ^= (1ULL << (values[idx] & 0x3F));
+        normalize();
+      }
+      else
+      {
+        // Merge the two sorted lists dropping anything in both
+        uint16_t merged[2*SPARSE_MAX];
+        int total = 0, i = 0, j = 0;
+        while ((i < count) && (j < rhs_count))
+        {
+          if (bits.values[i] < rhs.bits.values[j])
+            merged[total++] = bits.values[i++];
+          else if (rhs.bits.values[j] < bits.values[i])
+            merged[total++] = rhs.bits.values[j++];
+          else
+          {
+            i++;
+            j++;
+          }
+        }
+        while (i < count)
+          merged[total++] = bits.values[i++];
+        while (j < rhs_count)
+          merged[total++] = rhs.bits.values[j++];
+        if (total <= SPARSE_MAX)
+          set_sparse(merged, total);
+        else
+          set_dense(merged, total);
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool DynamicBitMask<MAX>::operator*(const DynamicBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      const int count = get_count();
+      if (count != DENSE_CNT)
+      {
+        for (int idx = 0; idx < count; idx++)
+          if (rhs.is_set(bits.values[idx]))
+            return false;
+        return true;
+      }
+      const int rhs_count = rhs.get_count();
+      if (rhs_count != DENSE_CNT)
+      {
+        for (int idx = 0; idx < rhs_count; idx++)
+          if (is_set(rhs.bits.values[idx]))
+            return false;
+        return true;
+      }
+      return dense_disjoint(bits.dense, rhs.bits.dense);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX> DynamicBitMask<MAX>::operator-(
+                                               const DynamicBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      DynamicBitMask<MAX> result(*this);
+      result -= rhs;
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX>& DynamicBitMask<MAX>::operator-=(
+                                                     const DynamicBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      const int count = get_count();
+      const int rhs_count = rhs.get_count();
+      if (count == DENSE_CNT)
+      {
+        if (rhs_count == DENSE_CNT)
+          dense_andnot(bits.dense, rhs.bits.dense);
+        else
+        {
+          for (int idx = 0; idx < rhs_count; idx++)
+            bits.dense[rhs.bits.values[idx] >> 6] &= 
+              ~(1ULL << (rhs.bits.values[idx] & 0x3F));
+        }
+        normalize();
+      }
+      else
+      {
+        int total = 0;
+        for (int idx = 0; idx < count; idx++)
+          if (!rhs.is_set(bits.values[idx]))
+            bits.values[total++] = bits.values[idx];
+        set_count(total);
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool DynamicBitMask<MAX>::operator!(void) const
+    //-------------------------------------------------------------------------
+    {
+      // Dense masks always have bits set
+      return (get_count() == 0);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX> DynamicBitMask<MAX>::operator<<(
+                                                         unsigned shift) const
+    //-------------------------------------------------------------------------
+    {
+      DynamicBitMask<MAX> result(*this);
+      result <<= shift;
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX> DynamicBitMask<MAX>::operator>>(
+                                                         unsigned shift) const
+    //-------------------------------------------------------------------------
+    {
+      DynamicBitMask<MAX> result(*this);
+      result >>= shift;
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX>& DynamicBitMask<MAX>::operator<<=(
+                                                                unsigned shift)
+    //-------------------------------------------------------------------------
+    {
+      const int count = get_count();
+      if (count == DENSE_CNT)
+      {
+        dense_shift_left(bits.dense, shift);
+        normalize();
+      }
+      else if (shift >= max_bits)
+        set_count(0);
+      else
+      {
+        // Values are sorted so once one falls off the end they all do
+        int total = 0;
+        while ((total < count) && ((bits.values[total] + shift) < max_bits))
+        {
+          bits.values[total] += shift;
+          total++;
+        }
+        set_count(total);
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline DynamicBitMask<MAX>& DynamicBitMask<MAX>::operator>>=(
+                                                                unsigned shift)
+    //-------------------------------------------------------------------------
+    {
+      const int count = get_count();
+      if (count == DENSE_CNT)
+      {
+        dense_shift_right(bits.dense, shift);
+        normalize();
+      }
+      else
+      {
+        int total = 0;
+        for (int idx = 0; idx < count; idx++)
+          if (bits.values[idx] >= shift)
+            bits.values[total++] = bits.values[idx] - shift;
+        set_count(total);
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline uint64_t DynamicBitMask<MAX>::get_hash_key(void) const
+    //-------------------------------------------------------------------------
+    {
+      uint64_t result = 0;
+      const int count = get_count();
+      if (count == DENSE_CNT)
+      {
+        for (unsigned idx = 0; idx < max_words; idx++)
+          result |= bits.dense[idx];
+      }
+      else
+      {
+        for (int idx = 0; idx < count; idx++)
+          result |= (1ULL << (bits.values[idx] & 0x3F));
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void DynamicBitMask<MAX>::serialize(Serializer &rez) const
+    //-------------------------------------------------------------------------
+    {
+      const uint16_t count = get_count();
+      rez.serialize(count);
+      if (count == DENSE_CNT)
+        rez.serialize(bits.dense, max_words * sizeof(uint64_t));
+      else
+        rez.serialize(bits.values, count * sizeof(uint16_t));
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void DynamicBitMask<MAX>::deserialize(Deserializer &derez)
+    //-------------------------------------------------------------------------
+    {
+      uint16_t count;
+      derez.deserialize(count);
+      if (count == DENSE_CNT)
+      {
+        if (get_count() != DENSE_CNT)
+        {
+          bits.dense = allocate_words();
+          set_count(DENSE_CNT);
+        }
+        derez.deserialize(bits.dense, max_words * sizeof(uint64_t));
+      }
+      else
+      {
+        if (get_count() == DENSE_CNT)
+          free_words(bits.dense);
+        derez.deserialize(bits.values, count * sizeof(uint16_t));
+        set_count(count);
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline char* DynamicBitMask<MAX>::to_string(void) const
+    //-------------------------------------------------------------------------
+    {
+      const int count = get_count();
+      if (count == DENSE_CNT)
+        return BitMaskHelper::to_string(bits.dense, max_bits);
+      uint64_t *words = allocate_words();
+      memset(words, 0, max_words * sizeof(uint64_t));
+      for (int idx = 0; idx < count; idx++)
+        words[bits.values[idx] >> 6] |= (1ULL << (bits.values[idx] & 0x3F));
+      char *result = BitMaskHelper::to_string(words, max_bits);
+      free_words(words);
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline int DynamicBitMask<MAX>::pop_count(void) const
+    //-------------------------------------------------------------------------
+    {
+      const int count = get_count();
+      if (count != DENSE_CNT)
+        return count;
+      int result = 0;
+      for (unsigned idx = 0; idx < max_words; idx++)
+        result += __builtin_popcountll(bits.dense[idx]);
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline int DynamicBitMask<MAX>::pop_count(
+                                                const DynamicBitMask<MAX> &mask)
+    //-------------------------------------------------------------------------
+    {
+      return mask.pop_count();
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline int DynamicBitMask<MAX>::get_count(void) const
+    //-------------------------------------------------------------------------
+    {
+      return bits.values[SPARSE_MAX];
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void DynamicBitMask<MAX>::set_count(int count)
+    //-------------------------------------------------------------------------
+    {
+      bits.values[SPARSE_MAX] = count;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void DynamicBitMask<MAX>::make_dense(void)
+    //-------------------------------------------------------------------------
+    {
+      // The words are going to overwrite our values so copy them out
+      uint16_t values[SPARSE_MAX];
+      const int count = get_count();
+#ifdef DEBUG_LEGION
+      assert(count != DENSE_CNT);
+#endif
+      for (int idx = 0; idx < count; idx++)
+        values[idx] = bits.values[idx];
+      set_dense(values, count);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void DynamicBitMask<MAX>::normalize(void)
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(get_count() == DENSE_CNT);
+#endif
+      // Stop counting as soon as we know we have to stay dense
+      int total = 0;
+      for (unsigned idx = 0; idx < max_words; idx++)
+      {
+        total += __builtin_popcountll(bits.dense[idx]);
+        if (total > SPARSE_MAX)
+          return;
+      }
+      uint64_t *words = bits.dense;
+      total = 0;
+      for (unsigned idx = 0; idx < max_words; idx++)
+      {
+        uint64_t word = words[idx];
+        while (word != 0)
+        {
+          bits.values[total++] = idx * 64 + __builtin_ctzll(word);
+          word &= (word - 1);
+        }
+      }
+      set_count(total);
+      free_words(words);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void DynamicBitMask<MAX>::set_sparse(const uint16_t *values,
+                                                int count)
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(count <= SPARSE_MAX);
+#endif
+      for (int idx = 0; idx < count; idx++)
+        bits.values[idx] = values[idx];
+      set_count(count);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void DynamicBitMask<MAX>::set_dense(const uint16_t *values,
+                                               int count)
+    //-------------------------------------------------------------------------
+    {
+      uint64_t *words = allocate_words();
+      memset(words, 0, max_words * sizeof(uint64_t));
+      for (int idx = 0; idx < count; idx++)
+        words[values[idx] >> 6] |= (1ULL << (values[idx] & 0x3F));
+      bits.dense = words;
+      set_count(DENSE_CNT);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline uint64_t* DynamicBitMask<MAX>::allocate_words(void)
+    //-------------------------------------------------------------------------
+    {
+      // Round up to whole AVX vectors so we can align to them
+      const size_t bytes = ((max_words + 3) & ~3U) * sizeof(uint64_t);
+      uint64_t *result = (uint64_t*)
+        Internal::legion_alloc_aligned<32,32,true/*bytes*/>(bytes);
+#ifdef DEBUG_LEGION
+      assert(result != NULL);
+#endif
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline void DynamicBitMask<MAX>::free_words(uint64_t *words)
+    //-------------------------------------------------------------------------
+    {
+      free(words);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline void DynamicBitMask<MAX>::dense_or(uint64_t *dst,
+                                                         const uint64_t *src)
+    //-------------------------------------------------------------------------
+    {
+      unsigned idx = 0;
+#ifdef __AVX2__
+      for ( ; (idx + 4) <= max_words; idx += 4)
+      {
+        __m256i a = _mm256_load_si256((const __m256i*)(dst + idx));
+        __m256i b = _mm256_load_si256((const __m256i*)(src + idx));
+        _mm256_store_si256((__m256i*)(dst + idx), _mm256_or_si256(a, b));
+      }
+#endif
+#ifdef __SSE2__
+      for ( ; (idx + 2) <= max_words; idx += 2)
+      {
+        __m128i a = _mm_load_si128((const __m128i*)(dst + idx));
+        __m128i b = _mm_load_si128((const __m128i*)(src + idx));
+        _mm_store_si128((__m128i*)(dst + idx), _mm_or_si128(a, b));
+      }
+#endif
+      for ( ; idx < max_words; idx++)
+        dst[idx] |= src[idx];
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline void DynamicBitMask<MAX>::dense_and(uint64_t *dst,
+                                                          const uint64_t *src)
+    //-------------------------------------------------------------------------
+    {
+      unsigned idx = 0;
+#ifdef __AVX2__
+      for ( ; (idx + 4) <= max_words; idx += 4)
+      {
+        __m256i a = _mm256_load_si256((const __m256i*)(dst + idx));
+        __m256i b = _mm256_load_si256((const __m256i*)(src + idx));
+        _mm256_store_si256((__m256i*)(dst + idx), _mm256_and_si256(a, b));
+      }
+#endif
+#ifdef __SSE2__
+      for ( ; (idx + 2) <= max_words; idx += 2)
+      {
+        __m128i a = _mm_load_si128((const __m128i*)(dst + idx));
+        __m128i b = _mm_load_si128((const __m128i*)(src + idx));
+        _mm_store_si128((__m128i*)(dst + idx), _mm_and_si128(a, b));
+      }
+#endif
+      for ( ; idx < max_words; idx++)
+        dst[idx] &= src[idx];
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline void DynamicBitMask<MAX>::dense_xor(uint64_t *dst,
+                                                          const uint64_t *src)
+    //-------------------------------------------------------------------------
+    {
+      unsigned idx = 0;
+#ifdef __AVX2__
+      for ( ; (idx + 4) <= max_words; idx += 4)
+      {
+        __m256i a = _mm256_load_si256((const __m256i*)(dst + idx));
+        __m256i b = _mm256_load_si256((const __m256i*)(src + idx));
+        _mm256_store_si256((__m256i*)(dst + idx), _mm256_xor_si256(a, b));
+      }
+#endif
+#ifdef __SSE2__
+      for ( ; (idx + 2) <= max_words; idx += 2)
+      {
+        __m128i a = _mm_load_si128((const __m128i*)(dst + idx));
+        __m128i b = _mm_load_si128((const __m128i*)(src + idx));
+        _mm_store_si128((__m128i*)(dst + idx), _mm_xor_si128(a, b));
+      }
+#endif
+      for ( ; idx < max_words; idx++)
+        dst[idx] ^= src[idx];
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline void DynamicBitMask<MAX>::dense_andnot(uint64_t *dst,
+                                                           const uint64_t *src)
+    //-------------------------------------------------------------------------
+    {
+      unsigned idx = 0;
+#ifdef __AVX2__
+      for ( ; (idx + 4) <= max_words; idx += 4)
+      {
+        __m256i a = _mm256_load_si256((const __m256i*)(dst + idx));
+        __m256i b = _mm256_load_si256((const __m256i*)(src + idx));
+        _mm256_store_si256((__m256i*)(dst + idx), _mm256_andnot_si256(b, a));
+      }
+#endif
+#ifdef __SSE2__
+      for ( ; (idx + 2) <= max_words; idx += 2)
+      {
+        __m128i a = _mm_load_si128((const __m128i*)(dst + idx));
+        __m128i b = _mm_load_si128((const __m128i*)(src + idx));
+        _mm_store_si128((__m128i*)(dst + idx), _mm_andnot_si128(b, a));
+      }
+#endif
+      for ( ; idx < max_words; idx++)
+        dst[idx] &= ~src[idx];
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline bool DynamicBitMask<MAX>::dense_disjoint(
+                                      const uint64_t *one, const uint64_t *two)
+    //-------------------------------------------------------------------------
+    {
+      unsigned idx = 0;
+#ifdef __AVX__
+      for ( ; (idx + 4) <= max_words; idx += 4)
+      {
+        __m256i a = _mm256_load_si256((const __m256i*)(one + idx));
+        __m256i b = _mm256_load_si256((const __m256i*)(two + idx));
+        if (!_mm256_testz_si256(a, b))
+          return false;
+      }
+#endif
+#ifdef __SSE4_1__
+      for ( ; (idx + 2) <= max_words; idx += 2)
+      {
+        __m128i a = _mm_load_si128((const __m128i*)(one + idx));
+        __m128i b = _mm_load_si128((const __m128i*)(two + idx));
+        if (!_mm_testz_si128(a, b))
+          return false;
+      }
+#endif
+      for ( ; idx < max_words; idx++)
+        if (one[idx] & two[idx])
+          return false;
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline void DynamicBitMask<MAX>::dense_shift_left(
+                                               uint64_t *words, unsigned shift)
+    //-------------------------------------------------------------------------
+    {
+      if (shift >= max_bits)
+      {
+        memset(words, 0, max_words * sizeof(uint64_t));
+        return;
+      }
+      const unsigned range = shift >> 6;
+      const unsigned local = shift & 0x3F;
+      if (local == 0)
+      {
+        for (unsigned idx = max_words; idx > range; idx--)
+          words[idx-1] = words[idx-1-range];
+      }
+      else
+      {
+        for (unsigned idx = max_words - 1; idx > range; idx--)
+          words[idx] = (words[idx - range] << local) |
+                       (words[idx - range - 1] >> (64 - local));
+        words[range] = words[0] << local;
+      }
+      for (unsigned idx = 0; idx < range; idx++)
+        words[idx] = 0;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline void DynamicBitMask<MAX>::dense_shift_right(
+                                               uint64_t *words, unsigned shift)
+    //-------------------------------------------------------------------------
+    {
+      if (shift >= max_bits)
+      {
+        memset(words, 0, max_words * sizeof(uint64_t));
+        return;
+      }
+      const unsigned range = shift >> 6;
+      const unsigned local = shift & 0x3F;
+      const unsigned last = max_words - 1 - range;
+      if (local == 0)
+      {
+        for (unsigned idx = 0; idx <= last; idx++)
+          words[idx] = words[idx + range];
+      }
+      else
+      {
+        for (unsigned idx = 0; idx < last; idx++)
+          words[idx] = (words[idx + range] >> local) |
+                       (words[idx + range + 1] << (64 - local));
+        words[last] = words[max_words - 1] >> local;
+      }
+      for (unsigned idx = last + 1; idx < max_words; idx++)
+        words[idx] = 0;
+    }
+
     //-------------------------------------------------------------------------
     template<typename BITMASK, unsigned LOG2MAX>
     BitPermutation<BITMASK,LOG2MAX>::BitPermutation(void)
@@ -0,0 +1,325 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __LEGION_ND_RECTANGLE_SET_H__
+#define __LEGION_ND_RECTANGLE_SET_H__
+
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include <cassert>
+
+namespace Legion {
+  namespace Internal {
+
+    /**
+     * \class NDRectangle
+     * A simple axis-aligned box of discrete points with
+     * inclusive lower and upper bounds in each dimension.
+     */
+    template<typename T, int DIM>
+    class NDRectangle {
+    public:
+      inline bool empty(void) const;
+      inline bool overlaps(const NDRectangle<T,DIM> &other) const;
+      inline bool contains(const NDRectangle<T,DIM> &other) const;
+      // Append the pieces of this rectangle not covered by other
+      inline void subtract(const NDRectangle<T,DIM> &other,
+                           std::vector<NDRectangle<T,DIM> > &pieces) const;
+    public:
+      T lo[DIM], hi[DIM];
+    };
+
+    /**
+     * \class NDRectangleSet
+     * A set of rectangles in any number of dimensions, used for the
+     * dominance and disjointness tests on index spaces made of multiple
+     * domains. Rectangles are fragmented as they
+     * are added so that the set always stores disjoint rectangles,
+     * which makes it possible to answer coverage queries exactly
+     * by subtracting stored rectangles from the query. Rectangles
+     * are indexed by their lower bound in the first dimension so
+     * queries only need to look at rectangles that could possibly
+     * overlap along that dimension.
+     */
+    template<typename T, int DIM>
+    class NDRectangleSet {
+    public:
+      typedef NDRectangle<T,DIM> Rect;
+    public:
+      NDRectangleSet(void);
+      NDRectangleSet(const NDRectangleSet &rhs);
+      ~NDRectangleSet(void);
+    public:
+      NDRectangleSet& operator=(const NDRectangleSet &rhs);
+    public:
+      void add_rectangle(const T lo[DIM], const T hi[DIM]);
+      void add_rectangle(const Rect &rect);
+      bool intersects(const T lo[DIM], const T hi[DIM]) const;
+      bool intersects(const Rect &rect) const;
+      bool covers(const T lo[DIM], const T hi[DIM]) const;
+      bool covers(const Rect &rect) const;
+      inline size_t size(void) const { return rectangles.size(); }
+    protected:
+      // Subtract all the stored rectangles from the given pieces
+      // stopping early if there is nothing left
+      void subtract_all(std::vector<Rect> &pieces) const;
+    protected:
+      // Disjoint rectangles keyed by lower bound in the first dimension
+      std::multimap<T,Rect> rectangles;
+      // Largest extent of any stored rectangle in the first dimension
+      T max_extent;
+    };
+
+    /////////////////////////////////////////////////////////////
+    // ND Rectangle
+    /////////////////////////////////////////////////////////////
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    inline bool NDRectangle<T,DIM>::empty(void) const
+    //--------------------------------------------------------------------------
+    {
+      for (int i = 0; i < DIM; i++)
+        if (lo[i] > hi[i])
+          return true;
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    inline bool NDRectangle<T,DIM>::overlaps(
+                                         const NDRectangle<T,DIM> &other) const
+    //--------------------------------------------------------------------------
+    {
+      for (int i = 0; i < DIM; i++)
+        if ((other.hi[i] < lo[i]) || (hi[i] < other.lo[i]))
+          return false;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    inline bool NDRectangle<T,DIM>::contains(
+                                         const NDRectangle<T,DIM> &other) const
+    //--------------------------------------------------------------------------
+    {
+      for (int i = 0; i < DIM; i++)
+        if ((other.lo[i] < lo[i]) || (hi[i] < other.hi[i]))
+          return false;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    inline void NDRectangle<T,DIM>::subtract(const NDRectangle<T,DIM> &other,
+                                std::vector<NDRectangle<T,DIM> > &pieces) const
+    //--------------------------------------------------------------------------
+    {
+      if (!overlaps(other))
+      {
+        pieces.push_back(*this);
+        return;
+      }
+      // Peel off the slabs on either side of other one dimension at a
+      // time, shrinking what is left until it is inside of other
+      NDRectangle<T,DIM> remainder = *this;
+      for (int i = 0; i < DIM; i++)
+      {
+        if (remainder.lo[i] < other.lo[i])
+        {
+          NDRectangle<T,DIM> slab = remainder;
+          slab.hi[i] = other.lo[i] - 1;
+          pieces.push_back(slab);
+          remainder.lo[i] = other.lo[i];
+        }
+        if (other.hi[i] < remainder.hi[i])
+        {
+          NDRectangle<T,DIM> slab = remainder;
+          slab.lo[i] = other.hi[i] + 1;
+          pieces.push_back(slab);
+          remainder.hi[i] = other.hi[i];
+        }
+      }
+    }
+
+    /////////////////////////////////////////////////////////////
+    // ND Rectangle Set
+    /////////////////////////////////////////////////////////////
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    NDRectangleSet<T,DIM>::NDRectangleSet(void)
+      : max_extent(0)
+    //--------------------------------------------------------------------------
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    NDRectangleSet<T,DIM>::NDRectangleSet(const NDRectangleSet &rhs)
+      : rectangles(rhs.rectangles), max_extent(rhs.max_extent)
+    //--------------------------------------------------------------------------
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    NDRectangleSet<T,DIM>::~NDRectangleSet(void)
+    //--------------------------------------------------------------------------
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    NDRectangleSet<T,DIM>& NDRectangleSet<T,DIM>::operator=(
+                                                    const NDRectangleSet &rhs)
+    //--------------------------------------------------------------------------
+    {
+      rectangles = rhs.rectangles;
+      max_extent = rhs.max_extent;
+      return *this;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    void NDRectangleSet<T,DIM>::add_rectangle(const T lo[DIM],
+                                              const T hi[DIM])
+    //--------------------------------------------------------------------------
+    {
+      Rect rect;
+      for (int i = 0; i < DIM; i++)
+      {
+        rect.lo[i] = lo[i];
+        rect.hi[i] = hi[i];
+      }
+      add_rectangle(rect);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    void NDRectangleSet<T,DIM>::add_rectangle(const Rect &rect)
+    //--------------------------------------------------------------------------
+    {
+      if (rect.empty())
+        return;
+      // Only store the parts that aren't already in the set
+      std::vector<Rect> pieces(1, rect);
+      subtract_all(pieces);
+      for (typename std::vector<Rect>::const_iterator it = pieces.begin();
+            it != pieces.end(); it++)
+      {
+        rectangles.insert(std::pair<T,Rect>(it->lo[0], *it));
+        max_extent = std::max(max_extent, T(it->hi[0] - it->lo[0]));
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    bool NDRectangleSet<T,DIM>::intersects(const T lo[DIM],
+                                           const T hi[DIM]) const
+    //--------------------------------------------------------------------------
+    {
+      Rect rect;
+      for (int i = 0; i < DIM; i++)
+      {
+        rect.lo[i] = lo[i];
+        rect.hi[i] = hi[i];
+      }
+      return intersects(rect);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    bool NDRectangleSet<T,DIM>::intersects(const Rect &rect) const
+    //--------------------------------------------------------------------------
+    {
+      if (rect.empty())
+        return false;
+      for (typename std::multimap<T,Rect>::const_iterator it =
+            rectangles.lower_bound(rect.lo[0] - max_extent);
+            (it != rectangles.end()) && (it->first <= rect.hi[0]); it++)
+      {
+        if (it->second.overlaps(rect))
+          return true;
+      }
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    bool NDRectangleSet<T,DIM>::covers(const T lo[DIM], const T hi[DIM]) const
+    //--------------------------------------------------------------------------
+    {
+      Rect rect;
+      for (int i = 0; i < DIM; i++)
+      {
+        rect.lo[i] = lo[i];
+        rect.hi[i] = hi[i];
+      }
+      return covers(rect);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    bool NDRectangleSet<T,DIM>::covers(const Rect &rect) const
+    //--------------------------------------------------------------------------
+    {
+      if (rect.empty())
+        return true;
+      std::vector<Rect> pieces(1, rect);
+      subtract_all(pieces);
+      return pieces.empty();
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T, int DIM>
+    void NDRectangleSet<T,DIM>::subtract_all(std::vector<Rect> &pieces) const
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(pieces.size() == 1);
+#endif
+      const Rect bounds = pieces[0];
+      std::vector<Rect> next;
+      for (typename std::multimap<T,Rect>::const_iterator it =
+            rectangles.lower_bound(bounds.lo[0] - max_extent);
+            (it != rectangles.end()) && (it->first <= bounds.hi[0]); it++)
+      {
+        if (!it->second.overlaps(bounds))
+          continue;
+        if (it->second.contains(bounds))
+        {
+          pieces.clear();
+          return;
+        }
+        next.clear();
+        for (typename std::vector<Rect>::const_iterator pit =
+              pieces.begin(); pit != pieces.end(); pit++)
+          pit->subtract(it->second, next);
+        pieces.swap(next);
+        if (pieces.empty())
+          return;
+      }
+    }
+
+  }; // namespace Internal
+}; // namespace Legion
+
+#endif // __LEGION_ND_RECTANGLE_SET_H__
+
+// EOF
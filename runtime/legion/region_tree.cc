@@ -25,8 +25,11 @@
 #include "legion_instances.h"
 #include "legion_views.h"
 #include "legion_analysis.h"
-#include "interval_tree.h"
-#include "rectangle_set.h"
+#include "nd_rectangle_set.h"
+
+#include <queue>
+#include <algorithm>
+#include <functional>
 
 namespace Legion {
   namespace Internal {
@@ -4839,6 +4842,63 @@ namespace Legion {
                                                          can_fail, wait_until);
     }
 
+    //--------------------------------------------------------------------------
+    template<int DIM>
+    static inline NDRectangle<coord_t,DIM> domain_to_nd_rect(const Domain &d)
+    //--------------------------------------------------------------------------
+    {
+      LegionRuntime::Arrays::Rect<DIM> rect = d.get_rect<DIM>();
+      NDRectangle<coord_t,DIM> result;
+      for (int i = 0; i < DIM; i++)
+      {
+        result.lo[i] = rect.lo.x[i];
+        result.hi[i] = rect.hi.x[i];
+      }
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    template<int DIM>
+    static bool rect_sets_dominate(const std::set<Domain> &left_set,
+                                   const std::set<Domain> &right_set)
+    //--------------------------------------------------------------------------
+    {
+      NDRectangleSet<coord_t,DIM> rectangles;
+      for (std::set<Domain>::const_iterator it = left_set.begin();
+            it != left_set.end(); it++)
+        rectangles.add_rectangle(domain_to_nd_rect<DIM>(*it));
+      for (std::set<Domain>::const_iterator it = right_set.begin();
+            it != right_set.end(); it++)
+      {
+        if (!rectangles.covers(domain_to_nd_rect<DIM>(*it)))
+          return false;
+      }
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    template<int DIM>
+    static bool rect_sets_disjoint(const std::set<Domain> &left_set,
+                                   const std::set<Domain> &right_set)
+    //--------------------------------------------------------------------------
+    {
+      // Put the smaller of the two sets in the rectangle set
+      const bool left_smaller = (left_set.size() <= right_set.size());
+      const std::set<Domain> &build_set = left_smaller ? left_set : right_set;
+      const std::set<Domain> &probe_set = left_smaller ? right_set : left_set;
+      NDRectangleSet<coord_t,DIM> rectangles;
+      for (std::set<Domain>::const_iterator it = build_set.begin();
+            it != build_set.end(); it++)
+        rectangles.add_rectangle(domain_to_nd_rect<DIM>(*it));
+      for (std::set<Domain>::const_iterator it = probe_set.begin();
+            it != probe_set.end(); it++)
+      {
+        if (rectangles.intersects(domain_to_nd_rect<DIM>(*it)))
+          return false;
+      }
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     /*static*/ bool RegionTreeForest::are_disjoint(const Domain &left,
                                                    const Domain &right)
@@ -4906,15 +4966,38 @@ namespace Legion {
         {
           const std::set<Domain> &right_domains = 
             right->get_component_domains_blocking();
-          // Double Loop
-          for (std::set<Domain>::const_iterator lit = left_domains.begin();
-                disjoint && (lit != left_domains.end()); lit++)
+          switch (left_domains.begin()->get_dim())
           {
-            for (std::set<Domain>::const_iterator rit = right_domains.begin();
-                  disjoint && (rit != right_domains.end()); rit++)
-            {
-              disjoint = RegionTreeForest::are_disjoint(*lit, *rit);
-            }
+            case 1:
+              {
+                disjoint = rect_sets_disjoint<1>(left_domains, right_domains);
+                break;
+              }
+            case 2:
+              {
+                disjoint = rect_sets_disjoint<2>(left_domains, right_domains);
+                break;
+              }
+            case 3:
+              {
+                disjoint = rect_sets_disjoint<3>(left_domains, right_domains);
+                break;
+              }
+            default:
+              {
+                // Double Loop
+                for (std::set<Domain>::const_iterator lit = 
+                      left_domains.begin(); disjoint && 
+                      (lit != left_domains.end()); lit++)
+                {
+                  for (std::set<Domain>::const_iterator rit = 
+                        right_domains.begin(); disjoint && 
+                        (rit != right_domains.end()); rit++)
+                  {
+                    disjoint = RegionTreeForest::are_disjoint(*lit, *rit);
+                  }
+                }
+              }
           }
         }
         else
@@ -5440,85 +5523,23 @@ namespace Legion {
       else
       {
         // This is the hard case where we have multiple domains on the left
+        // Build an exact N-D rectangle set for the left set and check 
+        // that it covers every domain in the right set
         switch (left.get_dim())
         {
           case 1:
             {
-              // Construct an interval tree for the left set
-              // and then check to see if all the intervals within
-              // the right set are dominated by an interval in the tree
-              IntervalTree<int,true/*discrete*/> intervals;
-              for (std::set<Domain>::const_iterator it = left_set.begin();
-                    it != left_set.end(); it++)
-              {
-                LegionRuntime::Arrays::Rect<1> left_rect = it->get_rect<1>();
-                intervals.insert(left_rect.lo[0], left_rect.hi[0]);
-              }
-              dominates = true;
-              for (std::set<Domain>::const_iterator it = right_set.begin();
-                    it != right_set.end(); it++)
-              {
-                LegionRuntime::Arrays::Rect<1> right_rect = it->get_rect<1>();
-                if (!intervals.dominates(right_rect.lo[0], right_rect.hi[0]))
-                {
-                  dominates = false;
-                  break;
-                }
-              }
+              dominates = rect_sets_dominate<1>(left_set, right_set);
               break;
             }
           case 2:
             {
-              RectangleSet<int,true/*discrete*/> rectangles;
-              for (std::set<Domain>::const_iterator it = left_set.begin();
-                    it != left_set.end(); it++)
-              {
-                LegionRuntime::Arrays::Rect<2> left_rect = it->get_rect<2>();
-                if (left_rect.volume() > 0)
-                  rectangles.add_rectangle(left_rect.lo[0], left_rect.lo[1],
-                                           left_rect.hi[0], left_rect.hi[1]);
-              }
-              dominates = true;
-              for (std::set<Domain>::const_iterator it = right_set.begin();
-                    it != right_set.end(); it++)
-              {
-                LegionRuntime::Arrays::Rect<2> right_rect = it->get_rect<2>();
-                if (right_rect.volume() > 0 &&
-                    !rectangles.covers(right_rect.lo[0], right_rect.lo[1],
-                                       right_rect.hi[0], right_rect.hi[1]))
-                {
-                  dominates = false;
-                  break;
-                }
-              }
+              dominates = rect_sets_dominate<2>(left_set, right_set);
               break;
             }
           case 3:
             {
-              // TODO: Improve this terrible approximation
-              dominates = true;
-              for (std::set<Domain>::const_iterator rit = right_set.begin();
-                    (rit != right_set.end()) && dominates; rit++)
-              {
-                LegionRuntime::Arrays::Rect<3> right_rect = rit->get_rect<3>();
-                bool has_dominator = false;
-                // See if any of the rectangles on the left dominate it
-                for (std::set<Domain>::const_iterator lit = left_set.begin();
-                      lit != left_set.end(); lit++)
-                {
-                  LegionRuntime::Arrays::Rect<3> left_rect = lit->get_rect<3>();
-                  if (right_rect.intersection(left_rect) == right_rect)
-                  {
-                    has_dominator = true;
-                    break;
-                  }
-                }
-                if (!has_dominator)
-                {
-                  dominates = false;
-                  break;
-                }
-              }
+              dominates = rect_sets_dominate<3>(left_set, right_set);
               break;
             }
           default:
@@ -7088,7 +7109,8 @@ namespace Legion {
                                  RegionTreeForest *ctx)
       : IndexTreeNode(c, par->depth+1, ctx), handle(p), color_space(cspace),
         mode(m), parent(par), total_children(cspace.get_volume()), 
-        disjoint(dis), disjoint_ready(RtEvent::NO_RT_EVENT), has_complete(false)
+        disjoint(dis), disjoint_ready(RtEvent::NO_RT_EVENT), has_complete(false),
+        all_aliased_known(false)
     //--------------------------------------------------------------------------
     { 
     }
@@ -7100,7 +7122,8 @@ namespace Legion {
                                  RegionTreeForest *ctx)
       : IndexTreeNode(c, par->depth+1, ctx), handle(p), color_space(cspace),
         mode(m), parent(par), total_children(cspace.get_volume()), 
-        disjoint(false), disjoint_ready(ready), has_complete(false)
+        disjoint(false), disjoint_ready(ready), has_complete(false),
+        all_aliased_known(false)
     //--------------------------------------------------------------------------
     {
     }
@@ -7109,7 +7132,8 @@ namespace Legion {
     IndexPartNode::IndexPartNode(const IndexPartNode &rhs)
       : IndexTreeNode(), handle(IndexPartition::NO_PART), 
         color_space(Domain::NO_DOMAIN), mode(NO_MEMORY), 
-        parent(NULL), total_children(0), disjoint(false), has_complete(false)
+        parent(NULL), total_children(0), disjoint(false), has_complete(false),
+        all_aliased_known(false)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -7490,32 +7514,296 @@ namespace Legion {
       assert(ready_event == disjoint_ready);
 #endif
       // Make a copy of our color map 
-      std::set<ColorPoint> current_colors;
+      std::map<ColorPoint,IndexSpaceNode*> current_children;
       {
         AutoLock n_lock(node_lock,1,false/*exclusive*/);
-        for (std::map<ColorPoint,IndexSpaceNode*>::const_iterator it = 
-              color_map.begin(); it != color_map.end(); it++)
-          current_colors.insert(it->first);
-      }
-      // Now do the pairwise disjointness tests
-      disjoint = true;
-      for (std::set<ColorPoint>::const_iterator it1 = current_colors.begin();
-            disjoint && (it1 != current_colors.end()); it1++)
+        current_children = color_map;
+      }
+      // Rather than testing every pair of children, look at all of 
+      // them at once and either find the aliased pairs or prove that
+      // there aren't any. Partitions can have 100k children so the
+      // pairwise tests are much too expensive here.
+      std::set<std::pair<ColorPoint,ColorPoint> > aliased;
+      bool found_all;
+      if (parent->kind == UNSTRUCTURED_KIND)
+        found_all = find_aliased_masks(current_children, aliased);
+      else
+        found_all = find_aliased_rects(current_children, aliased);
+      const bool found_aliasing = !aliased.empty();
+      if (found_aliasing)
       {
-        for (std::set<ColorPoint>::const_iterator it2 = it1;
-              disjoint && (it2 != current_colors.end()); it2++)
+        // Record all the pairs that we found so are_disjoint can answer
+        // from them, and if that's all of them then every other pair 
+        // is disjoint without having to record it
+        AutoLock n_lock(node_lock);
+        for (std::set<std::pair<ColorPoint,ColorPoint> >::const_iterator it =
+              aliased.begin(); it != aliased.end(); it++)
         {
-          if ((*it1) == (*it2))
-            continue;
-          if (!are_disjoint(*it1, *it2, true/*force compute*/))
-            disjoint = false;
+          aliased_subspaces.insert(*it);
+          aliased_subspaces.insert(std::pair<ColorPoint,ColorPoint>(
+                it->second, it->first));
         }
+        all_aliased_known = found_all && 
+          (current_children.size() == total_children);
       }
+      // No need to record the disjoint pairs since are_disjoint will 
+      // check the disjointness of the whole partition first
+      disjoint = !found_aliasing;
       // Once we get here, we know the disjointness result so we can
       // trigger the event saying when the disjointness value is ready
       Runtime::trigger_event(ready_event);
     }
 
+    //--------------------------------------------------------------------------
+    bool IndexPartNode::find_aliased_rects(
+                    const std::map<ColorPoint,IndexSpaceNode*> &children,
+                    std::set<std::pair<ColorPoint,ColorPoint> > &aliased)
+    //--------------------------------------------------------------------------
+    {
+      // Flatten all the rectangles of all the children with unused 
+      // dimensions padded out to a single point
+      std::vector<DisjointnessRect> rects;
+      std::vector<ColorPoint> colors;
+      colors.reserve(children.size());
+      rects.reserve(children.size());
+      int dim = 0;
+      for (std::map<ColorPoint,IndexSpaceNode*>::const_iterator it = 
+            children.begin(); it != children.end(); it++)
+      {
+        std::vector<Domain> domains;
+        it->second->get_domains_blocking(domains);
+        for (std::vector<Domain>::const_iterator dit = domains.begin();
+              dit != domains.end(); dit++)
+        {
+          DisjointnessRect rect;
+          rect.child = colors.size();
+          dim = dit->get_dim();
+          switch (dim)
+          {
+            case 1:
+              {
+                LegionRuntime::Arrays::Rect<1> r = dit->get_rect<1>();
+                rect.lo[0] = r.lo[0]; rect.hi[0] = r.hi[0];
+                rect.lo[1] = 0; rect.hi[1] = 0;
+                rect.lo[2] = 0; rect.hi[2] = 0;
+                break;
+              }
+            case 2:
+              {
+                LegionRuntime::Arrays::Rect<2> r = dit->get_rect<2>();
+                rect.lo[0] = r.lo[0]; rect.hi[0] = r.hi[0];
+                rect.lo[1] = r.lo[1]; rect.hi[1] = r.hi[1];
+                rect.lo[2] = 0; rect.hi[2] = 0;
+                break;
+              }
+            case 3:
+              {
+                LegionRuntime::Arrays::Rect<3> r = dit->get_rect<3>();
+                rect.lo[0] = r.lo[0]; rect.hi[0] = r.hi[0];
+                rect.lo[1] = r.lo[1]; rect.hi[1] = r.hi[1];
+                rect.lo[2] = r.lo[2]; rect.hi[2] = r.hi[2];
+                break;
+              }
+            default:
+              assert(false);
+          }
+          // Empty rectangles can't alias anything
+          if ((rect.lo[0] > rect.hi[0]) || (rect.lo[1] > rect.hi[1]) ||
+              (rect.lo[2] > rect.hi[2]))
+            continue;
+          rects.push_back(rect);
+        }
+        colors.push_back(it->first);
+      }
+      // Sweep along the first dimension. Every rectangle in the active set
+      // contains the current sweep position, so as long as we haven't found
+      // an overlap, their projections onto the remaining dimensions must be
+      // disjoint and therefore have distinct lower corners. We keep those
+      // projections sorted by their lower corner. In 1-D and 2-D that makes
+      // each test O(log n): the projections are disjoint intervals so only
+      // the last one starting at or before our upper bound can overlap us.
+      // In 3-D we bound the search in both remaining dimensions: we only
+      // visit the columns of projections sharing a lower bound in the second
+      // dimension that start close enough to reach us given the widest
+      // active projection, and since each column contains that coordinate
+      // its projections are disjoint in the third dimension, so within a
+      // column we only look at the ones that overlap our own range there.
+      std::sort(rects.begin(), rects.end());
+      typedef std::pair<coord_t,coord_t> Corner;
+      std::map<Corner,unsigned> active;
+      // Extents of the active projections in the second dimension
+      std::multiset<coord_t> active_extents;
+      // Min-heap of the upper bounds of the active set in the first dimension
+      std::priority_queue<std::pair<coord_t,unsigned>,
+                          std::vector<std::pair<coord_t,unsigned> >,
+                          std::greater<std::pair<coord_t,unsigned> > > expiry;
+      for (unsigned idx = 0; idx < rects.size(); idx++)
+      {
+        const DisjointnessRect &rect = rects[idx];
+        // Retire anything that ends before this rectangle starts
+        while (!expiry.empty() && (expiry.top().first < rect.lo[0]))
+        {
+          const DisjointnessRect &done = rects[expiry.top().second];
+          active.erase(Corner(done.lo[1], done.lo[2]));
+          active_extents.erase(active_extents.find(done.hi[1] - done.lo[1]));
+          expiry.pop();
+        }
+        int other_idx = -1;
+        if (dim < 3)
+        {
+          std::map<Corner,unsigned>::const_iterator finder = 
+            active.upper_bound(Corner(rect.hi[1], 0));
+          if (finder != active.begin())
+          {
+            finder--;
+            if (rects[finder->second].hi[1] >= rect.lo[1])
+              other_idx = finder->second;
+          }
+        }
+        else if (!active.empty())
+        {
+          const coord_t max_extent = *(active_extents.rbegin());
+          std::map<Corner,unsigned>::const_iterator column = 
+            active.lower_bound(Corner(rect.lo[1] - max_extent, LLONG_MIN));
+          while ((column != active.end()) && 
+                 (column->first.first <= rect.hi[1]))
+          {
+            const coord_t x = column->first.first;
+            std::map<Corner,unsigned>::const_iterator next_column = 
+              active.upper_bound(Corner(x, LLONG_MAX));
+            // Projections in a column are disjoint in the third dimension
+            // so we only look at the ones that overlap us there, starting
+            // with the one that contains our lower bound (if any)
+            std::map<Corner,unsigned>::const_iterator it = 
+              active.lower_bound(Corner(x, rect.lo[2]));
+            if (it != column)
+            {
+              std::map<Corner,unsigned>::const_iterator prev = it;
+              prev--;
+              if (rects[prev->second].hi[2] >= rect.lo[2])
+                it = prev;
+            }
+            for ( ; (it != next_column) && 
+                    (it->first.second <= rect.hi[2]); it++)
+            {
+              if (rects[it->second].hi[1] >= rect.lo[1])
+              {
+                other_idx = it->second;
+                break;
+              }
+            }
+            if (other_idx >= 0)
+              break;
+            column = next_column;
+          }
+        }
+        // Once anything overlaps, the invariant above no longer holds
+        // so go find all the overlapping pairs the slow way (this might
+        // only be rectangles of the same child, which don't count)
+        if (other_idx >= 0)
+          return find_all_aliased_rects(rects, colors, aliased);
+        active[Corner(rect.lo[1], rect.lo[2])] = idx;
+        active_extents.insert(rect.hi[1] - rect.lo[1]);
+        expiry.push(std::pair<coord_t,unsigned>(rect.hi[0], idx));
+      }
+      return true;
+    }
+
+    // Most aliased pairs compute_disjointness will record for a partition
+    static const size_t MAX_RECORDED_ALIASED_PAIRS = 1 << 20;
+
+    //--------------------------------------------------------------------------
+    bool IndexPartNode::find_all_aliased_rects(
+                    const std::vector<DisjointnessRect> &rects,
+                    const std::vector<ColorPoint> &colors,
+                    std::set<std::pair<ColorPoint,ColorPoint> > &aliased)
+    //--------------------------------------------------------------------------
+    {
+      // Same sweep along the first dimension (the rectangles are already
+      // sorted), but now every rectangle gets tested against everything
+      // in the active set since the active projections can overlap. 
+      // Aliased partitions are usually things like halos where only a 
+      // few neighbors are active at once so this stays cheap.
+      std::vector<unsigned> active;
+      for (unsigned idx = 0; idx < rects.size(); idx++)
+      {
+        const DisjointnessRect &rect = rects[idx];
+        unsigned kept = 0;
+        for (unsigned i = 0; i < active.size(); i++)
+        {
+          const DisjointnessRect &other = rects[active[i]];
+          // Retire anything that ends before this rectangle starts
+          if (other.hi[0] < rect.lo[0])
+            continue;
+          active[kept++] = active[i];
+          if (other.child == rect.child)
+            continue;
+          if ((other.hi[1] < rect.lo[1]) || (rect.hi[1] < other.lo[1]) ||
+              (other.hi[2] < rect.lo[2]) || (rect.hi[2] < other.lo[2]))
+            continue;
+          const ColorPoint &c1 = colors[other.child];
+          const ColorPoint &c2 = colors[rect.child];
+          if (c2 < c1)
+            aliased.insert(std::pair<ColorPoint,ColorPoint>(c2,c1));
+          else
+            aliased.insert(std::pair<ColorPoint,ColorPoint>(c1,c2));
+          if (aliased.size() >= MAX_RECORDED_ALIASED_PAIRS)
+            return false;
+        }
+        active.resize(kept);
+        active.push_back(idx);
+      }
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    bool IndexPartNode::find_aliased_masks(
+                    const std::map<ColorPoint,IndexSpaceNode*> &children,
+                    std::set<std::pair<ColorPoint,ColorPoint> > &aliased)
+    //--------------------------------------------------------------------------
+    {
+      // Keep a running union of the masks of all the children we've seen
+      // and test each new child against it. Only if that finds an overlap
+      // do we go back and look for which children we actually alias with.
+      Realm::ElementMask *all_elmts = NULL;
+      for (std::map<ColorPoint,IndexSpaceNode*>::const_iterator it = 
+            children.begin(); it != children.end(); it++)
+      {
+        const Realm::ElementMask &mask = 
+          it->second->get_domain_blocking().get_index_space().get_valid_mask();
+        if (all_elmts == NULL)
+        {
+          const Realm::ElementMask &parent_mask = 
+            parent->get_domain_blocking().get_index_space().get_valid_mask();
+          all_elmts = new Realm::ElementMask(parent_mask.get_num_elmts(),
+                                            parent_mask.get_first_element());
+        }
+        else if (all_elmts->overlaps_with(mask) != 
+                  Realm::ElementMask::OVERLAP_NO)
+        {
+          for (std::map<ColorPoint,IndexSpaceNode*>::const_iterator prev = 
+                children.begin(); prev != it; prev++)
+          {
+            const Realm::ElementMask &prev_mask = prev->second->
+              get_domain_blocking().get_index_space().get_valid_mask();
+            if (prev_mask.overlaps_with(mask) != 
+                Realm::ElementMask::OVERLAP_NO)
+              aliased.insert(std::pair<ColorPoint,ColorPoint>(prev->first,
+                                                              it->first));
+          }
+          if (aliased.size() >= MAX_RECORDED_ALIASED_PAIRS)
+          {
+            delete all_elmts;
+            return false;
+          }
+        }
+        (*all_elmts) |= mask;
+      }
+      if (all_elmts != NULL)
+        delete all_elmts;
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     bool IndexPartNode::is_disjoint(bool app_query)
     //--------------------------------------------------------------------------
@@ -7543,6 +7831,8 @@ namespace Legion {
           return true;
         else if (aliased_subspaces.find(key) != aliased_subspaces.end())
           return false;
+        else if (all_aliased_known)
+          return true;
         else
         {
           std::map<std::pair<ColorPoint,ColorPoint>,RtEvent>::const_iterator
@@ -9520,9 +9810,8 @@ namespace Legion {
         if (result < 0)
         {
           log_field.error("Exceeded maximum number of allocated fields for "
-                          "field space %x. Change MAX_FIELDS from %d and "
-                          "related macros at the top of legion_config.h and "
-                          "recompile.", handle.id, MAX_FIELDS);
+                          "field space %x. Raise the limit of %d with "
+                          "-lg:fields.", handle.id, Runtime::max_fields);
 #ifdef DEBUG_LEGION
           assert(false);
 #endif
@@ -9613,9 +9902,8 @@ namespace Legion {
           if (result < 0)
           {
             log_field.error("Exceeded maximum number of allocated fields for "
-                            "field space %x. Change MAX_FIELDS from %d and "
-                            "related macros at the top of legion_config.h and "
-                            "recompile.", handle.id, MAX_FIELDS);
+                            "field space %x. Raise the limit of %d with "
+                            "-lg:fields.", handle.id, Runtime::max_fields);
 #ifdef DEBUG_LEGION
             assert(false);
 #endif
@@ -10720,7 +11008,7 @@ namespace Legion {
 #ifdef DEBUG_LEGION
       assert(!!mask);
 #endif
-      char *result = (char*)malloc(MAX_FIELDS*4); 
+      char *result = (char*)malloc(Runtime::max_fields*4); 
       bool first = true;
       for (std::map<FieldID,FieldInfo>::const_iterator it = fields.begin();
             it != fields.end(); it++)
@@ -10779,7 +11067,7 @@ namespace Legion {
       if (result >= 0)
       {
         // If we have slots for local fields then we can't use those
-        if (result >= int(MAX_FIELDS - Runtime::max_local_fields))
+        if (result >= int(Runtime::max_fields - Runtime::max_local_fields))
           return -1;
         available_indexes.unset_bit(result);
       }
@@ -10804,7 +11092,7 @@ namespace Legion {
             layouts.begin(); lit != layouts.end(); lit++)
       {
         // If the bit is set, remove the layout descriptions
-        if (lit->first & (1ULL << index))
+        if (lit->first & (1ULL << (index & 0x3F)))
         {
           LegionList<LayoutDescription*,LAYOUT_DESCRIPTION_ALLOC>::tracked
             &descs = lit->second;
@@ -10853,7 +11141,8 @@ namespace Legion {
       {
         const size_t field_size = sizes[fidx];
         int chosen_index = -1;
-        unsigned global_idx = MAX_FIELDS - Runtime::max_local_fields;
+        unsigned global_idx = 
+          Runtime::max_fields - Runtime::max_local_fields;
         for (unsigned local_idx = 0; 
               local_idx < local_field_infos.size(); local_idx++, global_idx++)
         {
@@ -10906,10 +11195,11 @@ namespace Legion {
       {
         // Translate back to a local field index
 #ifdef DEBUG_LEGION
-        assert(indexes[idx] >= (MAX_FIELDS - Runtime::max_local_fields));
+        assert(indexes[idx] >= 
+                (Runtime::max_fields - Runtime::max_local_fields));
 #endif
         const unsigned local_index = 
-          indexes[idx] - (MAX_FIELDS - Runtime::max_local_fields);
+          indexes[idx] - (Runtime::max_fields - Runtime::max_local_fields);
 #ifdef DEBUG_LEGION
         assert(local_index < local_field_infos.size());
 #endif
@@ -931,6 +931,14 @@ namespace Legion {
         SemanticTag tag;
         AddressSpaceID source;
       };
+      struct DisjointnessRect {
+      public:
+        inline bool operator<(const DisjointnessRect &rhs) const
+          { return (lo[0] < rhs.lo[0]); }
+      public:
+        coord_t lo[3], hi[3];
+        unsigned child;
+      };
       class DestructionFunctor {
       public:
         DestructionFunctor(IndexPartition h, Runtime *rt)
@@ -992,6 +1000,19 @@ namespace Legion {
                         bool force_compute = false);
       void record_disjointness(bool disjoint,
                                const ColorPoint &c1, const ColorPoint &c2);
+    protected:
+      // Both of these return true if they found every aliased pair
+      // of children and false if they gave up after finding enough
+      bool find_aliased_rects(
+                    const std::map<ColorPoint,IndexSpaceNode*> &children,
+                    std::set<std::pair<ColorPoint,ColorPoint> > &aliased);
+      bool find_all_aliased_rects(const std::vector<DisjointnessRect> &rects,
+                    const std::vector<ColorPoint> &colors,
+                    std::set<std::pair<ColorPoint,ColorPoint> > &aliased);
+      bool find_aliased_masks(
+                    const std::map<ColorPoint,IndexSpaceNode*> &children,
+                    std::set<std::pair<ColorPoint,ColorPoint> > &aliased);
+    public:
       bool is_complete(void);
     public:
       void add_instance(PartitionNode *inst);
@@ -1065,6 +1086,9 @@ namespace Legion {
       std::set<PartitionNode*> logical_nodes;
       std::set<std::pair<ColorPoint,ColorPoint> > disjoint_subspaces;
       std::set<std::pair<ColorPoint,ColorPoint> > aliased_subspaces;
+      // Set once aliased_subspaces holds every aliased pair of children
+      // so any pair that isn't in there is disjoint
+      bool all_aliased_known;
     protected:
       // Support for pending child spaces that still need to be computed
       std::map<ColorPoint,std::pair<ApUserEvent,ApUserEvent> > pending_children;
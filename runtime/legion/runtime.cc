@@ -601,7 +601,7 @@ namespace Legion {
           rez.serialize(did);
           RezCheck z(rez);
           rez.serialize(result_size);
-          rez.serialize(result,result_size);
+          rez.serialize_reference(result,result_size);
         }
         for (std::set<AddressSpaceID>::const_iterator it =
              registered_waiters.begin(); it != registered_waiters.end(); it++)
@@ -636,7 +636,7 @@ namespace Legion {
             rez.serialize(did);
             RezCheck z(rez);
             rez.serialize(result_size);
-            rez.serialize(result,result_size);
+            rez.serialize_reference(result,result_size);
           }
           runtime->send_future_result(sid, rez);
         }
@@ -3066,6 +3066,7 @@ namespace Legion {
       // Make it valid to start since we know when we were created
       // that we were made valid to begin with
       InstanceInfo &info = current_instances[manager];
+      add_region_instance(manager);
       info.instance_size = inst_size;
     }
     
@@ -3077,6 +3078,7 @@ namespace Legion {
 #ifdef DEBUG_LEGION
       assert(current_instances.find(manager) != current_instances.end());
 #endif
+      remove_region_instance(manager);
       current_instances.erase(manager);
     }
     
@@ -3122,6 +3124,7 @@ namespace Legion {
 #endif
           Runtime::trigger_event(info.deferred_collect);
           // Now we can delete our entry because it has been deleted
+          remove_region_instance(manager);
           current_instances.erase(finder);
           if (is_owner)
             remove_reference = true;
@@ -4164,7 +4167,10 @@ namespace Legion {
           std::map<PhysicalManager*,InstanceInfo>::const_iterator finder =
           current_instances.find(manager);
           if (finder == current_instances.end())
+          {
             current_instances[manager] = InstanceInfo();
+            add_region_instance(manager);
+          }
           if (created && min_priority)
           {
             std::pair<MapperID,Processor> key(mapper_id,processor);
@@ -4201,7 +4207,10 @@ namespace Legion {
           std::map<PhysicalManager*,InstanceInfo>::const_iterator finder =
           current_instances.find(manager);
           if (finder == current_instances.end())
+          {
             current_instances[manager] = InstanceInfo();
+            add_region_instance(manager);
+          }
           if (min_priority)
           {
             InstanceInfo &info = current_instances[manager];
@@ -4408,20 +4417,23 @@ namespace Legion {
                                                  bool tight_region_bounds, bool remote)
     //--------------------------------------------------------------------------
     {
-      // Hold the lock while iterating here
+      // Only instances made for the first region or one of its ancestors
+      // can satisfy the request so we can use the region index
+      RegionNode *node = 
+        regions.empty() ? NULL : runtime->forest->get_node(regions[0]);
       std::deque<PhysicalManager*> candidates;
+      // Hold the lock while iterating here
       {
         AutoLock m_lock(manager_lock, 1, false/*exclusive*/);
-        for (std::map<PhysicalManager*,InstanceInfo>::const_iterator it =
-             current_instances.begin(); it != current_instances.end(); it++)
+        std::vector<PhysicalManager*> matches;
+        find_region_candidates(node, false/*valid only*/, matches);
+        for (std::vector<PhysicalManager*>::const_iterator it =
+             matches.begin(); it != matches.end(); it++)
         {
-          // Skip it if has already been collected
-          if (it->second.current_state == ACTIVE_COLLECTED_STATE)
+          if (!(*it)->meets_region_tree(regions))
             continue;
-          if (!it->first->meets_region_tree(regions))
-            continue;
-          it->first->add_base_resource_ref(MEMORY_MANAGER_REF);
-          candidates.push_back(it->first);
+          (*it)->add_base_resource_ref(MEMORY_MANAGER_REF);
+          candidates.push_back(*it);
         }
       }
       // If we have any candidates check their constraints
@@ -4462,20 +4474,23 @@ namespace Legion {
                                                  bool tight_region_bounds, bool remote)
     //--------------------------------------------------------------------------
     {
-      // Hold the lock while iterating here
+      // Only instances made for the first region or one of its ancestors
+      // can satisfy the request so we can use the region index
+      RegionNode *node = 
+        regions.empty() ? NULL : runtime->forest->get_node(regions[0]);
       std::deque<PhysicalManager*> candidates;
+      // Hold the lock while iterating here
       {
         AutoLock m_lock(manager_lock, 1, false/*exclusive*/);
-        for (std::map<PhysicalManager*,InstanceInfo>::const_iterator it =
-             current_instances.begin(); it != current_instances.end(); it++)
+        std::vector<PhysicalManager*> matches;
+        find_region_candidates(node, false/*valid only*/, matches);
+        for (std::vector<PhysicalManager*>::const_iterator it =
+             matches.begin(); it != matches.end(); it++)
         {
-          // Skip it if has already been collected
-          if (it->second.current_state == ACTIVE_COLLECTED_STATE)
+          if (!(*it)->meets_region_tree(regions))
             continue;
-          if (!it->first->meets_region_tree(regions))
-            continue;
-          it->first->add_base_resource_ref(MEMORY_MANAGER_REF);
-          candidates.push_back(it->first);
+          (*it)->add_base_resource_ref(MEMORY_MANAGER_REF);
+          candidates.push_back(*it);
         }
       }
       // If we have any candidates check their constraints
@@ -4518,19 +4533,22 @@ namespace Legion {
                                                  bool acquire, bool tight_bounds, bool remote)
     //--------------------------------------------------------------------------
     {
+      // Only instances made for the first region or one of its ancestors
+      // can satisfy the request so we can use the region index
+      RegionNode *node = 
+        regions.empty() ? NULL : runtime->forest->get_node(regions[0]);
       // Hold the lock while iterating here
       {
         AutoLock m_lock(manager_lock, 1, false/*exclusive*/);
-        for (std::map<PhysicalManager*,InstanceInfo>::const_iterator it =
-             current_instances.begin(); it != current_instances.end(); it++)
+        std::vector<PhysicalManager*> matches;
+        find_region_candidates(node, false/*valid only*/, matches);
+        for (std::vector<PhysicalManager*>::const_iterator it =
+             matches.begin(); it != matches.end(); it++)
         {
-          // Skip it if has already been collected
-          if (it->second.current_state == ACTIVE_COLLECTED_STATE)
-            continue;
-          if (!it->first->meets_region_tree(regions))
+          if (!(*it)->meets_region_tree(regions))
             continue;
-          it->first->add_base_resource_ref(MEMORY_MANAGER_REF);
-          candidates.insert(it->first);
+          (*it)->add_base_resource_ref(MEMORY_MANAGER_REF);
+          candidates.insert(*it);
         }
       }
       // If we have any candidates check their constraints
@@ -4569,18 +4587,21 @@ namespace Legion {
                                                  bool acquire, bool tight_bounds, bool remote)
     //--------------------------------------------------------------------------
     {
+      // Only instances made for the first region or one of its ancestors
+      // can satisfy the request so we can use the region index
+      RegionNode *node = 
+        regions.empty() ? NULL : runtime->forest->get_node(regions[0]);
       // Hold the lock while iterating here
       {
         AutoLock m_lock(manager_lock, 1, false/*exclusive*/);
-        for (std::map<PhysicalManager*,InstanceInfo>::const_iterator it =
-             current_instances.begin(); it != current_instances.end(); it++)
+        std::vector<PhysicalManager*> matches;
+        find_region_candidates(node, false/*valid only*/, matches);
+        for (std::vector<PhysicalManager*>::const_iterator it =
+             matches.begin(); it != matches.end(); it++)
         {
-          // Skip it if has already been collected
-          if (it->second.current_state == ACTIVE_COLLECTED_STATE)
+          if (!(*it)->meets_region_tree(regions))
             continue;
-          if (!it->first->meets_region_tree(regions))
-            continue;
-          candidates.insert(it->first);
+          candidates.insert(*it);
         }
       }
       // If we have any candidates check their constraints
@@ -4620,18 +4641,21 @@ namespace Legion {
                                             bool tight_region_bounds, bool remote)
     //--------------------------------------------------------------------------
     {
-      // Hold the lock while iterating here
+      // Only instances made for the first region or one of its ancestors
+      // can satisfy the request so we can use the region index
+      RegionNode *node = 
+        regions.empty() ? NULL : runtime->forest->get_node(regions[0]);
       std::deque<PhysicalManager*> candidates;
+      // Hold the lock while iterating here
       {
         AutoLock m_lock(manager_lock, 1, false/*exclusive*/);
-        for (std::map<PhysicalManager*,InstanceInfo>::const_iterator it =
-             current_instances.begin(); it != current_instances.end(); it++)
+        std::vector<PhysicalManager*> matches;
+        find_region_candidates(node, true/*valid only*/, matches);
+        for (std::vector<PhysicalManager*>::const_iterator it =
+             matches.begin(); it != matches.end(); it++)
         {
-          // Only consider ones that are currently valid
-          if (it->second.current_state != VALID_STATE)
-            continue;
-          it->first->add_base_resource_ref(MEMORY_MANAGER_REF);
-          candidates.push_back(it->first);
+          (*it)->add_base_resource_ref(MEMORY_MANAGER_REF);
+          candidates.push_back(*it);
         }
       }
       // If we have any candidates check their constraints
@@ -4673,18 +4697,21 @@ namespace Legion {
                                             bool tight_region_bounds, bool remote)
     //--------------------------------------------------------------------------
     {
-      // Hold the lock while iterating here
+      // Only instances made for the first region or one of its ancestors
+      // can satisfy the request so we can use the region index
+      RegionNode *node = 
+        regions.empty() ? NULL : runtime->forest->get_node(regions[0]);
       std::deque<PhysicalManager*> candidates;
+      // Hold the lock while iterating here
       {
         AutoLock m_lock(manager_lock, 1, false/*exclusive*/);
-        for (std::map<PhysicalManager*,InstanceInfo>::const_iterator it =
-             current_instances.begin(); it != current_instances.end(); it++)
+        std::vector<PhysicalManager*> matches;
+        find_region_candidates(node, true/*valid only*/, matches);
+        for (std::vector<PhysicalManager*>::const_iterator it =
+             matches.begin(); it != matches.end(); it++)
         {
-          // Only consider ones that are currently valid
-          if (it->second.current_state != VALID_STATE)
-            continue;
-          it->first->add_base_resource_ref(MEMORY_MANAGER_REF);
-          candidates.push_back(it->first);
+          (*it)->add_base_resource_ref(MEMORY_MANAGER_REF);
+          candidates.push_back(*it);
         }
       }
       // If we have any candidates check their constraints
@@ -4993,6 +5020,7 @@ namespace Legion {
         assert(current_instances.find(manager) == current_instances.end());
 #endif
         InstanceInfo &info = current_instances[manager];
+        add_region_instance(manager);
         if (early_valid)
           info.current_state = VALID_STATE;
         info.min_priority = priority;
@@ -5096,6 +5124,7 @@ namespace Legion {
         assert(current_instances.find(manager) == current_instances.end());
 #endif
         InstanceInfo &info = current_instances[manager];
+        add_region_instance(manager);
         if (early_valid)
           info.current_state = VALID_STATE;
         info.min_priority = priority;
@@ -5177,6 +5206,7 @@ namespace Legion {
         assert(current_instances.find(manager) == current_instances.end());
 #endif
         InstanceInfo &info = current_instances[manager];
+        add_region_instance(manager);
         if (early_valid)
           info.current_state = VALID_STATE;
         info.min_priority = priority;
@@ -5225,6 +5255,7 @@ namespace Legion {
 #ifdef DEBUG_LEGION
           assert(finder->second.current_state == COLLECTABLE_STATE);
 #endif
+          remove_region_instance(manager);
           current_instances.erase(finder);
           if (is_owner)
             remove_reference = true;
@@ -5235,6 +5266,78 @@ namespace Legion {
           manager->remove_base_resource_ref(MEMORY_MANAGER_REF))
         delete manager;
     }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::add_region_instance(PhysicalManager *manager)
+    //--------------------------------------------------------------------------
+    {
+      // Should be holding the manager lock when we get here
+      region_instances[manager->region_node].insert(manager);
+    }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::remove_region_instance(PhysicalManager *manager)
+    //--------------------------------------------------------------------------
+    {
+      // Should be holding the manager lock when we get here
+      std::map<RegionNode*,std::set<PhysicalManager*> >::iterator finder = 
+        region_instances.find(manager->region_node);
+#ifdef DEBUG_LEGION
+      assert(finder != region_instances.end());
+      assert(finder->second.find(manager) != finder->second.end());
+#endif
+      finder->second.erase(manager);
+      if (finder->second.empty())
+        region_instances.erase(finder);
+    }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::find_region_candidates(RegionNode *node, 
+               bool valid_only, std::vector<PhysicalManager*> &matches) const
+    //--------------------------------------------------------------------------
+    {
+      // Should be holding the manager lock when we get here
+      if (node == NULL)
+      {
+        // No region to key off of so we have to look at everything
+        for (std::map<PhysicalManager*,InstanceInfo>::const_iterator it = 
+              current_instances.begin(); it != current_instances.end(); it++)
+        {
+          if (valid_only ? (it->second.current_state != VALID_STATE) :
+              (it->second.current_state == ACTIVE_COLLECTED_STATE))
+            continue;
+          matches.push_back(it->first);
+        }
+        return;
+      }
+      // Walk up the region tree looking for instances made for
+      // this region or any of its ancestors
+      while (true)
+      {
+        std::map<RegionNode*,std::set<PhysicalManager*> >::const_iterator
+          region_finder = region_instances.find(node);
+        if (region_finder != region_instances.end())
+        {
+          for (std::set<PhysicalManager*>::const_iterator it = 
+                region_finder->second.begin(); it != 
+                region_finder->second.end(); it++)
+          {
+            std::map<PhysicalManager*,InstanceInfo>::const_iterator finder =
+              current_instances.find(*it);
+#ifdef DEBUG_LEGION
+            assert(finder != current_instances.end());
+#endif
+            if (valid_only ? (finder->second.current_state != VALID_STATE) :
+                (finder->second.current_state == ACTIVE_COLLECTED_STATE))
+              continue;
+            matches.push_back(*it);
+          }
+        }
+        if (node->parent == NULL)
+          break;
+        node = node->parent->parent;
+      }
+    }
     
     //--------------------------------------------------------------------------
     template<bool SMALLER>
@@ -5275,8 +5378,9 @@ namespace Legion {
                                    AddressSpaceID local_address_space,
                                    size_t max_message_size, LegionProfiler *prof)
     : sending_buffer((char*)malloc(max_message_size)),
-    sending_buffer_size(max_message_size),
-    observed_recent(true), profiler(prof)
+    sending_buffer_size(max_message_size), observed_recent(true), 
+    channel_kind(kind),
+    profiler(prof)
     //--------------------------------------------------------------------------
     //
     {
@@ -5311,7 +5415,8 @@ namespace Legion {
     
     //--------------------------------------------------------------------------
     VirtualChannel::VirtualChannel(const VirtualChannel &rhs)
-    : sending_buffer(NULL), sending_buffer_size(0), profiler(NULL)
+    : sending_buffer(NULL), sending_buffer_size(0), 
+      channel_kind(rhs.channel_kind), profiler(NULL)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -5331,15 +5436,22 @@ namespace Legion {
     }
     
     //--------------------------------------------------------------------------
-    void VirtualChannel::package_message(Serializer &rez, MessageKind k,
+    bool VirtualChannel::package_message(Serializer &rez, MessageKind k,
                                          bool flush, Runtime *runtime, Processor target,
-                                         bool response, bool shutdown)
+                                         bool response, bool shutdown, bool batchable)
     //--------------------------------------------------------------------------
     {
       // First check to see if the message fits in the current buffer
       // including the overhead for the message: kind and size
-      size_t buffer_size = rez.get_used_bytes();
-      const char *buffer = (const char*)rez.get_buffer();
+      const size_t buffer_size = rez.get_used_bytes();
+      // Large payloads can be referenced by the serializer instead of
+      // copied into it, in which case we gather the pieces directly
+      std::vector<std::pair<const void*,size_t> > pieces;
+      if (rez.has_segments())
+        rez.get_segments(pieces);
+      else
+        pieces.push_back(std::pair<const void*,size_t>(rez.get_buffer(),
+                                                       buffer_size));
       // Need to hold the lock when manipulating the buffer
       AutoLock s_lock(send_lock);
       if ((sending_index+buffer_size+sizeof(k)+sizeof(buffer_size)) >
@@ -5356,23 +5468,28 @@ namespace Legion {
         sending_index += sizeof(k);
         *((size_t*)(sending_buffer+sending_index)) = buffer_size;
         sending_index += sizeof(buffer_size);
-        while (buffer_size > 0)
+        for (unsigned idx = 0; idx < pieces.size(); idx++)
         {
-          unsigned remaining = sending_buffer_size - sending_index;
-          if (remaining == 0)
-            send_message(false/*complete*/, runtime,
-                         target, response, shutdown);
-          remaining = sending_buffer_size - sending_index;
-#ifdef DEBUG_LEGION
-          assert(remaining > 0); // should be space after the send
-#endif
-          // Figure out how much to copy into the buffer
-          unsigned to_copy = (remaining < buffer_size) ?
-          remaining : buffer_size;
-          memcpy(sending_buffer+sending_index,buffer,to_copy);
-          buffer_size -= to_copy;
-          buffer += to_copy;
-          sending_index += to_copy;
+          const char *buffer = (const char*)pieces[idx].first;
+          size_t piece_size = pieces[idx].second;
+          while (piece_size > 0)
+          {
+            unsigned remaining = sending_buffer_size - sending_index;
+            if (remaining == 0)
+              send_message(false/*complete*/, runtime,
+                           target, response, shutdown);
+            remaining = sending_buffer_size - sending_index;
+#ifdef DEBUG_LEGION
+            assert(remaining > 0); // should be space after the send
+#endif
+            // Figure out how much to copy into the buffer
+            unsigned to_copy = (remaining < piece_size) ?
+            remaining : piece_size;
+            memcpy(sending_buffer+sending_index,buffer,to_copy);
+            piece_size -= to_copy;
+            buffer += to_copy;
+            sending_index += to_copy;
+          }
         }
       }
       else
@@ -5383,12 +5500,50 @@ namespace Legion {
         sending_index += sizeof(k);
         *((size_t*)(sending_buffer+sending_index)) = buffer_size;
         sending_index += sizeof(buffer_size);
-        // Then copy over the buffer
-        memcpy(sending_buffer+sending_index,buffer,buffer_size);
-        sending_index += buffer_size;
+        // Then copy over the pieces
+        for (unsigned idx = 0; idx < pieces.size(); idx++)
+        {
+          memcpy(sending_buffer+sending_index,pieces[idx].first,
+                 pieces[idx].second);
+          sending_index += pieces[idx].second;
+        }
+      }
+      if (Runtime::message_aggregation_delay > 0)
+      {
+        const long long delay = 1000LL * Runtime::message_aggregation_delay;
+        const long long now = Realm::Clock::current_time_in_nanoseconds();
+        if (flush && batchable && !shutdown)
+        {
+          // Keep holding the batch until the first flush that was held
+          // back has waited for the full delay, the caller will make 
+          // sure a flush task is around to send it at the deadline
+          if (deferred_flush.defer(now, delay, response))
+            return true;
+        }
+        // Anything that has been waiting longer than the deadline
+        // gets sent now, whether or not this message wanted a flush
+        else if (!flush && deferred_flush.has_expired(now, delay))
+          flush = true;
       }
       if (flush)
         send_message(true/*complete*/, runtime, target, response, shutdown);
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    bool VirtualChannel::flush_deferred(Runtime *runtime, Processor target,
+                                        long long now)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(send_lock);
+      if (!deferred_flush.is_pending())
+        return false;
+      if (!deferred_flush.has_expired(now, 
+            1000LL * Runtime::message_aggregation_delay))
+        return true;
+      send_message(true/*complete*/, runtime, target, 
+                   false/*response*/, false/*shutdown*/);
+      return false;
     }
     
     //--------------------------------------------------------------------------
@@ -5408,6 +5563,9 @@ namespace Legion {
         header = FINAL_MESSAGE;
         partial = false;
       }
+      // A complete send takes any deferred messages with it
+      if (complete && deferred_flush.is_pending())
+        response = deferred_flush.clear() || response;
       // Save the header and the number of messages into the buffer
       const size_t base_size = sizeof(LgTaskID) + sizeof(AddressSpaceID)
       + sizeof(VirtualChannelKind);
@@ -5827,6 +5985,11 @@ namespace Legion {
             runtime->handle_did_create_remove(derez);
             break;
           }
+          case DISTRIBUTED_BATCH_UPDATE:
+          {
+            runtime->handle_did_remote_batch_update(derez);
+            break;
+          }
           case DISTRIBUTED_UNREGISTER:
           {
             runtime->handle_did_remote_unregister(derez);
@@ -6248,7 +6411,8 @@ namespace Legion {
         if (profiler != NULL)
         {
           stop = Realm::Clock::current_time_in_nanoseconds();
-          profiler->record_message(kind, start, stop);
+          profiler->record_message(kind, channel_kind, message_size, 
+                                   start, stop);
         }
         // Update the args and arglen
         args += message_size;
@@ -6334,11 +6498,13 @@ namespace Legion {
         new (channels+idx) VirtualChannel((VirtualChannelKind)idx,
                                           rt->address_space, max_message_size, runtime->profiler);
       }
+      flush_scheduled = false;
     }
     
     //--------------------------------------------------------------------------
     MessageManager::MessageManager(const MessageManager &rhs)
-    : remote_address_space(0), runtime(NULL), channels(NULL)
+    : remote_address_space(0), runtime(NULL), channels(NULL), 
+      flush_scheduled(false)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -6367,11 +6533,53 @@ namespace Legion {
     
     //--------------------------------------------------------------------------
     void MessageManager::send_message(Serializer &rez, MessageKind kind,
-                                      VirtualChannelKind channel, bool flush, bool response, bool shutdown)
+                                      VirtualChannelKind channel, bool flush, bool response, bool shutdown,
+                                      bool batchable)
+    //--------------------------------------------------------------------------
+    {
+      if (channels[channel].package_message(rez, kind, flush, runtime,
+                                target, response, shutdown, batchable))
+        schedule_flush();
+    }
+
+    //--------------------------------------------------------------------------
+    void MessageManager::schedule_flush(void)
+    //--------------------------------------------------------------------------
+    {
+      if (!__sync_bool_compare_and_swap(&flush_scheduled, false, true))
+        return;
+      // Realm has no timers so the flush task serves as one: it runs at
+      // throughput priority so whatever runtime work is already queued 
+      // up gets to add to the batch first, and it launches itself again
+      // until the deadline of every deferred batch has passed
+      MessageFlushArgs args;
+      args.manager = this;
+      runtime->issue_runtime_meta_task(args, LG_THROUGHPUT_PRIORITY);
+    }
+
+    //--------------------------------------------------------------------------
+    void MessageManager::flush_deferred_messages(void)
+    //--------------------------------------------------------------------------
+    {
+      // Clear the flag first so any message deferred after we've looked
+      // at its channel will schedule another flush
+      flush_scheduled = false;
+      __sync_synchronize();
+      const long long now = Realm::Clock::current_time_in_nanoseconds();
+      bool still_deferred = false;
+      for (unsigned idx = 0; idx < MAX_NUM_VIRTUAL_CHANNELS; idx++)
+        if (channels[idx].flush_deferred(runtime, target, now))
+          still_deferred = true;
+      if (still_deferred)
+        schedule_flush();
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void MessageManager::handle_message_flush(const void *args)
     //--------------------------------------------------------------------------
     {
-      channels[channel].package_message(rez, kind, flush, runtime,
-                                        target, response, shutdown);
+      const MessageFlushArgs *fargs = (const MessageFlushArgs*)args;
+      fargs->manager->flush_deferred_messages();
     }
     
     //--------------------------------------------------------------------------
@@ -8827,6 +9035,11 @@ namespace Legion {
       // message managers lazily as they are needed
       for (unsigned idx = 0; idx < MAX_NUM_NODES; idx++)
         message_managers[idx] = NULL;
+      if (max_reference_batch > 0)
+        reference_batcher = new RemoteReferenceBatcher(this, 
+                                                       max_reference_batch);
+      else
+        reference_batcher = NULL;
       
       // Make the default number of contexts
       // No need to hold the lock yet because nothing is running
@@ -8917,6 +9130,11 @@ namespace Legion {
           message_managers[idx] = NULL;
         }
       }
+      if (reference_batcher != NULL)
+      {
+        delete reference_batcher;
+        reference_batcher = NULL;
+      }
       if (profiler != NULL)
       {
         profiler->finalize();
@@ -9358,12 +9576,14 @@ namespace Legion {
       LG_TASK_DESCRIPTIONS(lg_task_descriptions);
       profiler = new LegionProfiler((local_utils.empty() ?
                                      Processor::NO_PROC : utility_group),
-                                    machine, LG_LAST_TASK_ID,
+                                    machine, this, LG_LAST_TASK_ID,
                                     lg_task_descriptions,
                                     Operation::LAST_OP_KIND,
                                     Operation::op_names,
                                     Runtime::serializer_type,
-                                    Runtime::prof_logfile);
+                                    Runtime::prof_logfile,
+                         size_t(Runtime::prof_footprint_threshold) << 20,
+                         size_t(Runtime::prof_target_latency) * 1000000);
       LG_MESSAGE_DESCRIPTIONS(lg_message_descriptions);
       profiler->record_message_kinds(lg_message_descriptions, LAST_SEND_KIND);
       MAPPER_CALL_NAMES(lg_mapper_calls);
@@ -12272,7 +12492,7 @@ namespace Legion {
     }
     
     //--------------------------------------------------------------------------
-    void Runtime::begin_trace(Context ctx, TraceID tid)
+    void Runtime::begin_trace(Context ctx, TraceID tid, bool memoize)
     //--------------------------------------------------------------------------
     {
       if (ctx == DUMMY_CONTEXT)
@@ -12284,7 +12504,7 @@ namespace Legion {
 #endif
         exit(ERROR_DUMMY_CONTEXT_OPERATION);
       }
-      ctx->begin_trace(tid);
+      ctx->begin_trace(tid, memoize);
     }
     
     //--------------------------------------------------------------------------
@@ -13382,7 +13602,7 @@ namespace Legion {
           rez.serialize(source);
           rez.serialize(message_kind);
           rez.serialize(message_size);
-          rez.serialize(message, message_size);
+          rez.serialize_reference(message, message_size);
         }
         send_mapper_message(find_address_space(target), rez);
       }
@@ -13415,7 +13635,7 @@ namespace Legion {
           rez.serialize(radix);
           rez.serialize(offset);
           rez.serialize(message_size);
-          rez.serialize(message, message_size);
+          rez.serialize_reference(message, message_size);
         }
         send_mapper_broadcast(target, rez);
       }
@@ -14028,7 +14248,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       find_messenger(target)->send_message(rez, DISTRIBUTED_VALID_UPDATE,
-                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/);
+                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/,
+                                           false/*response*/, false/*shutdown*/,
+                                           true/*batchable*/);
     }
     
     //--------------------------------------------------------------------------
@@ -14037,7 +14259,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       find_messenger(target)->send_message(rez, DISTRIBUTED_GC_UPDATE,
-                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/);
+                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/,
+                                           false/*response*/, false/*shutdown*/,
+                                           true/*batchable*/);
     }
     
     //--------------------------------------------------------------------------
@@ -14046,7 +14270,20 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       find_messenger(target)->send_message(rez, DISTRIBUTED_RESOURCE_UPDATE,
-                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/);
+                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/,
+                                           false/*response*/, false/*shutdown*/,
+                                           true/*batchable*/);
+    }
+    
+    //--------------------------------------------------------------------------
+    void Runtime::send_did_remote_batch_update(AddressSpaceID target,
+                                               Serializer &rez)
+    //--------------------------------------------------------------------------
+    {
+      find_messenger(target)->send_message(rez, DISTRIBUTED_BATCH_UPDATE,
+                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/,
+                                           false/*response*/, false/*shutdown*/,
+                                           true/*batchable*/);
     }
     
     //--------------------------------------------------------------------------
@@ -14055,7 +14292,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       find_messenger(target)->send_message(rez, DISTRIBUTED_CREATE_ADD,
-                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/);
+                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/,
+                                           false/*response*/, false/*shutdown*/,
+                                           true/*batchable*/);
     }
     
     //--------------------------------------------------------------------------
@@ -14064,7 +14303,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       find_messenger(target)->send_message(rez, DISTRIBUTED_CREATE_REMOVE,
-                                           DEFAULT_VIRTUAL_CHANNEL, flush);
+                                           DEFAULT_VIRTUAL_CHANNEL, flush,
+                                           false/*response*/, false/*shutdown*/,
+                                           true/*batchable*/);
     }
     
     //--------------------------------------------------------------------------
@@ -14219,7 +14460,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       find_messenger(target)->send_message(rez, SEND_VIEW_REMOTE_UPDATE,
-                                           UPDATE_VIRTUAL_CHANNEL, true/*flush*/);
+                                           UPDATE_VIRTUAL_CHANNEL, true/*flush*/,
+                                           false/*response*/, false/*shutdown*/,
+                                           true/*batchable*/);
     }
     
     //--------------------------------------------------------------------------
@@ -14228,7 +14471,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       find_messenger(target)->send_message(rez, SEND_VIEW_REMOTE_INVALIDATE,
-                                           UPDATE_VIRTUAL_CHANNEL, true/*flush*/);
+                                           UPDATE_VIRTUAL_CHANNEL, true/*flush*/,
+                                           false/*response*/, false/*shutdown*/,
+                                           true/*batchable*/);
     }
     
     //--------------------------------------------------------------------------
@@ -14591,7 +14836,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       find_messenger(target)->send_message(rez, SEND_GC_PRIORITY_UPDATE,
-                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/);
+                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/,
+                                           false/*response*/, false/*shutdown*/,
+                                           true/*batchable*/);
     }
     
     //--------------------------------------------------------------------------
@@ -15094,6 +15341,13 @@ namespace Legion {
     {
       DistributedCollectable::handle_did_remote_resource_update(this, derez);
     }
+
+    //--------------------------------------------------------------------------
+    void Runtime::handle_did_remote_batch_update(Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+      RemoteReferenceBatcher::handle_batch_update(this, derez);
+    }
     
     //--------------------------------------------------------------------------
     void Runtime::handle_did_create_add(Deserializer &derez)
@@ -16639,6 +16893,10 @@ namespace Legion {
       // Record if we have any outstanding profiling requests
       if (profiler != NULL && profiler->has_outstanding_requests())
         shutdown_manager->record_outstanding_profiling_requests();
+      // Any reference removals still waiting to be batched have to
+      // go out now and be accounted for as recent messages
+      if ((reference_batcher != NULL) && reference_batcher->flush_all())
+        shutdown_manager->record_recent_message();
       // Check all our message managers for outstanding messages
       for (unsigned idx = 0; idx < MAX_NUM_NODES; idx++)
       {
@@ -16660,6 +16918,8 @@ namespace Legion {
       for (std::map<Memory,MemoryManager*>::const_iterator it =
            memory_managers.begin(); it != memory_managers.end(); it++)
         it->second->prepare_for_shutdown();
+      if (reference_batcher != NULL)
+        reference_batcher->report_statistics();
       prepared_for_shutdown = true;
     }
     
@@ -18922,10 +19182,14 @@ namespace Legion {
     DEFAULT_SUPERSCALAR_WIDTH;
     /*static*/ unsigned Runtime::max_message_size =
     DEFAULT_MAX_MESSAGE_SIZE;
+    /*static*/ unsigned Runtime::message_aggregation_delay = 0;
+    /*static*/ unsigned Runtime::max_reference_batch =
+    DEFAULT_MAX_REFERENCE_BATCH;
     /*static*/ unsigned Runtime::gc_epoch_size =
     DEFAULT_GC_EPOCH_SIZE;
     /*static*/ unsigned Runtime::max_local_fields =
     DEFAULT_LOCAL_FIELDS;
+    /*static*/ unsigned Runtime::max_fields = MAX_FIELDS;
     /*static*/ bool Runtime::runtime_started = false;
     /*static*/ bool Runtime::runtime_backgrounded = false;
     /*static*/ bool Runtime::runtime_warnings = false;
@@ -18969,6 +19233,8 @@ namespace Legion {
     /*static*/ unsigned Runtime::num_profiling_nodes = 0;
     /*static*/ const char* Runtime::serializer_type = "binary";
     /*static*/ const char* Runtime::prof_logfile = NULL;
+    /*static*/ unsigned Runtime::prof_footprint_threshold = 0;
+    /*static*/ unsigned Runtime::prof_target_latency = 0;
 #ifdef TRACE_ALLOCATION
     /*static*/ std::map<AllocationType,Runtime::AllocationTracker>
     Runtime::allocation_manager;
@@ -18981,6 +19247,8 @@ namespace Legion {
     {
       // Some static asserts that need to hold true for the runtime to work
       LEGION_STATIC_ASSERT(MAX_RETURN_SIZE > 0);
+      // MAX_FIELDS is only the default field limit now (see -lg:fields)
+      // but it still has to be a power of two like the runtime value
       LEGION_STATIC_ASSERT((1 << LEGION_FIELD_LOG2) == MAX_FIELDS);
       LEGION_STATIC_ASSERT(MAX_NUM_NODES > 0);
       LEGION_STATIC_ASSERT(MAX_NUM_PROCS > 0);
@@ -19060,12 +19328,17 @@ continue;					\
         initial_tasks_to_schedule = DEFAULT_MIN_TASKS_TO_SCHEDULE;
         superscalar_width = DEFAULT_SUPERSCALAR_WIDTH;
         max_message_size = DEFAULT_MAX_MESSAGE_SIZE;
+        message_aggregation_delay = 0;
+        max_reference_batch = DEFAULT_MAX_REFERENCE_BATCH;
         gc_epoch_size = DEFAULT_GC_EPOCH_SIZE;
         max_local_fields = DEFAULT_LOCAL_FIELDS;
+        max_fields = MAX_FIELDS;
         program_order_execution = false;
         num_profiling_nodes = 0;
         serializer_type = "binary";
         prof_logfile = NULL;
+        prof_footprint_threshold = 0;
+        prof_target_latency = 0;
         legion_collective_radix = LEGION_COLLECTIVE_RADIX;
         legion_collective_log_radix = 0;
         legion_collective_stages = 0;
@@ -19099,8 +19372,11 @@ continue;					\
           INT_ARG("-lg:sched", initial_tasks_to_schedule);
           INT_ARG("-lg:width", superscalar_width);
           INT_ARG("-lg:message",max_message_size);
+          INT_ARG("-lg:message_delay",message_aggregation_delay);
+          INT_ARG("-lg:ref_batch",max_reference_batch);
           INT_ARG("-lg:epoch", gc_epoch_size);
           INT_ARG("-lg:local", max_local_fields);
+          INT_ARG("-lg:fields", max_fields);
           if (!strcmp(argv[i],"-lg:no_dyn"))
             dynamic_independence_tests = false;
           BOOL_ARG("-lg:spy",legion_spy_enabled);
@@ -19149,6 +19425,8 @@ continue;					\
             prof_logfile = argv[++i];
             continue;
           }
+          INT_ARG("-lg:prof_footprint", prof_footprint_threshold);
+          INT_ARG("-lg:prof_latency", prof_target_latency);
           
           // These are all the deprecated versions of these flag
           BOOL_ARG("-hl:separate",separate_runtime_instances);
@@ -19219,9 +19497,30 @@ continue;					\
           sleep(delay_start);
 #undef INT_ARG
 #undef BOOL_ARG
+        // Sparse field masks store field indexes in 16 bits
+        if ((max_fields == 0) || 
+            (max_fields > FieldMask::MAX_BITS_LIMIT))
+        {
+          MessageDescriptor INVALID_FIELD_LIMIT(1080, "undefined");
+          log_run.error(INVALID_FIELD_LIMIT.id(),
+                        "Invalid field limit %u passed to -lg:fields. The "
+                        "field limit must be between 1 and %u.", 
+                        max_fields, FieldMask::MAX_BITS_LIMIT);
+#ifdef DEBUG_LEGION
+          assert(false);
+#endif
+          exit(ERROR_INVALID_FIELD_LIMIT);
+        }
+        // Field masks can be any number of words wide but copies compress
+        // them with log2(max_fields) steps so round up to a power of two
+        unsigned field_limit = 64;
+        while (field_limit < max_fields)
+          field_limit <<= 1;
+        max_fields = field_limit;
+        FieldMask::set_max_bits(max_fields);
 #ifdef DEBUG_LEGION
         assert(initial_task_window_hysteresis <= 100);
-        assert(max_local_fields <= MAX_FIELDS);
+        assert(max_local_fields <= max_fields);
 #endif
       }
       if (legion_spy_enabled)
@@ -20802,6 +21101,26 @@ continue;					\
           PhiView::handle_deferred_view_registration(args);
           break;
         }
+        case LG_PROFILER_FLUSH_TASK_ID:
+        {
+          LegionProfiler::handle_flush(args);
+          break;
+        }
+        case LG_PROFILER_SWEEP_TASK_ID:
+        {
+          LegionProfiler::handle_latency_sweep(args);
+          break;
+        }
+        case LG_MESSAGE_FLUSH_TASK_ID:
+        {
+          MessageManager::handle_message_flush(args);
+          break;
+        }
+        case LG_REFERENCE_FLUSH_TASK_ID:
+        {
+          RemoteReferenceBatcher::handle_reference_flush(args);
+          break;
+        }
         case LG_RETRY_SHUTDOWN_TASK_ID:
         {
           const ShutdownManager::RetryShutdownArgs *shutdown_args =
@@ -21029,7 +21348,7 @@ continue;					\
   /*static*/ char* BitMaskHelper::to_string(const uint64_t *bits, int count)
   //--------------------------------------------------------------------------
   {
-    char *result = (char*)malloc((((count + 7) >> 3) + 1)*sizeof(char));
+    char *result = (char*)malloc((((count + 3) >> 2) + 1)*sizeof(char));
     assert(result != 0);
     char *p = result;
     // special case for non-multiple-of-64
@@ -21041,7 +21360,7 @@ continue;					\
     }
     // rest are whole words
     int idx = (count >> 6);
-    while(idx >= 0) {
+    while(idx > 0) {
       sprintf(p, "%16.16" MASK_FMT, bits[--idx]);
       p += 16;
     }
@@ -763,6 +763,11 @@ namespace Legion {
                                     Processor proc, GCPriority priority,
                                     bool tight_region_bounds, bool remote);
       void record_deleted_instance(PhysicalManager *manager); 
+      // These must be called while holding the manager lock
+      void add_region_instance(PhysicalManager *manager);
+      void remove_region_instance(PhysicalManager *manager);
+      void find_region_candidates(RegionNode *node, bool valid_only,
+                          std::vector<PhysicalManager*> &matches) const;
       void find_instances_by_state(size_t needed_size, InstanceState state, 
                      std::set<CollectableInfo<true> > &smaller_instances,
                      std::set<CollectableInfo<false> > &larger_instances) const;
@@ -792,6 +797,10 @@ namespace Legion {
       // It is only valid on the owner node
       LegionMap<PhysicalManager*,InstanceInfo,
                 MEMORY_INSTANCES_ALLOC>::tracked current_instances;
+      // An index of the current instances by the logical region they
+      // were created for so that lookups only have to consider the
+      // instances made for the requested region or one of its ancestors
+      std::map<RegionNode*,std::set<PhysicalManager*> > region_instances;
     };
 
     /**
@@ -818,9 +827,14 @@ namespace Legion {
     public:
       VirtualChannel& operator=(const VirtualChannel &rhs);
     public:
-      void package_message(Serializer &rez, MessageKind k, bool flush,
+      // returns true if a batchable flush was deferred and the
+      // caller needs to make sure flush_deferred gets called
+      bool package_message(Serializer &rez, MessageKind k, bool flush,
                            Runtime *runtime, Processor target, 
-                           bool response, bool shutdown);
+                           bool response, bool shutdown, bool batchable);
+      // sends the deferred batch if its deadline has passed, returns
+      // true if there is still a batch waiting for its deadline
+      bool flush_deferred(Runtime *runtime, Processor target, long long now);
       void process_message(const void *args, size_t arglen, 
                         Runtime *runtime, AddressSpaceID remote_address_space);
       void confirm_shutdown(ShutdownManager *shutdown_manager, bool phase_one);
@@ -841,6 +855,8 @@ namespace Legion {
       MessageHeader header;
       unsigned packaged_messages;
       bool partial;
+      // Batchable flushes held back until -lg:message_delay has passed
+      DeferredFlush deferred_flush;
       // State for receiving messages
       // No lock for receiving messages since we know
       // that they are ordered
@@ -850,6 +866,7 @@ namespace Legion {
       unsigned received_messages;
       bool observed_recent;
     private:
+      const VirtualChannelKind channel_kind;
       LegionProfiler *const profiler;
     }; 
 
@@ -872,6 +889,13 @@ namespace Legion {
      * before handling the message.
      */
     class MessageManager { 
+    public:
+      struct MessageFlushArgs : public LgTaskArgs<MessageFlushArgs> {
+      public:
+        static const LgTaskID TASK_ID = LG_MESSAGE_FLUSH_TASK_ID;
+      public:
+        MessageManager *manager;
+      };
     public:
       MessageManager(AddressSpaceID remote, 
                      Runtime *rt, size_t max,
@@ -881,12 +905,22 @@ namespace Legion {
     public:
       MessageManager& operator=(const MessageManager &rhs);
     public:
+      // Batchable messages that ask for a flush may be held back for up
+      // to -lg:message_delay microseconds so they can share an active
+      // message with whatever gets sent to the same node after them
       void send_message(Serializer &rez, MessageKind kind, 
                         VirtualChannelKind channel, bool flush, 
-                        bool response = false, bool shutdown = false);
+                        bool response = false, bool shutdown = false,
+                        bool batchable = false);
       void receive_message(const void *args, size_t arglen);
+      // Sends everything held back on any channel to this node once
+      // its deadline has passed
+      void flush_deferred_messages(void);
+      static void handle_message_flush(const void *args);
       void confirm_shutdown(ShutdownManager *shutdown_manager,
                             bool phase_one);
+    private:
+      void schedule_flush(void);
     public:
       const AddressSpaceID remote_address_space;
     private:
@@ -894,6 +928,8 @@ namespace Legion {
       // State for sending messages
       Processor target;
       VirtualChannel *const channels; 
+      // One flush task covers all the channels to this node
+      volatile bool flush_scheduled;
     };
 
     /**
@@ -1806,7 +1842,7 @@ namespace Legion {
       void issue_release(Context ctx, const ReleaseLauncher &launcher);
       void issue_mapping_fence(Context ctx);
       void issue_execution_fence(Context ctx);
-      void begin_trace(Context ctx, TraceID tid);
+      void begin_trace(Context ctx, TraceID tid, bool memoize);
       void end_trace(Context ctx, TraceID tid);
       void begin_static_trace(Context ctx, 
                               const std::set<RegionTreeID> *managed);
@@ -2003,6 +2039,8 @@ namespace Legion {
       void send_did_remote_gc_update(AddressSpaceID target, Serializer &rez);
       void send_did_remote_resource_update(AddressSpaceID target,
                                            Serializer &rez);
+      void send_did_remote_batch_update(AddressSpaceID target, 
+                                        Serializer &rez);
       void send_did_add_create_reference(AddressSpaceID target,Serializer &rez);
       void send_did_remove_create_reference(AddressSpaceID target,
                                             Serializer &rez, bool flush = true);
@@ -2169,6 +2207,7 @@ namespace Legion {
       void handle_did_remote_valid_update(Deserializer &derez);
       void handle_did_remote_gc_update(Deserializer &derez);
       void handle_did_remote_resource_update(Deserializer &derez);
+      void handle_did_remote_batch_update(Deserializer &derez);
       void handle_did_create_add(Deserializer &derez);
       void handle_did_create_remove(Deserializer &derez);
       void handle_did_remote_unregister(Deserializer &derez);
@@ -2616,6 +2655,8 @@ namespace Legion {
       RegionTreeForest *const forest;
       Processor utility_group;
       const bool has_explicit_utility_procs;
+      // NULL when remote reference batching is disabled
+      RemoteReferenceBatcher *reference_batcher;
     protected:
       bool prepared_for_shutdown;
     protected:
@@ -2906,8 +2947,11 @@ namespace Legion {
       static unsigned initial_tasks_to_schedule;
       static unsigned superscalar_width;
       static unsigned max_message_size;
+      static unsigned message_aggregation_delay; // us
+      static unsigned max_reference_batch;
       static unsigned gc_epoch_size;
       static unsigned max_local_fields;
+      static unsigned max_fields;
       static bool runtime_started;
       static bool runtime_backgrounded;
       static bool runtime_warnings;
@@ -2947,6 +2991,8 @@ namespace Legion {
       static unsigned num_profiling_nodes;
       static const char* serializer_type;
       static const char* prof_logfile;
+      static unsigned prof_footprint_threshold; // MB
+      static unsigned prof_target_latency; // ms
     public:
       static inline ApEvent merge_events(ApEvent e1, ApEvent e2);
       static inline ApEvent merge_events(ApEvent e1, ApEvent e2, ApEvent e3);
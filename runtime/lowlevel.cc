@@ -97,21 +97,21 @@ namespace LegionRuntime {
 	     << " local=" << e->current_local_waiters.size()
 	     << "+" << e->future_local_waiters.size()
 	     << " remote=" << e->remote_waiters.size() << "\n";
-	  for(std::vector<EventWaiter *>::const_iterator it = e->current_local_waiters.begin();
-	      it != e->current_local_waiters.end();
-	      it++) {
-	    os << "  [" << (e->generation+1) << "] L:" << (*it) << " - ";
-	    (*it)->print(os);
+	  for(const EventWaiterNode *w = e->current_local_waiters.head;
+	      w;
+	      w = w->next) {
+	    os << "  [" << (e->generation+1) << "] L:" << w->waiter << " - ";
+	    w->print(os);
 	    os << "\n";
 	  }
-	  for(std::map<EventImpl::gen_t, std::vector<EventWaiter *> >::const_iterator it = e->future_local_waiters.begin();
+	  for(std::map<EventImpl::gen_t, EventWaiterList>::const_iterator it = e->future_local_waiters.begin();
 	      it != e->future_local_waiters.end();
 	      it++) {
-	    for(std::vector<EventWaiter *>::const_iterator it2 = it->second.begin();
-		it2 != it->second.end();
-		it2++) {
-	      os << "  [" << (it->first) << "] L:" << (*it2) << " - ";
-	      (*it2)->print(os);
+	    for(const EventWaiterNode *w = it->second.head;
+		w;
+		w = w->next) {
+	      os << "  [" << (it->first) << "] L:" << w->waiter << " - ";
+	      w->print(os);
 	      os << "\n";
 	    }
 	  }
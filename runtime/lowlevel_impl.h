@@ -71,6 +71,8 @@ namespace LegionRuntime {
   namespace LowLevel {
     typedef Realm::ID ID;
     typedef Realm::EventWaiter EventWaiter;
+    typedef Realm::EventWaiterNode EventWaiterNode;
+    typedef Realm::EventWaiterList EventWaiterList;
     typedef Realm::EventImpl EventImpl;
     typedef Realm::GenEventImpl GenEventImpl;
     typedef Realm::BarrierImpl BarrierImpl;
@@ -68,7 +68,8 @@ namespace Legion {
         max_steal_count(STATIC_MAX_STEAL_COUNT),
         breadth_first_traversal(STATIC_BREADTH_FIRST),
         stealing_enabled(STATIC_STEALING_ENABLED),
-        max_schedule_count(STATIC_MAX_SCHEDULE_COUNT)
+        max_schedule_count(STATIC_MAX_SCHEDULE_COUNT),
+        decision_cache(NULL), decision_cache_file(NULL)
     //--------------------------------------------------------------------------
     {
       log_mapper.spew("Initializing the default mapper for "
@@ -96,10 +97,28 @@ namespace Legion {
           BOOL_ARG("-dm:steal", stealing_enabled);
           BOOL_ARG("-dm:bft", breadth_first_traversal);
           INT_ARG("-dm:sched", max_schedule_count);
+          if (!strcmp(argv[i], "-dm:cache") && ((i+1) < argc))
+          {
+            // Each mapper gets its own file so they never race on it
+            const char *prefix = argv[++i];
+            const size_t buffer_size = strlen(prefix) + 32;
+            decision_cache_file = (char*)malloc(buffer_size*sizeof(char));
+            snprintf(decision_cache_file, buffer_size, 
+                     "%s." IDFMT "", prefix, local_proc.id);
+            continue;
+          }
 #undef BOOL_ARG
 #undef INT_ARG
         }
       }
+      if (decision_cache_file != NULL)
+      {
+        decision_cache = new MappingDecisionCache(machine);
+        if (decision_cache->load(decision_cache_file))
+          log_mapper.info("Default mapper on processor " IDFMT " loaded "
+                          "cached mapping decisions from %s", 
+                          local_proc.id, decision_cache_file);
+      }
       if (stealing_enabled)
       {
         log_mapper.warning("Default mapper does not have a stealing algorithm "
@@ -287,6 +306,16 @@ namespace Legion {
     {
       log_mapper.spew("Deleting default mapper for processor " IDFMT "",
                   local_proc.id);
+      if (decision_cache != NULL)
+      {
+        if (decision_cache->is_dirty() && 
+            !decision_cache->save(decision_cache_file))
+          log_mapper.warning("Default mapper on processor " IDFMT " failed "
+                             "to save mapping decisions to %s", 
+                             local_proc.id, decision_cache_file);
+        delete decision_cache;
+        free(decision_cache_file);
+      }
       free(const_cast<char*>(mapper_name));
     }
 
@@ -611,6 +640,19 @@ namespace Legion {
       // Do a quick test to see if we have cached the result
       std::map<TaskID,VariantInfo>::const_iterator finder = 
                                         preferred_variants.find(task.task_id);
+      // Decisions from an earlier run are made per region shape so
+      // they are more specific than the per-task result cached here
+      if (decision_cache != NULL)
+      {
+        VariantInfo result;
+        if (default_find_cached_decision(task, ctx, needs_tight_bound, 
+                                         specific, result))
+        {
+          if (cache_result && (finder == preferred_variants.end()))
+            preferred_variants[task.task_id] = result;
+          return result;
+        }
+      }
       if (finder != preferred_variants.end() && 
           (!needs_tight_bound || finder->second.tight_bound))
         return finder->second;
@@ -805,6 +847,16 @@ namespace Legion {
             }
           }
           preferred_variants[task.task_id] = result;
+          if (decision_cache != NULL)
+          {
+            MappingDecisionCache::Decision decision;
+            decision.variant = result.variant;
+            decision.proc_kind = result.proc_kind;
+            decision.tight_bound = result.tight_bound;
+            decision.is_inner = result.is_inner;
+            decision_cache->record_decision(task.task_id,
+                MappingDecisionCache::compute_region_shape(task), decision);
+          }
         }
         return result;
       }
@@ -816,6 +868,44 @@ namespace Legion {
       return VariantInfo();
     }
 
+    //--------------------------------------------------------------------------
+    bool DefaultMapper::default_find_cached_decision(const Task &task,
+                                 MapperContext ctx, bool needs_tight_bound,
+                                 Processor::Kind specific, VariantInfo &result)
+    //--------------------------------------------------------------------------
+    {
+      const unsigned long long shape = 
+        MappingDecisionCache::compute_region_shape(task);
+      MappingDecisionCache::Decision decision;
+      if (!decision_cache->find_decision(task.task_id, shape, decision))
+        return false;
+      if (needs_tight_bound && !decision.tight_bound)
+        return false;
+      if ((specific != Processor::NO_KIND) && (specific != decision.proc_kind))
+        return false;
+      // The machine signature matched so the processor kind is still here,
+      // but the application may have registered different variants since
+      // the decision was made so make sure this one is still valid
+      if (!decision.validated)
+      {
+        std::vector<VariantID> variants;
+        runtime->find_valid_variants(ctx, task.task_id, 
+                                     variants, decision.proc_kind);
+        if (std::find(variants.begin(), variants.end(), decision.variant) ==
+            variants.end())
+        {
+          decision_cache->invalidate_decision(task.task_id, shape);
+          return false;
+        }
+        decision_cache->validate_decision(task.task_id, shape);
+      }
+      result.variant = decision.variant;
+      result.proc_kind = decision.proc_kind;
+      result.tight_bound = decision.tight_bound;
+      result.is_inner = decision.is_inner;
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     void DefaultMapper::default_policy_rank_processor_kinds(MapperContext ctx,
                         const Task &task, std::vector<Processor::Kind> &ranking)
@@ -1121,6 +1211,10 @@ namespace Legion {
       // be scheduled on as determined by select initial task
       Processor::Kind target_kind =
         task.must_epoch_task ? local_proc.kind() : task.target_proc.kind();
+      // Seed the slice cache with slices from an earlier run and note if
+      // neither run has sliced this domain yet so we can save the result
+      const bool record_slices = (decision_cache != NULL) &&
+        !default_find_cached_slices(target_kind, input.domain);
       switch (target_kind)
       {
         case Processor::LOC_PROC:
@@ -1156,6 +1250,60 @@ namespace Legion {
         default:
           assert(false); // unimplemented processor kind
       }
+      if (record_slices)
+        decision_cache->record_slices(target_kind, input.domain, 
+                                      output.slices);
+    }
+
+    //--------------------------------------------------------------------------
+    bool DefaultMapper::default_find_cached_slices(Processor::Kind kind,
+                                                   const Domain &domain)
+    //--------------------------------------------------------------------------
+    {
+      std::map<Domain,std::vector<TaskSlice> > *cached_slices = NULL;
+      switch (kind)
+      {
+        case Processor::LOC_PROC:
+          {
+            cached_slices = &cpu_slices_cache;
+            break;
+          }
+        case Processor::TOC_PROC:
+          {
+            cached_slices = &gpu_slices_cache;
+            break;
+          }
+        case Processor::IO_PROC:
+          {
+            cached_slices = &io_slices_cache;
+            break;
+          }
+        case Processor::PROC_SET:
+          {
+            cached_slices = &procset_slices_cache;
+            break;
+          }
+        case Processor::OMP_PROC:
+          {
+            cached_slices = &omp_slices_cache;
+            break;
+          }
+        default:
+          return true; // nothing we would save
+      }
+      if (cached_slices->find(domain) != cached_slices->end())
+        return true;
+      std::vector<TaskSlice> slices;
+      if (!decision_cache->find_slices(kind, domain, slices))
+        return false;
+      // The machine signature matched, but make sure every processor
+      // is still one that we would slice across
+      for (std::vector<TaskSlice>::const_iterator it = 
+            slices.begin(); it != slices.end(); it++)
+        if (!it->proc.exists() || (it->proc.kind() != kind))
+          return false;
+      (*cached_slices)[domain] = slices;
+      return true;
     }
 
     //--------------------------------------------------------------------------
@@ -1544,6 +1692,8 @@ namespace Legion {
         }
       }
       // Now that we are done, let's cache the result so we can use it later
+      // (this one is never saved to the decision cache since the instances
+      // it names only exist in this run)
       std::list<CachedTaskMapping> &map_list = cached_task_mappings[cache_key];
       map_list.push_back(CachedTaskMapping());
       CachedTaskMapping &cached_result = map_list.back();
@@ -398,6 +398,11 @@ namespace Legion {
                                       const std::set<LogicalRegion> &regions);
       bool have_proc_kind_variant(const MapperContext ctx, TaskID id,
 				  Processor::Kind kind);
+      bool default_find_cached_decision(const Task &task, MapperContext ctx,
+                                 bool needs_tight_bound, Processor::Kind kind,
+                                 VariantInfo &result);
+      bool default_find_cached_slices(Processor::Kind kind, 
+                                      const Domain &domain);
     protected: // static helper methods
       static const char* create_default_name(Processor p);
       template<int DIM>
@@ -478,6 +483,10 @@ namespace Legion {
       bool stealing_enabled;
       // The maximum number of tasks scheduled per step
       unsigned max_schedule_count;
+    protected:
+      // Variant decisions saved across runs, controlled by -dm:cache
+      Utilities::MappingDecisionCache *decision_cache;
+      char *decision_cache_file;
     };
 
   }; // namespace Mapping
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <limits>
+#include <cstdio>
 
 namespace Legion {
   namespace Mapping {
@@ -606,6 +607,337 @@ namespace Legion {
       {
       }
     
+      /**************************
+       * Mapping Decision Cache
+       **************************/
+
+      static const unsigned MAPPING_FILE_MAGIC = 0x4C474D43; // LGMC
+      static const unsigned MAPPING_FILE_VERSION = 2;
+      // Bounds on the counts read back from a file so that a corrupt
+      // file is rejected rather than forcing a huge allocation
+      static const size_t MAX_MAPPING_FILE_ENTRIES = 1 << 20;
+      static const size_t MAX_MAPPING_FILE_SLICES = 1 << 20;
+
+      //------------------------------------------------------------------------
+      MappingDecisionCache::MappingDecisionCache(Machine m)
+        : machine_signature(compute_machine_signature(m)), dirty(false)
+      //------------------------------------------------------------------------
+      {
+      }
+
+      //------------------------------------------------------------------------
+      bool MappingDecisionCache::find_decision(TaskID task_id, 
+                       unsigned long long shape, Decision &decision) const
+      //------------------------------------------------------------------------
+      {
+        std::map<DecisionKey,Decision>::const_iterator finder = 
+          decisions.find(DecisionKey(machine_signature, task_id, shape));
+        if (finder == decisions.end())
+          return false;
+        decision = finder->second;
+        return true;
+      }
+
+      //------------------------------------------------------------------------
+      void MappingDecisionCache::record_decision(TaskID task_id,
+                 unsigned long long shape, const Decision &decision)
+      //------------------------------------------------------------------------
+      {
+        Decision &entry = 
+          decisions[DecisionKey(machine_signature, task_id, shape)];
+        // Anything decided in this run is valid in this run
+        entry.validated = true;
+        if ((entry.variant == decision.variant) && 
+            (entry.proc_kind == decision.proc_kind) &&
+            (entry.tight_bound == decision.tight_bound) &&
+            (entry.is_inner == decision.is_inner))
+          return;
+        entry = decision;
+        entry.validated = true;
+        dirty = true;
+      }
+
+      //------------------------------------------------------------------------
+      void MappingDecisionCache::validate_decision(TaskID task_id,
+                                                   unsigned long long shape)
+      //------------------------------------------------------------------------
+      {
+        std::map<DecisionKey,Decision>::iterator finder = 
+          decisions.find(DecisionKey(machine_signature, task_id, shape));
+        if (finder != decisions.end())
+          finder->second.validated = true;
+      }
+
+      //------------------------------------------------------------------------
+      void MappingDecisionCache::invalidate_decision(TaskID task_id,
+                                                     unsigned long long shape)
+      //------------------------------------------------------------------------
+      {
+        if (decisions.erase(DecisionKey(machine_signature, task_id, shape)))
+          dirty = true;
+      }
+
+      //------------------------------------------------------------------------
+      bool MappingDecisionCache::find_slices(Processor::Kind kind, 
+          const Domain &domain, std::vector<Mapper::TaskSlice> &result) const
+      //------------------------------------------------------------------------
+      {
+        std::map<SliceKey,std::vector<Mapper::TaskSlice> >::const_iterator
+          finder = slices.find(SliceKey(machine_signature, kind, domain));
+        if (finder == slices.end())
+          return false;
+        result = finder->second;
+        return true;
+      }
+
+      //------------------------------------------------------------------------
+      void MappingDecisionCache::record_slices(Processor::Kind kind,
+          const Domain &domain, const std::vector<Mapper::TaskSlice> &result)
+      //------------------------------------------------------------------------
+      {
+        // Only rectangles mean the same thing in the next run, domains
+        // named by index space handles do not
+        if ((domain.get_dim() == 0) || result.empty())
+          return;
+        for (std::vector<Mapper::TaskSlice>::const_iterator it = 
+              result.begin(); it != result.end(); it++)
+          if (it->domain.get_dim() == 0)
+            return;
+        slices[SliceKey(machine_signature, kind, domain)] = result;
+        dirty = true;
+      }
+
+      //------------------------------------------------------------------------
+      static bool write_rect_domain(FILE *f, const Domain &domain)
+      //------------------------------------------------------------------------
+      {
+        Domain::IDType data[1 + 2 * Domain::MAX_RECT_DIM];
+        const size_t words = domain.serialize(data) - data;
+        return (fwrite(data, sizeof(Domain::IDType), words, f) == words);
+      }
+
+      //------------------------------------------------------------------------
+      static bool read_rect_domain(FILE *f, Domain &domain)
+      //------------------------------------------------------------------------
+      {
+        Domain::IDType data[1 + 2 * Domain::MAX_RECT_DIM];
+        if (fread(data, sizeof(Domain::IDType), 1, f) != 1)
+          return false;
+        if ((data[0] < 1) || (data[0] > Domain::MAX_RECT_DIM))
+          return false;
+        const size_t words = 2 * data[0];
+        if (fread(data + 1, sizeof(Domain::IDType), words, f) != words)
+          return false;
+        domain.deserialize(data);
+        return true;
+      }
+
+      //------------------------------------------------------------------------
+      bool MappingDecisionCache::save(const char *filename) const
+      //------------------------------------------------------------------------
+      {
+        std::string temp_name = std::string(filename) + ".tmp";
+        FILE *f = fopen(temp_name.c_str(), "wb");
+        if (f == NULL)
+          return false;
+        const size_t count = decisions.size();
+        bool ok = (fwrite(&MAPPING_FILE_MAGIC, sizeof(MAPPING_FILE_MAGIC), 
+                          1, f) == 1);
+        ok = ok && (fwrite(&MAPPING_FILE_VERSION, 
+                           sizeof(MAPPING_FILE_VERSION), 1, f) == 1);
+        ok = ok && (fwrite(&count, sizeof(count), 1, f) == 1);
+        for (std::map<DecisionKey,Decision>::const_iterator it = 
+              decisions.begin(); ok && (it != decisions.end()); it++)
+        {
+          const int proc_kind = it->second.proc_kind;
+          const unsigned char tight = it->second.tight_bound ? 1 : 0;
+          const unsigned char inner = it->second.is_inner ? 1 : 0;
+          ok = ok && (fwrite(&it->first.signature, 
+                             sizeof(it->first.signature), 1, f) == 1);
+          ok = ok && (fwrite(&it->first.task_id, 
+                             sizeof(it->first.task_id), 1, f) == 1);
+          ok = ok && (fwrite(&it->first.shape, 
+                             sizeof(it->first.shape), 1, f) == 1);
+          ok = ok && (fwrite(&it->second.variant, 
+                             sizeof(it->second.variant), 1, f) == 1);
+          ok = ok && (fwrite(&proc_kind, sizeof(proc_kind), 1, f) == 1);
+          ok = ok && (fwrite(&tight, sizeof(tight), 1, f) == 1);
+          ok = ok && (fwrite(&inner, sizeof(inner), 1, f) == 1);
+        }
+        const size_t slice_count = slices.size();
+        ok = ok && (fwrite(&slice_count, sizeof(slice_count), 1, f) == 1);
+        for (std::map<SliceKey,std::vector<Mapper::TaskSlice> >::
+              const_iterator it = slices.begin(); ok && 
+              (it != slices.end()); it++)
+        {
+          const int kind = it->first.kind;
+          const size_t num_slices = it->second.size();
+          ok = ok && (fwrite(&it->first.signature, 
+                             sizeof(it->first.signature), 1, f) == 1);
+          ok = ok && (fwrite(&kind, sizeof(kind), 1, f) == 1);
+          ok = ok && write_rect_domain(f, it->first.domain);
+          ok = ok && (fwrite(&num_slices, sizeof(num_slices), 1, f) == 1);
+          for (std::vector<Mapper::TaskSlice>::const_iterator sit = 
+                it->second.begin(); ok && (sit != it->second.end()); sit++)
+          {
+            const unsigned char recurse = sit->recurse ? 1 : 0;
+            const unsigned char stealable = sit->stealable ? 1 : 0;
+            ok = ok && write_rect_domain(f, sit->domain);
+            ok = ok && (fwrite(&sit->proc.id, 
+                               sizeof(sit->proc.id), 1, f) == 1);
+            ok = ok && (fwrite(&recurse, sizeof(recurse), 1, f) == 1);
+            ok = ok && (fwrite(&stealable, sizeof(stealable), 1, f) == 1);
+          }
+        }
+        if ((fclose(f) != 0) || !ok || 
+            (rename(temp_name.c_str(), filename) != 0))
+        {
+          remove(temp_name.c_str());
+          return false;
+        }
+        dirty = false;
+        return true;
+      }
+
+      //------------------------------------------------------------------------
+      bool MappingDecisionCache::load(const char *filename)
+      //------------------------------------------------------------------------
+      {
+        FILE *f = fopen(filename, "rb");
+        if (f == NULL)
+          return false;
+        unsigned magic = 0, version = 0;
+        size_t count = 0;
+        bool ok = (fread(&magic, sizeof(magic), 1, f) == 1) && 
+                  (magic == MAPPING_FILE_MAGIC);
+        ok = ok && (fread(&version, sizeof(version), 1, f) == 1) &&
+                   (version == MAPPING_FILE_VERSION);
+        ok = ok && (fread(&count, sizeof(count), 1, f) == 1) &&
+                   (count <= MAX_MAPPING_FILE_ENTRIES);
+        std::map<DecisionKey,Decision> loaded;
+        for (size_t i = 0; ok && (i < count); i++)
+        {
+          DecisionKey key(0, 0, 0);
+          Decision decision;
+          int proc_kind = 0;
+          unsigned char tight = 0, inner = 0;
+          ok = ok && (fread(&key.signature, sizeof(key.signature), 1, f) == 1);
+          ok = ok && (fread(&key.task_id, sizeof(key.task_id), 1, f) == 1);
+          ok = ok && (fread(&key.shape, sizeof(key.shape), 1, f) == 1);
+          ok = ok && (fread(&decision.variant, 
+                            sizeof(decision.variant), 1, f) == 1);
+          ok = ok && (fread(&proc_kind, sizeof(proc_kind), 1, f) == 1);
+          ok = ok && (fread(&tight, sizeof(tight), 1, f) == 1);
+          ok = ok && (fread(&inner, sizeof(inner), 1, f) == 1);
+          if (!ok)
+            break;
+          decision.proc_kind = (Processor::Kind)proc_kind;
+          decision.tight_bound = (tight != 0);
+          decision.is_inner = (inner != 0);
+          loaded[key] = decision;
+        }
+        size_t slice_count = 0;
+        ok = ok && (fread(&slice_count, sizeof(slice_count), 1, f) == 1) &&
+                   (slice_count <= MAX_MAPPING_FILE_ENTRIES);
+        std::map<SliceKey,std::vector<Mapper::TaskSlice> > loaded_slices;
+        for (size_t i = 0; ok && (i < slice_count); i++)
+        {
+          SliceKey key(0, Processor::NO_KIND, Domain::NO_DOMAIN);
+          int kind = 0;
+          size_t num_slices = 0;
+          ok = ok && (fread(&key.signature, sizeof(key.signature), 1, f) == 1);
+          ok = ok && (fread(&kind, sizeof(kind), 1, f) == 1);
+          ok = ok && read_rect_domain(f, key.domain);
+          ok = ok && (fread(&num_slices, sizeof(num_slices), 1, f) == 1) &&
+                     (num_slices <= MAX_MAPPING_FILE_SLICES);
+          if (!ok)
+            break;
+          key.kind = (Processor::Kind)kind;
+          std::vector<Mapper::TaskSlice> &result = loaded_slices[key];
+          result.resize(num_slices);
+          for (size_t idx = 0; ok && (idx < num_slices); idx++)
+          {
+            unsigned char recurse = 0, stealable = 0;
+            ok = ok && read_rect_domain(f, result[idx].domain);
+            ok = ok && (fread(&result[idx].proc.id, 
+                              sizeof(result[idx].proc.id), 1, f) == 1);
+            ok = ok && (fread(&recurse, sizeof(recurse), 1, f) == 1);
+            ok = ok && (fread(&stealable, sizeof(stealable), 1, f) == 1);
+            result[idx].recurse = (recurse != 0);
+            result[idx].stealable = (stealable != 0);
+          }
+        }
+        fclose(f);
+        if (!ok)
+          return false;
+        // Anything decided in this run takes precedence
+        for (std::map<DecisionKey,Decision>::const_iterator it = 
+              loaded.begin(); it != loaded.end(); it++)
+          decisions.insert(*it);
+        for (std::map<SliceKey,std::vector<Mapper::TaskSlice> >::
+              const_iterator it = loaded_slices.begin(); 
+              it != loaded_slices.end(); it++)
+          slices.insert(*it);
+        return true;
+      }
+
+      //------------------------------------------------------------------------
+      /*static*/ unsigned long long 
+        MappingDecisionCache::compute_machine_signature(Machine machine)
+      //------------------------------------------------------------------------
+      {
+        // Same style of hash as the default mapper's task hash, but
+        // queries iterate in ID order so this is the same on every node
+        const unsigned long long c1 = 0x5491C27F12DB3FA5;
+        const unsigned long long c2 = 353435097;
+        unsigned long long result = c2;
+        Machine::ProcessorQuery all_procs(machine);
+        for (Machine::ProcessorQuery::iterator it = all_procs.begin();
+              it != all_procs.end(); it++)
+        {
+          result = result * c1 + c2 + it->address_space();
+          result = result * c1 + c2 + it->kind();
+        }
+        Machine::MemoryQuery all_mems(machine);
+        for (Machine::MemoryQuery::iterator it = all_mems.begin();
+              it != all_mems.end(); it++)
+        {
+          result = result * c1 + c2 + it->address_space();
+          result = result * c1 + c2 + it->kind();
+          result = result * c1 + c2 + it->capacity();
+        }
+        return result;
+      }
+
+      //------------------------------------------------------------------------
+      /*static*/ unsigned long long 
+        MappingDecisionCache::compute_region_shape(const Task &task)
+      //------------------------------------------------------------------------
+      {
+        const unsigned long long c1 = 0x5491C27F12DB3FA5;
+        const unsigned long long c2 = 353435097;
+        unsigned long long result = c2 + task.regions.size();
+        for (unsigned idx = 0; idx < task.regions.size(); idx++)
+        {
+          const RegionRequirement &req = task.regions[idx];
+          result = result * c1 + c2 + req.handle_type;
+          result = result * c1 + c2 + req.privilege_fields.size();
+          result = result * c1 + c2 + req.privilege;
+          result = result * c1 + c2 + req.prop;
+          result = result * c1 + c2 + req.redop;
+          result = result * c1 + c2 + req.tag;
+        }
+        return result;
+      }
+
+      //------------------------------------------------------------------------
+      MappingDecisionCache::Decision::Decision(void)
+        : variant(0), proc_kind(Processor::NO_KIND), 
+          tight_bound(false), is_inner(false), validated(false)
+      //------------------------------------------------------------------------
+      {
+      }
+
       /************************
        * Mapping Profiler
        ************************/
@@ -18,6 +18,7 @@
 #define __MAPPING_UTILITIES__
 
 #include "legion.h"
+#include "legion_mapping.h"
 
 #include <cstdlib>
 #include <cassert>
@@ -175,6 +176,124 @@ namespace Legion {
         std::map<MappingKey,MemoizedMapping> permanent_mappings;
       };
 
+      /**
+       * A cache of variant decisions that can be saved to a file
+       * at shutdown and loaded again at startup so that later runs 
+       * of the same application skip the policy code for tasks that
+       * they have already seen.  Decisions are keyed by task ID, the 
+       * shape of the task's region requirements (not the regions 
+       * themselves) and a signature of the machine that they were 
+       * made on.  Only decisions with the signature of the current 
+       * machine are ever returned, so stale decisions from another 
+       * machine cost a single integer comparison.  Decisions from 
+       * other machines are kept and saved again so that one file 
+       * can be shared by several machine shapes.  The cache also 
+       * keeps the slices chosen for rectangular index space launch 
+       * domains, keyed the same way by the processor kind they were 
+       * sliced across.  Physical instance choices are not kept since 
+       * the instances themselves do not outlive the run that made them.
+       */
+      class MappingDecisionCache {
+      public:
+        struct Decision {
+        public:
+          Decision(void);
+        public:
+          VariantID       variant;
+          Processor::Kind proc_kind;
+          bool            tight_bound;
+          bool            is_inner;
+          // Set once the variant has been checked against the variants
+          // registered in this run, never saved
+          bool            validated;
+        };
+      public:
+        MappingDecisionCache(Machine m);
+      public:
+        bool find_decision(TaskID task_id, unsigned long long shape,
+                           Decision &decision) const;
+        void record_decision(TaskID task_id, unsigned long long shape,
+                             const Decision &decision);
+        void validate_decision(TaskID task_id, unsigned long long shape);
+        void invalidate_decision(TaskID task_id, unsigned long long shape);
+      public:
+        bool find_slices(Processor::Kind kind, const Domain &domain,
+                         std::vector<Mapper::TaskSlice> &slices) const;
+        void record_slices(Processor::Kind kind, const Domain &domain,
+                           const std::vector<Mapper::TaskSlice> &slices);
+        inline unsigned long long get_machine_signature(void) const
+          { return machine_signature; }
+        inline bool is_dirty(void) const { return dirty; }
+      public:
+        /**
+         * Save all the decisions to a file.  Returns true on success.
+         */
+        bool save(const char *filename) const;
+        /**
+         * Load decisions from a file written by save.  Returns false
+         * if the file does not exist or was not written by save.
+         */
+        bool load(const char *filename);
+      public:
+        /**
+         * Compute a signature for the machine from the number and 
+         * kind of processors and memories on each node along with
+         * the capacity of the memories.
+         */
+        static unsigned long long compute_machine_signature(Machine machine);
+        /**
+         * Compute a hash of the shape of the region requirements of 
+         * a task: their number, privileges, coherence, reduction 
+         * operators, tags and the number of fields, but not the 
+         * names of the regions or fields.
+         */
+        static unsigned long long compute_region_shape(const Task &task);
+      protected:
+        struct DecisionKey {
+        public:
+          DecisionKey(unsigned long long sig, TaskID tid, 
+                      unsigned long long s)
+            : signature(sig), task_id(tid), shape(s) { }
+        public:
+          inline bool operator<(const DecisionKey &rhs) const
+          {
+            if (signature < rhs.signature) return true;
+            if (signature > rhs.signature) return false;
+            if (task_id < rhs.task_id) return true;
+            if (task_id > rhs.task_id) return false;
+            return (shape < rhs.shape);
+          }
+        public:
+          unsigned long long signature;
+          TaskID task_id;
+          unsigned long long shape;
+        };
+        struct SliceKey {
+        public:
+          SliceKey(unsigned long long sig, Processor::Kind k, 
+                   const Domain &d)
+            : signature(sig), kind(k), domain(d) { }
+        public:
+          inline bool operator<(const SliceKey &rhs) const
+          {
+            if (signature < rhs.signature) return true;
+            if (signature > rhs.signature) return false;
+            if (kind < rhs.kind) return true;
+            if (kind > rhs.kind) return false;
+            return (domain < rhs.domain);
+          }
+        public:
+          unsigned long long signature;
+          Processor::Kind kind;
+          Domain domain;
+        };
+      protected:
+        const unsigned long long machine_signature;
+        std::map<DecisionKey,Decision> decisions;
+        std::map<SliceKey,std::vector<Mapper::TaskSlice> > slices;
+        mutable bool dirty;
+      };
+
       /**
        * The Mapping Profiler will cycle through all the different 
        * variants of the task until it has reached the required 
@@ -294,6 +413,8 @@ namespace LegionRuntime {
         MachineQueryInterface;
       typedef Legion::Mapping::Utilities::MappingMemoizer MappingMemoizer;
       typedef Legion::Mapping::Utilities::MappingProfiler MappingProfiler;
+      typedef Legion::Mapping::Utilities::MappingDecisionCache 
+        MappingDecisionCache;
     };
   };
 };
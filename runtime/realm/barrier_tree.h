@@ -0,0 +1,94 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// arrival trees for tree-mode barriers
+
+#ifndef REALM_BARRIER_TREE_H
+#define REALM_BARRIER_TREE_H
+
+#include <vector>
+#include <map>
+
+#include "redop.h"
+
+namespace Realm {
+
+  // positions in a k-ary tree of 'num_nodes' nodes rooted at 'root' - the
+  //  node count is a parameter (rather than gasnet_nodes()) so that the
+  //  topology can be exercised without a multi-node launch
+  namespace BarrierTree {
+    inline unsigned parent(unsigned node, unsigned root, unsigned radix,
+			   unsigned num_nodes);
+    inline void children(unsigned node, unsigned root, unsigned radix,
+			 unsigned num_nodes, std::vector<unsigned>& children);
+
+    // stores the reduction results carried by a trigger message for the
+    //  generations (previous_gen, trigger_gen] into a node's result array,
+    //  which holds the value for generation g at index (g - first_gen - 1)
+    //  and is grown as needed
+    inline void store_values(char *& values, unsigned& capacity,
+			     unsigned first_gen, unsigned previous_gen,
+			     unsigned trigger_gen,
+			     const void *data, size_t elem_size);
+  };
+
+  // the per-node state for combining arrivals on their way up the tree: the
+  //  first arrival goes out immediately, and while anything sent to the
+  //  parent is unacknowledged, further arrivals (local or from children) are
+  //  folded together per generation and released when the last ack comes back
+  // the combiner does no locking or messaging of its own - the caller holds
+  //  whatever lock protects it and sends whatever it is told to send
+  template <typename GEN>
+  class BarrierArrivalCombiner {
+  public:
+    BarrierArrivalCombiner(void);
+    ~BarrierArrivalCombiner(void);
+
+    struct CombinedArrival {
+      int delta;
+      ReductionOpID redop_id;
+      char *value;
+      size_t value_size;
+    };
+
+    typedef std::map<GEN, CombinedArrival> PendingMap;
+
+    // returns true if the arrival should be sent to the parent right away,
+    //  false if it was folded into the pending arrivals for its generation
+    //  ('redop' is only used for folding and may be null if there is no value)
+    bool add_arrival(GEN gen, int delta, ReductionOpID redop_id,
+		     const ReductionOpUntyped *redop,
+		     const void *value, size_t value_size);
+
+    // called for each ack from the parent - if that was the last outstanding
+    //  message, any pending arrivals are moved into 'to_send' (one message
+    //  each), and the caller must free their values once they're sent
+    void acknowledged(PendingMap& to_send);
+
+    // pending delta for a generation (0 if nothing is pending)
+    int pending_delta(GEN gen) const;
+
+    void clear(void);
+
+  protected:
+    unsigned in_flight;
+    PendingMap pending;
+  };
+
+};
+
+#include "barrier_tree.inl"
+
+#endif // ifndef REALM_BARRIER_TREE_H
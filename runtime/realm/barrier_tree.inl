@@ -0,0 +1,163 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// arrival trees for tree-mode barriers
+
+// nop, but helps IDEs
+#include "barrier_tree.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+namespace Realm {
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // namespace BarrierTree
+
+  namespace BarrierTree {
+
+    inline unsigned parent(unsigned node, unsigned root, unsigned radix,
+			   unsigned num_nodes)
+    {
+      // number the nodes relative to the root, which is 0
+      unsigned rel = (node + num_nodes - root) % num_nodes;
+      assert(rel > 0);
+      return (((rel - 1) / radix) + root) % num_nodes;
+    }
+
+    inline void children(unsigned node, unsigned root, unsigned radix,
+			 unsigned num_nodes, std::vector<unsigned>& children)
+    {
+      unsigned rel = (node + num_nodes - root) % num_nodes;
+      for(unsigned i = 1; i <= radix; i++) {
+	unsigned child = (rel * radix) + i;
+	if(child >= num_nodes) break;
+	children.push_back((child + root) % num_nodes);
+      }
+    }
+
+    inline void store_values(char *& values, unsigned& capacity,
+			     unsigned first_gen, unsigned previous_gen,
+			     unsigned trigger_gen,
+			     const void *data, size_t elem_size)
+    {
+      int rel_gen = trigger_gen - first_gen;
+      assert(rel_gen > 0);
+      if(capacity < (unsigned)rel_gen) {
+	values = (char *)realloc(values, rel_gen * elem_size);
+	// no need to initialize new entries - we'll overwrite them now or when data does show up
+	capacity = rel_gen;
+      }
+      // the values start with the one for generation previous_gen + 1
+      memcpy(values + ((previous_gen - first_gen) * elem_size),
+	     data, (trigger_gen - previous_gen) * elem_size);
+    }
+
+  };
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class BarrierArrivalCombiner<GEN>
+
+  template <typename GEN>
+  inline BarrierArrivalCombiner<GEN>::BarrierArrivalCombiner(void)
+    : in_flight(0)
+  {}
+
+  template <typename GEN>
+  inline BarrierArrivalCombiner<GEN>::~BarrierArrivalCombiner(void)
+  {
+    clear();
+  }
+
+  template <typename GEN>
+  inline bool BarrierArrivalCombiner<GEN>::add_arrival(GEN gen, int delta,
+						       ReductionOpID redop_id,
+						       const ReductionOpUntyped *redop,
+						       const void *value,
+						       size_t value_size)
+  {
+    if(in_flight == 0) {
+      // nothing to wait for - send this one right away
+      in_flight = 1;
+      return true;
+    }
+
+    typename PendingMap::iterator it = pending.find(gen);
+    if(it == pending.end()) {
+      CombinedArrival& ca = pending[gen];
+      ca.delta = delta;
+      ca.redop_id = redop_id;
+      ca.value = 0;
+      ca.value_size = value_size;
+      if(value_size > 0) {
+	ca.value = (char *)malloc(value_size);
+	memcpy(ca.value, value, value_size);
+      }
+    } else {
+      CombinedArrival& ca = it->second;
+      ca.delta += delta;
+      if(value_size > 0) {
+	if(ca.value_size > 0) {
+	  assert(ca.value_size == value_size);
+	  assert(redop != 0);
+	  redop->fold(ca.value, value, 1, true /*exclusive*/);
+	} else {
+	  ca.redop_id = redop_id;
+	  ca.value = (char *)malloc(value_size);
+	  memcpy(ca.value, value, value_size);
+	  ca.value_size = value_size;
+	}
+      }
+    }
+    return false;
+  }
+
+  template <typename GEN>
+  inline void BarrierArrivalCombiner<GEN>::acknowledged(PendingMap& to_send)
+  {
+    assert(in_flight > 0);
+    in_flight--;
+    // once everything we sent has been acknowledged, send whatever has
+    //  piled up in the meantime
+    if((in_flight == 0) && !pending.empty()) {
+      to_send.swap(pending);
+      in_flight = to_send.size();
+    }
+  }
+
+  template <typename GEN>
+  inline int BarrierArrivalCombiner<GEN>::pending_delta(GEN gen) const
+  {
+    typename PendingMap::const_iterator it = pending.find(gen);
+    return ((it != pending.end()) ? it->second.delta : 0);
+  }
+
+  template <typename GEN>
+  inline void BarrierArrivalCombiner<GEN>::clear(void)
+  {
+    for(typename PendingMap::iterator it = pending.begin();
+	it != pending.end();
+	it++)
+      if(it->second.value)
+	free(it->second.value);
+    pending.clear();
+    in_flight = 0;
+  }
+
+};
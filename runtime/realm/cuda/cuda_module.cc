@@ -1593,7 +1593,7 @@ namespace Realm {
       : MemoryImpl(_me, _size, MKIND_GPUFB, 512, Memory::GPU_FB_MEM)
       , gpu(_gpu), base(_base)
     {
-      free_blocks[0] = size;
+      free_blocks.add_range(0, size);
     }
 
     GPUFBMemory::~GPUFBMemory(void) {}
@@ -1667,7 +1667,7 @@ namespace Realm {
       : MemoryImpl(_me, _size, MKIND_ZEROCOPY, 256, Memory::Z_COPY_MEM)
       , gpu_base(_gpu_base), cpu_base((char *)_cpu_base)
     {
-      free_blocks[0] = size;
+      free_blocks.add_range(0, size);
     }
 
     GPUZCMemory::~GPUZCMemory(void) {}
@@ -29,7 +29,6 @@ namespace Realm {
 
       int level;
       IT first_index, last_index;
-      LT lock;
     };
 
     template <typename ET, size_t _SIZE, typename LT, typename IT>
@@ -62,9 +61,10 @@ namespace Realm {
 
     protected:
       NodeBase *new_tree_node(int level, IT first_index, IT last_index,
-			      int owner, typename ALLOCATOR::FreeList *free_list);
+			      int owner);
 
-      // lock protects _changes_ to 'root', but not access to it
+      // lock protects _changes_ to 'root', but not access to it - child nodes
+      //  are installed with a compare-and-swap and need no lock at all
       LT lock;
       NodeBase * volatile root;
     };
@@ -81,11 +81,32 @@ namespace Realm {
       ET *alloc_entry(void);
       void free_entry(ET *entry);
 
+      // called by the table when it installs a new leaf - all of its entries
+      //  go on the shared free list
+      void push_new_leaf(typename ALLOCATOR::LEAF_TYPE *leaf);
+
+      // each thread keeps some entries of its own, and moves them to or from
+      //  the shared list this many at a time, so most allocs and frees don't
+      //  touch the lock
+      static const unsigned CACHE_BATCH_SIZE = 32;
+
       DynamicTable<ALLOCATOR>& table;
       int owner;
       LT lock;
       ET * volatile first_free;
       IT volatile next_alloc;
+
+    protected:
+      struct ThreadCache {
+	DynamicTableFreeList<ALLOCATOR> *list;
+	ET *head;
+	unsigned count;
+      };
+
+      // gives all but 'keep' of a thread's cached entries back to their list
+      static void flush_thread_cache(ThreadCache& cache, unsigned keep);
+
+      static __thread ThreadCache thread_cache;
     };
 	
 }; // namespace Realm
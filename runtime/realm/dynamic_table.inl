@@ -67,7 +67,7 @@ namespace Realm {
   }
 
   template <typename ALLOCATOR>
-  typename DynamicTable<ALLOCATOR>::NodeBase *DynamicTable<ALLOCATOR>::new_tree_node(int level, IT first_index, IT last_index, int owner, typename ALLOCATOR::FreeList *free_list /*= 0*/)
+  typename DynamicTable<ALLOCATOR>::NodeBase *DynamicTable<ALLOCATOR>::new_tree_node(int level, IT first_index, IT last_index, int owner)
   {
     if(level > 0) {
       // an inner node - we can create that ourselves
@@ -76,7 +76,7 @@ namespace Realm {
 	inner->elems[i] = 0;
       return inner;
     } else {
-      return ALLOCATOR::new_leaf_node(first_index, last_index, owner, free_list);
+      return ALLOCATOR::new_leaf_node(first_index, last_index, owner);
     }
   }
 
@@ -154,14 +154,17 @@ namespace Realm {
 
       if(!root) {
 	// simple case - just create a root node at the level we want
-	root = new_tree_node(level_needed, 0, elems_addressable - 1, owner, free_list);
+	NodeBase *new_root = new_tree_node(level_needed, 0, elems_addressable - 1, owner);
+	if((level_needed == 0) && free_list)
+	  free_list->push_new_leaf(static_cast<typename ALLOCATOR::LEAF_TYPE *>(new_root));
+	root = new_root;
       } else {
 	// some of the tree already exists - add new layers on top
 	while(root->level < level_needed) {
 	  int parent_level = root->level + 1;
 	  IT parent_first = 0;
 	  IT parent_last = (((root->last_index + 1) << ALLOCATOR::INNER_BITS) - 1);
-	  NodeBase *parent = new_tree_node(parent_level, parent_first, parent_last, owner, free_list);
+	  NodeBase *parent = new_tree_node(parent_level, parent_first, parent_last, owner);
 	  typename ALLOCATOR::INNER_TYPE *inner = static_cast<typename ALLOCATOR::INNER_TYPE *>(parent);
 	  inner->elems[0] = root;
 	  root = parent;
@@ -187,23 +190,24 @@ namespace Realm {
 
       NodeBase *child = inner->elems[i];
       if(child == 0) {
-	// need to populate subtree
-
-	// take lock on inner node
-	inner->lock.lock();
-
-	// now that lock is held, see if we really need to make new node
-	if(inner->elems[i] == 0) {
-	  int child_level = inner->level - 1;
-	  int child_shift = (ALLOCATOR::LEAF_BITS + child_level * ALLOCATOR::INNER_BITS);
-	  IT child_first = inner->first_index + (i << child_shift);
-	  IT child_last = inner->first_index + ((i + 1) << child_shift) - 1;
-
-	  inner->elems[i] = new_tree_node(child_level, child_first, child_last, owner, free_list);
+	// need to populate subtree - build the new node without any lock held
+	//  and try to install it - if somebody else got there first, throw
+	//  ours away and use theirs
+	int child_level = inner->level - 1;
+	int child_shift = (ALLOCATOR::LEAF_BITS + child_level * ALLOCATOR::INNER_BITS);
+	IT child_first = inner->first_index + (i << child_shift);
+	IT child_last = inner->first_index + ((i + 1) << child_shift) - 1;
+
+	NodeBase *new_child = new_tree_node(child_level, child_first, child_last, owner);
+	if(__sync_bool_compare_and_swap(&(inner->elems[i]), (NodeBase *)0, new_child)) {
+	  // only the winner's entries can go on the free list
+	  if((child_level == 0) && free_list)
+	    free_list->push_new_leaf(static_cast<typename ALLOCATOR::LEAF_TYPE *>(new_child));
+	  child = new_child;
+	} else {
+	  delete new_child;
+	  child = inner->elems[i];
 	}
-	child = inner->elems[i];
-
-	inner->lock.unlock();
       }
       assert((child != 0) &&
 	     (child->level == (n->level - 1)) &&
@@ -224,6 +228,9 @@ namespace Realm {
   // class DynamicTableFreeList<ALLOCATOR>
   //
 
+  template <typename ALLOCATOR>
+  __thread typename DynamicTableFreeList<ALLOCATOR>::ThreadCache DynamicTableFreeList<ALLOCATOR>::thread_cache = { 0, 0, 0 };
+
   template <typename ALLOCATOR>
   DynamicTableFreeList<ALLOCATOR>::DynamicTableFreeList(DynamicTable<ALLOCATOR>& _table, int _owner)
     : table(_table), owner(_owner), first_free(0), next_alloc(0)
@@ -232,28 +239,53 @@ namespace Realm {
   template <typename ALLOCATOR>
   typename DynamicTableFreeList<ALLOCATOR>::ET *DynamicTableFreeList<ALLOCATOR>::alloc_entry(void)
   {
-    // take the lock first, since we're messing with the free list
-    lock.lock();
+    ThreadCache& cache = thread_cache;
 
-    // if the free list is empty, we can fill it up by referencing the next entry to be allocated -
-    // this uses the existing dynamic-filling code to avoid race conditions
-    while(!first_free) {
-      IT to_lookup = next_alloc;
-      next_alloc += ((IT)1) << ALLOCATOR::LEAF_BITS; // do this before letting go of lock
-      lock.unlock();
+    // a thread's cache only holds entries from one list at a time
+    if(cache.list != this) {
+      if(cache.list)
+	flush_thread_cache(cache, 0);
+      cache.list = this;
+    }
+
+    if(!cache.head) {
+      // refill from the shared list - take the lock first, since we're messing with it
+      lock.lock();
+
+      // if the free list is empty, we can fill it up by referencing the next entry to be allocated -
+      // this uses the existing dynamic-filling code to avoid race conditions
+      while(!first_free) {
+	IT to_lookup = next_alloc;
+	next_alloc += ((IT)1) << ALLOCATOR::LEAF_BITS; // do this before letting go of lock
+	lock.unlock();
 #ifndef NDEBUG
-      typename DynamicTable<ALLOCATOR>::ET *dummy =
+	typename DynamicTable<ALLOCATOR>::ET *dummy =
 #endif
-        table.lookup_entry(to_lookup, owner, this);
-      assert(dummy != 0);
-      // can't actually use dummy because we let go of lock - retake lock and hopefully find non-empty
-      //  list next time
-      lock.lock();
+	  table.lookup_entry(to_lookup, owner, this);
+	assert(dummy != 0);
+	// can't actually use dummy because we let go of lock - retake lock and hopefully find non-empty
+	//  list next time
+	lock.lock();
+      }
+
+      // take up to a batch's worth
+      ET *last = first_free;
+      unsigned count = 1;
+      while(last->next_free && (count < CACHE_BATCH_SIZE)) {
+	last = last->next_free;
+	count++;
+      }
+      cache.head = first_free;
+      cache.count = count;
+      first_free = last->next_free;
+      last->next_free = 0;
+
+      lock.unlock();
     }
 
-    typename DynamicTable<ALLOCATOR>::ET *entry = first_free;
-    first_free = entry->next_free;
-    lock.unlock();
+    ET *entry = cache.head;
+    cache.head = entry->next_free;
+    cache.count--;
 
     return entry;
   }
@@ -261,11 +293,69 @@ namespace Realm {
   template <typename ALLOCATOR>
   void DynamicTableFreeList<ALLOCATOR>::free_entry(ET *entry)
   {
-    // just stick ourselves on front of free list
+    ThreadCache& cache = thread_cache;
+
+    if(cache.list != this) {
+      if(cache.list)
+	flush_thread_cache(cache, 0);
+      cache.list = this;
+    }
+
+    // just stick ourselves on front of this thread's list
+    entry->next_free = cache.head;
+    cache.head = entry;
+    cache.count++;
+
+    // a thread that frees more than it allocates hands the excess back
+    if(cache.count >= (2 * CACHE_BATCH_SIZE))
+      flush_thread_cache(cache, CACHE_BATCH_SIZE);
+  }
+
+  template <typename ALLOCATOR>
+  void DynamicTableFreeList<ALLOCATOR>::push_new_leaf(typename ALLOCATOR::LEAF_TYPE *leaf)
+  {
+    // stitch all the new elements into the free list (except for the
+    //  very first entry in the table, which is never handed out)
+    IT first_ofs = (leaf->first_index ? 0 : 1);
+    IT last_ofs = (((IT)1) << ALLOCATOR::LEAF_BITS) - 1;
+
+    for(IT i = first_ofs; i < last_ofs; i++)
+      leaf->elems[i].next_free = &(leaf->elems[i+1]);
+
     lock.lock();
-    entry->next_free = first_free;
-    first_free = entry;
+    leaf->elems[last_ofs].next_free = first_free;
+    first_free = &(leaf->elems[first_ofs]);
     lock.unlock();
   }
 
+  template <typename ALLOCATOR>
+  /*static*/ void DynamicTableFreeList<ALLOCATOR>::flush_thread_cache(ThreadCache& cache,
+								     unsigned keep)
+  {
+    if(cache.count <= keep)
+      return;
+
+    // split off everything past the first 'keep' entries
+    ET *first = cache.head;
+    if(keep > 0) {
+      ET *last_kept = cache.head;
+      for(unsigned i = 1; i < keep; i++)
+	last_kept = last_kept->next_free;
+      first = last_kept->next_free;
+      last_kept->next_free = 0;
+    } else
+      cache.head = 0;
+
+    ET *last = first;
+    while(last->next_free)
+      last = last->next_free;
+    cache.count = keep;
+
+    DynamicTableFreeList<ALLOCATOR> *list = cache.list;
+    list->lock.lock();
+    last->next_free = list->first_free;
+    list->first_free = first;
+    list->lock.unlock();
+  }
+
 }; // namespace Realm
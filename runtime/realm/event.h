@@ -106,8 +106,14 @@ namespace Realm {
 
       static const Barrier NO_BARRIER;
 
+      // if arrival_radix is non-zero, arrivals made on other nodes are combined
+      //  up a tree of nodes (rooted at the creating node) with that fan-in, and
+      //  triggers are broadcast back down the same tree to every node - this
+      //  suits barriers that all nodes arrive at and wait on (e.g. SPMD phase
+      //  barriers), and is ignored for reduction ops that can't be folded
       static Barrier create_barrier(unsigned expected_arrivals, ReductionOpID redop_id = 0,
-				    const void *initial_value = 0, size_t initial_value_size = 0);
+				    const void *initial_value = 0, size_t initial_value_size = 0,
+				    unsigned arrival_radix = 0);
       void destroy_barrier(void);
 
       Barrier advance_barrier(void) const;
@@ -38,7 +38,7 @@ namespace Realm {
 
   class DeferredEventTrigger : public EventWaiter {
   public:
-    DeferredEventTrigger(Event _after_event);
+    DeferredEventTrigger(Event _after_event, bool _ignore_faults = false);
 
     virtual ~DeferredEventTrigger(void);
     
@@ -50,17 +50,20 @@ namespace Realm {
 
   protected:
     Event after_event;
+    bool ignore_faults;
   };
   
-  DeferredEventTrigger::DeferredEventTrigger(Event _after_event)
+  DeferredEventTrigger::DeferredEventTrigger(Event _after_event,
+					     bool _ignore_faults /*= false*/)
     : after_event(_after_event)
+    , ignore_faults(_ignore_faults)
   {}
 
   DeferredEventTrigger::~DeferredEventTrigger(void) { }
 
   bool DeferredEventTrigger::event_triggered(Event e, bool poisoned)
   {
-    if(poisoned) {
+    if(poisoned && !ignore_faults) {
       log_poison.info() << "poisoned deferred event: event=" << after_event;
       GenEventImpl::trigger(after_event, true /*poisoned*/);
       return true;
@@ -331,6 +334,8 @@ namespace Realm {
     // if non-zero, eagerly checks deferred user event triggers for loops up to the
     //  specified limit
     int event_loop_detection_limit = 0;
+
+    int batch_event_triggers = 1;
   };
 
   void UserEvent::trigger(Event wait_on) const
@@ -358,7 +363,7 @@ namespace Realm {
 	  assert(0);
 	}
       }
-      EventImpl::add_waiter(wait_on, new DeferredEventTrigger(*this));
+      EventImpl::add_trigger_link(wait_on, *this, false /*!ignore_faults*/);
       return;
     }
 
@@ -405,11 +410,13 @@ namespace Realm {
   /*static*/ Barrier Barrier::create_barrier(unsigned expected_arrivals,
 					     ReductionOpID redop_id /*= 0*/,
 					     const void *initial_value /*= 0*/,
-					     size_t initial_value_size /*= 0*/)
+					     size_t initial_value_size /*= 0*/,
+					     unsigned arrival_radix /*= 0*/)
   {
     DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
 
-    BarrierImpl *impl = BarrierImpl::create_barrier(expected_arrivals, redop_id, initial_value, initial_value_size);
+    BarrierImpl *impl = BarrierImpl::create_barrier(expected_arrivals, redop_id, initial_value, initial_value_size,
+						    arrival_radix);
     Barrier b = impl->current_barrier();
 
 #ifdef EVENT_GRAPH_TRACE
@@ -495,13 +502,19 @@ namespace Realm {
   // class EventImpl
   //
 
+  // one step along an event chain - trigger links have no waiter object
+  struct EventChainLink {
+    Event finish_event;
+    EventWaiter *waiter;
+  };
+
   /*static*/ bool EventImpl::detect_event_chain(Event search_from, Event target,
 						int max_depth, bool print_chain)
   {
     std::vector<Event> events;
     std::vector<EventWaiter *> waiters;
     std::set<Event> events_seen;
-    std::vector<EventWaiter *> todo;
+    std::vector<EventChainLink> todo;
 
     events.reserve(max_depth + 1);
     waiters.reserve(max_depth + 1);
@@ -511,7 +524,7 @@ namespace Realm {
 
     Event e = search_from;
     while(true) {
-      std::vector<EventWaiter *> waiters_copy;
+      std::vector<EventChainLink> waiters_copy;
 
       ID id(e);
       if(id.is_event()) {
@@ -519,18 +532,25 @@ namespace Realm {
 
 	{
 	  AutoHSLLock al(impl->mutex);
+	  const EventWaiterList *list = 0;
 	  if(impl->generation >= id.event.generation) {
 	    // already triggered!?
 	    assert(0);
 	  } else if((impl->generation + 1) == id.event.generation) {
 	    // current generation
-	    waiters_copy.assign(impl->current_local_waiters.begin(),
-				impl->current_local_waiters.end());
+	    list = &impl->current_local_waiters;
 	  } else {
-	    std::map<EventImpl::gen_t, std::vector<EventWaiter *> >::const_iterator it = impl->future_local_waiters.find(id.event.generation);
+	    std::map<EventImpl::gen_t, EventWaiterList>::const_iterator it = impl->future_local_waiters.find(id.event.generation);
 	    if(it != impl->future_local_waiters.end())
-	      waiters_copy.assign(it->second.begin(), it->second.end());
+	      list = &it->second;
 	  }
+	  if(list)
+	    for(const EventWaiterNode *n = list->head; n; n = n->next) {
+	      EventChainLink link;
+	      link.waiter = n->waiter;
+	      link.finish_event = (n->waiter ? n->waiter->get_finish_event() : n->successor);
+	      waiters_copy.push_back(link);
+	    }
 	}
       } else if(id.is_barrier()) {
 	assert(0);
@@ -542,10 +562,10 @@ namespace Realm {
       // record all of these event waiters as seen before traversing, so that we find the
       //  shortest possible path
       int count = 0;
-      for(std::vector<EventWaiter *>::const_iterator it = waiters_copy.begin();
+      for(std::vector<EventChainLink>::const_iterator it = waiters_copy.begin();
 	  it != waiters_copy.end();
 	  it++) {
-	Event e2 = (*it)->get_finish_event();
+	Event e2 = it->finish_event;
 	if(!e2.exists()) continue;
 	if(e2 == target) {
 	  if(print_chain) {
@@ -553,7 +573,7 @@ namespace Realm {
 	    if(msg.is_active()) {
 	      msg << "event chain found!";
 	      events.push_back(e2);
-	      waiters.push_back(*it);
+	      waiters.push_back(it->waiter);
 	      for(size_t i = 0; i < events.size(); i++) {
 		msg << "\n  " << events[i];
 		if(waiters[i]) {
@@ -570,8 +590,13 @@ namespace Realm {
 	  continue;
 	bool inserted = events_seen.insert(e2).second;
 	if(inserted) {
-	  if(count++ == 0)
-	    todo.push_back(0); // marker so we know when to "pop" the stack
+	  if(count++ == 0) {
+	    // marker so we know when to "pop" the stack
+	    EventChainLink marker;
+	    marker.finish_event = Event::NO_EVENT;
+	    marker.waiter = 0;
+	    todo.push_back(marker);
+	  }
 	  todo.push_back(*it);
 	}
       }
@@ -582,23 +607,33 @@ namespace Realm {
       }
 
       // get next waiter
-      EventWaiter *w = 0;
+      bool found = false;
+      EventChainLink next;
       while(!todo.empty()) {
-	w = todo.back();
+	next = todo.back();
 	todo.pop_back();
-	if(w) break;
+	if(next.finish_event.exists()) {
+	  found = true;
+	  break;
+	}
 	assert(!events.empty());
 	events.pop_back();
 	waiters.pop_back();
       }
-      if(!w) break;
-      e = w->get_finish_event();
+      if(!found) break;
+      e = next.finish_event;
       events.push_back(e);
-      waiters.push_back(w);
+      waiters.push_back(next.waiter);
     }
     return false;
   }
 
+  bool EventImpl::add_trigger_link(gen_t needed_gen, Event successor, bool ignore_faults)
+  {
+    // no way to hold a link directly, so use a waiter object
+    return add_waiter(needed_gen, new DeferredEventTrigger(successor, ignore_faults));
+  }
+
 
   ////////////////////////////////////////////////////////////////////////
   //
@@ -758,7 +793,8 @@ namespace Realm {
 #ifndef EVENT_GRAPH_TRACE
       // counts of 0 or 1 don't require any merging
       if(wait_count == 0) return Event::NO_EVENT;
-      if((wait_count == 1) && !ignore_faults) return first_wait;
+      if(wait_count == 1)
+	return (ignore_faults ? ignorefaults(first_wait) : first_wait);
 #else
       if((wait_for.size() == 1) && !ignore_faults)
         return *(wait_for.begin());
@@ -798,21 +834,19 @@ namespace Realm {
       if(wait_for.has_triggered_faultaware(poisoned))
         return Event::NO_EVENT;
       Event finish_event = GenEventImpl::create_genevent()->current_event();
-      EventMerger *m = new EventMerger(finish_event, true/*ignore faults*/);
 #ifdef EVENT_GRAPH_TRACE
       log_event_graph.info("Event Merge: (" IDFMT ",%d) 1", 
 			   finish_event.id, finish_event.gen);
 #endif
       log_event.info() << "event merging: event=" << finish_event 
                        << " wait_on=" << wait_for;
-      m->add_event(wait_for);
+      // a single input doesn't need a merger - link the finish event to it
+      EventImpl::add_trigger_link(wait_for, finish_event, true /*ignore faults*/);
 #ifdef EVENT_GRAPH_TRACE
       log_event_graph.info("Event Precondition: (" IDFMT ",%d) (" IDFMT ",%d)",
                            finish_event.id, finish_event.gen,
                            wait_for.id, wait_for.gen);
 #endif
-      if(m->arm())
-        delete m;
       return finish_event;
     }
 
@@ -953,6 +987,25 @@ namespace Realm {
 
     bool GenEventImpl::add_waiter(gen_t needed_gen, EventWaiter *waiter)
     {
+      EventWaiterNode *node = EventWaiterNode::alloc();
+      node->waiter = waiter;
+      add_waiter_node(needed_gen, node);
+      return true;  // waiter is always either enqueued or triggered right now
+    }
+
+    bool GenEventImpl::add_trigger_link(gen_t needed_gen, Event successor, bool ignore_faults)
+    {
+      // the link lives in our waiter list - no EventWaiter object is needed
+      EventWaiterNode *node = EventWaiterNode::alloc();
+      node->waiter = 0;
+      node->successor = successor;
+      node->ignore_faults = ignore_faults;
+      add_waiter_node(needed_gen, node);
+      return true;
+    }
+
+    void GenEventImpl::add_waiter_node(gen_t needed_gen, EventWaiterNode *node)
+    {
 #ifdef EVENT_TRACING
       {
         EventTraceItem &item = Tracer<EventTraceItem>::trace_item();
@@ -994,11 +1047,11 @@ namespace Realm {
 	    // is this for the "current" next generation?
 	    if(needed_gen == (generation + 1)) {
 	      // yes, put in the current waiter list
-	      current_local_waiters.push_back(waiter);
+	      current_local_waiters.push_back(node);
 	    } else {
 	      // no, put it in an appropriate future waiter list - only allowed for non-owners
 	      assert(owner != gasnet_mynode());
-	      future_local_waiters[needed_gen].push_back(waiter);
+	      future_local_waiters[needed_gen].push_back(node);
 	    }
 
 	    // do we need to subscribe to this event?
@@ -1016,14 +1069,8 @@ namespace Realm {
 					    make_event(needed_gen),
 					    previous_subscribe_gen);
 
-      if(trigger_now) {
-	bool nuke = waiter->event_triggered(make_event(needed_gen),
-					    trigger_poisoned);
-        if(nuke)
-          delete waiter;
-      }
-
-      return true;  // waiter is always either enqueued or triggered right now
+      if(trigger_now)
+	EventWaiterNode::notify(node, make_event(needed_gen), trigger_poisoned);
     }
 
     inline bool GenEventImpl::is_generation_poisoned(gen_t gen) const
@@ -1079,6 +1126,299 @@ namespace Realm {
     Message::request(target, args);
   }
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class EventWaiterNode
+  //
+
+  // waiter nodes are carved out of chunks that are never handed back to the
+  //  heap - each thread keeps a bounded cache of free nodes and spills half of
+  //  it to a shared list when it gets too big, since nodes are usually freed
+  //  by whichever thread triggers the event, not the one that allocated them
+  static const size_t WAITER_NODE_CHUNK_SIZE = 256;
+  static const size_t WAITER_NODE_CACHE_LIMIT = 1024;
+
+  namespace ThreadLocal {
+    static __thread EventWaiterNode *waiter_node_cache = 0;
+    static __thread size_t waiter_node_cache_size = 0;
+  };
+
+  static GASNetHSL shared_waiter_node_lock;
+  static EventWaiterNode *shared_waiter_nodes = 0;
+
+  /*static*/ EventWaiterNode *EventWaiterNode::alloc(void)
+  {
+    if(__builtin_expect((ThreadLocal::waiter_node_cache == 0), 0)) {
+      // refill from the shared list first
+      {
+	AutoHSLLock al(shared_waiter_node_lock);
+	EventWaiterNode *last = 0;
+	EventWaiterNode *n = shared_waiter_nodes;
+	size_t count = 0;
+	while(n && (count < WAITER_NODE_CHUNK_SIZE)) {
+	  last = n;
+	  n = n->next;
+	  count++;
+	}
+	if(last) {
+	  last->next = 0;
+	  ThreadLocal::waiter_node_cache = shared_waiter_nodes;
+	  ThreadLocal::waiter_node_cache_size = count;
+	  shared_waiter_nodes = n;
+	}
+      }
+      if(ThreadLocal::waiter_node_cache == 0) {
+	EventWaiterNode *chunk = new EventWaiterNode[WAITER_NODE_CHUNK_SIZE];
+	for(size_t i = 0; i < WAITER_NODE_CHUNK_SIZE - 1; i++)
+	  chunk[i].next = &chunk[i + 1];
+	chunk[WAITER_NODE_CHUNK_SIZE - 1].next = 0;
+	ThreadLocal::waiter_node_cache = chunk;
+	ThreadLocal::waiter_node_cache_size = WAITER_NODE_CHUNK_SIZE;
+      }
+    }
+
+    EventWaiterNode *node = ThreadLocal::waiter_node_cache;
+    ThreadLocal::waiter_node_cache = node->next;
+    ThreadLocal::waiter_node_cache_size--;
+    node->next = 0;
+    return node;
+  }
+
+  /*static*/ void EventWaiterNode::free(EventWaiterNode *node)
+  {
+    node->next = ThreadLocal::waiter_node_cache;
+    ThreadLocal::waiter_node_cache = node;
+    ThreadLocal::waiter_node_cache_size++;
+
+    if(__builtin_expect((ThreadLocal::waiter_node_cache_size > WAITER_NODE_CACHE_LIMIT), 0)) {
+      // keep half, spill the rest
+      EventWaiterNode *last = ThreadLocal::waiter_node_cache;
+      for(size_t i = 1; i < WAITER_NODE_CACHE_LIMIT / 2; i++)
+	last = last->next;
+      EventWaiterNode *spill = last->next;
+      last->next = 0;
+      ThreadLocal::waiter_node_cache_size = WAITER_NODE_CACHE_LIMIT / 2;
+
+      EventWaiterNode *spill_tail = spill;
+      while(spill_tail->next)
+	spill_tail = spill_tail->next;
+
+      AutoHSLLock al(shared_waiter_node_lock);
+      spill_tail->next = shared_waiter_nodes;
+      shared_waiter_nodes = spill;
+    }
+  }
+
+  /*static*/ void EventWaiterNode::notify(EventWaiterNode *node, Event e, bool poisoned)
+  {
+    // return the node to the pool first so that anything triggered below can
+    //  reuse it
+    EventWaiter *waiter = node->waiter;
+    Event successor = node->successor;
+    bool ignore_faults = node->ignore_faults;
+    free(node);
+
+    if(waiter) {
+      bool nuke = waiter->event_triggered(e, poisoned);
+      if(nuke)
+	delete waiter;
+    } else {
+      if(poisoned && !ignore_faults)
+	log_poison.info() << "poisoned trigger link: event=" << successor;
+      GenEventImpl::trigger(successor, poisoned && !ignore_faults);
+    }
+  }
+
+  void EventWaiterNode::print(std::ostream& os) const
+  {
+    if(waiter)
+      waiter->print(os);
+    else
+      os << "trigger link: after=" << successor
+	 << (ignore_faults ? " (ignoring faults)" : "");
+  }
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class EventWaiterList
+  //
+
+  size_t EventWaiterList::size(void) const
+  {
+    size_t count = 0;
+    for(const EventWaiterNode *n = head; n; n = n->next)
+      count++;
+    return count;
+  }
+
+  void EventWaiterList::push_back(EventWaiterNode *node)
+  {
+    node->next = 0;
+    if(tail)
+      tail->next = node;
+    else
+      head = node;
+    tail = node;
+  }
+
+  void EventWaiterList::swap(EventWaiterList& other)
+  {
+    std::swap(head, other.head);
+    std::swap(tail, other.tail);
+  }
+
+  void EventWaiterList::notify_all(Event e, bool poisoned)
+  {
+    EventWaiterNode *n = head;
+    head = tail = 0;
+    while(n) {
+      // grab the next pointer before the node goes back to the pool
+      EventWaiterNode *next = n->next;
+      EventWaiterNode::notify(n, e, poisoned);
+      n = next;
+    }
+  }
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class EventTriggerBatch
+  //
+
+  namespace ThreadLocal {
+    static __thread EventTriggerBatch *current_trigger_batch = 0;
+  };
+
+  EventTriggerBatch::EventTriggerBatch(void)
+    : active(false)
+  {
+    // only the outermost batch on a thread does anything
+    if(Config::batch_event_triggers && !ThreadLocal::current_trigger_batch) {
+      active = true;
+      ThreadLocal::current_trigger_batch = this;
+    }
+  }
+
+  EventTriggerBatch::~EventTriggerBatch(void)
+  {
+    if(active) {
+      flush();
+      ThreadLocal::current_trigger_batch = 0;
+    }
+  }
+
+  /*static*/ EventTriggerBatch *EventTriggerBatch::current(void)
+  {
+    return ThreadLocal::current_trigger_batch;
+  }
+
+  // helper to feed a NodeSet into the batch's per-node lists
+  struct BatchUpdateHelper {
+    inline void apply(gasnet_node_t target)
+    {
+      batch->add_remote_update(target, event, num_poisoned, poisoned_generations);
+    }
+
+    EventTriggerBatch *batch;
+    Event event;
+    int num_poisoned;
+    const EventImpl::gen_t *poisoned_generations;
+  };
+
+  void EventTriggerBatch::add_remote_update(const NodeSet& targets, Event e,
+					    int num_poisoned,
+					    const EventImpl::gen_t *poisoned_generations)
+  {
+    BatchUpdateHelper helper;
+    helper.batch = this;
+    helper.event = e;
+    helper.num_poisoned = num_poisoned;
+    helper.poisoned_generations = poisoned_generations;
+    targets.map(helper);
+  }
+
+  void EventTriggerBatch::add_remote_update(gasnet_node_t target, Event e,
+					    int num_poisoned,
+					    const EventImpl::gen_t *poisoned_generations)
+  {
+    PendingUpdates& pu = pending_updates[target];
+    if(!pu.dbs)
+      pu.dbs = new Serialization::DynamicBufferSerializer(256);
+
+    // each update is the event, the poisoned generation count, and the
+    //  poisoned generations themselves
+#ifndef NDEBUG
+    bool ok =
+#endif
+      ((*pu.dbs << e) &&
+       (*pu.dbs << num_poisoned) &&
+       pu.dbs->append_bytes(poisoned_generations,
+			    num_poisoned * sizeof(EventImpl::gen_t)));
+    assert(ok);
+    pu.count++;
+
+    if(pu.dbs->bytes_used() >= MAX_UPDATE_BYTES)
+      send_updates(target);
+  }
+
+  void EventTriggerBatch::send_updates(gasnet_node_t target)
+  {
+    std::map<gasnet_node_t, PendingUpdates>::iterator it = pending_updates.find(target);
+    assert(it != pending_updates.end());
+
+    size_t datalen = it->second.dbs->bytes_used();
+    void *data = it->second.dbs->detach_buffer(-1);  // don't trim - this buffer has a short life
+    int count = it->second.count;
+    delete it->second.dbs;
+    pending_updates.erase(it);
+
+    EventUpdateBatchMessage::send_request(target, count, data, datalen);
+  }
+
+  void EventTriggerBatch::flush(void)
+  {
+    while(!pending_updates.empty())
+      send_updates(pending_updates.begin()->first);
+  }
+
+  /*static*/ void EventUpdateBatchMessage::send_request(gasnet_node_t target, int count,
+							void *data, size_t datalen)
+  {
+    RequestArgs args;
+
+    args.count = count;
+
+    Message::request(target, args, data, datalen, PAYLOAD_FREE);
+  }
+
+  /*static*/ void EventUpdateBatchMessage::handle_request(RequestArgs args,
+							  const void *data, size_t datalen)
+  {
+    log_event.debug() << "event update batch: count=" << args.count << " bytes=" << datalen;
+
+    // the remote updates caused by the waiters these wake are also batched
+    EventTriggerBatch batch;
+
+    Serialization::FixedBufferDeserializer fbd(data, datalen);
+    for(int i = 0; i < args.count; i++) {
+      Event e;
+      int num_poisoned;
+#ifndef NDEBUG
+      bool ok =
+#endif
+	((fbd >> e) && (fbd >> num_poisoned));
+      assert(ok);
+      const EventImpl::gen_t *poisoned_gens = (const EventImpl::gen_t *)(fbd.peek_bytes(num_poisoned * sizeof(EventImpl::gen_t)));
+      if(num_poisoned > 0) {
+	assert(poisoned_gens != 0);
+	fbd.extract_bytes(0, num_poisoned * sizeof(EventImpl::gen_t));
+      }
+
+      GenEventImpl *impl = get_runtime()->get_genevent_impl(e);
+      impl->process_update(ID(e).event.generation, poisoned_gens, num_poisoned);
+    }
+    assert(fbd.bytes_left() == 0);
+  }
+
   /*static*/ void EventUpdateMessage::send_request(gasnet_node_t target, Event event,
 						   int num_poisoned,
 						   const EventImpl::gen_t *poisoned_generations)
@@ -1224,7 +1564,7 @@ namespace Realm {
 
     // the result of the update may trigger multiple generations worth of waiters - keep their
     //  generation IDs straight (we'll look up the poison bits later)
-    std::map<gen_t, std::vector<EventWaiter *> > to_wake;
+    std::map<gen_t, EventWaiterList> to_wake;
 
     {
       AutoHSLLock a(mutex);
@@ -1265,7 +1605,7 @@ namespace Realm {
 
       // now any future waiters up to and including the triggered gen
       if(!future_local_waiters.empty()) {
-	std::map<gen_t, std::vector<EventWaiter *> >::iterator it = future_local_waiters.begin();
+	std::map<gen_t, EventWaiterList>::iterator it = future_local_waiters.begin();
 	while((it != future_local_waiters.end()) && (it->first <= current_gen)) {
 	  to_wake[it->first].swap(it->second);
 	  future_local_waiters.erase(it);
@@ -1297,20 +1637,12 @@ namespace Realm {
 
     // now trigger anybody that needs to be triggered
     if(!to_wake.empty()) {
-      for(std::map<gen_t, std::vector<EventWaiter *> >::const_iterator it = to_wake.begin();
+      for(std::map<gen_t, EventWaiterList>::iterator it = to_wake.begin();
 	  it != to_wake.end();
 	  it++) {
 	Event e = make_event(it->first);
 	bool poisoned = is_generation_poisoned(it->first);
-	for(std::vector<EventWaiter *>::const_iterator it2 = it->second.begin();
-	    it2 != it->second.end();
-	    it2++) {
-	  bool nuke = (*it2)->event_triggered(e, poisoned);
-	  if(nuke) {
-	    //printf("deleting: "); (*it)->print_info(); fflush(stdout);
-	    delete (*it2);
-	  }
-	}
+	it->second.notify_all(e, poisoned);
       }
     }
   }
@@ -1446,7 +1778,11 @@ namespace Realm {
       }
 #endif
 
-      std::vector<EventWaiter *> to_wake;
+      EventWaiterList to_wake;
+
+      // remote updates for this trigger and anything triggered by our
+      //  waiters go into this batch unless the caller already has one open
+      EventTriggerBatch batch;
 
       if(gasnet_mynode() == owner) {
 	// we own this event
@@ -1483,11 +1819,19 @@ namespace Realm {
 	}
 
 	// any remote nodes to notify?
-	if(!to_update.empty())
-	  EventUpdateMessage::broadcast_request(to_update, 
-						make_event(gen_triggered),
-						num_poisoned_generations,
-						poisoned_generations);
+	if(!to_update.empty()) {
+	  EventTriggerBatch *cur_batch = EventTriggerBatch::current();
+	  if(cur_batch)
+	    cur_batch->add_remote_update(to_update,
+					 make_event(gen_triggered),
+					 num_poisoned_generations,
+					 poisoned_generations);
+	  else
+	    EventUpdateMessage::broadcast_request(to_update, 
+						  make_event(gen_triggered),
+						  num_poisoned_generations,
+						  poisoned_generations);
+	}
 
 	// free event?
 	if(free_event)
@@ -1517,7 +1861,7 @@ namespace Realm {
 	    to_wake.swap(current_local_waiters);
 	    // any future waiters?
 	    if(!future_local_waiters.empty()) {
-	      std::map<gen_t, std::vector<EventWaiter *> >::iterator it = future_local_waiters.begin();
+	      std::map<gen_t, EventWaiterList>::iterator it = future_local_waiters.begin();
 	      log_event.debug() << "future waiters non-empty: first=" << it->first << " (= " << (gen_triggered + 1) << "?)";
 	      if(it->first == (gen_triggered + 1)) {
 		current_local_waiters.swap(it->second);
@@ -1543,7 +1887,7 @@ namespace Realm {
 	      //  future waiter list to see who we can wake, and update the local trigger
 	      //  list
 
-	      std::map<gen_t, std::vector<EventWaiter *> >::iterator it = future_local_waiters.find(gen_triggered);
+	      std::map<gen_t, EventWaiterList>::iterator it = future_local_waiters.find(gen_triggered);
 	      if(it != future_local_waiters.end()) {
 		to_wake.swap(it->second);
 		future_local_waiters.erase(it);
@@ -1567,22 +1911,15 @@ namespace Realm {
       // finally, trigger any local waiters
       if(!to_wake.empty()) {
 	Event e = make_event(gen_triggered);
-	for(std::vector<EventWaiter *>::iterator it = to_wake.begin();
-	    it != to_wake.end();
-	    it++) {
-	  bool nuke = (*it)->event_triggered(e, poisoned);
-          if(nuke) {
-            //printf("deleting: "); (*it)->print_info(); fflush(stdout);
-            delete (*it);
-          }
-        }
+	to_wake.notify_all(e, poisoned);
       }
     }
 
     /*static*/ BarrierImpl *BarrierImpl::create_barrier(unsigned expected_arrivals,
 							ReductionOpID redopid,
 							const void *initial_value /*= 0*/,
-							size_t initial_value_size /*= 0*/)
+							size_t initial_value_size /*= 0*/,
+							unsigned arrival_radix /*= 0*/)
     {
       BarrierImpl *impl = get_runtime()->local_barrier_free_list->alloc_entry();
       assert(impl);
@@ -1612,11 +1949,19 @@ namespace Realm {
 	impl->final_values = 0;
       }
 
+      // partial reduction values can only be combined on the way up the tree
+      //  if they can be folded together
+      if((arrival_radix > 0) && impl->redop && !impl->redop->is_foldable)
+	arrival_radix = 0;
+      impl->arrival_radix = arrival_radix;
+      impl->tree_broadcast_gen = impl->generation;
+
       // and let the barrier rearm as many times as necessary without being released
       //impl->free_generation = (unsigned)-1;
 
       log_barrier.info() << "barrier created: " << impl->me << "/" << impl->generation
-			 << " base_count=" << impl->base_arrival_count << " redop=" << redopid;
+			 << " base_count=" << impl->base_arrival_count << " redop=" << redopid
+			 << " radix=" << impl->arrival_radix;
 #ifdef EVENT_TRACING
       {
 	EventTraceItem &item = Tracer<EventTraceItem>::trace_item();
@@ -1642,6 +1987,8 @@ namespace Realm {
       initial_value = 0;
       value_capacity = 0;
       final_values = 0;
+      arrival_radix = 0;
+      tree_broadcast_gen = 0;
     }
 
     void BarrierImpl::init(ID _me, unsigned _init_owner)
@@ -1659,6 +2006,8 @@ namespace Realm {
       initial_value = 0;
       value_capacity = 0;
       final_values = 0;
+      arrival_radix = 0;
+      tree_broadcast_gen = 0;
     }
 
     /*static*/ void BarrierAdjustMessage::handle_request(RequestArgs args, const void *data, size_t datalen)
@@ -1710,7 +2059,8 @@ namespace Realm {
 							EventImpl::gen_t trigger_gen, EventImpl::gen_t previous_gen,
 							EventImpl::gen_t first_generation, ReductionOpID redop_id,
 							gasnet_node_t migration_target,	unsigned base_arrival_count,
-							const void *data, size_t datalen)
+							const void *data, size_t datalen,
+							unsigned arrival_radix /*= 0*/)
     {
       RequestArgs args;
 
@@ -1722,6 +2072,7 @@ namespace Realm {
       args.redop_id = redop_id;
       args.migration_target = migration_target;
       args.base_arrival_count = base_arrival_count;
+      args.arrival_radix = arrival_radix;
 
       Message::request(target, args, data, datalen, PAYLOAD_COPY);
     }
@@ -1855,7 +2206,7 @@ static void *bytedup(const void *data, size_t datalen)
 
 	// only forward deferred arrivals if the precondition is not one that looks like it'll
 	//  trigger here first
-        if(owner != gasnet_mynode()) {
+        if((owner != gasnet_mynode()) && (arrival_radix == 0)) {
 	  ID wait_id(wait_on);
 	  int wait_node = (wait_id.is_event() ? wait_id.event.creator_node : wait_id.barrier.creator_node);
 	  if(wait_node != (int)gasnet_mynode()) {
@@ -1880,6 +2231,13 @@ static void *bytedup(const void *data, size_t datalen)
 	return;
       }
 
+      // arrivals for tree-mode barriers go up the tree instead of to the owner,
+      //  unless they're adjustments that have to be ordered by timestamp
+      if((arrival_radix > 0) && (owner != gasnet_mynode()) && (timestamp == 0)) {
+	combine_arrival(barrier_gen, delta, redop_id, reduce_value, reduce_value_size);
+	return;
+      }
+
       log_barrier.info() << "barrier adjustment: event=" << b
 			 << " delta=" << delta << " ts=" << timestamp;
 
@@ -1903,6 +2261,7 @@ static void *bytedup(const void *data, size_t datalen)
       gasnet_node_t migration_target = (gasnet_node_t) -1;
       gasnet_node_t forward_to_node = (gasnet_node_t) -1;
       gasnet_node_t inform_migration = (gasnet_node_t) -1;
+      bool tree_broadcast = false;
 
       do { // so we can use 'break' from the middle
 	AutoHSLLock a(mutex);
@@ -1954,9 +2313,17 @@ static void *bytedup(const void *data, size_t datalen)
 	    it = generations.begin();
 	  }
 
+	  // tree-mode barriers broadcast every trigger to all nodes down the tree
+	  //  rather than notifying subscribers individually
+	  if((generation >= barrier_gen) && (arrival_radix > 0)) {
+	    tree_broadcast = true;
+	    oldest_previous = tree_broadcast_gen;
+	    tree_broadcast_gen = generation;
+	  }
+
 	  // if any triggers occurred, figure out which remote nodes need notifications
 	  //  (i.e. any who have subscribed)
-	  if(generation >= barrier_gen) {
+	  if((generation >= barrier_gen) && !tree_broadcast) {
 	    std::map<unsigned, gen_t>::iterator it = remote_subscribe_gens.begin();
 	    while(it != remote_subscribe_gens.end()) {
 	      RemoteNotification rn;
@@ -2084,6 +2451,24 @@ static void *bytedup(const void *data, size_t datalen)
 					      first_generation, redop_id, migration_target, base_arrival_count,
 					      data, datalen);
 	}
+
+	if(tree_broadcast) {
+	  std::vector<gasnet_node_t> children;
+	  tree_children(gasnet_mynode(), gasnet_mynode(), arrival_radix, children);
+	  size_t datalen = (final_values_copy ?
+			      ((trigger_gen - oldest_previous) * redop->sizeof_lhs) :
+			      0);
+	  for(std::vector<gasnet_node_t>::const_iterator it = children.begin();
+	      it != children.end();
+	      it++) {
+	    log_barrier.info() << "broadcasting barrier trigger: " << me << "/"
+			       << oldest_previous << " -> " << trigger_gen << ", dest=" << *it;
+	    BarrierTriggerMessage::send_request(*it, me.id, trigger_gen, oldest_previous,
+						first_generation, redop_id,
+						(gasnet_node_t) -1 /*no migration*/, base_arrival_count,
+						final_values_copy, datalen, arrival_radix);
+	  }
+	}
       }
 
       // free our copy of the final values, if we had one
@@ -2109,7 +2494,8 @@ static void *bytedup(const void *data, size_t datalen)
 	    gen_subscribed = needed_gen;
 	}
 
-	if(previous_subscription < needed_gen) {
+	// tree-mode barriers broadcast every trigger, so there's nothing to subscribe to
+	if((previous_subscription < needed_gen) && (arrival_radix == 0)) {
 	  log_barrier.info() << "subscribing to barrier " << make_barrier(needed_gen) << " (prev=" << previous_subscription << ")";
 	  BarrierSubscribeMessage::send_request(owner, me.id, needed_gen, gasnet_mynode(), false/*!forwarded*/);
 	}
@@ -2198,6 +2584,11 @@ static void *bytedup(const void *data, size_t datalen)
 	// make sure the subscription is for this "lifetime" of the barrier
 	assert(args.subscribe_gen > impl->first_generation);
 
+	// a tree-mode barrier's triggers are broadcast to every node anyway (a node
+	//  that subscribed before it learned the barrier's mode ends up here)
+	if(impl->arrival_radix > 0)
+	  break;
+
 	bool already_subscribed = false;
 	{
 	  std::map<unsigned, EventImpl::gen_t>::iterator it = impl->remote_subscribe_gens.find(args.subscriber);
@@ -2276,11 +2667,18 @@ static void *bytedup(const void *data, size_t datalen)
       Barrier b = id.convert<Barrier>();
       BarrierImpl *impl = get_runtime()->get_barrier_impl(b);
 
+      // a tree broadcast is relayed to our children as is, so remember the
+      //  range before it's merged with any held triggers
+      EventImpl::gen_t relay_trigger_gen = args.trigger_gen;
+
       // we'll probably end up with a list of local waiters to notify
       std::vector<EventWaiter *> local_notifications;
       {
 	AutoHSLLock a(impl->mutex);
 
+	if(args.arrival_radix > 0)
+	  impl->arrival_radix = args.arrival_radix;
+
 	// handle migration of the barrier ownership (possibly to us)
 	if(args.migration_target != (gasnet_node_t) -1) {
 	  log_barrier.info() << "barrier " << b << " has migrated to " << args.migration_target;
@@ -2337,19 +2735,27 @@ static void *bytedup(const void *data, size_t datalen)
 	  impl->redop = get_runtime()->reduce_op_table[args.redop_id];
 	  impl->first_generation = args.first_generation;
 
-	  int rel_gen = args.trigger_gen - impl->first_generation;
-	  assert(rel_gen > 0);
-	  if(impl->value_capacity < (size_t)rel_gen) {
-	    size_t new_capacity = rel_gen;
-	    impl->final_values = (char *)realloc(impl->final_values, new_capacity * impl->redop->sizeof_lhs);
-	    // no need to initialize new entries - we'll overwrite them now or when data does show up
-	    impl->value_capacity = new_capacity;
-	  }
-	  assert(datalen == (impl->redop->sizeof_lhs * (args.trigger_gen - args.previous_gen)));
-	  memcpy(impl->final_values + ((rel_gen - 1) * impl->redop->sizeof_lhs), data, datalen);
+	  // the data covers the range named in the message, even if held triggers
+	  //  were collapsed into it above
+	  assert(datalen == (impl->redop->sizeof_lhs * (relay_trigger_gen - args.previous_gen)));
+	  BarrierTree::store_values(impl->final_values, impl->value_capacity,
+				    impl->first_generation, args.previous_gen,
+				    relay_trigger_gen, data, impl->redop->sizeof_lhs);
 	}
       }
 
+      if(args.arrival_radix > 0) {
+	std::vector<gasnet_node_t> children;
+	BarrierImpl::tree_children(gasnet_mynode(), impl->owner, args.arrival_radix, children);
+	for(std::vector<gasnet_node_t>::const_iterator it = children.begin();
+	    it != children.end();
+	    it++)
+	  BarrierTriggerMessage::send_request(*it, args.barrier_id, relay_trigger_gen, args.previous_gen,
+					      args.first_generation, args.redop_id,
+					      (gasnet_node_t) -1 /*no migration*/, args.base_arrival_count,
+					      data, datalen, args.arrival_radix);
+      }
+
       // with lock released, perform any local notifications
       for(std::vector<EventWaiter *>::const_iterator it = local_notifications.begin();
 	  it != local_notifications.end();
@@ -2380,6 +2786,136 @@ static void *bytedup(const void *data, size_t datalen)
       return true;
     }
 
+    /*static*/ gasnet_node_t BarrierImpl::tree_parent(gasnet_node_t node, gasnet_node_t root,
+						      unsigned radix)
+    {
+      return BarrierTree::parent(node, root, radix, gasnet_nodes());
+    }
+
+    /*static*/ void BarrierImpl::tree_children(gasnet_node_t node, gasnet_node_t root,
+					       unsigned radix,
+					       std::vector<gasnet_node_t>& children)
+    {
+      std::vector<unsigned> nodes;
+      BarrierTree::children(node, root, radix, gasnet_nodes(), nodes);
+      children.insert(children.end(), nodes.begin(), nodes.end());
+    }
+
+    void BarrierImpl::combine_arrival(gen_t barrier_gen, int delta, ReductionOpID redop_id,
+				      const void *reduce_value, size_t reduce_value_size)
+    {
+      bool send_now;
+      {
+	AutoHSLLock a(mutex);
+
+	const ReductionOpUntyped *r = (redop_id ?
+				         get_runtime()->reduce_op_table[redop_id] :
+				         0);
+	send_now = combiner.add_arrival(barrier_gen, delta, redop_id, r,
+					reduce_value, reduce_value_size);
+	if(!send_now)
+	  log_barrier.info() << "combining barrier arrival: " << make_barrier(barrier_gen)
+			     << " delta=" << delta << " pending=" << combiner.pending_delta(barrier_gen);
+      }
+
+      if(send_now) {
+	gasnet_node_t parent = tree_parent(gasnet_mynode(), owner, arrival_radix);
+	log_barrier.info() << "sending combined barrier arrival: " << make_barrier(barrier_gen)
+			   << " delta=" << delta << " parent=" << parent;
+	BarrierCombineMessage::send_request(parent, make_barrier(barrier_gen), delta,
+					    redop_id, arrival_radix,
+					    reduce_value, reduce_value_size);
+      }
+    }
+
+    void BarrierImpl::combine_acknowledged(void)
+    {
+      BarrierArrivalCombiner<gen_t>::PendingMap to_send;
+      {
+	AutoHSLLock a(mutex);
+
+	combiner.acknowledged(to_send);
+      }
+
+      if(to_send.empty())
+	return;
+
+      gasnet_node_t parent = tree_parent(gasnet_mynode(), owner, arrival_radix);
+      for(BarrierArrivalCombiner<gen_t>::PendingMap::iterator it = to_send.begin();
+	  it != to_send.end();
+	  it++) {
+	log_barrier.info() << "sending combined barrier arrival: " << make_barrier(it->first)
+			   << " delta=" << it->second.delta << " parent=" << parent;
+	BarrierCombineMessage::send_request(parent, make_barrier(it->first), it->second.delta,
+					    it->second.redop_id, arrival_radix,
+					    it->second.value, it->second.value_size);
+	if(it->second.value)
+	  free(it->second.value);
+      }
+    }
+
+    /*static*/ void BarrierCombineMessage::handle_request(RequestArgs args,
+							  const void *data, size_t datalen)
+    {
+      log_barrier.info() << "received combined barrier arrival: delta=" << args.delta
+			 << " barrier=" << args.barrier << " sender=" << args.sender;
+      BarrierImpl *impl = get_runtime()->get_barrier_impl(args.barrier);
+      EventImpl::gen_t gen = ID(args.barrier).barrier.generation;
+
+      // tree-mode barriers never migrate, so we're either the root or somewhere
+      //  on the way to it
+      if(impl->owner == gasnet_mynode()) {
+	impl->adjust_arrival(gen, args.delta, 0, Event::NO_EVENT,
+			     args.sender, false /*!forwarded*/,
+			     datalen ? data : 0, datalen);
+      } else {
+	{
+	  AutoHSLLock a(impl->mutex);
+	  impl->arrival_radix = args.arrival_radix;
+	  if((args.redop_id != 0) && (impl->redop_id == 0)) {
+	    impl->redop_id = args.redop_id;
+	    impl->redop = get_runtime()->reduce_op_table[args.redop_id];
+	  }
+	}
+	impl->combine_arrival(gen, args.delta, args.redop_id,
+			      datalen ? data : 0, datalen);
+      }
+
+      // our parent is now responsible for this arrival
+      BarrierCombineAckMessage::send_request(args.sender, args.barrier);
+    }
+
+    /*static*/ void BarrierCombineMessage::send_request(gasnet_node_t target, Barrier barrier,
+							int delta, ReductionOpID redop_id,
+							unsigned arrival_radix,
+							const void *data, size_t datalen)
+    {
+      RequestArgs args;
+
+      args.barrier = barrier;
+      args.sender = gasnet_mynode();
+      args.delta = delta;
+      args.redop_id = redop_id;
+      args.arrival_radix = arrival_radix;
+
+      Message::request(target, args, data, datalen, PAYLOAD_COPY);
+    }
+
+    /*static*/ void BarrierCombineAckMessage::handle_request(RequestArgs args)
+    {
+      BarrierImpl *impl = get_runtime()->get_barrier_impl(args.barrier);
+      impl->combine_acknowledged();
+    }
+
+    /*static*/ void BarrierCombineAckMessage::send_request(gasnet_node_t target, Barrier barrier)
+    {
+      RequestArgs args;
+
+      args.barrier = barrier;
+
+      Message::request(target, args);
+    }
+
     /*static*/ void BarrierMigrationMessage::handle_request(RequestArgs args)
     {
       log_barrier.info() << "received barrier migration: barrier=" << args.barrier << " owner=" << args.current_owner;
@@ -22,8 +22,11 @@
 #include "id.h"
 #include "nodeset.h"
 #include "faults.h"
+#include "logging.h"
 
 #include "activemsg.h"
+#include "serialize.h"
+#include "barrier_tree.h"
 
 #include <vector>
 #include <map>
@@ -55,6 +58,48 @@ namespace Realm {
       virtual Event get_finish_event(void) const = 0;
     };
 
+    // an entry in an event's list of local waiters - entries come from a
+    //  per-thread pool, so registering a waiter does not go to the heap, and
+    //  an entry can name a successor event to trigger directly instead of an
+    //  EventWaiter object (see EventImpl::add_trigger_link)
+    struct EventWaiterNode {
+      EventWaiter *waiter;     // 0 for a trigger link
+      Event successor;         // trigger links only
+      bool ignore_faults;      // trigger links only - don't propagate poison
+      EventWaiterNode *next;
+
+      static EventWaiterNode *alloc(void);
+      static void free(EventWaiterNode *node);
+
+      // delivers the trigger and returns the node to the pool
+      static void notify(EventWaiterNode *node, Event e, bool poisoned);
+
+      void print(std::ostream& os) const;
+    };
+
+    // intrusive FIFO list of waiter nodes - cheap to swap under a lock
+    class EventWaiterList {
+    public:
+      EventWaiterList(void) : head(0), tail(0) {}
+
+      bool empty(void) const { return (head == 0); }
+      size_t size(void) const; // walks the list
+      void push_back(EventWaiterNode *node);
+      void swap(EventWaiterList& other);
+
+      // notifies (and frees) every node on the list, leaving it empty
+      void notify_all(Event e, bool poisoned);
+
+      EventWaiterNode *head, *tail;
+    };
+
+    namespace Config {
+      // if nonzero (the default - use -ll:batch_triggers 0 to disable), the
+      //  remote update messages caused by a trigger are batched (see
+      //  EventTriggerBatch)
+      extern int batch_event_triggers;
+    };
+
     // parent class of GenEventImpl and BarrierImpl
     class EventImpl {
     public:
@@ -72,9 +117,55 @@ namespace Realm {
 
       static bool add_waiter(Event needed, EventWaiter *waiter);
 
+      // triggers 'successor' (which must be a GenEventImpl event) once the
+      //  needed generation triggers - poison is propagated unless
+      //  'ignore_faults' is set - events that can hold a link without an
+      //  EventWaiter override this, the default uses a deferred trigger
+      virtual bool add_trigger_link(gen_t needed_gen, Event successor, bool ignore_faults);
+
+      static bool add_trigger_link(Event needed, Event successor, bool ignore_faults);
+
       static bool detect_event_chain(Event search_from, Event target, int max_depth, bool print_chain);
     };
 
+    // a trigger batch collects the remote update messages that result from
+    //  event triggers on the calling thread (including the ones caused by
+    //  waking up local waiters, which are still notified right away) - all
+    //  the updates headed to the same node are sent as a single message when
+    //  the batch is closed
+    // batches nest - only the outermost batch on a thread does any work
+    class EventTriggerBatch {
+    public:
+      EventTriggerBatch(void);
+      ~EventTriggerBatch(void);
+
+      // returns the batch that remote updates on this thread should be added
+      //  to, or 0 if no batch is open
+      static EventTriggerBatch *current(void);
+
+      void add_remote_update(const NodeSet& targets, Event e,
+			     int num_poisoned, const EventImpl::gen_t *poisoned_generations);
+      void add_remote_update(gasnet_node_t target, Event e,
+			     int num_poisoned, const EventImpl::gen_t *poisoned_generations);
+
+      // send pending updates once they reach this size, even if the batch is
+      //  still open
+      static const size_t MAX_UPDATE_BYTES = 4096;
+
+    protected:
+      void flush(void);
+      void send_updates(gasnet_node_t target);
+
+      struct PendingUpdates {
+	PendingUpdates(void) : count(0), dbs(0) {}
+	int count;
+	Serialization::DynamicBufferSerializer *dbs;
+      };
+
+      bool active;
+      std::map<gasnet_node_t, PendingUpdates> pending_updates;
+    };
+
     class GenEventImpl : public EventImpl {
     public:
       static const ID::ID_Types ID_TYPE = ID::ID_EVENT;
@@ -98,6 +189,8 @@ namespace Realm {
 
       virtual bool add_waiter(gen_t needed_gen, EventWaiter *waiter);
 
+      virtual bool add_trigger_link(gen_t needed_gen, Event successor, bool ignore_faults);
+
       // creates an event that won't trigger until all input events have
       static Event merge_events(const std::set<Event>& wait_for,
 				bool ignore_faults);
@@ -129,6 +222,9 @@ namespace Realm {
 
       bool is_generation_poisoned(gen_t gen) const; // helper function - linear search
 
+      // common path for add_waiter and add_trigger_link
+      void add_waiter_node(gen_t needed_gen, EventWaiterNode *node);
+
       // this is only manipulated when the event is "idle"
       GenEventImpl *next_free;
 
@@ -139,8 +235,8 @@ namespace Realm {
       //  for the "current" generation, whereas a map-by-generation-id is used for
       //  "future" generations (i.e. ones ahead of what we've heard about if we're
       //  not the owner)
-      std::vector<EventWaiter *> current_local_waiters;
-      std::map<gen_t, std::vector<EventWaiter *> > future_local_waiters;
+      EventWaiterList current_local_waiters;
+      std::map<gen_t, EventWaiterList> future_local_waiters;
 
       // remote waiters are kept in a bitmask for the current generation - this is
       //  only maintained on the owner, who never has to worry about more than one
@@ -183,7 +279,8 @@ namespace Realm {
       Barrier make_barrier(gen_t gen, Barrier::timestamp_t timestamp = 0) const;
 
       static BarrierImpl *create_barrier(unsigned expected_arrivals, ReductionOpID redopid,
-					 const void *initial_value = 0, size_t initial_value_size = 0);
+					 const void *initial_value = 0, size_t initial_value_size = 0,
+					 unsigned arrival_radix = 0);
 
       // test whether an event has triggered without waiting
       virtual bool has_triggered(gen_t needed_gen, bool& poisoned);
@@ -201,6 +298,19 @@ namespace Realm {
 
       bool get_result(gen_t result_gen, void *value, size_t value_size);
 
+      // arrivals for a tree-mode barrier are sent to the node's parent in the
+      //  arrival tree - while an earlier message to the parent is unacknowledged,
+      //  further arrivals (local or from children) are combined and sent together
+      //  once the acknowledgement comes back
+      void combine_arrival(gen_t barrier_gen, int delta, ReductionOpID redop_id,
+			   const void *reduce_value, size_t reduce_value_size);
+      void combine_acknowledged(void);
+
+      // positions in a k-ary tree of all nodes rooted at 'root'
+      static gasnet_node_t tree_parent(gasnet_node_t node, gasnet_node_t root, unsigned radix);
+      static void tree_children(gasnet_node_t node, gasnet_node_t root, unsigned radix,
+				std::vector<gasnet_node_t>& children);
+
     public: //protected:
       ID me;
       unsigned owner;
@@ -243,6 +353,14 @@ namespace Realm {
 
       unsigned value_capacity; // how many values the two allocations below can hold
       char *final_values;   // results of completed reductions
+
+      // fan-in of the arrival tree (0 = all arrivals go straight to the owner) -
+      //  non-owner nodes learn this from the first trigger broadcast or combined
+      //  arrival they see, and send arrivals directly to the owner until then
+      unsigned arrival_radix;
+      gen_t tree_broadcast_gen; // owner only: last generation broadcast down the tree
+
+      BarrierArrivalCombiner<gen_t> combiner; // non-owner nodes of tree-mode barriers
     };
 
   // active messages
@@ -283,6 +401,23 @@ namespace Realm {
     static void send_request(gasnet_node_t target, Event event, bool poisoned);
   };
 
+  // carries updates for many events from one owner node
+  struct EventUpdateBatchMessage {
+    struct RequestArgs : public BaseMedium {
+      int count;
+    };
+
+    static void handle_request(RequestArgs args, const void *data, size_t datalen);
+
+    typedef ActiveMessageMediumNoReply<EVENT_UPDATE_BATCH_MSGID,
+				       RequestArgs,
+				       handle_request> Message;
+
+    // takes ownership of 'data'
+    static void send_request(gasnet_node_t target, int count,
+			     void *data, size_t datalen);
+  };
+
   struct EventUpdateMessage {
     struct RequestArgs : public BaseMedium {
       Event event;
@@ -351,6 +486,7 @@ namespace Realm {
 	ReductionOpID redop_id;
 	gasnet_node_t migration_target;
 	unsigned base_arrival_count;
+	unsigned arrival_radix; // non-zero if this is a tree broadcast to be relayed
       };
 
       static void handle_request(RequestArgs args, const void *data, size_t datalen);
@@ -363,9 +499,46 @@ namespace Realm {
 			       EventImpl::gen_t trigger_gen, EventImpl::gen_t previous_gen,
 			       EventImpl::gen_t first_generation, ReductionOpID redop_id,
 			       gasnet_node_t migration_target, unsigned base_arrival_count,
+			       const void *data, size_t datalen,
+			       unsigned arrival_radix = 0);
+    };
+
+    // carries the combined arrivals for one generation of a tree-mode barrier
+    //  from a node to its parent in the arrival tree
+    struct BarrierCombineMessage {
+      struct RequestArgs : public BaseMedium {
+	Barrier barrier;
+	gasnet_node_t sender;
+	int delta;
+	ReductionOpID redop_id;
+	unsigned arrival_radix;
+      };
+
+      static void handle_request(RequestArgs args, const void *data, size_t datalen);
+
+      typedef ActiveMessageMediumNoReply<BARRIER_COMBINE_MSGID,
+					 RequestArgs,
+					 handle_request> Message;
+
+      static void send_request(gasnet_node_t target, Barrier barrier, int delta,
+			       ReductionOpID redop_id, unsigned arrival_radix,
 			       const void *data, size_t datalen);
     };
 
+    struct BarrierCombineAckMessage {
+      struct RequestArgs {
+	Barrier barrier;
+      };
+
+      static void handle_request(RequestArgs args);
+
+      typedef ActiveMessageShortNoReply<BARRIER_COMBINE_ACK_MSGID,
+					RequestArgs,
+					handle_request> Message;
+
+      static void send_request(gasnet_node_t target, Barrier barrier);
+    };
+
     struct BarrierMigrationMessage {
       struct RequestArgs {
 	Barrier barrier;
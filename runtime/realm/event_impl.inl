@@ -37,6 +37,13 @@ namespace Realm {
     return get_event_impl(needed)->add_waiter(ID(needed).event.generation, waiter);
   }
 
+  inline /*static*/ bool EventImpl::add_trigger_link(Event needed, Event successor,
+						     bool ignore_faults)
+  {
+    return get_event_impl(needed)->add_trigger_link(ID(needed).event.generation,
+						    successor, ignore_faults);
+  }
+
 
   ////////////////////////////////////////////////////////////////////////
   //
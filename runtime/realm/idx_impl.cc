@@ -23,6 +23,8 @@
 #include "mem_impl.h"
 #include "runtime_impl.h"
 
+#include <unistd.h>
+
 #ifdef USE_HDF
 #include "realm/hdf5/hdf5_module.h"
 #endif
@@ -182,9 +184,8 @@ namespace Realm {
                                            bool mutable_results,
 					   Event wait_on /*= Event::NO_EVENT*/)
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      ProfilingRequestSet reqs;
+      return compute_index_spaces(pairs, reqs, mutable_results, wait_on);
     }
 
     /*static*/
@@ -193,9 +194,12 @@ namespace Realm {
                                            bool mutable_results,
 					   Event wait_on /*= Event::NO_EVENT*/)
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      Event finish_event = GenEventImpl::create_genevent()->current_event();
+      BinaryIndexSpaceOperation *op = new BinaryIndexSpaceOperation(pairs, reqs,
+								    mutable_results,
+								    finish_event);
+      op->launch(wait_on);
+      return finish_event;
     }
 
     /*static*/
@@ -206,9 +210,9 @@ namespace Realm {
                                           IndexSpace parent /*= IndexSpace::NO_SPACE*/,
 				          Event wait_on /*= Event::NO_EVENT*/)
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      ProfilingRequestSet reqs;
+      return reduce_index_spaces(op, spaces, reqs, result, mutable_results,
+				 parent, wait_on);
     }
 
     /*static*/
@@ -220,9 +224,13 @@ namespace Realm {
                                           IndexSpace parent /*= IndexSpace::NO_SPACE*/,
 				          Event wait_on /*= Event::NO_EVENT*/)
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      Event finish_event = GenEventImpl::create_genevent()->current_event();
+      ReduceIndexSpaceOperation *r_op = new ReduceIndexSpaceOperation(op, spaces, result,
+								      parent, reqs,
+								      mutable_results,
+								      finish_event);
+      r_op->launch(wait_on);
+      return finish_event;
     }
 
     Event IndexSpace::create_subspaces_by_field(
@@ -231,9 +239,9 @@ namespace Realm {
                                 bool mutable_results,
                                 Event wait_on /*= Event::NO_EVENT*/) const
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      ProfilingRequestSet reqs;
+      return create_subspaces_by_field(field_data, subspaces, reqs,
+				       mutable_results, wait_on);
     }
 
     Event IndexSpace::create_subspaces_by_field(
@@ -243,9 +251,13 @@ namespace Realm {
                                 bool mutable_results,
                                 Event wait_on /*= Event::NO_EVENT*/) const
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      Event finish_event = GenEventImpl::create_genevent()->current_event();
+      FieldPartitionOperation *op = new FieldPartitionOperation(*this, field_data,
+								subspaces, reqs,
+								mutable_results,
+								finish_event);
+      op->launch(wait_on);
+      return finish_event;
     }
 
     Event IndexSpace::create_subspaces_by_image(
@@ -254,9 +266,9 @@ namespace Realm {
                                 bool mutable_results,
                                 Event wait_on /*= Event::NO_EVENT*/) const
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      ProfilingRequestSet reqs;
+      return create_subspaces_by_image(field_data, subspaces, reqs,
+				       mutable_results, wait_on);
     }
 
     Event IndexSpace::create_subspaces_by_image(
@@ -266,9 +278,13 @@ namespace Realm {
                                 bool mutable_results,
                                 Event wait_on /*= Event::NO_EVENT*/) const
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      Event finish_event = GenEventImpl::create_genevent()->current_event();
+      ImagePartitionOperation *op = new ImagePartitionOperation(*this, field_data,
+								subspaces, reqs,
+								mutable_results,
+								finish_event);
+      op->launch(wait_on);
+      return finish_event;
     }
 
     Event IndexSpace::create_subspaces_by_preimage(
@@ -277,9 +293,9 @@ namespace Realm {
                                  bool mutable_results,
                                  Event wait_on /*= Event::NO_EVENT*/) const
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      ProfilingRequestSet reqs;
+      return create_subspaces_by_preimage(field_data, subspaces, reqs,
+					  mutable_results, wait_on);
     }
 
     Event IndexSpace::create_subspaces_by_preimage(
@@ -289,9 +305,13 @@ namespace Realm {
                                  bool mutable_results,
                                  Event wait_on /*= Event::NO_EVENT*/) const
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      Event finish_event = GenEventImpl::create_genevent()->current_event();
+      PreimagePartitionOperation *op = new PreimagePartitionOperation(*this, field_data,
+								      subspaces, reqs,
+								      mutable_results,
+								      finish_event);
+      op->launch(wait_on);
+      return finish_event;
     }
 
   
@@ -1053,7 +1073,24 @@ namespace Realm {
 
     void ElementMask::set_raw(const void *data)
     {
-      assert(0);
+      assert(raw_data != 0);
+      size_t words = (num_elements + 63) >> 6;
+      memcpy(raw_data, data, words << 3);
+
+      // recompute the range of enabled elements
+      const uint64_t *bits = (const uint64_t *)raw_data;
+      first_enabled_elmt = -1LL;
+      last_enabled_elmt = -1LL;
+      for(size_t i = 0; i < words; i++)
+	if(bits[i]) {
+	  first_enabled_elmt = first_element + (i << 6) + __builtin_ctzll(bits[i]);
+	  break;
+	}
+      for(size_t i = words; i > 0; i--)
+	if(bits[i - 1]) {
+	  last_enabled_elmt = first_element + ((i - 1) << 6) + 63 - __builtin_clzll(bits[i - 1]);
+	  break;
+	}
     }
 
     bool ElementMask::is_set(coord_t ptr) const
@@ -1954,6 +1991,888 @@ namespace Realm {
     Message::request(target, args, data, datalen, payload_mode);
   }
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class PartitioningOperation
+  //
+
+  // don't split an operation into chunks smaller than this many elements
+  static const coord_t MIN_PARTITION_CHUNK = 1 << 16;
+
+  PartitioningOperation::PartitioningOperation(Event _finish_event,
+					       const ProfilingRequestSet &_reqs,
+					       bool _mutable_results)
+    : Operation(_finish_event, _reqs)
+    , num_chunks(0), next_chunk(0), chunks_done(0)
+    , mutable_results(_mutable_results)
+    , chunk_base(0), chunk_size(0), chunk_end(0), result_elmts(0)
+  {
+  }
+
+  PartitioningOperation::~PartitioningOperation(void)
+  {
+    for(std::vector<uint64_t *>::iterator it = result_bits.begin();
+	it != result_bits.end();
+	it++)
+      if(*it)
+	free(*it);
+  }
+
+  void PartitioningOperation::launch(Event wait_on)
+  {
+    get_runtime()->optable.add_local_operation(finish_event, this);
+
+    bool poisoned = false;
+    if(wait_on.has_triggered_faultaware(poisoned)) {
+      if(poisoned) {
+	log_poison.info() << "cancelling poisoned partitioning operation - op=" << this << " after=" << finish_event;
+	handle_poisoned_precondition(wait_on);
+      } else
+	PartitioningOpQueue::get_queue()->enqueue_operation(this);
+    } else
+      EventImpl::add_waiter(wait_on, new DeferredLaunch(this));
+  }
+
+  void PartitioningOperation::choose_chunks(coord_t lo, coord_t hi)
+  {
+    if(hi <= lo) {
+      num_chunks = 0;
+      return;
+    }
+
+    // aim for a few chunks per worker so that uneven chunks balance out
+    lo &= ~(coord_t)63;
+    coord_t pieces = 4 * PartitioningOpQueue::get_queue()->get_num_workers();
+    coord_t size = (hi - lo + pieces - 1) / pieces;
+    if(size < MIN_PARTITION_CHUNK)
+      size = MIN_PARTITION_CHUNK;
+    size = (size + 63) & ~(coord_t)63;
+
+    chunk_base = lo;
+    chunk_size = size;
+    chunk_end = hi;
+    num_chunks = (hi - lo + size - 1) / size;
+  }
+
+  void PartitioningOperation::get_chunk_range(size_t chunk, coord_t& lo, coord_t& hi) const
+  {
+    lo = chunk_base + (chunk * chunk_size);
+    hi = std::min(lo + chunk_size, chunk_end);
+  }
+
+  void PartitioningOperation::init_results(size_t count, size_t _result_elmts)
+  {
+    result_elmts = _result_elmts;
+    result_bits.assign(count, (uint64_t *)0);
+  }
+
+  uint64_t *PartitioningOperation::get_result_bits(size_t index)
+  {
+    uint64_t *bits = result_bits[index];
+    if(bits)
+      return bits;
+
+    // allocate a zeroed bitmap, but another worker may beat us to it
+    uint64_t *new_bits = (uint64_t *)calloc((result_elmts + 63) >> 6, sizeof(uint64_t));
+    assert(new_bits != 0);
+    bits = __sync_val_compare_and_swap(&result_bits[index], (uint64_t *)0, new_bits);
+    if(bits) {
+      free(new_bits);
+      return bits;
+    }
+    return new_bits;
+  }
+
+  void PartitioningOperation::install_result(IndexSpaceImpl *impl, IndexSpace parent,
+					     size_t index)
+  {
+    ElementMask mask(result_elmts);
+    if(result_bits[index]) {
+      mask.set_raw(result_bits[index]);
+      free(result_bits[index]);
+      result_bits[index] = 0;
+    }
+    impl->init(impl->me, parent, result_elmts, &mask, !mutable_results);
+  }
+
+  /*static*/ uint64_t PartitioningOperation::mask_word(const ElementMask& mask, coord_t word)
+  {
+    // masks always start on a 64-element boundary, so this is just a lookup
+    coord_t rel = word - (mask.get_first_element() >> 6);
+    if((rel < 0) || (rel >= (coord_t)((mask.get_num_elmts() + 63) >> 6)))
+      return 0;
+    const uint64_t *bits = (const uint64_t *)(mask.get_raw());
+    assert(bits != 0);
+    return bits[rel];
+  }
+
+  void PartitioningOperation::prepare_sources(const std::vector<IndexSpace::FieldDataDescriptor>& field_data,
+					      std::vector<FieldSource>& sources,
+					      coord_t& lo, coord_t& hi)
+  {
+    lo = hi = 0;
+    bool first = true;
+    sources.resize(field_data.size());
+    for(size_t i = 0; i < field_data.size(); i++) {
+      const IndexSpace::FieldDataDescriptor& fdd = field_data[i];
+      FieldSource& src = sources[i];
+
+      src.mask = &(fdd.index_space.get_valid_mask());
+      src.inst = get_runtime()->get_instance_impl(fdd.inst);
+      src.field_offset = fdd.field_offset;
+      src.field_size = fdd.field_size;
+
+      // use direct access to the instance data where possible
+      void *base = 0;
+      size_t stride = 0;
+      if(src.inst->get_strided_parameters(base, stride, fdd.field_offset)) {
+	src.base = (char *)base;
+	src.stride = stride;
+      } else {
+	src.base = 0;
+	src.stride = 0;
+      }
+
+      if(src.mask->first_enabled() < 0)
+	continue;
+      if(first || (src.mask->first_enabled() < lo))
+	lo = src.mask->first_enabled();
+      if(first || (src.mask->last_enabled() >= hi))
+	hi = src.mask->last_enabled() + 1;
+      first = false;
+    }
+  }
+
+  void PartitioningOperation::FieldSource::read(coord_t ptr, void *dst) const
+  {
+    if(base)
+      memcpy(dst, base + (ptr * stride), field_size);
+    else
+      inst->get_bytes(ptr, field_offset, dst, field_size);
+  }
+
+  coord_t PartitioningOperation::FieldSource::read_pointer(coord_t ptr) const
+  {
+    // common case: direct access to the instance data
+    if(base) {
+      if(field_size == sizeof(coord_t))
+	return *(const coord_t *)(base + (ptr * stride));
+      if(field_size == sizeof(int))
+	return *(const int *)(base + (ptr * stride));
+    }
+
+    if(field_size == sizeof(int)) {
+      int val;
+      read(ptr, &val);
+      return val;
+    } else {
+      assert(field_size == sizeof(coord_t));
+      coord_t val;
+      read(ptr, &val);
+      return val;
+    }
+  }
+
+  // the workers don't need to know which part of the index space a chunk covers
+  //  when the operation's range doesn't end on a word boundary, so clip here
+  static inline uint64_t clip_word(uint64_t bits, coord_t word, coord_t hi)
+  {
+    if(((word + 1) << 6) > hi)
+      bits &= ((1ULL << (hi & 63)) - 1);
+    return bits;
+  }
+
+  static IndexSpaceImpl *alloc_result_space(void)
+  {
+    IndexSpaceImpl *impl = get_runtime()->local_index_space_free_list->alloc_entry();
+    assert(impl);
+    assert(ID(impl->me).is_idxspace());
+    return impl;
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class PartitioningOperation::DeferredLaunch
+  //
+
+  PartitioningOperation::DeferredLaunch::DeferredLaunch(PartitioningOperation *_op)
+    : op(_op)
+  {}
+
+  PartitioningOperation::DeferredLaunch::~DeferredLaunch(void)
+  {}
+
+  bool PartitioningOperation::DeferredLaunch::event_triggered(Event e, bool poisoned)
+  {
+    if(poisoned) {
+      log_poison.info() << "cancelling poisoned partitioning operation - op=" << op << " after=" << op->get_finish_event();
+      op->handle_poisoned_precondition(e);
+    } else
+      PartitioningOpQueue::get_queue()->enqueue_operation(op);
+    return true;
+  }
+
+  void PartitioningOperation::DeferredLaunch::print(std::ostream& os) const
+  {
+    os << "deferred partitioning operation: op=" << op;
+  }
+
+  Event PartitioningOperation::DeferredLaunch::get_finish_event(void) const
+  {
+    return op->get_finish_event();
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class FieldPartitionOperation
+  //
+
+  FieldPartitionOperation::FieldPartitionOperation(IndexSpace _parent,
+						   const std::vector<IndexSpace::FieldDataDescriptor>& _field_data,
+						   std::map<DomainPoint, IndexSpace>& _subspaces,
+						   const ProfilingRequestSet &_reqs,
+						   bool _mutable_results,
+						   Event _finish_event)
+    : PartitioningOperation(_finish_event, _reqs, _mutable_results)
+    , parent(_parent), field_data(_field_data), color_dim(-1), color_table_base(0)
+  {
+    coord_t lo = 0, hi = -1;
+    for(std::map<DomainPoint, IndexSpace>::iterator it = _subspaces.begin();
+	it != _subspaces.end();
+	it++) {
+      // all colors must have the same dimension
+      if(color_dim == -1)
+	color_dim = it->first.get_dim();
+      else
+	assert(color_dim == it->first.get_dim());
+
+      IndexSpaceImpl *impl = alloc_result_space();
+      it->second = impl->me;
+      color_map[it->first] = results.size();
+      results.push_back(impl);
+
+      coord_t c = it->first.point_data[0];
+      if((hi < lo) || (c < lo)) lo = c;
+      if((hi < lo) || (c > hi)) hi = c;
+    }
+
+    // 1-D colors that are (mostly) compact get a dense lookup table
+    if((color_dim <= 1) && !results.empty() &&
+       ((hi - lo + 1) <= (coord_t)(4 * results.size() + 64))) {
+      color_table_base = lo;
+      color_table.assign(hi - lo + 1, -1);
+      for(std::map<DomainPoint, size_t>::const_iterator it = color_map.begin();
+	  it != color_map.end();
+	  it++)
+	color_table[it->first.point_data[0] - lo] = it->second;
+    }
+  }
+
+  void FieldPartitionOperation::prepare(void)
+  {
+    size_t num_elmts = StaticAccess<IndexSpaceImpl>(get_runtime()->get_index_space_impl(parent))->num_elmts;
+    init_results(results.size(), num_elmts);
+
+    coord_t lo, hi;
+    prepare_sources(field_data, sources, lo, hi);
+    choose_chunks(lo, hi);
+  }
+
+  void FieldPartitionOperation::execute_chunk(size_t chunk)
+  {
+    coord_t lo, hi;
+    get_chunk_range(chunk, lo, hi);
+
+    int dims = ((color_dim > 0) ? color_dim : 1);
+    for(std::vector<FieldSource>::const_iterator it = sources.begin();
+	it != sources.end();
+	it++) {
+      const FieldSource& src = *it;
+      size_t coord_size = src.field_size / dims;
+      assert(((coord_size == sizeof(int)) || (coord_size == sizeof(coord_t))) &&
+	     ((coord_size * dims) == src.field_size));
+
+      for(coord_t w = (lo >> 6); (w << 6) < hi; w++) {
+	uint64_t bits = clip_word(mask_word(*src.mask, w), w, hi);
+	while(bits) {
+	  int b = __builtin_ctzll(bits);
+	  bits &= (bits - 1);
+	  coord_t ptr = (w << 6) + b;
+	  assert(ptr < (coord_t)result_elmts);
+
+	  char raw[DomainPoint::MAX_POINT_DIM * sizeof(coord_t)];
+	  src.read(ptr, raw);
+	  DomainPoint dp;
+	  dp.dim = color_dim;
+	  for(int i = 0; i < dims; i++)
+	    dp.point_data[i] = ((coord_size == sizeof(int)) ?
+				  ((const int *)raw)[i] :
+				  ((const coord_t *)raw)[i]);
+
+	  // values that don't name one of the requested colors are ignored
+	  size_t index;
+	  if(!color_table.empty()) {
+	    coord_t rel = dp.point_data[0] - color_table_base;
+	    if((rel < 0) || (rel >= (coord_t)color_table.size()) || (color_table[rel] < 0))
+	      continue;
+	    index = color_table[rel];
+	  } else {
+	    std::map<DomainPoint, size_t>::const_iterator finder = color_map.find(dp);
+	    if(finder == color_map.end())
+	      continue;
+	    index = finder->second;
+	  }
+
+	  // chunks never share a word, so no atomics are needed here
+	  get_result_bits(index)[w] |= (1ULL << b);
+	}
+      }
+    }
+  }
+
+  void FieldPartitionOperation::install_results(void)
+  {
+    for(size_t i = 0; i < results.size(); i++)
+      install_result(results[i], parent, i);
+  }
+
+  void FieldPartitionOperation::print(std::ostream& os) const
+  {
+    os << "FieldPartitionOperation(" << parent << ", " << results.size() << " colors)";
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class ImagePartitionOperation
+  //
+
+  ImagePartitionOperation::ImagePartitionOperation(IndexSpace _parent,
+						   const std::vector<IndexSpace::FieldDataDescriptor>& _field_data,
+						   std::map<IndexSpace, IndexSpace>& _subspaces,
+						   const ProfilingRequestSet &_reqs,
+						   bool _mutable_results,
+						   Event _finish_event)
+    : PartitioningOperation(_finish_event, _reqs, _mutable_results)
+    , parent(_parent), field_data(_field_data), parent_mask(0)
+  {
+    for(std::map<IndexSpace, IndexSpace>::iterator it = _subspaces.begin();
+	it != _subspaces.end();
+	it++) {
+      IndexSpaceImpl *impl = alloc_result_space();
+      it->second = impl->me;
+      source_spaces.push_back(it->first);
+      results.push_back(impl);
+    }
+  }
+
+  void ImagePartitionOperation::prepare(void)
+  {
+    size_t num_elmts = StaticAccess<IndexSpaceImpl>(get_runtime()->get_index_space_impl(parent))->num_elmts;
+    init_results(results.size(), num_elmts);
+
+    parent_mask = &(parent.get_valid_mask());
+    source_masks.resize(source_spaces.size());
+    for(size_t i = 0; i < source_spaces.size(); i++)
+      source_masks[i] = &(source_spaces[i].get_valid_mask());
+
+    // chunks cover the elements holding the pointers, not the ones pointed to
+    coord_t lo, hi;
+    prepare_sources(field_data, sources, lo, hi);
+    choose_chunks(lo, hi);
+  }
+
+  void ImagePartitionOperation::execute_chunk(size_t chunk)
+  {
+    coord_t lo, hi;
+    get_chunk_range(chunk, lo, hi);
+
+    for(std::vector<FieldSource>::const_iterator it = sources.begin();
+	it != sources.end();
+	it++) {
+      const FieldSource& src = *it;
+
+      for(coord_t w = (lo >> 6); (w << 6) < hi; w++) {
+	uint64_t data_bits = clip_word(mask_word(*src.mask, w), w, hi);
+	if(!data_bits)
+	  continue;
+
+	for(size_t k = 0; k < source_masks.size(); k++) {
+	  uint64_t bits = data_bits & mask_word(*source_masks[k], w);
+	  while(bits) {
+	    int b = __builtin_ctzll(bits);
+	    bits &= (bits - 1);
+	    coord_t target = src.read_pointer((w << 6) + b);
+
+	    // pointers outside of the parent space are ignored
+	    if((target < 0) || (target >= (coord_t)result_elmts) ||
+	       !parent_mask->is_set(target))
+	      continue;
+
+	    // images from different chunks can land in the same word
+	    __sync_fetch_and_or(&(get_result_bits(k)[target >> 6]), (1ULL << (target & 63)));
+	  }
+	}
+      }
+    }
+  }
+
+  void ImagePartitionOperation::install_results(void)
+  {
+    for(size_t i = 0; i < results.size(); i++)
+      install_result(results[i], parent, i);
+  }
+
+  void ImagePartitionOperation::print(std::ostream& os) const
+  {
+    os << "ImagePartitionOperation(" << parent << ", " << results.size() << " sources)";
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class PreimagePartitionOperation
+  //
+
+  PreimagePartitionOperation::PreimagePartitionOperation(IndexSpace _parent,
+							 const std::vector<IndexSpace::FieldDataDescriptor>& _field_data,
+							 std::map<IndexSpace, IndexSpace>& _subspaces,
+							 const ProfilingRequestSet &_reqs,
+							 bool _mutable_results,
+							 Event _finish_event)
+    : PartitioningOperation(_finish_event, _reqs, _mutable_results)
+    , parent(_parent), field_data(_field_data), disjoint_ranges(false)
+  {
+    for(std::map<IndexSpace, IndexSpace>::iterator it = _subspaces.begin();
+	it != _subspaces.end();
+	it++) {
+      IndexSpaceImpl *impl = alloc_result_space();
+      it->second = impl->me;
+      target_spaces.push_back(it->first);
+      results.push_back(impl);
+    }
+  }
+
+  void PreimagePartitionOperation::prepare(void)
+  {
+    size_t num_elmts = StaticAccess<IndexSpaceImpl>(get_runtime()->get_index_space_impl(parent))->num_elmts;
+    init_results(results.size(), num_elmts);
+
+    target_masks.resize(target_spaces.size());
+    range_starts.clear();
+    for(size_t i = 0; i < target_spaces.size(); i++) {
+      target_masks[i] = &(target_spaces[i].get_valid_mask());
+      if(target_masks[i]->first_enabled() >= 0)
+	range_starts.push_back(std::make_pair(target_masks[i]->first_enabled(), i));
+    }
+    std::sort(range_starts.begin(), range_starts.end());
+    disjoint_ranges = true;
+    for(size_t i = 1; i < range_starts.size(); i++)
+      if(range_starts[i].first <= target_masks[range_starts[i - 1].second]->last_enabled()) {
+	disjoint_ranges = false;
+	break;
+      }
+
+    coord_t lo, hi;
+    prepare_sources(field_data, sources, lo, hi);
+    choose_chunks(lo, hi);
+  }
+
+  void PreimagePartitionOperation::execute_chunk(size_t chunk)
+  {
+    coord_t lo, hi;
+    get_chunk_range(chunk, lo, hi);
+
+    if(target_masks.empty())
+      return;
+    size_t last_k = 0;
+
+    for(std::vector<FieldSource>::const_iterator it = sources.begin();
+	it != sources.end();
+	it++) {
+      const FieldSource& src = *it;
+
+      for(coord_t w = (lo >> 6); (w << 6) < hi; w++) {
+	uint64_t bits = clip_word(mask_word(*src.mask, w), w, hi);
+	while(bits) {
+	  int b = __builtin_ctzll(bits);
+	  bits &= (bits - 1);
+	  coord_t ptr = (w << 6) + b;
+	  assert(ptr < (coord_t)result_elmts);
+	  coord_t target = src.read_pointer(ptr);
+
+	  if(disjoint_ranges) {
+	    // pointers tend to be clustered, so try the previous target first, and
+	    //  then find the last target whose range starts at or before the pointer
+	    const ElementMask *m = target_masks[last_k];
+	    if((target < m->first_enabled()) || (target > m->last_enabled())) {
+	      std::vector<std::pair<coord_t, size_t> >::const_iterator it2 =
+		std::upper_bound(range_starts.begin(), range_starts.end(),
+				 std::make_pair(target, (size_t)-1));
+	      if(it2 == range_starts.begin())
+		continue;
+	      last_k = (it2 - 1)->second;
+	      m = target_masks[last_k];
+	      if(target > m->last_enabled())
+		continue;
+	    }
+	    if(m->is_set(target))
+	      get_result_bits(last_k)[w] |= (1ULL << b);
+	    continue;
+	  }
+
+	  for(size_t k = 0; k < target_masks.size(); k++) {
+	    // cheap bounds check before looking at the bits
+	    const ElementMask *m = target_masks[k];
+	    if((target < m->first_enabled()) || (target > m->last_enabled()) ||
+	       !m->is_set(target))
+	      continue;
+
+	    // results are indexed by the pointer's location, which is chunk-private
+	    get_result_bits(k)[w] |= (1ULL << b);
+	  }
+	}
+      }
+    }
+  }
+
+  void PreimagePartitionOperation::install_results(void)
+  {
+    for(size_t i = 0; i < results.size(); i++)
+      install_result(results[i], parent, i);
+  }
+
+  void PreimagePartitionOperation::print(std::ostream& os) const
+  {
+    os << "PreimagePartitionOperation(" << parent << ", " << results.size() << " targets)";
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class BinaryIndexSpaceOperation
+  //
+
+  BinaryIndexSpaceOperation::BinaryIndexSpaceOperation(std::vector<IndexSpace::BinaryOpDescriptor>& _pairs,
+						       const ProfilingRequestSet &_reqs,
+						       bool _mutable_results,
+						       Event _finish_event)
+    : PartitioningOperation(_finish_event, _reqs, _mutable_results)
+  {
+    for(std::vector<IndexSpace::BinaryOpDescriptor>::iterator it = _pairs.begin();
+	it != _pairs.end();
+	it++) {
+      IndexSpaceImpl *impl = alloc_result_space();
+      it->result = impl->me;
+      results.push_back(impl);
+    }
+    pairs = _pairs;
+  }
+
+  void BinaryIndexSpaceOperation::prepare(void)
+  {
+    left_masks.resize(pairs.size());
+    right_masks.resize(pairs.size());
+    parent_elmts.resize(pairs.size());
+    result_masks.assign(pairs.size(), (ElementMask *)0);
+    for(size_t i = 0; i < pairs.size(); i++) {
+      left_masks[i] = &(pairs[i].left_operand.get_valid_mask());
+      right_masks[i] = &(pairs[i].right_operand.get_valid_mask());
+      parent_elmts[i] = StaticAccess<IndexSpaceImpl>(get_runtime()->get_index_space_impl(pairs[i].parent))->num_elmts;
+    }
+
+    // each pair is computed word-by-word by a single worker
+    num_chunks = pairs.size();
+  }
+
+  void BinaryIndexSpaceOperation::execute_chunk(size_t chunk)
+  {
+    const ElementMask& left = *left_masks[chunk];
+    const ElementMask& right = *right_masks[chunk];
+    size_t words = (parent_elmts[chunk] + 63) >> 6;
+    std::vector<uint64_t> bits(words, 0);
+
+    for(size_t w = 0; w < words; w++) {
+      uint64_t l = mask_word(left, w);
+      switch(pairs[chunk].op) {
+      case IndexSpace::ISO_UNION:
+	bits[w] = l | mask_word(right, w);
+	break;
+      case IndexSpace::ISO_INTERSECT:
+	bits[w] = (l ? (l & mask_word(right, w)) : 0);
+	break;
+      case IndexSpace::ISO_SUBTRACT:
+	bits[w] = (l ? (l & ~mask_word(right, w)) : 0);
+	break;
+      default:
+	assert(0);
+      }
+    }
+
+    ElementMask *mask = new ElementMask(parent_elmts[chunk]);
+    if(words > 0)
+      mask->set_raw(&bits[0]);
+    result_masks[chunk] = mask;
+  }
+
+  void BinaryIndexSpaceOperation::install_results(void)
+  {
+    for(size_t i = 0; i < results.size(); i++) {
+      results[i]->init(results[i]->me, pairs[i].parent, parent_elmts[i],
+		       result_masks[i], !mutable_results);
+      delete result_masks[i];
+      result_masks[i] = 0;
+    }
+  }
+
+  void BinaryIndexSpaceOperation::print(std::ostream& os) const
+  {
+    os << "BinaryIndexSpaceOperation(" << pairs.size() << " pairs)";
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class ReduceIndexSpaceOperation
+  //
+
+  ReduceIndexSpaceOperation::ReduceIndexSpaceOperation(IndexSpace::IndexSpaceOperation _op,
+						       const std::vector<IndexSpace>& _spaces,
+						       IndexSpace& _result, IndexSpace _parent,
+						       const ProfilingRequestSet &_reqs,
+						       bool _mutable_results,
+						       Event _finish_event)
+    : PartitioningOperation(_finish_event, _reqs, _mutable_results)
+    , op(_op), spaces(_spaces), parent(_parent)
+  {
+    result = alloc_result_space();
+    _result = result->me;
+  }
+
+  void ReduceIndexSpaceOperation::prepare(void)
+  {
+    masks.resize(spaces.size());
+    size_t num_elmts = 0;
+    for(size_t i = 0; i < spaces.size(); i++) {
+      masks[i] = &(spaces[i].get_valid_mask());
+      size_t end = masks[i]->get_first_element() + masks[i]->get_num_elmts();
+      if(end > num_elmts)
+	num_elmts = end;
+    }
+    if(parent.exists())
+      num_elmts = StaticAccess<IndexSpaceImpl>(get_runtime()->get_index_space_impl(parent))->num_elmts;
+
+    init_results(1, num_elmts);
+    choose_chunks(0, num_elmts);
+  }
+
+  void ReduceIndexSpaceOperation::execute_chunk(size_t chunk)
+  {
+    coord_t lo, hi;
+    get_chunk_range(chunk, lo, hi);
+
+    for(coord_t w = (lo >> 6); (w << 6) < hi; w++) {
+      uint64_t bits = 0;
+      if(!masks.empty()) {
+	bits = mask_word(*masks[0], w);
+	for(size_t i = 1; i < masks.size(); i++) {
+	  switch(op) {
+	  case IndexSpace::ISO_UNION:
+	    bits |= mask_word(*masks[i], w);
+	    break;
+	  case IndexSpace::ISO_INTERSECT:
+	    bits &= mask_word(*masks[i], w);
+	    break;
+	  case IndexSpace::ISO_SUBTRACT:
+	    bits &= ~mask_word(*masks[i], w);
+	    break;
+	  default:
+	    assert(0);
+	  }
+	  if(!bits && (op != IndexSpace::ISO_UNION))
+	    break;
+	}
+      }
+      bits = clip_word(bits, w, hi);
+      if(bits)
+	get_result_bits(0)[w] = bits;
+    }
+  }
+
+  void ReduceIndexSpaceOperation::install_results(void)
+  {
+    install_result(result, parent, 0);
+  }
+
+  void ReduceIndexSpaceOperation::print(std::ostream& os) const
+  {
+    os << "ReduceIndexSpaceOperation(" << spaces.size() << " spaces)";
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class PartitioningOpQueue
+  //
+
+  static PartitioningOpQueue *partitioning_queue = 0;
+
+  PartitioningOpQueue::PartitioningOpQueue(CoreReservationSet& crs, int _num_workers)
+    : queue_condvar(queue_mutex)
+    , shutdown_flag(false)
+    , num_workers((_num_workers > 0) ? _num_workers : 1)
+    , core_rsrv("partitioning workers", crs,
+		CoreReservationParameters().set_num_cores(num_workers))
+  {
+  }
+
+  PartitioningOpQueue::~PartitioningOpQueue(void)
+  {
+    assert(worker_threads.empty());
+  }
+
+  /*static*/ PartitioningOpQueue *PartitioningOpQueue::get_queue(void)
+  {
+    assert(partitioning_queue != 0);
+    return partitioning_queue;
+  }
+
+  void PartitioningOpQueue::start_workers(void)
+  {
+    ThreadLaunchParameters tlp;
+
+    for(int i = 0; i < num_workers; i++) {
+      Thread *t = Thread::create_kernel_thread<PartitioningOpQueue,
+					       &PartitioningOpQueue::worker_thread_loop>(this,
+											 tlp,
+											 core_rsrv,
+											 0 /* default scheduler*/);
+      worker_threads.push_back(t);
+    }
+  }
+
+  void PartitioningOpQueue::shutdown_queue(void)
+  {
+    queue_mutex.lock();
+
+    assert(ready_ops.empty() && running_ops.empty());
+
+    shutdown_flag = true;
+    queue_condvar.broadcast();
+    queue_mutex.unlock();
+
+    // reap all the threads
+    for(std::vector<Thread *>::iterator it = worker_threads.begin();
+	it != worker_threads.end();
+	it++) {
+      (*it)->join();
+      delete (*it);
+    }
+    worker_threads.clear();
+  }
+
+  void PartitioningOpQueue::enqueue_operation(PartitioningOperation *op)
+  {
+    // record that it is ready - check for cancellation though
+    bool ok_to_run = op->mark_ready();
+    if(!ok_to_run) {
+      op->mark_finished(false /*!successful*/);
+      return;
+    }
+
+    AutoHSLLock al(queue_mutex);
+    ready_ops.push_back(op);
+    queue_condvar.signal();
+  }
+
+  void PartitioningOpQueue::worker_thread_loop(void)
+  {
+    log_meta.info("partitioning worker thread created");
+
+    queue_mutex.lock();
+    while(true) {
+      // finish chunks of operations that are already running before starting new ones
+      if(!running_ops.empty()) {
+	PartitioningOperation *op = running_ops.front();
+	size_t chunk = op->next_chunk++;
+	if(op->next_chunk == op->num_chunks)
+	  running_ops.pop_front();
+	queue_mutex.unlock();
+
+	op->execute_chunk(chunk);
+
+	size_t done = __sync_add_and_fetch(&op->chunks_done, 1);
+	if(done == op->num_chunks) {
+	  op->install_results();
+	  op->mark_finished(true /*successful*/);
+	}
+
+	queue_mutex.lock();
+	continue;
+      }
+
+      if(!ready_ops.empty()) {
+	PartitioningOperation *op = ready_ops.front();
+	ready_ops.pop_front();
+	queue_mutex.unlock();
+
+	if(op->mark_started()) {
+	  op->prepare();
+
+	  if(op->num_chunks > 0) {
+	    queue_mutex.lock();
+	    running_ops.push_back(op);
+	    // wake up other workers to help with the chunks
+	    if(op->num_chunks > 1)
+	      queue_condvar.broadcast();
+	    continue;
+	  }
+
+	  // nothing to do but install the (empty) results
+	  op->install_results();
+	  op->mark_finished(true /*successful*/);
+	} else
+	  op->mark_finished(false /*!successful*/);
+
+	queue_mutex.lock();
+	continue;
+      }
+
+      if(shutdown_flag)
+	break;
+
+      queue_condvar.wait();
+    }
+    queue_mutex.unlock();
+
+    log_meta.info("partitioning worker thread terminating");
+  }
+
+  void start_partitioning_workers(int count, CoreReservationSet& crs)
+  {
+    // a count of zero means size the pool from the machine: one worker per
+    //  four online cores, capped at four so the pool stays small next to
+    //  the application's own processors
+    if(count <= 0) {
+      long cores = sysconf(_SC_NPROCESSORS_ONLN);
+      count = (cores > 0) ? (int)(cores / 4) : 1;
+      if(count < 1) count = 1;
+      if(count > 4) count = 4;
+    }
+    partitioning_queue = new PartitioningOpQueue(crs, count);
+    partitioning_queue->start_workers();
+  }
+
+  void stop_partitioning_workers(void)
+  {
+    partitioning_queue->shutdown_queue();
+    delete partitioning_queue;
+    partitioning_queue = 0;
+  }
+
+
   class FetchISMaskWaiter : public EventWaiter {
   public:
     FetchISMaskWaiter(Event complete, IndexSpace is);
@@ -24,9 +24,14 @@
 #include "activemsg.h"
 
 #include "rsrv_impl.h"
+#include "event_impl.h"
+#include "operation.h"
+#include "threads.h"
 
 namespace Realm {
 
+    class RegionInstanceImpl;
+
     struct ElementMaskImpl {
       //int count, offset;
       //typedef unsigned long long uint64;
@@ -106,6 +111,233 @@ namespace Realm {
       IndexSpaceImpl *is_impl;
     };
 
+    // dependent partitioning operations (partitions by field/image/preimage and
+    //  logical operations on IndexSpaces) are deferred until their preconditions
+    //  trigger, and then split into chunks that are processed in parallel by a
+    //  pool of worker threads - results are accumulated in dense bitmaps and
+    //  installed as the ElementMasks of the new IndexSpaces when all chunks are done
+    class PartitioningOperation : public Operation {
+    protected:
+      PartitioningOperation(Event _finish_event, const ProfilingRequestSet &_reqs,
+			    bool _mutable_results);
+
+      virtual ~PartitioningOperation(void);
+
+    public:
+      // registers the operation and hands it to the workers once 'wait_on' has triggered
+      void launch(Event wait_on);
+
+      // called (once) by a worker before any chunks are handed out - fetches
+      //  input masks and instance layouts and decides on the number of chunks
+      virtual void prepare(void) = 0;
+
+      // called concurrently for each chunk in [0, num_chunks)
+      virtual void execute_chunk(size_t chunk) = 0;
+
+      // called (once) after all chunks have finished
+      virtual void install_results(void) = 0;
+
+      // work distribution, protected by the queue's mutex
+      size_t num_chunks, next_chunk;
+      // number of chunks done - updated atomically
+      size_t chunks_done;
+
+    protected:
+      // splits [lo, hi) into 64-element-aligned chunks so that concurrent chunks
+      //  never write the same word of a result bitmap
+      void choose_chunks(coord_t lo, coord_t hi);
+      void get_chunk_range(size_t chunk, coord_t& lo, coord_t& hi) const;
+
+      // result bitmaps cover [0, result_elmts) and are allocated on first use
+      void init_results(size_t count, size_t _result_elmts);
+      uint64_t *get_result_bits(size_t index);
+      void install_result(IndexSpaceImpl *impl, IndexSpace parent, size_t index);
+
+      // reads the 64 bits of 'mask' starting at element 'word << 6'
+      static uint64_t mask_word(const ElementMask& mask, coord_t word);
+
+      class DeferredLaunch : public EventWaiter {
+      public:
+	DeferredLaunch(PartitioningOperation *_op);
+	virtual ~DeferredLaunch(void);
+
+	virtual bool event_triggered(Event e, bool poisoned);
+	virtual void print(std::ostream& os) const;
+	virtual Event get_finish_event(void) const;
+
+      protected:
+	PartitioningOperation *op;
+      };
+
+      // one per FieldDataDescriptor - knows how to read the field data for an element
+      struct FieldSource {
+	const ElementMask *mask;
+	RegionInstanceImpl *inst;
+	char *base;
+	size_t stride;
+	off_t field_offset;
+	size_t field_size;
+
+	void read(coord_t ptr, void *dst) const;
+	coord_t read_pointer(coord_t ptr) const;
+      };
+      void prepare_sources(const std::vector<IndexSpace::FieldDataDescriptor>& field_data,
+			   std::vector<FieldSource>& sources, coord_t& lo, coord_t& hi);
+
+      bool mutable_results;
+      coord_t chunk_base, chunk_size, chunk_end;
+      size_t result_elmts;
+      std::vector<uint64_t *> result_bits;
+    };
+
+    class FieldPartitionOperation : public PartitioningOperation {
+    public:
+      FieldPartitionOperation(IndexSpace _parent,
+			      const std::vector<IndexSpace::FieldDataDescriptor>& _field_data,
+			      std::map<DomainPoint, IndexSpace>& _subspaces,
+			      const ProfilingRequestSet &_reqs, bool _mutable_results,
+			      Event _finish_event);
+
+      virtual void prepare(void);
+      virtual void execute_chunk(size_t chunk);
+      virtual void install_results(void);
+      virtual void print(std::ostream& os) const;
+
+    protected:
+      IndexSpace parent;
+      std::vector<IndexSpace::FieldDataDescriptor> field_data;
+      std::vector<FieldSource> sources;
+      std::vector<IndexSpaceImpl *> results;
+      int color_dim;
+      // colors are found with a dense table when they're compact 1-D values, or
+      //  with a map otherwise
+      std::map<DomainPoint, size_t> color_map;
+      std::vector<int> color_table;
+      coord_t color_table_base;
+    };
+
+    class ImagePartitionOperation : public PartitioningOperation {
+    public:
+      ImagePartitionOperation(IndexSpace _parent,
+			      const std::vector<IndexSpace::FieldDataDescriptor>& _field_data,
+			      std::map<IndexSpace, IndexSpace>& _subspaces,
+			      const ProfilingRequestSet &_reqs, bool _mutable_results,
+			      Event _finish_event);
+
+      virtual void prepare(void);
+      virtual void execute_chunk(size_t chunk);
+      virtual void install_results(void);
+      virtual void print(std::ostream& os) const;
+
+    protected:
+      IndexSpace parent;
+      std::vector<IndexSpace::FieldDataDescriptor> field_data;
+      std::vector<FieldSource> sources;
+      std::vector<IndexSpace> source_spaces;
+      std::vector<const ElementMask *> source_masks;
+      std::vector<IndexSpaceImpl *> results;
+      const ElementMask *parent_mask;
+    };
+
+    class PreimagePartitionOperation : public PartitioningOperation {
+    public:
+      PreimagePartitionOperation(IndexSpace _parent,
+				 const std::vector<IndexSpace::FieldDataDescriptor>& _field_data,
+				 std::map<IndexSpace, IndexSpace>& _subspaces,
+				 const ProfilingRequestSet &_reqs, bool _mutable_results,
+				 Event _finish_event);
+
+      virtual void prepare(void);
+      virtual void execute_chunk(size_t chunk);
+      virtual void install_results(void);
+      virtual void print(std::ostream& os) const;
+
+    protected:
+      IndexSpace parent;
+      std::vector<IndexSpace::FieldDataDescriptor> field_data;
+      std::vector<FieldSource> sources;
+      std::vector<IndexSpace> target_spaces;
+      std::vector<const ElementMask *> target_masks;
+      std::vector<IndexSpaceImpl *> results;
+      // when the targets' enabled ranges don't overlap (e.g. a blocked partition),
+      //  a binary search on the range starts finds the only candidate target
+      bool disjoint_ranges;
+      std::vector<std::pair<coord_t, size_t> > range_starts;
+    };
+
+    class BinaryIndexSpaceOperation : public PartitioningOperation {
+    public:
+      BinaryIndexSpaceOperation(std::vector<IndexSpace::BinaryOpDescriptor>& _pairs,
+				const ProfilingRequestSet &_reqs, bool _mutable_results,
+				Event _finish_event);
+
+      virtual void prepare(void);
+      virtual void execute_chunk(size_t chunk);
+      virtual void install_results(void);
+      virtual void print(std::ostream& os) const;
+
+    protected:
+      std::vector<IndexSpace::BinaryOpDescriptor> pairs;
+      std::vector<IndexSpaceImpl *> results;
+      // each pair may have a different parent, so results are built directly
+      std::vector<const ElementMask *> left_masks, right_masks;
+      std::vector<size_t> parent_elmts;
+      std::vector<ElementMask *> result_masks;
+    };
+
+    class ReduceIndexSpaceOperation : public PartitioningOperation {
+    public:
+      ReduceIndexSpaceOperation(IndexSpace::IndexSpaceOperation _op,
+				const std::vector<IndexSpace>& _spaces,
+				IndexSpace& _result, IndexSpace _parent,
+				const ProfilingRequestSet &_reqs, bool _mutable_results,
+				Event _finish_event);
+
+      virtual void prepare(void);
+      virtual void execute_chunk(size_t chunk);
+      virtual void install_results(void);
+      virtual void print(std::ostream& os) const;
+
+    protected:
+      IndexSpace::IndexSpaceOperation op;
+      std::vector<IndexSpace> spaces;
+      std::vector<const ElementMask *> masks;
+      IndexSpace parent;
+      IndexSpaceImpl *result;
+    };
+
+    // ready partitioning operations are queued here, and worker threads claim
+    //  chunks of the operation at the head of the queue
+    class PartitioningOpQueue {
+    public:
+      PartitioningOpQueue(CoreReservationSet& crs, int _num_workers);
+      ~PartitioningOpQueue(void);
+
+      static PartitioningOpQueue *get_queue(void);
+
+      void start_workers(void);
+      void shutdown_queue(void);
+
+      void enqueue_operation(PartitioningOperation *op);
+
+      int get_num_workers(void) const { return num_workers; }
+
+    protected:
+      void worker_thread_loop(void);
+
+      GASNetHSL queue_mutex;
+      GASNetCondVar queue_condvar;
+      // operations waiting to be prepared, and prepared operations with chunks left
+      std::deque<PartitioningOperation *> ready_ops, running_ops;
+      bool shutdown_flag;
+      int num_workers;
+      CoreReservation core_rsrv;
+      std::vector<Thread *> worker_threads;
+    };
+
+    void start_partitioning_workers(int count, CoreReservationSet& crs);
+    void stop_partitioning_workers(void);
+
     // active messages
 
     struct ValidMaskRequestMessage {
@@ -20,6 +20,8 @@
 
 #include "instance.h"
 #include "id.h"
+#include "indexspace.h"
+#include "profiling.h"
 
 #include "activemsg.h"
 
@@ -29,8 +29,13 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <ctype.h>
 #include <assert.h>
 #include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <link.h>
 
 #include <set>
 #include <map>
@@ -45,6 +50,13 @@ namespace Realm {
 
     virtual void write(const char *buffer, size_t len) = 0;
     virtual void flush(void) = 0;
+
+    // streams that record messages in the binary format take the printf
+    //  format and arguments directly - returns false if the message has to
+    //  be formatted and sent through write() instead
+    virtual bool is_binary(void) const { return false; }
+    virtual bool write_format(const Logger *logger, Logger::LoggingLevel level,
+			      const char *fmt, va_list args) { return false; }
   };
 
   class LoggerFileStream : public LoggerOutputStream {
@@ -141,6 +153,506 @@ namespace Realm {
     pthread_mutex_t mutex;
   };
 
+  // The binary log format (decoded by tools/realm_log_decode.py) starts
+  //  with an 8 byte magic number and the node number, followed by
+  //  records that each have a one byte type and a 4 byte payload length.
+  //  A message record names its logger and format string by address, and
+  //  a string definition record for each address is written before its
+  //  first use.  All values are in native byte order.
+  static const char LOG_BINARY_MAGIC[8] = { 'R', 'L', 'O', 'G', 'B', 'I', 'N', '1' };
+
+  enum {
+    LOG_REC_TEXT = 1,     // already formatted text
+    LOG_REC_STRING = 2,   // u64 id, string bytes
+    LOG_REC_MESSAGE = 3,  // u64 thread, u64 name id, u64 format id, u8 level, args
+    LOG_REC_DROPPED = 4,  // u64 thread, u64 count
+  };
+
+  enum {
+    LOG_ARG_INT = 'i',     // int64
+    LOG_ARG_UINT = 'u',    // uint64
+    LOG_ARG_DOUBLE = 'f',  // double
+    LOG_ARG_STRING = 's',  // u32 length, bytes
+    LOG_ARG_POINTER = 'p', // uint64
+  };
+
+  static const size_t LOG_REC_HEADER_SIZE = 5;
+
+  // appends to a fixed-size buffer, remembering if anything didn't fit
+  class LogRecordBuilder {
+  public:
+    LogRecordBuilder(char *_base, size_t _maxlen)
+      : base(_base), maxlen(_maxlen), len(0), overflow(false) {}
+
+    void add(const void *data, size_t bytes)
+    {
+      if((len + bytes) > maxlen) {
+	overflow = true;
+	return;
+      }
+      memcpy(base + len, data, bytes);
+      len += bytes;
+    }
+
+    template <typename T>
+    void add_value(T val) { add(&val, sizeof(T)); }
+
+    void add_header(unsigned char type, unsigned payload_len)
+    {
+      add_value(type);
+      add_value(payload_len);
+    }
+
+    char *base;
+    size_t maxlen, len;
+    bool overflow;
+  };
+
+  // walks a printf format and records the arguments it would consume -
+  //  returns false for conversions the decoder can't reproduce
+  static bool encode_format_args(const char *fmt, va_list args,
+				 LogRecordBuilder& rb)
+  {
+    const char *p = fmt;
+    while(*p) {
+      if(*p++ != '%') continue;
+      if(*p == '%') {
+	p++;
+	continue;
+      }
+      // flags
+      while(*p && strchr("-+ #0'", *p)) p++;
+      // width and precision
+      for(int i = 0; i < 2; i++) {
+	if(i == 1) {
+	  if(*p != '.') break;
+	  p++;
+	}
+	if(*p == '*') {
+	  rb.add_value((unsigned char)LOG_ARG_INT);
+	  rb.add_value((long long)va_arg(args, int));
+	  p++;
+	} else
+	  while(isdigit(*p)) p++;
+      }
+      // length modifier
+      int lmod = 0;  // 0 = int, 1 = long, 2 = long long, 3 = size_t/ptrdiff_t/intmax_t
+      if((p[0] == 'h') && (p[1] == 'h')) p += 2;
+      else if(*p == 'h') p++;
+      else if((p[0] == 'l') && (p[1] == 'l')) { lmod = 2; p += 2; }
+      else if((*p == 'l') || (*p == 'q')) { lmod = (*p == 'l') ? 1 : 2; p++; }
+      else if((*p == 'z') || (*p == 't') || (*p == 'j')) { lmod = 3; p++; }
+      else if(*p == 'L') return false;  // long double
+
+      switch(*p++) {
+      case 'd':
+      case 'i':
+      case 'c':
+	{
+	  long long v;
+	  switch(lmod) {
+	  case 0: v = va_arg(args, int); break;
+	  case 1: v = va_arg(args, long); break;
+	  case 2: v = va_arg(args, long long); break;
+	  default: v = va_arg(args, ssize_t); break;
+	  }
+	  rb.add_value((unsigned char)LOG_ARG_INT);
+	  rb.add_value(v);
+	  break;
+	}
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+	{
+	  unsigned long long v;
+	  switch(lmod) {
+	  case 0: v = va_arg(args, unsigned); break;
+	  case 1: v = va_arg(args, unsigned long); break;
+	  case 2: v = va_arg(args, unsigned long long); break;
+	  default: v = va_arg(args, size_t); break;
+	  }
+	  rb.add_value((unsigned char)LOG_ARG_UINT);
+	  rb.add_value(v);
+	  break;
+	}
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+	{
+	  rb.add_value((unsigned char)LOG_ARG_DOUBLE);
+	  rb.add_value(va_arg(args, double));
+	  break;
+	}
+      case 's':
+	{
+	  if(lmod != 0) return false;  // wide strings
+	  const char *str = va_arg(args, const char *);
+	  if(!str) str = "(null)";
+	  unsigned slen = strlen(str);
+	  rb.add_value((unsigned char)LOG_ARG_STRING);
+	  rb.add_value(slen);
+	  rb.add(str, slen);
+	  break;
+	}
+      case 'p':
+	{
+	  rb.add_value((unsigned char)LOG_ARG_POINTER);
+	  rb.add_value((unsigned long long)(uintptr_t)va_arg(args, void *));
+	  break;
+	}
+      default:
+	// %n, %m, wide chars, and anything malformed
+	return false;
+      }
+      if(rb.overflow) return false;
+    }
+    return !rb.overflow;
+  }
+
+  class LoggerStreamAsync;
+
+  // a single-producer/single-consumer byte ring - the owning thread
+  //  appends whole records and the writer removes them
+  class LoggerRing {
+  public:
+    LoggerRing(LoggerStreamAsync *_stream, size_t _size)
+      : stream(_stream), size(_size), head(0), tail(0)
+      , dropped(0), dropped_reported(0)
+      , thread((unsigned long)pthread_self())
+    {
+      // size must be a power of two
+      assert((size & (size - 1)) == 0);
+      buffer = (char *)malloc(size);
+      assert(buffer != 0);
+    }
+
+    ~LoggerRing(void)
+    {
+      free(buffer);
+    }
+
+    // either copies both pieces or counts the record as dropped
+    bool append(const void *data1, size_t len1, const void *data2, size_t len2)
+    {
+      size_t h = head;
+      size_t t = tail;
+      if((size - (h - t)) < (len1 + len2)) {
+	dropped++;
+	return false;
+      }
+      copy_in(h, data1, len1);
+      copy_in(h + len1, data2, len2);
+      // make sure the data is visible before the new head
+      __sync_synchronize();
+      head = h + len1 + len2;
+      return true;
+    }
+
+    // called only by the consumer - appends everything available to 'out'
+    void drain(std::vector<char>& out)
+    {
+      size_t h = head;
+      __sync_synchronize();
+      size_t t = tail;
+      if(h == t) return;
+      size_t start = t & (size - 1);
+      size_t bytes = h - t;
+      size_t first = ((start + bytes) > size) ? (size - start) : bytes;
+      out.insert(out.end(), buffer + start, buffer + start + first);
+      out.insert(out.end(), buffer, buffer + (bytes - first));
+      // don't let the producer reuse the space until we've copied it
+      __sync_synchronize();
+      tail = h;
+    }
+
+    LoggerStreamAsync *stream;
+    const size_t size;
+    char *buffer;
+    volatile size_t head, tail;
+    volatile size_t dropped;
+    size_t dropped_reported;  // only touched by the consumer
+    const unsigned long thread;
+    std::set<const char *> strings_defined;  // only touched by the producer
+
+  protected:
+    void copy_in(size_t pos, const void *data, size_t len)
+    {
+      size_t start = pos & (size - 1);
+      size_t first = ((start + len) > size) ? (size - start) : len;
+      memcpy(buffer + start, data, first);
+      memcpy(buffer, ((const char *)data) + first, len - first);
+    }
+  };
+
+  // each thread's ring for the (one) async stream it writes to
+  static __thread LoggerRing *thread_log_ring = 0;
+
+  // Application threads append their messages to per-thread rings, which
+  //  a background thread drains into the underlying stream, so logging
+  //  never waits on the file system or on other logging threads.  If a
+  //  thread's ring is full, the message is dropped and counted, and the
+  //  number of lost messages is written to the log (and reported on
+  //  stderr at shutdown).
+  class LoggerStreamAsync : public LoggerOutputStream {
+  public:
+    LoggerStreamAsync(LoggerOutputStream *_stream, size_t _ring_size,
+		      bool _binary)
+      : stream(_stream), ring_size(_ring_size), binary(_binary)
+      , shutdown_requested(false), total_dropped(0)
+    {
+      pthread_mutex_init(&rings_mutex, 0);
+      pthread_mutex_init(&drain_mutex, 0);
+      pthread_mutex_init(&wake_mutex, 0);
+      pthread_cond_init(&wake_cond, 0);
+
+      if(binary) {
+	dl_iterate_phdr(add_readonly_ranges, &readonly_ranges);
+	stream->write(LOG_BINARY_MAGIC, sizeof(LOG_BINARY_MAGIC));
+	unsigned node = gasnet_mynode();
+	unsigned pad = 0;
+	stream->write((const char *)&node, sizeof(node));
+	stream->write((const char *)&pad, sizeof(pad));
+      }
+
+#ifndef NDEBUG
+      int ret =
+#endif
+	pthread_create(&writer_thread, 0, writer_entry, this);
+      assert(ret == 0);
+    }
+
+    virtual ~LoggerStreamAsync(void)
+    {
+      pthread_mutex_lock(&wake_mutex);
+      shutdown_requested = true;
+      pthread_cond_signal(&wake_cond);
+      pthread_mutex_unlock(&wake_mutex);
+      pthread_join(writer_thread, 0);
+
+      // one last pass for anything logged while we were shutting down
+      drain_all();
+      stream->flush();
+      if(total_dropped > 0)
+	fprintf(stderr, "WARNING: %zd log messages were dropped because the logging buffers were full (try a larger -logringsize)\n",
+		total_dropped);
+
+      for(std::vector<LoggerRing *>::iterator it = rings.begin();
+	  it != rings.end();
+	  it++)
+	delete *it;
+      delete stream;
+      pthread_cond_destroy(&wake_cond);
+      pthread_mutex_destroy(&wake_mutex);
+      pthread_mutex_destroy(&drain_mutex);
+      pthread_mutex_destroy(&rings_mutex);
+    }
+
+    virtual void write(const char *buffer, size_t len)
+    {
+      LoggerRing *ring = get_ring();
+      if(binary) {
+	char hdr[LOG_REC_HEADER_SIZE];
+	LogRecordBuilder rb(hdr, sizeof(hdr));
+	rb.add_header(LOG_REC_TEXT, len);
+	ring->append(hdr, rb.len, buffer, len);
+      } else
+	ring->append(buffer, len, 0, 0);
+    }
+
+    // writes everything buffered so far to the underlying stream
+    virtual void flush(void)
+    {
+      drain_all();
+      stream->flush();
+    }
+
+    virtual bool is_binary(void) const { return binary; }
+
+    virtual bool write_format(const Logger *logger, Logger::LoggingLevel level,
+			      const char *fmt, va_list args)
+    {
+      // the format is identified by its address, which is only safe if
+      //  the string can't change or go away (i.e. it's a literal)
+      if(!binary || !is_static_string(fmt))
+	return false;
+
+      static const size_t MAXLEN = 4096;
+      char record[MAXLEN];
+      LogRecordBuilder rb(record, MAXLEN);
+      const char *name = logger->get_name().c_str();
+      rb.add_header(LOG_REC_MESSAGE, 0);  // length filled in below
+      rb.add_value((unsigned long long)pthread_self());
+      rb.add_value((unsigned long long)(uintptr_t)name);
+      rb.add_value((unsigned long long)(uintptr_t)fmt);
+      rb.add_value((unsigned char)level);
+      if(!encode_format_args(fmt, args, rb))
+	return false;
+      unsigned payload = rb.len - LOG_REC_HEADER_SIZE;
+      memcpy(record + 1, &payload, sizeof(payload));
+
+      // each ring defines the strings it uses before their first use, so
+      //  the writer never has to look at them
+      LoggerRing *ring = get_ring();
+      if(!define_string(ring, name) || !define_string(ring, fmt))
+	return true;  // counted as dropped
+      ring->append(record, rb.len, 0, 0);
+      return true;
+    }
+
+  protected:
+    bool define_string(LoggerRing *ring, const char *str)
+    {
+      if(ring->strings_defined.count(str) > 0)
+	return true;
+      unsigned slen = strlen(str);
+      char hdr[LOG_REC_HEADER_SIZE + 8];
+      LogRecordBuilder rb(hdr, sizeof(hdr));
+      rb.add_header(LOG_REC_STRING, 8 + slen);
+      rb.add_value((unsigned long long)(uintptr_t)str);
+      if(!ring->append(hdr, rb.len, str, slen))
+	return false;
+      ring->strings_defined.insert(str);
+      return true;
+    }
+
+    // is 'p' in a read-only segment of the executable or a library that
+    //  was loaded when logging was configured?
+    bool is_static_string(const char *p) const
+    {
+      uintptr_t addr = (uintptr_t)p;
+      std::map<uintptr_t, uintptr_t>::const_iterator it = readonly_ranges.upper_bound(addr);
+      if(it == readonly_ranges.begin())
+	return false;
+      --it;
+      return (addr < it->second);
+    }
+
+    static int add_readonly_ranges(struct dl_phdr_info *info, size_t size, void *data)
+    {
+      std::map<uintptr_t, uintptr_t> *ranges = (std::map<uintptr_t, uintptr_t> *)data;
+      for(int i = 0; i < info->dlpi_phnum; i++) {
+	const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+	if((ph.p_type == PT_LOAD) && !(ph.p_flags & PF_W)) {
+	  uintptr_t start = info->dlpi_addr + ph.p_vaddr;
+	  (*ranges)[start] = start + ph.p_memsz;
+	}
+      }
+      return 0;
+    }
+
+    LoggerRing *get_ring(void)
+    {
+      LoggerRing *ring = thread_log_ring;
+      if(ring && (ring->stream == this))
+	return ring;
+      ring = new LoggerRing(this, ring_size);
+      pthread_mutex_lock(&rings_mutex);
+      rings.push_back(ring);
+      pthread_mutex_unlock(&rings_mutex);
+      thread_log_ring = ring;
+      return ring;
+    }
+
+    static void *writer_entry(void *data)
+    {
+      ((LoggerStreamAsync *)data)->writer_loop();
+      return 0;
+    }
+
+    void writer_loop(void)
+    {
+      pthread_mutex_lock(&wake_mutex);
+      while(!shutdown_requested) {
+	pthread_mutex_unlock(&wake_mutex);
+	bool any = drain_all();
+	pthread_mutex_lock(&wake_mutex);
+	// producers never signal (that would cost them a syscall), so poll
+	//  when there's nothing to do
+	if(!any && !shutdown_requested) {
+	  struct timespec ts;
+	  clock_gettime(CLOCK_REALTIME, &ts);
+	  ts.tv_nsec += 2000000;  // 2 ms
+	  if(ts.tv_nsec >= 1000000000) {
+	    ts.tv_sec++;
+	    ts.tv_nsec -= 1000000000;
+	  }
+	  pthread_cond_timedwait(&wake_cond, &wake_mutex, &ts);
+	}
+      }
+      pthread_mutex_unlock(&wake_mutex);
+    }
+
+    // returns true if anything was written
+    bool drain_all(void)
+    {
+      pthread_mutex_lock(&drain_mutex);
+
+      std::vector<LoggerRing *> to_drain;
+      pthread_mutex_lock(&rings_mutex);
+      to_drain = rings;
+      pthread_mutex_unlock(&rings_mutex);
+
+      bool any = false;
+      for(std::vector<LoggerRing *>::iterator it = to_drain.begin();
+	  it != to_drain.end();
+	  it++) {
+	LoggerRing *ring = *it;
+	buffer.clear();
+	ring->drain(buffer);
+	if(!buffer.empty()) {
+	  any = true;
+	  stream->write(&buffer[0], buffer.size());
+	}
+	size_t dropped = ring->dropped;
+	if(dropped != ring->dropped_reported) {
+	  report_dropped(ring, dropped - ring->dropped_reported);
+	  total_dropped += dropped - ring->dropped_reported;
+	  ring->dropped_reported = dropped;
+	  any = true;
+	}
+      }
+
+      pthread_mutex_unlock(&drain_mutex);
+      return any;
+    }
+
+    void report_dropped(LoggerRing *ring, size_t count)
+    {
+      if(binary) {
+	char record[LOG_REC_HEADER_SIZE + 16];
+	LogRecordBuilder rb(record, sizeof(record));
+	rb.add_header(LOG_REC_DROPPED, 16);
+	rb.add_value((unsigned long long)(ring->thread));
+	rb.add_value((unsigned long long)count);
+	stream->write(record, rb.len);
+      } else {
+	char msg[128];
+	int len = snprintf(msg, sizeof(msg), "[%d - %lx] {%d}{logging}: %zd messages dropped\n",
+			   gasnet_mynode(), ring->thread, Logger::LEVEL_WARNING, count);
+	stream->write(msg, len);
+      }
+    }
+
+    LoggerOutputStream *stream;
+    size_t ring_size;
+    bool binary;
+    pthread_t writer_thread;
+    pthread_mutex_t rings_mutex, drain_mutex, wake_mutex;
+    pthread_cond_t wake_cond;
+    bool shutdown_requested;
+    std::vector<LoggerRing *> rings;
+    // the rest is protected by drain_mutex
+    std::vector<char> buffer;
+    size_t total_dropped;
+    std::map<uintptr_t, uintptr_t> readonly_ranges;
+  };
+
   class LoggerConfig {
   protected:
     LoggerConfig(void);
@@ -161,6 +673,8 @@ namespace Realm {
     bool parse_level_argument(const std::string& s);
 
     bool cmdline_read;
+    bool async_logging, binary_logging;
+    size_t ring_size_kb;
     Logger::LoggingLevel default_level, stderr_level;
     std::map<std::string, Logger::LoggingLevel> category_levels;
     std::string cats_enabled;
@@ -170,6 +684,9 @@ namespace Realm {
 
   LoggerConfig::LoggerConfig(void)
     : cmdline_read(false)
+    , async_logging(false)
+    , binary_logging(false)
+    , ring_size_kb(256)
     , default_level(Logger::LEVEL_PRINT)
     , stderr_level(Logger::LEVEL_ERROR)
     , stream(0)
@@ -299,6 +816,9 @@ namespace Realm {
       .add_option_string("-logfile", logname)
       .add_option_method("-level", this, &LoggerConfig::parse_level_argument)
       .add_option_int("-errlevel", stderr_level)
+      .add_option_bool("-logasync", async_logging)
+      .add_option_bool("-logbinary", binary_logging)
+      .add_option_int("-logringsize", ring_size_kb)
       .parse_command_line(cmdline);
 
     if(!ok) {
@@ -306,8 +826,29 @@ namespace Realm {
       exit(1);
     }
 
+    // the binary format only makes sense in a file
+    if(binary_logging) {
+      if(logname.empty() || (logname == "stdout") || (logname == "stderr")) {
+	fprintf(stderr, "WARNING: -logbinary requires -logfile - using text logging\n");
+	binary_logging = false;
+      } else
+	async_logging = true;
+    }
+    if(async_logging) {
+      // round up to a power of two
+      size_t ring_size = 4096;
+      while(ring_size < (ring_size_kb << 10))
+	ring_size <<= 1;
+      ring_size_kb = ring_size >> 10;
+    }
+
     // lots of choices for log output
-    if(logname.empty() || (logname == "stdout")) {
+    if(async_logging && (logname.empty() || (logname == "stdout") ||
+			 (logname == "stderr"))) {
+      stream = new LoggerStreamAsync(new LoggerFileStream((logname == "stderr") ? stderr : stdout,
+							  false),
+				     ring_size_kb << 10, false);
+    } else if(logname.empty() || (logname == "stdout")) {
       stream = new LoggerStreamSerialized<LoggerFileStream>(new LoggerFileStream(stdout, false),
 							    true);
     } else if(logname == "stderr") {
@@ -353,10 +894,16 @@ namespace Realm {
 	  exit(1);
 	}
       }
-      // TODO: consider buffering in some cases?
-      setbuf(f, 0); // disable output buffering
-      stream = new LoggerStreamSerialized<LoggerFileStream>(new LoggerFileStream(f, true),
-							    true);
+      if(async_logging) {
+	// only the writer thread touches the file, and it writes big chunks
+	stream = new LoggerStreamAsync(new LoggerFileStream(f, true),
+				       ring_size_kb << 10, binary_logging);
+      } else {
+	// TODO: consider buffering in some cases?
+	setbuf(f, 0); // disable output buffering
+	stream = new LoggerStreamSerialized<LoggerFileStream>(new LoggerFileStream(f, true),
+							      true);
+      }
 
       // when logging to a file, also sent critical-enough messages to stderr
       if(stderr_level < Logger::LEVEL_NONE)
@@ -430,7 +977,7 @@ namespace Realm {
   // class Logger
 
   Logger::Logger(const std::string& _name)
-    : name(_name), log_level(LEVEL_NONE)
+    : name(_name), log_level(LEVEL_NONE), has_binary_streams(false)
   {
     LoggerConfig::get_config()->configure(this);
   }
@@ -452,7 +999,63 @@ namespace Realm {
     LoggerConfig::get_config()->read_command_line(cmdline);
   }
 
-  void Logger::log_msg(LoggingLevel level, const std::string& msg)
+  void Logger::log_vprintf(LoggingLevel level, const char *fmt, va_list args)
+  {
+    if(!has_binary_streams) {
+      newmsg(level).vprintf(fmt, args);
+      return;
+    }
+
+    // the binary path only pays off if some binary stream takes this
+    //  level - a text stream (e.g. stderr) may well be noisier than the
+    //  binary file, in which case just format the text as usual
+    bool binary_wanted = false;
+    for(std::vector<LogStream>::const_iterator it = streams.begin();
+	it != streams.end();
+	it++)
+      if(it->s->is_binary() && (level >= it->min_level)) {
+	binary_wanted = true;
+	break;
+      }
+    if(!binary_wanted) {
+      newmsg(level).vprintf(fmt, args);
+      return;
+    }
+
+    // offer the unformatted message to the binary streams first
+    bool text_needed = false;
+    for(std::vector<LogStream>::iterator it = streams.begin();
+	it != streams.end();
+	it++) {
+      if(level < it->min_level)
+	continue;
+
+      if(it->s->is_binary()) {
+	va_list args_copy;
+	va_copy(args_copy, args);
+	bool ok = it->s->write_format(this, level, fmt, args_copy);
+	va_end(args_copy);
+	if(!ok) {
+	  // every stream gets the formatted text instead
+	  newmsg(level).vprintf(fmt, args);
+	  return;
+	}
+	if((level >= LEVEL_ERROR) || it->flush_each_write)
+	  it->s->flush();
+      } else
+	text_needed = true;
+    }
+
+    if(text_needed) {
+      static const int MAXLEN = 4096;
+      char msg[MAXLEN];
+      vsnprintf(msg, MAXLEN, fmt, args);
+      log_msg(level, msg, true /*skip_binary_streams*/);
+    }
+  }
+
+  void Logger::log_msg(LoggingLevel level, const std::string& msg,
+		       bool skip_binary_streams)
   {
     // no logging of empty messages
     if(msg.length() == 0)
@@ -485,10 +1088,14 @@ namespace Realm {
             it++) {
           if(level < it->min_level)
             continue;
+          if(skip_binary_streams && it->s->is_binary())
+            continue;
 
           it->s->write(full_buffer, full_len);
 
-          if(it->flush_each_write)
+          // always flush errors so asynchronous streams don't lose them if
+          //  we're about to abort
+          if(it->flush_each_write || (level >= LEVEL_ERROR))
             it->s->flush();
         }
         free(full_buffer);
@@ -507,10 +1114,14 @@ namespace Realm {
 	it++) {
       if(level < it->min_level)
 	continue;
+      if(skip_binary_streams && it->s->is_binary())
+	continue;
 
       it->s->write(buffer, len);
 
-      if(it->flush_each_write)
+      // always flush errors so asynchronous streams don't lose them if
+      //  we're about to abort
+      if(it->flush_each_write || (level >= LEVEL_ERROR))
 	it->s->flush();
     }
   }
@@ -525,6 +1136,9 @@ namespace Realm {
     ls.flush_each_write = flush_each_write;
     streams.push_back(ls);
 
+    if(s->is_binary())
+      has_binary_streams = true;
+
     // update our logging level if needed
     if(log_level > min_level)
       log_level = min_level;
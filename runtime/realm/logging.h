@@ -105,7 +105,12 @@ namespace Realm {
   protected:
     friend class LoggerMessage;
     
-    void log_msg(LoggingLevel level, const std::string& msg);
+    void log_msg(LoggingLevel level, const std::string& msg,
+		 bool skip_binary_streams = false);
+
+    // printf-style messages go through here so that binary streams can
+    //  record the format and arguments without formatting them
+    void log_vprintf(LoggingLevel level, const char *fmt, va_list args);
     
     friend class LoggerConfig;
     
@@ -122,6 +127,7 @@ namespace Realm {
     std::string name;
     std::vector<LogStream> streams;
     LoggingLevel log_level;  // the min level of any stream
+    bool has_binary_streams;
   };
   
   class LoggerMessage {
@@ -192,7 +192,7 @@ namespace Realm {
     
     va_list args;
     va_start(args, fmt);
-    spew().vprintf(fmt, args);
+    log_vprintf(LEVEL_SPEW, fmt, args);
     va_end(args);
   }
     
@@ -219,7 +219,7 @@ namespace Realm {
     
     va_list args;
     va_start(args, fmt);
-    debug().vprintf(fmt, args);
+    log_vprintf(LEVEL_DEBUG, fmt, args);
     va_end(args);
   }
   
@@ -244,7 +244,7 @@ namespace Realm {
     
     va_list args;
     va_start(args, fmt);
-    info().vprintf(fmt, args);
+    log_vprintf(LEVEL_INFO, fmt, args);
     va_end(args);
   }
   
@@ -269,7 +269,7 @@ namespace Realm {
     
     va_list args;
     va_start(args, fmt);
-    print().vprintf(fmt, args);
+    log_vprintf(LEVEL_PRINT, fmt, args);
     va_end(args);
   }
   
@@ -294,7 +294,7 @@ namespace Realm {
     
     va_list args;
     va_start(args, fmt);
-    warning().vprintf(fmt, args);
+    log_vprintf(LEVEL_WARNING, fmt, args);
     va_end(args);
   }
   
@@ -319,7 +319,7 @@ namespace Realm {
     
     va_list args;
     va_start(args, fmt);
-    error().vprintf(fmt, args);
+    log_vprintf(LEVEL_ERROR, fmt, args);
     va_end(args);
   }
   
@@ -344,7 +344,7 @@ namespace Realm {
     
     va_list args;
     va_start(args, fmt);
-    fatal().vprintf(fmt, args);
+    log_vprintf(LEVEL_FATAL, fmt, args);
     va_end(args);
   }
   
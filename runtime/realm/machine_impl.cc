@@ -22,6 +22,8 @@
 
 #include "activemsg.h"
 
+#include <algorithm>
+
 namespace Realm {
 
   Logger log_machine("machine");
@@ -354,6 +356,7 @@ namespace Realm {
     MachineImpl *machine_singleton = 0;
 
   MachineImpl::MachineImpl(void)
+    : generation(0)
   {
     assert(machine_singleton == 0);
     machine_singleton = this;
@@ -561,6 +564,9 @@ namespace Realm {
 	  assert(0);
 	}
       }
+
+      // new processors/memories may have been added even if no affinities were
+      bump_generation();
     }
 
     void MachineImpl::get_all_memories(std::set<Memory>& mset) const
@@ -996,6 +1002,7 @@ namespace Realm {
     if(!lock_held) mutex.lock();
 
     proc_mem_affinities.push_back(pma);
+    bump_generation();
 
     int np = ID(pma.p).proc.owner_node;
     int mp = ID(pma.m).memory.owner_node;
@@ -1023,6 +1030,7 @@ namespace Realm {
     if(!lock_held) mutex.lock();
 
     mem_mem_affinities.push_back(mma);
+    bump_generation();
 
     int m1p = ID(mma.m1).memory.owner_node;
     int m2p = ID(mma.m2).memory.owner_node;
@@ -1044,6 +1052,11 @@ namespace Realm {
     if(!lock_held) mutex.unlock();
   }
 
+  void MachineImpl::bump_generation(void)
+  {
+    __sync_fetch_and_add(&generation, 1);
+  }
+
     void MachineImpl::add_subscription(Machine::MachineUpdateSubscriber *subscriber)
     {
       AutoHSLLock al(mutex);
@@ -1356,6 +1369,141 @@ namespace Realm {
   }
 
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class QueryMatchCache<T>
+  //
+
+  template <typename T>
+  QueryMatchCache<T>::QueryMatchCache(T _no_match)
+    : no_match(_no_match)
+    , valid(false)
+    , generation(0)
+    , scanned_through(_no_match)
+    , complete(false)
+    , last_pos(0)
+  {}
+
+  template <typename T>
+  bool QueryMatchCache<T>::covers(unsigned machine_generation, T after,
+				  bool need_all, T& resume) const
+  {
+    if(!valid || (generation != machine_generation)) {
+      // start over
+      resume = no_match;
+      return false;
+    }
+    if(complete)
+      return true;
+    if(!need_all && !matches.empty() &&
+       ((after == no_match) || (after < matches.back())))
+      return true;
+    // pick up where the last scan stopped
+    resume = scanned_through;
+    return false;
+  }
+
+  template <typename T>
+  bool QueryMatchCache<T>::first(unsigned machine_generation,
+				 T& result, T& resume) const
+  {
+    AutoHSLLock al(mutex);
+    if(!covers(machine_generation, no_match, false /*!need_all*/, resume))
+      return false;
+    if(matches.empty()) {
+      result = no_match;
+    } else {
+      last_pos = 0;
+      result = matches[0];
+    }
+    return true;
+  }
+
+  template <typename T>
+  bool QueryMatchCache<T>::next(unsigned machine_generation, T after,
+				T& result, T& resume) const
+  {
+    AutoHSLLock al(mutex);
+    if(!covers(machine_generation, after, false /*!need_all*/, resume))
+      return false;
+    size_t pos;
+    // the common case is walking the matches in order
+    if((last_pos < matches.size()) && (matches[last_pos] == after))
+      pos = last_pos + 1;
+    else
+      pos = (std::upper_bound(matches.begin(), matches.end(), after) -
+	     matches.begin());
+    if(pos >= matches.size()) {
+      result = no_match;
+    } else {
+      last_pos = pos;
+      result = matches[pos];
+    }
+    return true;
+  }
+
+  template <typename T>
+  bool QueryMatchCache<T>::count(unsigned machine_generation,
+				 size_t& result, T& resume) const
+  {
+    AutoHSLLock al(mutex);
+    if(!covers(machine_generation, no_match, true /*need_all*/, resume))
+      return false;
+    result = matches.size();
+    return true;
+  }
+
+  template <typename T>
+  bool QueryMatchCache<T>::random(unsigned machine_generation,
+				  T& result, T& resume) const
+  {
+    AutoHSLLock al(mutex);
+    if(!covers(machine_generation, no_match, true /*need_all*/, resume))
+      return false;
+    if(matches.empty())
+      result = no_match;
+    else
+      result = matches[lrand48() % matches.size()];
+    return true;
+  }
+
+  template <typename T>
+  void QueryMatchCache<T>::extend(unsigned machine_generation, T resume,
+				  std::vector<T>& new_matches,
+				  T new_scanned_through, bool new_complete)
+  {
+    AutoHSLLock al(mutex);
+    if(resume == no_match) {
+      // a scan from the start replaces whatever we had
+      matches.swap(new_matches);
+      generation = machine_generation;
+      valid = true;
+      last_pos = 0;
+    } else {
+      // two threads may race to extend the cache (or the machine may have
+      //  changed underneath the scan) - only a scan that continues exactly
+      //  where the cache left off can be added, and the loser just retries
+      if(!valid || (generation != machine_generation) ||
+	 complete || !(scanned_through == resume))
+	return;
+      matches.insert(matches.end(), new_matches.begin(), new_matches.end());
+    }
+    scanned_through = new_scanned_through;
+    complete = new_complete;
+  }
+
+  template <typename T>
+  void QueryMatchCache<T>::invalidate(void)
+  {
+    AutoHSLLock al(mutex);
+    valid = false;
+    matches.clear();
+    scanned_through = no_match;
+    complete = false;
+    last_pos = 0;
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class ProcessorQueryImpl
@@ -1366,6 +1514,7 @@ namespace Realm {
     , machine((MachineImpl *)_machine.impl)
     , is_restricted_node(false)
     , is_restricted_kind(false)
+    , cache(Processor::NO_PROC)
   {}
      
   ProcessorQueryImpl::ProcessorQueryImpl(const ProcessorQueryImpl& copy_from)
@@ -1375,6 +1524,7 @@ namespace Realm {
     , restricted_node_id(copy_from.restricted_node_id)
     , is_restricted_kind(copy_from.is_restricted_kind)
     , restricted_kind(copy_from.restricted_kind)
+    , cache(Processor::NO_PROC)
   {
     predicates.reserve(copy_from.predicates.size());
     for(std::vector<ProcQueryPredicate *>::const_iterator it = copy_from.predicates.begin();
@@ -1419,6 +1569,7 @@ namespace Realm {
 
   void ProcessorQueryImpl::restrict_to_node(int new_node_id)
   {
+    cache.invalidate();
     // attempts to restrict to two different nodes results in no possible match
     if(is_restricted_node && (new_node_id != restricted_node_id)) {
       restricted_node_id = -1;
@@ -1430,6 +1581,7 @@ namespace Realm {
 
   void ProcessorQueryImpl::restrict_to_kind(Processor::Kind new_kind)
   {
+    cache.invalidate();
     // attempts to restrict to two different kind results in no possible match
     // (use node restriction to enforce this)
     if(is_restricted_kind && (new_kind != restricted_kind)) {
@@ -1445,37 +1597,17 @@ namespace Realm {
   {
     // a writer is always unique, so no need for mutexes
     predicates.push_back(pred);
+    cache.invalidate();
   }
 
-  Processor ProcessorQueryImpl::first_match(void) const
+  bool ProcessorQueryImpl::scan_matches(Processor resume, Processor stop_after, bool to_end,
+				      std::vector<Processor>& matches,
+				      Processor& scanned_through) const
   {
-#ifdef USE_OLD_AFFINITIES
-    if(is_restricted_node && (restricted_node_id < 0)) return Processor::NO_PROC;
-    Processor lowest = Processor::NO_PROC;
-    {
-      // problem with nested locks here...
-      //AutoHSLLock al(machine->mutex);
-      for(std::vector<Machine::ProcessorMemoryAffinity>::const_iterator it = machine->proc_mem_affinities.begin();
-	  it != machine->proc_mem_affinities.end();
-	  it++) {
-	Processor p =(*it).p;
-	if(is_restricted_node && (ID(p).proc.owner_node != (unsigned)restricted_node_id))
-	  continue;
-	if(is_restricted_kind && (p.kind() != restricted_kind))
-	  continue;
-	bool ok = true;
-	for(std::vector<ProcQueryPredicate *>::const_iterator it2 = predicates.begin();
-	    ok && (it2 != predicates.end());
-	    it2++)
-	  ok &= (*it2)->matches_predicate(machine, p);
-	if(ok && (!lowest.exists() || (p.id < lowest.id)))
-	  lowest = p;
-      }
-    }
-    return lowest;
-#else
     std::map<int, MachineNodeInfo *>::const_iterator it;
-    if(is_restricted_node)
+    if(resume.exists())
+      it = machine->nodeinfos.find(ID(resume).proc.owner_node);
+    else if(is_restricted_node)
       it = machine->nodeinfos.lower_bound(restricted_node_id);
     else
       it = machine->nodeinfos.begin();
@@ -1494,25 +1626,85 @@ namespace Realm {
 	plist = &(it->second->procs);
 
       if(plist) {
-	std::map<Processor, MachineProcInfo *>::const_iterator it2 = plist->begin();
+        std::map<Processor, MachineProcInfo *>::const_iterator it2;
+	// same node?  if so, skip past ones we've done
+	if(resume.exists() && (it->first == (int)ID(resume).proc.owner_node))
+	  it2 = plist->upper_bound(resume);
+	else
+	  it2 = plist->begin();
 	while(it2 != plist->end()) {
 	  bool ok = true;
 	  for(std::vector<ProcQueryPredicate *>::const_iterator it3 = predicates.begin();
 	      ok && (it3 != predicates.end());
 	      it3++)
 	    ok = (*it3)->matches_predicate(machine, it2->first, it2->second);
-	  if(ok)
-	    return it2->first;
+	  scanned_through = it2->first;
+	  if(ok) {
+	    matches.push_back(it2->first);
+	    // stop as soon as we have what the caller asked for
+	    if(!to_end && (!stop_after.exists() || (stop_after < it2->first)))
+	      return false;
+	  }
 
-	  // try next processor (if it exists)
+	  // continue to next processor (if it exists)
 	  ++it2;
 	}
       }
 
-      // try the next node (if it exists)
+      // continue to the next node (if it exists)
       ++it;
     }
-    return Processor::NO_PROC;
+    return true;
+  }
+
+  void ProcessorQueryImpl::extend_cache(unsigned gen, Processor resume, Processor stop_after,
+				      bool to_end) const
+  {
+    // predicates may take the machine's mutex, so the scan can't happen
+    //  while holding the cache's lock
+    std::vector<Processor> matches;
+    Processor scanned_through = resume;
+    bool complete = scan_matches(resume, stop_after, to_end,
+				 matches, scanned_through);
+    cache.extend(gen, resume, matches, scanned_through, complete);
+  }
+
+  Processor ProcessorQueryImpl::first_match(void) const
+  {
+#ifdef USE_OLD_AFFINITIES
+    if(is_restricted_node && (restricted_node_id < 0)) return Processor::NO_PROC;
+    Processor lowest = Processor::NO_PROC;
+    {
+      // problem with nested locks here...
+      //AutoHSLLock al(machine->mutex);
+      for(std::vector<Machine::ProcessorMemoryAffinity>::const_iterator it = machine->proc_mem_affinities.begin();
+	  it != machine->proc_mem_affinities.end();
+	  it++) {
+	Processor p =(*it).p;
+	if(is_restricted_node && (ID(p).proc.owner_node != (unsigned)restricted_node_id))
+	  continue;
+	if(is_restricted_kind && (p.kind() != restricted_kind))
+	  continue;
+	bool ok = true;
+	for(std::vector<ProcQueryPredicate *>::const_iterator it2 = predicates.begin();
+	    ok && (it2 != predicates.end());
+	    it2++)
+	  ok &= (*it2)->matches_predicate(machine, p);
+	if(ok && (!lowest.exists() || (p.id < lowest.id)))
+	  lowest = p;
+      }
+    }
+    return lowest;
+#else
+    // sample the generation before looking so that an update that races
+    //  with a scan leaves the cache stale rather than wrongly current
+    while(true) {
+      unsigned gen = machine->get_generation();
+      Processor result, resume;
+      if(cache.first(gen, result, resume))
+	return result;
+      extend_cache(gen, resume, Processor::NO_PROC, false /*!to_end*/);
+    }
 #endif
   }
 
@@ -1545,48 +1737,13 @@ namespace Realm {
     }
     return lowest;
 #else
-    std::map<int, MachineNodeInfo *>::const_iterator it;
-    // start where we left off
-    it = machine->nodeinfos.find(ID(after).proc.owner_node);
-    while(it != machine->nodeinfos.end()) {
-      if(is_restricted_node && (it->first != restricted_node_id))
-	break;
-
-      const std::map<Processor, MachineProcInfo *> *plist;
-      if(is_restricted_kind) {
-	std::map<Processor::Kind, std::map<Processor, MachineProcInfo *> >::const_iterator it2 = it->second->proc_by_kind.find(restricted_kind);
-	if(it2 != it->second->proc_by_kind.end())
-	  plist = &(it2->second);
-	else
-	  plist = 0;
-      } else
-	plist = &(it->second->procs);
-
-      if(plist) {
-        std::map<Processor, MachineProcInfo *>::const_iterator it2;
-	// same node?  if so, skip past ones we've done
-	if(it->first == ID(after).proc.owner_node)
-	  it2 = plist->upper_bound(after);
-	else
-	  it2 = plist->begin();
-	while(it2 != plist->end()) {
-	  bool ok = true;
-	  for(std::vector<ProcQueryPredicate *>::const_iterator it3 = predicates.begin();
-	      ok && (it3 != predicates.end());
-	      it3++)
-	    ok = (*it3)->matches_predicate(machine, it2->first, it2->second);
-	  if(ok)
-	    return it2->first;
-
-	  // try next processor (if it exists)
-	  ++it2;
-	}
-      }
-
-      // try the next node (if it exists)
-      ++it;
+    while(true) {
+      unsigned gen = machine->get_generation();
+      Processor result, resume;
+      if(cache.next(gen, after, result, resume))
+	return result;
+      extend_cache(gen, resume, after, false /*!to_end*/);
     }
-    return Processor::NO_PROC;
 #endif
   }
 
@@ -1617,46 +1774,14 @@ namespace Realm {
     }
     return pset.size();
 #else
-    size_t count = 0;
-    std::map<int, MachineNodeInfo *>::const_iterator it;
-    if(is_restricted_node)
-      it = machine->nodeinfos.lower_bound(restricted_node_id);
-    else
-      it = machine->nodeinfos.begin();
-    while(it != machine->nodeinfos.end()) {
-      if(is_restricted_node && (it->first != restricted_node_id))
-	break;
-
-      const std::map<Processor, MachineProcInfo *> *plist;
-      if(is_restricted_kind) {
-	std::map<Processor::Kind, std::map<Processor, MachineProcInfo *> >::const_iterator it2 = it->second->proc_by_kind.find(restricted_kind);
-	if(it2 != it->second->proc_by_kind.end())
-	  plist = &(it2->second);
-	else
-	  plist = 0;
-      } else
-	plist = &(it->second->procs);
-
-      if(plist) {
-	std::map<Processor, MachineProcInfo *>::const_iterator it2 = plist->begin();
-	while(it2 != plist->end()) {
-	  bool ok = true;
-	  for(std::vector<ProcQueryPredicate *>::const_iterator it3 = predicates.begin();
-	      ok && (it3 != predicates.end());
-	      it3++)
-	    ok = (*it3)->matches_predicate(machine, it2->first, it2->second);
-	  if(ok)
-	    count += 1;
-
-	  // continue to next processor (if it exists)
-	  ++it2;
-	}
-      }
-
-      // continue to the next node (if it exists)
-      ++it;
+    while(true) {
+      unsigned gen = machine->get_generation();
+      size_t result;
+      Processor resume;
+      if(cache.count(gen, result, resume))
+	return result;
+      extend_cache(gen, resume, Processor::NO_PROC, true /*to_end*/);
     }
-    return count;
 #endif
   }
 
@@ -1690,47 +1815,12 @@ namespace Realm {
       }
     }
 #else
-    size_t count = 0;
-    std::map<int, MachineNodeInfo *>::const_iterator it;
-    if(is_restricted_node)
-      it = machine->nodeinfos.lower_bound(restricted_node_id);
-    else
-      it = machine->nodeinfos.begin();
-    while(it != machine->nodeinfos.end()) {
-      if(is_restricted_node && (it->first != restricted_node_id))
+    while(true) {
+      unsigned gen = machine->get_generation();
+      Processor resume;
+      if(cache.random(gen, chosen, resume))
 	break;
-
-      const std::map<Processor, MachineProcInfo *> *plist;
-      if(is_restricted_kind) {
-	std::map<Processor::Kind, std::map<Processor, MachineProcInfo *> >::const_iterator it2 = it->second->proc_by_kind.find(restricted_kind);
-	if(it2 != it->second->proc_by_kind.end())
-	  plist = &(it2->second);
-	else
-	  plist = 0;
-      } else
-	plist = &(it->second->procs);
-
-      if(plist) {
-	std::map<Processor, MachineProcInfo *>::const_iterator it2 = plist->begin();
-	while(it2 != plist->end()) {
-	  bool ok = true;
-	  for(std::vector<ProcQueryPredicate *>::const_iterator it3 = predicates.begin();
-	      ok && (it3 != predicates.end());
-	      it3++)
-	    ok = (*it3)->matches_predicate(machine, it2->first, it2->second);
-	  if(ok) {
-	    count++;
-	    if((count == 1) || ((lrand48() % count) == 0))
-	      chosen = it2->first;
-	  }
-
-	  // continue to next processor (if it exists)
-	  ++it2;
-	}
-      }
-
-      // continue to the next node (if it exists)
-      ++it;
+      extend_cache(gen, resume, Processor::NO_PROC, true /*to_end*/);
     }
 #endif
     return chosen;
@@ -1917,6 +2007,7 @@ namespace Realm {
     , machine((MachineImpl *)_machine.impl)
     , is_restricted_node(false)
     , is_restricted_kind(false)
+    , cache(Memory::NO_MEMORY)
   {}
      
   MemoryQueryImpl::MemoryQueryImpl(const MemoryQueryImpl& copy_from)
@@ -1926,6 +2017,7 @@ namespace Realm {
     , restricted_node_id(copy_from.restricted_node_id)
     , is_restricted_kind(copy_from.is_restricted_kind)
     , restricted_kind(copy_from.restricted_kind)
+    , cache(Memory::NO_MEMORY)
   {
     predicates.reserve(copy_from.predicates.size());
     for(std::vector<MemoryQueryPredicate *>::const_iterator it = copy_from.predicates.begin();
@@ -1970,6 +2062,7 @@ namespace Realm {
 
   void MemoryQueryImpl::restrict_to_node(int new_node_id)
   {
+    cache.invalidate();
     // attempts to restrict to two different nodes results in no possible match
     if(is_restricted_node && (new_node_id != restricted_node_id)) {
       restricted_node_id = -1;
@@ -1981,6 +2074,7 @@ namespace Realm {
 
   void MemoryQueryImpl::restrict_to_kind(Memory::Kind new_kind)
   {
+    cache.invalidate();
     // attempts to restrict to two different kind results in no possible match
     // (use node restriction to enforce this)
     if(is_restricted_kind && (new_kind != restricted_kind)) {
@@ -1996,37 +2090,17 @@ namespace Realm {
   {
     // a writer is always unique, so no need for mutexes
     predicates.push_back(pred);
+    cache.invalidate();
   }
 
-  Memory MemoryQueryImpl::first_match(void) const
+  bool MemoryQueryImpl::scan_matches(Memory resume, Memory stop_after, bool to_end,
+				      std::vector<Memory>& matches,
+				      Memory& scanned_through) const
   {
-#if USE_OLD_AFFINITIES
-    if(is_restricted_node && (restricted_node_id < 0)) return Memory::NO_MEMORY;
-    Memory lowest = Memory::NO_MEMORY;
-    {
-      // problem with nested locks here...
-      //AutoHSLLock al(machine->mutex);
-      for(std::vector<Machine::ProcessorMemoryAffinity>::const_iterator it = machine->proc_mem_affinities.begin();
-	  it != machine->proc_mem_affinities.end();
-	  it++) {
-	Memory m =(*it).m;
-	if(is_restricted_node && (ID(m).memory.owner_node != (unsigned)restricted_node_id))
-	  continue;
-	if(is_restricted_kind && (m.kind() != restricted_kind))
-	  continue;
-	bool ok = true;
-	for(std::vector<MemoryQueryPredicate *>::const_iterator it2 = predicates.begin();
-	    ok && (it2 != predicates.end());
-	    it2++)
-	  ok &= (*it2)->matches_predicate(machine, m);
-	if(ok && (!lowest.exists() || (m.id < lowest.id)))
-	  lowest = m;
-      }
-    }
-    return lowest;
-#else
     std::map<int, MachineNodeInfo *>::const_iterator it;
-    if(is_restricted_node)
+    if(resume.exists())
+      it = machine->nodeinfos.find(ID(resume).memory.owner_node);
+    else if(is_restricted_node)
       it = machine->nodeinfos.lower_bound(restricted_node_id);
     else
       it = machine->nodeinfos.begin();
@@ -2045,25 +2119,85 @@ namespace Realm {
 	plist = &(it->second->mems);
 
       if(plist) {
-	std::map<Memory, MachineMemInfo *>::const_iterator it2 = plist->begin();
+        std::map<Memory, MachineMemInfo *>::const_iterator it2;
+	// same node?  if so, skip past ones we've done
+	if(resume.exists() && (it->first == (int)ID(resume).memory.owner_node))
+	  it2 = plist->upper_bound(resume);
+	else
+	  it2 = plist->begin();
 	while(it2 != plist->end()) {
 	  bool ok = true;
 	  for(std::vector<MemoryQueryPredicate *>::const_iterator it3 = predicates.begin();
 	      ok && (it3 != predicates.end());
 	      it3++)
 	    ok = (*it3)->matches_predicate(machine, it2->first, it2->second);
-	  if(ok)
-	    return it2->first;
+	  scanned_through = it2->first;
+	  if(ok) {
+	    matches.push_back(it2->first);
+	    // stop as soon as we have what the caller asked for
+	    if(!to_end && (!stop_after.exists() || (stop_after < it2->first)))
+	      return false;
+	  }
 
-	  // try next memory (if it exists)
+	  // continue to next memory (if it exists)
 	  ++it2;
 	}
       }
 
-      // try the next node (if it exists)
+      // continue to the next node (if it exists)
       ++it;
     }
-    return Memory::NO_MEMORY;
+    return true;
+  }
+
+  void MemoryQueryImpl::extend_cache(unsigned gen, Memory resume, Memory stop_after,
+				      bool to_end) const
+  {
+    // predicates may take the machine's mutex, so the scan can't happen
+    //  while holding the cache's lock
+    std::vector<Memory> matches;
+    Memory scanned_through = resume;
+    bool complete = scan_matches(resume, stop_after, to_end,
+				 matches, scanned_through);
+    cache.extend(gen, resume, matches, scanned_through, complete);
+  }
+
+  Memory MemoryQueryImpl::first_match(void) const
+  {
+#if USE_OLD_AFFINITIES
+    if(is_restricted_node && (restricted_node_id < 0)) return Memory::NO_MEMORY;
+    Memory lowest = Memory::NO_MEMORY;
+    {
+      // problem with nested locks here...
+      //AutoHSLLock al(machine->mutex);
+      for(std::vector<Machine::ProcessorMemoryAffinity>::const_iterator it = machine->proc_mem_affinities.begin();
+	  it != machine->proc_mem_affinities.end();
+	  it++) {
+	Memory m =(*it).m;
+	if(is_restricted_node && (ID(m).memory.owner_node != (unsigned)restricted_node_id))
+	  continue;
+	if(is_restricted_kind && (m.kind() != restricted_kind))
+	  continue;
+	bool ok = true;
+	for(std::vector<MemoryQueryPredicate *>::const_iterator it2 = predicates.begin();
+	    ok && (it2 != predicates.end());
+	    it2++)
+	  ok &= (*it2)->matches_predicate(machine, m);
+	if(ok && (!lowest.exists() || (m.id < lowest.id)))
+	  lowest = m;
+      }
+    }
+    return lowest;
+#else
+    // sample the generation before looking so that an update that races
+    //  with a scan leaves the cache stale rather than wrongly current
+    while(true) {
+      unsigned gen = machine->get_generation();
+      Memory result, resume;
+      if(cache.first(gen, result, resume))
+	return result;
+      extend_cache(gen, resume, Memory::NO_MEMORY, false /*!to_end*/);
+    }
 #endif
   }
 
@@ -2096,48 +2230,13 @@ namespace Realm {
     }
     return lowest;
 #else
-    std::map<int, MachineNodeInfo *>::const_iterator it;
-    // start where we left off
-    it = machine->nodeinfos.find(ID(after).memory.owner_node);
-    while(it != machine->nodeinfos.end()) {
-      if(is_restricted_node && (it->first != restricted_node_id))
-	break;
-
-      const std::map<Memory, MachineMemInfo *> *plist;
-      if(is_restricted_kind) {
-	std::map<Memory::Kind, std::map<Memory, MachineMemInfo *> >::const_iterator it2 = it->second->mem_by_kind.find(restricted_kind);
-	if(it2 != it->second->mem_by_kind.end())
-	  plist = &(it2->second);
-	else
-	  plist = 0;
-      } else
-	plist = &(it->second->mems);
-
-      if(plist) {
-        std::map<Memory, MachineMemInfo *>::const_iterator it2;
-	// same node?  if so, skip past ones we've done
-	if(it->first == ID(after).memory.owner_node)
-	  it2 = plist->upper_bound(after);
-	else
-	  it2 = plist->begin();
-	while(it2 != plist->end()) {
-	  bool ok = true;
-	  for(std::vector<MemoryQueryPredicate *>::const_iterator it3 = predicates.begin();
-	      ok && (it3 != predicates.end());
-	      it3++)
-	    ok = (*it3)->matches_predicate(machine, it2->first, it2->second);
-	  if(ok)
-	    return it2->first;
-
-	  // try next memory (if it exists)
-	  ++it2;
-	}
-      }
-
-      // try the next node (if it exists)
-      ++it;
+    while(true) {
+      unsigned gen = machine->get_generation();
+      Memory result, resume;
+      if(cache.next(gen, after, result, resume))
+	return result;
+      extend_cache(gen, resume, after, false /*!to_end*/);
     }
-    return Memory::NO_MEMORY;
 #endif
   }
 
@@ -2168,46 +2267,14 @@ namespace Realm {
     }
     return pset.size();
 #else
-    size_t count = 0;
-    std::map<int, MachineNodeInfo *>::const_iterator it;
-    if(is_restricted_node)
-      it = machine->nodeinfos.lower_bound(restricted_node_id);
-    else
-      it = machine->nodeinfos.begin();
-    while(it != machine->nodeinfos.end()) {
-      if(is_restricted_node && (it->first != restricted_node_id))
-	break;
-
-      const std::map<Memory, MachineMemInfo *> *plist;
-      if(is_restricted_kind) {
-	std::map<Memory::Kind, std::map<Memory, MachineMemInfo *> >::const_iterator it2 = it->second->mem_by_kind.find(restricted_kind);
-	if(it2 != it->second->mem_by_kind.end())
-	  plist = &(it2->second);
-	else
-	  plist = 0;
-      } else
-	plist = &(it->second->mems);
-
-      if(plist) {
-	std::map<Memory, MachineMemInfo *>::const_iterator it2 = plist->begin();
-	while(it2 != plist->end()) {
-	  bool ok = true;
-	  for(std::vector<MemoryQueryPredicate *>::const_iterator it3 = predicates.begin();
-	      ok && (it3 != predicates.end());
-	      it3++)
-	    ok = (*it3)->matches_predicate(machine, it2->first, it2->second);
-	  if(ok)
-	    count += 1;
-
-	  // continue to next memory (if it exists)
-	  ++it2;
-	}
-      }
-
-      // continue to the next node (if it exists)
-      ++it;
+    while(true) {
+      unsigned gen = machine->get_generation();
+      size_t result;
+      Memory resume;
+      if(cache.count(gen, result, resume))
+	return result;
+      extend_cache(gen, resume, Memory::NO_MEMORY, true /*to_end*/);
     }
-    return count;
 #endif
   }
 
@@ -2241,47 +2308,12 @@ namespace Realm {
       }
     }
 #else
-    size_t count = 0;
-    std::map<int, MachineNodeInfo *>::const_iterator it;
-    if(is_restricted_node)
-      it = machine->nodeinfos.lower_bound(restricted_node_id);
-    else
-      it = machine->nodeinfos.begin();
-    while(it != machine->nodeinfos.end()) {
-      if(is_restricted_node && (it->first != restricted_node_id))
+    while(true) {
+      unsigned gen = machine->get_generation();
+      Memory resume;
+      if(cache.random(gen, chosen, resume))
 	break;
-
-      const std::map<Memory, MachineMemInfo *> *plist;
-      if(is_restricted_kind) {
-	std::map<Memory::Kind, std::map<Memory, MachineMemInfo *> >::const_iterator it2 = it->second->mem_by_kind.find(restricted_kind);
-	if(it2 != it->second->mem_by_kind.end())
-	  plist = &(it2->second);
-	else
-	  plist = 0;
-      } else
-	plist = &(it->second->mems);
-
-      if(plist) {
-	std::map<Memory, MachineMemInfo *>::const_iterator it2 = plist->begin();
-	while(it2 != plist->end()) {
-	  bool ok = true;
-	  for(std::vector<MemoryQueryPredicate *>::const_iterator it3 = predicates.begin();
-	      ok && (it3 != predicates.end());
-	      it3++)
-	    ok = (*it3)->matches_predicate(machine, it2->first, it2->second);
-	  if(ok) {
-	    count++;
-	    if((count == 1) || ((lrand48() % count) == 0))
-	      chosen = it2->first;
-	  }
-
-	  // continue to next memory (if it exists)
-	  ++it2;
-	}
-      }
-
-      // continue to the next node (if it exists)
-      ++it;
+      extend_cache(gen, resume, Memory::NO_MEMORY, true /*to_end*/);
     }
 #endif
     return chosen;
@@ -130,6 +130,10 @@ namespace Realm {
       void add_subscription(Machine::MachineUpdateSubscriber *subscriber);
       void remove_subscription(Machine::MachineUpdateSubscriber *subscriber);
 
+      // bumped whenever processors, memories or affinities are added - any
+      //  cached query results from an older generation are stale
+      unsigned get_generation(void) const { return generation; }
+
       mutable GASNetHSL mutex;
       std::vector<Machine::ProcessorMemoryAffinity> proc_mem_affinities;
       std::vector<Machine::MemoryMemoryAffinity> mem_mem_affinities;
@@ -138,6 +142,10 @@ namespace Realm {
       std::map<int, MachineNodeInfo *> nodeinfos;
 
     protected:
+      void bump_generation(void);
+
+      volatile unsigned generation;
+
       MachineNodeInfo *get_nodeinfo(int node) const;
       MachineNodeInfo *get_nodeinfo(Processor p) const;
       MachineNodeInfo *get_nodeinfo(Memory m) const;
@@ -186,6 +194,49 @@ namespace Realm {
       int latency_weight;
     };
 
+    // the matches of a query, in the order in which first/next_match walk
+    //  them (i.e. sorted by ID, which orders by owner node first) - the
+    //  machine is only scanned as far as the lookups so far have needed, so
+    //  a one-shot first_match stops at the first match, while walking all the
+    //  matches (or counting them) scans the machine once per generation
+    // each lookup either answers from the matches found so far and returns
+    //  true, or returns false along with the point after which the caller
+    //  must scan ('no_match' meaning from the start) and then call extend()
+    template <typename T>
+    class QueryMatchCache {
+    public:
+      QueryMatchCache(T _no_match);
+
+      bool first(unsigned machine_generation, T& result, T& resume) const;
+      // O(1) when 'after' is the previous result, O(log n) otherwise
+      bool next(unsigned machine_generation, T after, T& result, T& resume) const;
+      bool count(unsigned machine_generation, size_t& result, T& resume) const;
+      bool random(unsigned machine_generation, T& result, T& resume) const;
+
+      // adds the matches found by a scan that started after 'resume' and
+      //  examined everything up to 'scanned_through' (or to the end of the
+      //  machine if 'complete' is set)
+      void extend(unsigned machine_generation, T resume,
+		  std::vector<T>& new_matches, T scanned_through, bool complete);
+      // called when the query itself changes
+      void invalidate(void);
+
+    protected:
+      // must be called with the mutex held - true if the matches found so
+      //  far are enough to find the first match after 'after' (or all of them)
+      bool covers(unsigned machine_generation, T after, bool need_all,
+		  T& resume) const;
+
+      const T no_match;
+      mutable GASNetHSL mutex;
+      bool valid;
+      unsigned generation;
+      std::vector<T> matches;
+      T scanned_through;
+      bool complete;
+      mutable size_t last_pos;
+    };
+
     class ProcessorQueryImpl {
     public:
       ProcessorQueryImpl(const Machine& _machine);
@@ -218,6 +269,17 @@ namespace Realm {
       bool is_restricted_kind;
       Processor::Kind restricted_kind;
       std::vector<ProcQueryPredicate *> predicates;     
+
+      // scans the machine for matches after 'resume' (or from the start if
+      //  it doesn't exist), stopping at the first match after 'stop_after'
+      //  unless 'to_end' is set - returns true if the end was reached
+      bool scan_matches(Processor resume, Processor stop_after, bool to_end,
+			std::vector<Processor>& matches, Processor& scanned_through) const;
+      // scans from 'resume' and adds the results to the cache
+      void extend_cache(unsigned gen, Processor resume, Processor stop_after,
+			bool to_end) const;
+
+      mutable QueryMatchCache<Processor> cache;
     };            
 
     typedef QueryPredicate<Memory, MachineMemInfo> MemoryQueryPredicate;
@@ -314,6 +376,17 @@ namespace Realm {
       bool is_restricted_kind;
       Memory::Kind restricted_kind;
       std::vector<MemoryQueryPredicate *> predicates;     
+
+      // scans the machine for matches after 'resume' (or from the start if
+      //  it doesn't exist), stopping at the first match after 'stop_after'
+      //  unless 'to_end' is set - returns true if the end was reached
+      bool scan_matches(Memory resume, Memory stop_after, bool to_end,
+			std::vector<Memory>& matches, Memory& scanned_through) const;
+      // scans from 'resume' and adds the results to the cache
+      void extend_cache(unsigned gen, Memory resume, Memory stop_after,
+			bool to_end) const;
+
+      mutable QueryMatchCache<Memory> cache;
     };            
 
     extern MachineImpl *machine_singleton;
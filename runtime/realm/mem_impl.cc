@@ -68,6 +68,133 @@ namespace Realm {
     /*static*/ const Memory Memory::NO_MEMORY = { 0 };
 
 
+  namespace Config {
+    bool mem_alloc_high = false;
+  };
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class MemoryRangeAllocator
+  //
+
+    MemoryRangeAllocator::MemoryRangeAllocator(AllocPolicy _policy /*= ALLOC_BEST_FIT*/)
+      : policy(_policy), free_bytes(0)
+    {
+    }
+
+    void MemoryRangeAllocator::insert_range(off_t offset, off_t size)
+    {
+      ranges_by_offset[offset] = size;
+      ranges_by_size.insert(std::make_pair(size, offset));
+      free_bytes += size;
+    }
+
+    void MemoryRangeAllocator::remove_range(std::map<off_t, off_t>::iterator it)
+    {
+      size_t count = ranges_by_size.erase(std::make_pair(it->second, it->first));
+      assert(count == 1);
+#ifdef NDEBUG
+      (void)count;
+#endif
+      free_bytes -= it->second;
+      ranges_by_offset.erase(it);
+    }
+
+    void MemoryRangeAllocator::add_range(off_t offset, off_t size)
+    {
+      if(size > 0)
+	deallocate(offset, size);
+    }
+
+    off_t MemoryRangeAllocator::allocate(off_t size)
+    {
+      std::map<off_t, off_t>::iterator it = ranges_by_offset.end();
+
+      switch(policy) {
+      case ALLOC_BEST_FIT:
+	{
+	  // smallest range that fits - among ranges of that size, take the
+	  //  highest one to keep the footprint down
+	  std::set<std::pair<off_t, off_t> >::iterator it2 = ranges_by_size.lower_bound(std::make_pair(size, (off_t)0));
+	  if(it2 == ranges_by_size.end())
+	    return -1;
+	  it2 = ranges_by_size.lower_bound(std::make_pair(it2->first + 1, (off_t)0));
+	  --it2;
+	  it = ranges_by_offset.find(it2->second);
+	  break;
+	}
+
+      case ALLOC_HIGH:
+	{
+	  // try to minimize footprint by allocating at the highest address possible
+	  while(it != ranges_by_offset.begin()) {
+	    --it;  // predecrement since we started at the end
+	    if(it->second >= size)
+	      break;
+	  }
+	  if((it == ranges_by_offset.end()) || (it->second < size))
+	    return -1;
+	  break;
+	}
+      }
+
+      assert((it != ranges_by_offset.end()) && (it->second >= size));
+      off_t range_start = it->first;
+      off_t leftover = it->second - size;
+      remove_range(it);
+      // carve the allocation off the top of the range
+      if(leftover > 0)
+	insert_range(range_start, leftover);
+      return range_start + leftover;
+    }
+
+    void MemoryRangeAllocator::deallocate(off_t offset, off_t size)
+    {
+      // find the first existing range that comes _after_ us
+      std::map<off_t, off_t>::iterator after = ranges_by_offset.lower_bound(offset);
+      if(after != ranges_by_offset.end()) {
+	assert((offset + size) <= after->first); // no overlap!
+	if((offset + size) == after->first) {
+	  // merge the ranges by eating the "after"
+	  size += after->second;
+	  std::map<off_t, off_t>::iterator to_remove = after++;
+	  remove_range(to_remove);
+	}
+      }
+
+      // and see if we can merge with the range that's before us
+      if(after != ranges_by_offset.begin()) {
+	std::map<off_t, off_t>::iterator before = after; --before;
+	assert((before->first + before->second) <= offset); // no overlap!
+	if((before->first + before->second) == offset) {
+	  offset = before->first;
+	  size += before->second;
+	  remove_range(before);
+	}
+      }
+
+      insert_range(offset, size);
+    }
+
+    size_t MemoryRangeAllocator::num_free_ranges(void) const
+    {
+      return ranges_by_offset.size();
+    }
+
+    off_t MemoryRangeAllocator::largest_free_range(void) const
+    {
+      if(ranges_by_size.empty())
+	return 0;
+      return ranges_by_size.rbegin()->first;
+    }
+
+    off_t MemoryRangeAllocator::total_free_bytes(void) const
+    {
+      return free_bytes;
+    }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class MemoryImpl
@@ -78,22 +205,35 @@ namespace Realm {
 
     MemoryImpl::MemoryImpl(Memory _me, size_t _size, MemoryKind _kind, size_t _alignment, Memory::Kind _lowlevel_kind)
       : me(_me), size(_size), kind(_kind), alignment(_alignment), lowlevel_kind(_lowlevel_kind)
+      , free_blocks(Config::mem_alloc_high ? MemoryRangeAllocator::ALLOC_HIGH :
+		                             MemoryRangeAllocator::ALLOC_BEST_FIT)
       , usage(stringbuilder() << "realm/mem " << _me << "/usage")
       , peak_usage(stringbuilder() << "realm/mem " << _me << "/peak_usage")
       , peak_footprint(stringbuilder() << "realm/mem " << _me << "/peak_footprint")
+      , free_ranges(stringbuilder() << "realm/mem " << _me << "/free_ranges")
+      , largest_free_range(stringbuilder() << "realm/mem " << _me << "/largest_free_range")
     {
     }
 
     MemoryImpl::~MemoryImpl(void)
     {
 #ifdef REALM_PROFILE_MEMORY_USAGE
-      printf("Memory " IDFMT " usage: peak=%zd (%.1f MB) footprint=%zd (%.1f MB)\n",
+      printf("Memory " IDFMT " usage: peak=%zd (%.1f MB) footprint=%zd (%.1f MB) free_ranges=%zd largest_free=%zd (%.1f MB)\n",
 	     me.id, 
 	     (size_t)peak_usage, peak_usage / 1048576.0,
-	     (size_t)peak_footprint, peak_footprint / 1048576.0);
+	     (size_t)peak_footprint, peak_footprint / 1048576.0,
+	     (size_t)free_ranges,
+	     (size_t)largest_free_range, largest_free_range / 1048576.0);
 #endif
     }
 
+    // caller must hold the mutex
+    void MemoryImpl::update_fragmentation_gauges(void)
+    {
+      free_ranges = free_blocks.num_free_ranges();
+      largest_free_range = free_blocks.largest_free_range();
+    }
+
     off_t MemoryImpl::alloc_bytes_local(size_t size)
     {
       AutoHSLLock al(mutex);
@@ -115,42 +255,20 @@ namespace Realm {
       //  the end of their allocations
       size += 0;
 
-      // try to minimize footprint by allocating at the highest address possible
-      if(!free_blocks.empty()) {
-	std::map<off_t, off_t>::iterator it = free_blocks.end();
-	do {
-	  --it;  // predecrement since we started at the end
-
-	  if(it->second == (off_t)size) {
-	    // perfect match
-	    off_t retval = it->first;
-	    free_blocks.erase(it);
-	    log_malloc.info("alloc full block: mem=" IDFMT " size=%zd ofs=%zd", me.id, size, (ssize_t)retval);
-	    usage += size;
-	    if(usage > peak_usage) peak_usage = usage;
-	    size_t footprint = this->size - retval;
-	    if(footprint > peak_footprint) peak_footprint = footprint;
-	    return retval;
-	  }
-	
-	  if(it->second > (off_t)size) {
-	    // some left over
-	    off_t leftover = it->second - size;
-	    off_t retval = it->first + leftover;
-	    it->second = leftover;
-	    log_malloc.info("alloc partial block: mem=" IDFMT " size=%zd ofs=%zd", me.id, size, (ssize_t)retval);
-	    usage += size;
-	    if(usage > peak_usage) peak_usage = usage;
-	    size_t footprint = this->size - retval;
-	    if(footprint > peak_footprint) peak_footprint = footprint;
-	    return retval;
-	  }
-	} while(it != free_blocks.begin());
+      off_t retval = free_blocks.allocate(size);
+      if(retval < 0) {
+	// no blocks large enough - boo hoo
+	log_malloc.info("alloc FAILED: mem=" IDFMT " size=%zd", me.id, size);
+	return -1;
       }
 
-      // no blocks large enough - boo hoo
-      log_malloc.info("alloc FAILED: mem=" IDFMT " size=%zd", me.id, size);
-      return -1;
+      log_malloc.info("alloc block: mem=" IDFMT " size=%zd ofs=%zd", me.id, size, (ssize_t)retval);
+      usage += size;
+      if(usage > peak_usage) peak_usage = usage;
+      size_t footprint = this->size - retval;
+      if(footprint > peak_footprint) peak_footprint = footprint;
+      update_fragmentation_gauges();
+      return retval;
     }
 
     void MemoryImpl::free_bytes_local(off_t offset, size_t size)
@@ -176,60 +294,8 @@ namespace Realm {
       usage -= size;
       // only made things smaller, so can't impact the peak usage
 
-      if(free_blocks.size() > 0) {
-	// find the first existing block that comes _after_ us
-	std::map<off_t, off_t>::iterator after = free_blocks.lower_bound(offset);
-	if(after != free_blocks.end()) {
-	  // found one - is it the first one?
-	  if(after == free_blocks.begin()) {
-	    // yes, so no "before"
-	    assert((offset + (off_t)size) <= after->first); // no overlap!
-	    if((offset + (off_t)size) == after->first) {
-	      // merge the ranges by eating the "after"
-	      size += after->second;
-	      free_blocks.erase(after);
-	    }
-	    free_blocks[offset] = size;
-	  } else {
-	    // no, get range that comes before us too
-	    std::map<off_t, off_t>::iterator before = after; before--;
-
-	    // if we're adjacent to the after, merge with it
-	    assert((offset + (off_t)size) <= after->first); // no overlap!
-	    if((offset + (off_t)size) == after->first) {
-	      // merge the ranges by eating the "after"
-	      size += after->second;
-	      free_blocks.erase(after);
-	    }
-
-	    // if we're adjacent with the before, grow it instead of adding
-	    //  a new range
-	    assert((before->first + before->second) <= offset);
-	    if((before->first + before->second) == offset) {
-	      before->second += size;
-	    } else {
-	      free_blocks[offset] = size;
-	    }
-	  }
-	} else {
-	  // nothing's after us, so just see if we can merge with the range
-	  //  that's before us
-
-	  std::map<off_t, off_t>::iterator before = after; before--;
-
-	  // if we're adjacent with the before, grow it instead of adding
-	  //  a new range
-	  assert((before->first + before->second) <= offset);
-	  if((before->first + before->second) == offset) {
-	    before->second += size;
-	  } else {
-	    free_blocks[offset] = size;
-	  }
-	}
-      } else {
-	// easy case - nothing was free, so now just our block is
-	free_blocks[offset] = size;
-      }
+      free_blocks.deallocate(offset, size);
+      update_fragmentation_gauges();
     }
 
     off_t MemoryImpl::alloc_bytes_remote(size_t size)
@@ -473,7 +539,7 @@ namespace Realm {
     }
     log_malloc.debug("CPU memory at %p, size = %zd%s%s", base, _size, 
 		     prealloced ? " (prealloced)" : "", registered ? " (registered)" : "");
-    free_blocks[0] = _size;
+    free_blocks.add_range(0, _size);
   }
 
   LocalCPUMemory::~LocalCPUMemory(void)
@@ -640,7 +706,7 @@ namespace Realm {
       size = size_per_node * num_nodes;
       memory_stride = MEMORY_STRIDE;
       
-      free_blocks[0] = size;
+      free_blocks.add_range(0, size);
     }
 
     GASNetMemory::~GASNetMemory(void)
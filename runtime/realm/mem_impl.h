@@ -20,6 +20,7 @@
 
 #include "memory.h"
 #include "id.h"
+#include "indexspace.h"
 
 #include "activemsg.h"
 #include "operation.h"
@@ -33,9 +34,54 @@
 #include <hdf5.h>
 #endif
 
+#include <map>
+#include <set>
+
 namespace Realm {
 
   class RegionInstanceImpl;
+
+  namespace Config {
+    // if set, memories use the original "allocate at the highest address
+    //  possible" first-fit policy instead of the best-fit allocator
+    extern bool mem_alloc_high;
+  };
+
+    // tracks the free ranges of a memory - ranges are indexed both by offset
+    //  (so that frees can be coalesced with their neighbors) and by size (so
+    //  that a best-fit allocation is O(log n) in the number of free ranges)
+    // not thread-safe - the owning MemoryImpl's mutex must be held
+    class MemoryRangeAllocator {
+    public:
+      enum AllocPolicy {
+	ALLOC_BEST_FIT,  // smallest free range that fits
+	ALLOC_HIGH,      // first fit, scanning down from the highest address
+      };
+
+      MemoryRangeAllocator(AllocPolicy _policy = ALLOC_BEST_FIT);
+
+      // adds a range of free bytes - must not overlap any existing range
+      void add_range(off_t offset, off_t size);
+
+      // returns -1 if no free range is large enough
+      off_t allocate(off_t size);
+      void deallocate(off_t offset, off_t size);
+
+      // fragmentation statistics
+      size_t num_free_ranges(void) const;
+      off_t largest_free_range(void) const;
+      off_t total_free_bytes(void) const;
+
+      AllocPolicy policy;
+
+    protected:
+      void insert_range(off_t offset, off_t size);
+      void remove_range(std::map<off_t, off_t>::iterator it);
+
+      std::map<off_t, off_t> ranges_by_offset;          // offset -> size
+      std::set<std::pair<off_t, off_t> > ranges_by_size; // (size, offset)
+      off_t free_bytes;
+    };
   
     class MemoryImpl {
     public:
@@ -137,8 +183,13 @@ namespace Realm {
       Memory::Kind lowlevel_kind;
       GASNetHSL mutex; // protection for resizing vectors
       std::vector<RegionInstanceImpl *> instances;
-      std::map<off_t, off_t> free_blocks;
+      MemoryRangeAllocator free_blocks;
       ProfilingGauges::AbsoluteGauge<size_t> usage, peak_usage, peak_footprint;
+      // fragmentation of the free space, updated on every alloc/free
+      ProfilingGauges::AbsoluteGauge<size_t> free_ranges, largest_free_range;
+
+    protected:
+      void update_fragmentation_gauges(void);
     };
 
     class LocalCPUMemory : public MemoryImpl {
@@ -0,0 +1,242 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// dynamic node set implementation for Realm
+
+#include "nodeset.h"
+
+#include <string.h>
+
+namespace Realm {
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class NodeSet
+  //
+
+  // replaced with the real node count during runtime initialization
+  /*static*/ int NodeSet::max_node_count = 1024;
+
+  /*static*/ void NodeSet::configure(int max_nodes)
+  {
+    assert(max_nodes > 0);
+    max_node_count = max_nodes;
+  }
+
+  /*static*/ size_t NodeSet::sparse_capacity(size_t count)
+  {
+    // powers of two, starting at twice what fits inline
+    size_t cap = 2 * MAX_INLINE_VALUES;
+    while(cap < count)
+      cap <<= 1;
+    return cap;
+  }
+
+  bool NodeSet::contains_slow(NodeID node) const
+  {
+    switch(encoding) {
+    case ENC_SPARSE:
+      return std::binary_search(data.sparse, data.sparse + count, node);
+
+    case ENC_BITMASK:
+      {
+	if((node < 0) || (node >= max_node_count))
+	  return false;
+	return ((data.bitmask[node / BITS_PER_WORD] >> (node % BITS_PER_WORD)) & 1) != 0;
+      }
+
+    default:
+      assert(0);
+      return false;
+    }
+  }
+
+  void NodeSet::add_slow(NodeID node)
+  {
+    assert((node >= 0) && (node < max_node_count));
+
+    switch(encoding) {
+    case ENC_VALS:
+      {
+	// inline storage is full
+	assert(count == MAX_INLINE_VALUES);
+	if(contains(node))
+	  return;
+	// a bitmask is the better choice once a sorted array would be no
+	//  smaller (it's cheaper to build and walk)
+	if((sparse_capacity(count + 1) * sizeof(NodeID)) >=
+	   (bitmask_words() * sizeof(BitWord))) {
+	  convert_to_bitmask();
+	  add(node);
+	  return;
+	}
+	NodeID *sparse = (NodeID *)malloc(sparse_capacity(count + 1) * sizeof(NodeID));
+	assert(sparse != 0);
+	int pos = 0;
+	for(int i = 0; i < count; i++)
+	  if(data.values[i] < node)
+	    sparse[pos++] = data.values[i];
+	  else
+	    sparse[i + 1] = data.values[i];
+	sparse[pos] = node;
+	data.sparse = sparse;
+	encoding = ENC_SPARSE;
+	count++;
+	break;
+      }
+
+    case ENC_SPARSE:
+      {
+	int pos;
+	if(count <= 16) {
+	  // sorted insertion from the end - for short arrays this beats a
+	  //  binary search plus memmove
+	  pos = count;
+	  while((pos > 0) && (data.sparse[pos - 1] > node))
+	    pos--;
+	  if((pos > 0) && (data.sparse[pos - 1] == node))
+	    return;
+	} else {
+	  pos = std::lower_bound(data.sparse, data.sparse + count, node) - data.sparse;
+	  if((pos < count) && (data.sparse[pos] == node))
+	    return;
+	}
+	if(sparse_capacity(count + 1) > sparse_capacity(count)) {
+	  if((sparse_capacity(count + 1) * sizeof(NodeID)) >=
+	     (bitmask_words() * sizeof(BitWord))) {
+	    convert_to_bitmask();
+	    add(node);
+	    return;
+	  }
+	  data.sparse = (NodeID *)realloc(data.sparse,
+					  sparse_capacity(count + 1) * sizeof(NodeID));
+	  assert(data.sparse != 0);
+	}
+	memmove(data.sparse + pos + 1, data.sparse + pos, (count - pos) * sizeof(NodeID));
+	data.sparse[pos] = node;
+	count++;
+	break;
+      }
+
+    default:
+      // bitmasks are handled inline
+      assert(0);
+    }
+  }
+
+  void NodeSet::remove_slow(NodeID node)
+  {
+    switch(encoding) {
+    case ENC_SPARSE:
+      {
+	NodeID *pos = std::lower_bound(data.sparse, data.sparse + count, node);
+	if((pos == (data.sparse + count)) || (*pos != node))
+	  return;
+	memmove(pos, pos + 1, (data.sparse + count - pos - 1) * sizeof(NodeID));
+	count--;
+	if(count <= MAX_INLINE_VALUES)
+	  convert_to_values();
+	else if(sparse_capacity(count) < sparse_capacity(count + 1))
+	  data.sparse = (NodeID *)realloc(data.sparse,
+					  sparse_capacity(count) * sizeof(NodeID));
+	break;
+      }
+
+    case ENC_BITMASK:
+      {
+	if((node < 0) || (node >= max_node_count))
+	  return;
+	BitWord& word = data.bitmask[node / BITS_PER_WORD];
+	BitWord bit = BitWord(1) << (node % BITS_PER_WORD);
+	if((word & bit) == 0)
+	  return;
+	word &= ~bit;
+	count--;
+	// a bitmask doesn't go back to a sorted array until it's nearly
+	//  empty, so sets hovering around the crossover don't thrash
+	if(count <= MAX_INLINE_VALUES)
+	  convert_to_values();
+	break;
+      }
+
+    default:
+      assert(0);
+    }
+  }
+
+  // assumes we're currently empty (and therefore have nothing allocated)
+  void NodeSet::copy_from(const NodeSet& other)
+  {
+    assert((count == 0) && (encoding == ENC_VALS));
+    count = other.count;
+    encoding = other.encoding;
+    switch(encoding) {
+    case ENC_VALS:
+      {
+	for(int i = 0; i < count; i++)
+	  data.values[i] = other.data.values[i];
+	break;
+      }
+
+    case ENC_SPARSE:
+      {
+	data.sparse = (NodeID *)malloc(sparse_capacity(count) * sizeof(NodeID));
+	assert(data.sparse != 0);
+	memcpy(data.sparse, other.data.sparse, count * sizeof(NodeID));
+	break;
+      }
+
+    case ENC_BITMASK:
+      {
+	data.bitmask = (BitWord *)malloc(bitmask_words() * sizeof(BitWord));
+	assert(data.bitmask != 0);
+	memcpy(data.bitmask, other.data.bitmask, bitmask_words() * sizeof(BitWord));
+	break;
+      }
+    }
+  }
+
+  void NodeSet::convert_to_bitmask(void)
+  {
+    assert(encoding != ENC_BITMASK);
+    BitWord *bitmask = (BitWord *)calloc(bitmask_words(), sizeof(BitWord));
+    assert(bitmask != 0);
+    const NodeID *members = ((encoding == ENC_VALS) ? data.values : data.sparse);
+    for(int i = 0; i < count; i++)
+      bitmask[members[i] / BITS_PER_WORD] |= BitWord(1) << (members[i] % BITS_PER_WORD);
+    if(encoding == ENC_SPARSE)
+      free(data.sparse);
+    data.bitmask = bitmask;
+    encoding = ENC_BITMASK;
+  }
+
+  void NodeSet::convert_to_values(void)
+  {
+    assert(count <= MAX_INLINE_VALUES);
+    NodeID values[MAX_INLINE_VALUES];
+    int n = 0;
+    for(const_iterator it = begin(); it != end(); ++it)
+      values[n++] = *it;
+    assert(n == count);
+    if(encoding == ENC_SPARSE)
+      free(data.sparse);
+    else if(encoding == ENC_BITMASK)
+      free(data.bitmask);
+    for(int i = 0; i < n; i++)
+      data.values[i] = values[i];
+    encoding = ENC_VALS;
+  }
+
+}; // namespace Realm
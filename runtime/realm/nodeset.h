@@ -18,12 +18,114 @@
 #ifndef REALM_NODESET_H
 #define REALM_NODESET_H
 
-// currently just using the HLR's version
-#include "legion_types.h"
-#include "legion_utilities.h"
+#include <stddef.h>
 
 namespace Realm {
-  typedef Legion::Internal::NodeSet NodeSet;
-};
+
+  typedef int NodeID;
+
+  class NodeSetIterator;
+
+  // a set of node IDs, sized for the common case of a handful of members
+  //  but able to grow to any node count - the representation changes as
+  //  the set grows:
+  //   - up to MAX_INLINE_VALUES members are stored inline (no allocation)
+  //   - then a sorted array of members, as long as that's smaller than...
+  //   - a bitmask covering every node in the machine
+  // members are always visited in increasing order, and iteration only
+  //  costs as much as the number of members (plus empty bitmask words)
+  class NodeSet {
+  public:
+    NodeSet(void);
+    NodeSet(const NodeSet& copy_from);
+    ~NodeSet(void);
+
+    NodeSet& operator=(const NodeSet& copy_from);
+
+    // sets the bound on node IDs (i.e. every member must be in
+    //  [0, max_nodes)) - must be called before any set is populated
+    static void configure(int max_nodes);
+    static int max_nodes(void);
+
+    bool empty(void) const;
+    size_t size(void) const;
+    bool contains(NodeID node) const;
+
+    void add(NodeID node);
+    void remove(NodeID node);
+    void clear(void);
+    NodeSet& swap(NodeSet& swap_with);
+
+    typedef NodeSetIterator const_iterator;
+    const_iterator begin(void) const;
+    const_iterator end(void) const;
+
+    // calls 'functor.apply(node)' for each member, in increasing order
+    template <typename FUNCTOR>
+    void map(FUNCTOR& functor) const;
+
+  protected:
+    friend class NodeSetIterator;
+
+    enum Encoding {
+      ENC_VALS,     // data.values[0..count), sorted
+      ENC_SPARSE,   // data.sparse[0..count), sorted, heap-allocated
+      ENC_BITMASK,  // data.bitmask, bitmask_words() words
+    };
+
+    static const int MAX_INLINE_VALUES = 4;
+
+    typedef unsigned long long BitWord;
+    static const int BITS_PER_WORD = 8 * sizeof(BitWord);
+
+    static size_t bitmask_words(void);
+    static size_t sparse_capacity(size_t count);
+
+    // everything that might allocate or change the encoding
+    void add_slow(NodeID node);
+    void remove_slow(NodeID node);
+    bool contains_slow(NodeID node) const;
+    void copy_from(const NodeSet& other);
+    void convert_to_bitmask(void);
+    void convert_to_values(void);
+
+    // returns the first member >= 'node', or -1 if there is none
+    NodeID next_member(NodeID node) const;
+
+    static int max_node_count;
+
+    int count;
+    int encoding;
+    union {
+      NodeID values[MAX_INLINE_VALUES];
+      NodeID *sparse;
+      BitWord *bitmask;
+    } data;
+  };
+
+  class NodeSetIterator {
+  public:
+    NodeSetIterator(void);
+
+    NodeID operator*(void) const;
+    NodeSetIterator& operator++(/*prefix*/);
+    NodeSetIterator operator++(int /*postfix*/);
+
+    bool operator==(const NodeSetIterator& compare_to) const;
+    bool operator!=(const NodeSetIterator& compare_to) const;
+
+  protected:
+    friend class NodeSet;
+
+    NodeSetIterator(const NodeSet *_nodeset, int _index, NodeID _cur_node);
+
+    const NodeSet *nodeset;
+    int index;        // position within values/sparse (unused for bitmask)
+    NodeID cur_node;  // -1 once we've walked off the end
+  };
+
+}; // namespace Realm
+
+#include "nodeset.inl"
 
 #endif // ifndef REALM_NODESET_H
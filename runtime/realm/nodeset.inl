@@ -0,0 +1,283 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// INCLDUED FROM nodeset.h - DO NOT INCLUDE THIS DIRECTLY
+
+// this is a nop, but it's for the benefit of IDEs trying to parse this file
+#include "nodeset.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include <algorithm>
+
+namespace Realm {
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class NodeSet
+  //
+
+  inline NodeSet::NodeSet(void)
+    : count(0), encoding(ENC_VALS)
+  {}
+
+  inline NodeSet::NodeSet(const NodeSet& copy_from)
+    : count(0), encoding(ENC_VALS)
+  {
+    this->copy_from(copy_from);
+  }
+
+  inline NodeSet::~NodeSet(void)
+  {
+    clear();
+  }
+
+  inline NodeSet& NodeSet::operator=(const NodeSet& copy_from)
+  {
+    if(this != &copy_from) {
+      clear();
+      this->copy_from(copy_from);
+    }
+    return *this;
+  }
+
+  /*static*/ inline int NodeSet::max_nodes(void)
+  {
+    return max_node_count;
+  }
+
+  /*static*/ inline size_t NodeSet::bitmask_words(void)
+  {
+    return (max_node_count + BITS_PER_WORD - 1) / BITS_PER_WORD;
+  }
+
+  inline bool NodeSet::empty(void) const
+  {
+    return (count == 0);
+  }
+
+  inline size_t NodeSet::size(void) const
+  {
+    return count;
+  }
+
+  inline bool NodeSet::contains(NodeID node) const
+  {
+    if(encoding == ENC_VALS) {
+      for(int i = 0; i < count; i++)
+	if(data.values[i] == node)
+	  return true;
+      return false;
+    }
+    return contains_slow(node);
+  }
+
+  inline void NodeSet::add(NodeID node)
+  {
+    if((encoding == ENC_VALS) && (count < MAX_INLINE_VALUES)) {
+      assert((node >= 0) && (node < max_node_count));
+      // keep the inline values sorted
+      int pos = 0;
+      while((pos < count) && (data.values[pos] < node))
+	pos++;
+      if((pos < count) && (data.values[pos] == node))
+	return;
+      for(int i = count; i > pos; i--)
+	data.values[i] = data.values[i - 1];
+      data.values[pos] = node;
+      count++;
+      return;
+    }
+    if(encoding == ENC_BITMASK) {
+      assert((node >= 0) && (node < max_node_count));
+      BitWord& word = data.bitmask[node / BITS_PER_WORD];
+      BitWord bit = BitWord(1) << (node % BITS_PER_WORD);
+      // branch-free - whether the bit was already set is unpredictable
+      count += ((word & bit) == 0);
+      word |= bit;
+      return;
+    }
+    add_slow(node);
+  }
+
+  inline void NodeSet::remove(NodeID node)
+  {
+    if(encoding == ENC_VALS) {
+      for(int i = 0; i < count; i++)
+	if(data.values[i] == node) {
+	  for(int j = i + 1; j < count; j++)
+	    data.values[j - 1] = data.values[j];
+	  count--;
+	  return;
+	}
+      return;
+    }
+    remove_slow(node);
+  }
+
+  inline void NodeSet::clear(void)
+  {
+    if(encoding == ENC_SPARSE)
+      free(data.sparse);
+    else if(encoding == ENC_BITMASK)
+      free(data.bitmask);
+    count = 0;
+    encoding = ENC_VALS;
+  }
+
+  inline NodeSet& NodeSet::swap(NodeSet& swap_with)
+  {
+    std::swap(count, swap_with.count);
+    std::swap(encoding, swap_with.encoding);
+    std::swap(data, swap_with.data);
+    return *this;
+  }
+
+  inline NodeSet::const_iterator NodeSet::begin(void) const
+  {
+    if(count == 0)
+      return end();
+    switch(encoding) {
+    case ENC_VALS:
+      return NodeSetIterator(this, 0, data.values[0]);
+    case ENC_SPARSE:
+      return NodeSetIterator(this, 0, data.sparse[0]);
+    default:
+      return NodeSetIterator(this, 0, next_member(0));
+    }
+  }
+
+  inline NodeSet::const_iterator NodeSet::end(void) const
+  {
+    return NodeSetIterator(this, 0, -1);
+  }
+
+  template <typename FUNCTOR>
+  inline void NodeSet::map(FUNCTOR& functor) const
+  {
+    switch(encoding) {
+    case ENC_VALS:
+      {
+	for(int i = 0; i < count; i++)
+	  functor.apply(data.values[i]);
+	break;
+      }
+
+    case ENC_SPARSE:
+      {
+	for(int i = 0; i < count; i++)
+	  functor.apply(data.sparse[i]);
+	break;
+      }
+
+    case ENC_BITMASK:
+      {
+	// stop as soon as we've seen every member
+	int left = count;
+	for(size_t w = 0; left > 0; w++) {
+	  BitWord bits = data.bitmask[w];
+	  while(bits != 0) {
+	    functor.apply((NodeID)(w * BITS_PER_WORD + __builtin_ctzll(bits)));
+	    bits &= (bits - 1);
+	    left--;
+	  }
+	}
+	break;
+      }
+    }
+  }
+
+  inline NodeID NodeSet::next_member(NodeID node) const
+  {
+    assert(encoding == ENC_BITMASK);
+    size_t words = bitmask_words();
+    size_t w = node / BITS_PER_WORD;
+    if(w >= words)
+      return -1;
+    BitWord bits = data.bitmask[w] & (~BitWord(0) << (node % BITS_PER_WORD));
+    while(bits == 0) {
+      if(++w >= words)
+	return -1;
+      bits = data.bitmask[w];
+    }
+    return (NodeID)(w * BITS_PER_WORD + __builtin_ctzll(bits));
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class NodeSetIterator
+  //
+
+  inline NodeSetIterator::NodeSetIterator(void)
+    : nodeset(0), index(0), cur_node(-1)
+  {}
+
+  inline NodeSetIterator::NodeSetIterator(const NodeSet *_nodeset,
+					  int _index, NodeID _cur_node)
+    : nodeset(_nodeset), index(_index), cur_node(_cur_node)
+  {}
+
+  inline NodeID NodeSetIterator::operator*(void) const
+  {
+    return cur_node;
+  }
+
+  inline NodeSetIterator& NodeSetIterator::operator++(/*prefix*/)
+  {
+    assert(cur_node >= 0);
+    switch(nodeset->encoding) {
+    case NodeSet::ENC_VALS:
+      {
+	index++;
+	cur_node = ((index < nodeset->count) ? nodeset->data.values[index] : -1);
+	break;
+      }
+
+    case NodeSet::ENC_SPARSE:
+      {
+	index++;
+	cur_node = ((index < nodeset->count) ? nodeset->data.sparse[index] : -1);
+	break;
+      }
+
+    case NodeSet::ENC_BITMASK:
+      {
+	cur_node = nodeset->next_member(cur_node + 1);
+	break;
+      }
+    }
+    return *this;
+  }
+
+  inline NodeSetIterator NodeSetIterator::operator++(int /*postfix*/)
+  {
+    NodeSetIterator orig(*this);
+    ++(*this);
+    return orig;
+  }
+
+  inline bool NodeSetIterator::operator==(const NodeSetIterator& compare_to) const
+  {
+    return ((nodeset == compare_to.nodeset) && (cur_node == compare_to.cur_node));
+  }
+
+  inline bool NodeSetIterator::operator!=(const NodeSetIterator& compare_to) const
+  {
+    return ((nodeset != compare_to.nodeset) || (cur_node != compare_to.cur_node));
+  }
+
+}; // namespace Realm
@@ -22,6 +22,7 @@
 #include "threads.h"
 #include "runtime_impl.h"
 #include "utils.h"
+#include "realm/transfer/memcpy_engine.h"
 
 namespace Realm {
 
@@ -311,6 +312,13 @@ namespace Realm {
     void NumaModule::create_dma_channels(RuntimeImpl *runtime)
     {
       Module::create_dma_channels(runtime);
+
+      // let the parallel memcpy engine know which domain each memory is in
+      for(std::map<int, MemoryImpl *>::const_iterator it = memories.begin();
+	  it != memories.end();
+	  ++it)
+	LegionRuntime::LowLevel::register_numa_memory_in_dma_systems(it->second->me,
+								     it->first);
     }
 
     // create any code translators provided by the module (default == do nothing)
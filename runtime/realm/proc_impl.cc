@@ -52,6 +52,10 @@ namespace Realm {
     __thread Processor current_processor;
   };
 
+  namespace Config {
+    bool group_work_stealing = false;
+  };
+
     Processor::Kind Processor::kind(void) const
     {
       return get_runtime()->get_processor_impl(*this)->kind;
@@ -426,13 +430,17 @@ namespace Realm {
     ProcessorGroup::ProcessorGroup(void)
       : ProcessorImpl(Processor::NO_PROC, Processor::PROC_GROUP),
 	members_valid(false), members_requested(false), next_free(0)
-      , ready_task_count(0)
+      , ready_task_count(0), next_member_queue(0)
     {
     }
 
     ProcessorGroup::~ProcessorGroup(void)
     {
       delete ready_task_count;
+      for(std::vector<ThreadedTaskScheduler::TaskQueue *>::iterator it = member_queues.begin();
+	  it != member_queues.end();
+	  it++)
+	delete *it;
     }
 
     void ProcessorGroup::init(Processor _me, int _owner)
@@ -462,10 +470,33 @@ namespace Realm {
       members_requested = true;
       members_valid = true;
 
+      // with work stealing, every member's scheduler can steal from every
+      //  other member's queue
+      for(size_t i = 0; i < member_scheds.size(); i++)
+	for(size_t j = 0; j < member_queues.size(); j++)
+	  if(i != j)
+	    member_scheds[i]->add_steal_queue(member_queues[j]);
+
       // now that we exist, profile our queue depth
       std::string gname = stringbuilder() << "realm/proc " << me << "/ready tasks";
       ready_task_count = new ProfilingGauges::AbsoluteRangeGauge<int>(gname);
       task_queue.set_gauge(ready_task_count);
+      for(std::vector<ThreadedTaskScheduler::TaskQueue *>::iterator it = member_queues.begin();
+	  it != member_queues.end();
+	  it++)
+	(*it)->set_gauge(ready_task_count);
+    }
+
+    ThreadedTaskScheduler::TaskQueue *ProcessorGroup::add_member_queue(Processor member,
+								       ThreadedTaskScheduler *sched)
+    {
+      // only called during set_group_members, so no locking needed
+      assert(!members_valid);
+      ThreadedTaskScheduler::TaskQueue *queue = new ThreadedTaskScheduler::TaskQueue;
+      member_queues.push_back(queue);
+      member_scheds.push_back(sched);
+      member_queue_map[member] = queue;
+      return queue;
     }
 
     void ProcessorGroup::get_group_members(std::vector<Processor>& member_list)
@@ -480,11 +511,28 @@ namespace Realm {
 
     void ProcessorGroup::enqueue_task(Task *task)
     {
-      // put it into the task queue - one of the member procs will eventually grab it
-      if(task->mark_ready())
-	task_queue.put(task, task->priority);
-      else
+      if(!task->mark_ready()) {
 	task->mark_finished(false /*!successful*/);
+	return;
+      }
+
+      if(member_queues.empty()) {
+	// put it into the task queue - one of the member procs will eventually grab it
+	task_queue.put(task, task->priority);
+	return;
+      }
+
+      // work stealing - a task enqueued by one of our members stays with that
+      //  member, everything else is spread round-robin over the members
+      std::map<Processor, ThreadedTaskScheduler::TaskQueue *>::const_iterator it = member_queue_map.find(ThreadLocal::current_processor);
+      ThreadedTaskScheduler::TaskQueue *queue;
+      if(it != member_queue_map.end()) {
+	queue = it->second;
+      } else {
+	unsigned idx = __sync_fetch_and_add(&next_member_queue, 1);
+	queue = member_queues[idx % member_queues.size()];
+      }
+      queue->put(task, task->priority);
     }
 
     void ProcessorGroup::add_to_group(ProcessorGroup *group)
@@ -506,7 +554,7 @@ namespace Realm {
     {
       // create a task object and insert it into the queue
       Task *task = new Task(me, func_id, args, arglen, reqs,
-                            start_event, finish_event, priority);
+                            start_event, finish_event, priority, &arg_arena);
       get_runtime()->optable.add_local_operation(finish_event, task);
 
       bool poisoned = false;
@@ -815,6 +863,11 @@ namespace Realm {
   {
     // add the group's task queue to our scheduler too
     sched->add_task_queue(&group->task_queue);
+
+    // with work stealing, we also get a queue of our own in the group - the
+    //  group hooks up the stealing once all members have joined
+    if(Config::group_work_stealing)
+      sched->add_task_queue(group->add_member_queue(me, sched));
   }
 
   void LocalTaskProcessor::enqueue_task(Task *task)
@@ -834,7 +887,7 @@ namespace Realm {
   {
     // create a task object for this
     Task *task = new Task(me, func_id, args, arglen, reqs,
-			  start_event, finish_event, priority);
+			  start_event, finish_event, priority, &arg_arena);
     get_runtime()->optable.add_local_operation(finish_event, task);
 
     // if the start event has already triggered, we can enqueue right away
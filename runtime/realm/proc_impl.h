@@ -37,6 +37,12 @@ namespace Realm {
 
     class ProcessorGroup;
 
+    namespace Config {
+      // if set, processor groups keep a ready queue per local member and
+      //  members steal from each other instead of sharing a single queue
+      extern bool group_work_stealing;
+    };
+
     class ProcessorImpl {
     public:
       ProcessorImpl(Processor _me, Processor::Kind _kind, int _num_cores=1);
@@ -102,6 +108,7 @@ namespace Realm {
       ThreadedTaskScheduler *sched;
       PriorityQueue<Task *, GASNetHSL> task_queue;
       ProfilingGauges::AbsoluteRangeGauge<int> ready_task_count;
+      TaskArgArena arg_arena;
 
       struct TaskTableEntry {
 	Processor::TaskFuncPtr fnptr;
@@ -201,8 +208,21 @@ namespace Realm {
 
       void request_group_members(void);
 
+      // called by a local member when work stealing is enabled - creates a
+      //  ready queue that only that member's scheduler owns
+      ThreadedTaskScheduler::TaskQueue *add_member_queue(Processor member,
+							 ThreadedTaskScheduler *sched);
+
       PriorityQueue<Task *, GASNetHSL> task_queue;
       ProfilingGauges::AbsoluteRangeGauge<int> *ready_task_count;
+      TaskArgArena arg_arena;
+
+      // per-member queues (only used with group work stealing) - these are
+      //  set up in set_group_members and are read-only afterwards
+      std::vector<ThreadedTaskScheduler::TaskQueue *> member_queues;
+      std::vector<ThreadedTaskScheduler *> member_scheds;
+      std::map<Processor, ThreadedTaskScheduler::TaskQueue *> member_queue_map;
+      unsigned next_member_queue;
     };
     
     // this is generally useful to all processor implementations, so put it here
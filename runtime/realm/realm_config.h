@@ -33,6 +33,20 @@
 //define REALM_USE_KERNEL_AIO
 #endif
 
+// if set, async file I/O uses io_uring when the running kernel supports it,
+//  falling back to the above at runtime if not - the backend needs the
+//  opcode probe and IORING_OP_READ/WRITE, so require 5.6+ kernel headers
+//  (checked with linux/version.h since linux/io_uring.h drags in macros
+//  like BLOCK_SIZE from linux/fs.h)
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>) && __has_include(<linux/version.h>)
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,6,0)
+#define REALM_USE_IO_URING
+#endif
+#endif
+#endif
+
 // dynamic loading via dlfcn and a not-completely standard dladdr extension
 #define REALM_USE_DLFCN
 #define REALM_USE_DLADDR
@@ -22,7 +22,11 @@
 #include "accessor.h"
 
 #include <sys/types.h>
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
 #include <map>
+#include <limits>
 
 namespace Realm {
 
@@ -88,6 +92,16 @@ namespace Realm {
       RHS rhs;
     };
 
+    // vectorized kernels for contiguous applies and folds - the default is
+    //  to fall back to calling REDOP one element at a time
+    template <class REDOP>
+    struct ReductionKernels {
+      static bool apply(void *lhs_ptr, const void *rhs_ptr, size_t count,
+			bool exclusive) { return false; }
+      static bool fold(void *rhs1_ptr, const void *rhs2_ptr, size_t count,
+		       bool exclusive) { return false; }
+    };
+
     template <class REDOP>
     class ReductionOp : public ReductionOpUntyped {
     public:
@@ -101,6 +115,8 @@ namespace Realm {
       virtual void apply(void *lhs_ptr, const void *rhs_ptr, size_t count,
 			 bool exclusive = false) const
       {
+	if(ReductionKernels<REDOP>::apply(lhs_ptr, rhs_ptr, count, exclusive))
+	  return;
 	typename REDOP::LHS *lhs = (typename REDOP::LHS *)lhs_ptr;
 	const typename REDOP::RHS *rhs = (const typename REDOP::RHS *)rhs_ptr;
 	if(exclusive) {
@@ -116,6 +132,11 @@ namespace Realm {
 				 off_t lhs_stride, off_t rhs_stride, size_t count,
 				 bool exclusive = false) const
       {
+	// dense strides can use the contiguous kernels
+	if((lhs_stride == (off_t)sizeof(typename REDOP::LHS)) &&
+	   (rhs_stride == (off_t)sizeof(typename REDOP::RHS)) &&
+	   ReductionKernels<REDOP>::apply(lhs_ptr, rhs_ptr, count, exclusive))
+	  return;
 	char *lhs = (char *)lhs_ptr;
 	const char *rhs = (const char *)rhs_ptr;
 	if(exclusive) {
@@ -138,6 +159,8 @@ namespace Realm {
       virtual void fold(void *rhs1_ptr, const void *rhs2_ptr, size_t count,
 			bool exclusive = false) const
       {
+	if(ReductionKernels<REDOP>::fold(rhs1_ptr, rhs2_ptr, count, exclusive))
+	  return;
 	typename REDOP::RHS *rhs1 = (typename REDOP::RHS *)rhs1_ptr;
 	const typename REDOP::RHS *rhs2 = (const typename REDOP::RHS *)rhs2_ptr;
 	if(exclusive) {
@@ -153,6 +176,10 @@ namespace Realm {
 				off_t lhs_stride, off_t rhs_stride, size_t count,
 				bool exclusive = false) const
       {
+	if((lhs_stride == (off_t)sizeof(typename REDOP::RHS)) &&
+	   (rhs_stride == (off_t)sizeof(typename REDOP::RHS)) &&
+	   ReductionKernels<REDOP>::fold(lhs_ptr, rhs_ptr, count, exclusive))
+	  return;
 	char *lhs = (char *)lhs_ptr;
 	const char *rhs = (const char *)rhs_ptr;
 	if(exclusive) {
@@ -227,6 +254,188 @@ namespace Realm {
       return redop;
     }
 
+    // non-exclusive updates by the built-in reduction operators are made
+    //  under locks striped over the address space rather than with an atomic
+    //  per element: a vectorized apply takes one lock per block of
+    //  BLOCK_BYTES, and a single-element update takes the lock of the block
+    //  its element starts in, so the two can be mixed on the same instance
+    class BuiltinReductionLocks {
+    public:
+      static const size_t BLOCK_BYTES = 256;
+      static const size_t NUM_LOCKS = 1024;
+
+      static size_t block_of(const void *ptr)
+      {
+	return ((uintptr_t)ptr / BLOCK_BYTES);
+      }
+
+      static void lock_block(size_t block)
+      {
+	volatile int *l = &locks[block % NUM_LOCKS];
+	while(__sync_lock_test_and_set(l, 1))
+	  while(*l) {}
+      }
+
+      static void unlock_block(size_t block)
+      {
+	__sync_lock_release(&locks[block % NUM_LOCKS]);
+      }
+
+    protected:
+      static volatile int locks[NUM_LOCKS];  // defined in redop_simd.cc
+    };
+
+    // built-in reduction operators - these get vectorized apply and fold
+    //  kernels (chosen at runtime based on the instruction sets the CPU
+    //  supports) when used with 32/64-bit integers, floats or doubles
+    enum BuiltinReductionKind {
+      REDUCE_SUM,
+      REDUCE_MAX,
+      REDUCE_MIN
+    };
+
+    template <BuiltinReductionKind KIND, typename T>
+    class BuiltinReduction {
+    public:
+      typedef T LHS;
+      typedef T RHS;
+
+      static const RHS identity;
+
+      static T combine(T a, T b)
+      {
+	switch(KIND) {
+	case REDUCE_SUM: return a + b;
+	case REDUCE_MAX: return ((b > a) ? b : a);
+	case REDUCE_MIN: return ((b < a) ? b : a);
+	}
+	return a;
+      }
+
+      static T make_identity(void)
+      {
+	switch(KIND) {
+	case REDUCE_SUM: return T(0);
+	case REDUCE_MAX:
+	  return (std::numeric_limits<T>::has_infinity ?
+		    -std::numeric_limits<T>::infinity() :
+		  std::numeric_limits<T>::is_integer ?
+		    std::numeric_limits<T>::min() :
+		    -std::numeric_limits<T>::max());
+	case REDUCE_MIN:
+	  return (std::numeric_limits<T>::has_infinity ?
+		    std::numeric_limits<T>::infinity() :
+		    std::numeric_limits<T>::max());
+	}
+	return T(0);
+      }
+
+      // non-exclusive updates take the block's lock (see
+      //  BuiltinReductionLocks) unless the value wouldn't change - another
+      //  update can only move the value further in the same direction, so
+      //  that stays true
+      static void atomic_combine(T& lhs, T rhs)
+      {
+	T old_val = *(volatile T *)&lhs;
+	T new_val = combine(old_val, rhs);
+	if(memcmp(&old_val, &new_val, sizeof(T)) == 0)
+	  return;
+	size_t block = BuiltinReductionLocks::block_of(&lhs);
+	BuiltinReductionLocks::lock_block(block);
+	lhs = combine(lhs, rhs);
+	BuiltinReductionLocks::unlock_block(block);
+      }
+
+      template <bool EXCL>
+      static void apply(LHS& lhs, RHS rhs)
+      {
+	if(EXCL)
+	  lhs = combine(lhs, rhs);
+	else
+	  atomic_combine(lhs, rhs);
+      }
+
+      template <bool EXCL>
+      static void fold(RHS& rhs1, RHS rhs2)
+      {
+	apply<EXCL>(rhs1, rhs2);
+      }
+
+    };
+
+    template <BuiltinReductionKind KIND, typename T>
+    /*static*/ const T BuiltinReduction<KIND,T>::identity =
+      BuiltinReduction<KIND,T>::make_identity();
+
+    template <typename T>
+    class SumReduction : public BuiltinReduction<REDUCE_SUM, T> {};
+
+    template <typename T>
+    class MaxReduction : public BuiltinReduction<REDUCE_MAX, T> {};
+
+    template <typename T>
+    class MinReduction : public BuiltinReduction<REDUCE_MIN, T> {};
+
+    // the vectorized kernels only exist for these types
+    enum BuiltinReductionType {
+      REDUCE_TYPE_NONE = -1,
+      REDUCE_TYPE_INT32,
+      REDUCE_TYPE_INT64,
+      REDUCE_TYPE_FLOAT,
+      REDUCE_TYPE_DOUBLE
+    };
+
+    // any signed integer type of the right size works (e.g. both long and
+    //  long long for 64 bits)
+    template <typename T>
+    struct BuiltinReductionTypeOf {
+      static const BuiltinReductionType value =
+	((std::numeric_limits<T>::is_integer && std::numeric_limits<T>::is_signed) ?
+	   ((sizeof(T) == 4) ? REDUCE_TYPE_INT32 :
+	    (sizeof(T) == 8) ? REDUCE_TYPE_INT64 : REDUCE_TYPE_NONE) :
+	   REDUCE_TYPE_NONE);
+    };
+    template <>
+    struct BuiltinReductionTypeOf<float> { static const BuiltinReductionType value = REDUCE_TYPE_FLOAT; };
+    template <>
+    struct BuiltinReductionTypeOf<double> { static const BuiltinReductionType value = REDUCE_TYPE_DOUBLE; };
+
+    // returns false if there is no vectorized kernel for the kind/type
+    //  (defined in redop_simd.cc)
+    bool apply_builtin_reduction(BuiltinReductionKind kind, BuiltinReductionType type,
+				 void *lhs_ptr, const void *rhs_ptr, size_t count,
+				 bool exclusive);
+
+    template <BuiltinReductionKind KIND, typename T>
+    struct BuiltinReductionKernels {
+      static bool apply(void *lhs_ptr, const void *rhs_ptr, size_t count,
+			bool exclusive)
+      {
+	if(BuiltinReductionTypeOf<T>::value == REDUCE_TYPE_NONE)
+	  return false;
+	return apply_builtin_reduction(KIND, BuiltinReductionTypeOf<T>::value,
+				       lhs_ptr, rhs_ptr, count, exclusive);
+      }
+
+      static bool fold(void *rhs1_ptr, const void *rhs2_ptr, size_t count,
+		       bool exclusive)
+      {
+	return apply(rhs1_ptr, rhs2_ptr, count, exclusive);
+      }
+    };
+
+    template <typename T>
+    struct ReductionKernels<SumReduction<T> >
+      : public BuiltinReductionKernels<REDUCE_SUM, T> {};
+
+    template <typename T>
+    struct ReductionKernels<MaxReduction<T> >
+      : public BuiltinReductionKernels<REDUCE_MAX, T> {};
+
+    template <typename T>
+    struct ReductionKernels<MinReduction<T> >
+      : public BuiltinReductionKernels<REDUCE_MIN, T> {};
+
 }; // namespace Realm
 
 //include "redop.inl"
@@ -0,0 +1,227 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// vectorized kernels for the built-in reduction operators
+
+#include "redop.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace Realm {
+
+  /*static*/ volatile int BuiltinReductionLocks::locks[BuiltinReductionLocks::NUM_LOCKS];
+
+  enum ReductionISA {
+    REDUCE_ISA_SCALAR,
+    REDUCE_ISA_AVX2,
+    REDUCE_ISA_AVX512
+  };
+
+  // the best instruction set this CPU supports, which can be lowered (e.g.
+  //  for benchmarking) by setting REALM_REDOP_ISA to one of "scalar",
+  //  "avx2" or "avx512" - there's no SSE2 tier because SSE2 is part of the
+  //  x86_64 baseline and the compiler already vectorizes the scalar path
+  //  with it
+  static ReductionISA detect_reduction_isa(void)
+  {
+    ReductionISA isa = REDUCE_ISA_SCALAR;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+      isa = REDUCE_ISA_AVX2;
+    if(__builtin_cpu_supports("avx512f"))
+      isa = REDUCE_ISA_AVX512;
+#endif
+    const char *e = getenv("REALM_REDOP_ISA");
+    if(e) {
+      ReductionISA limit = isa;
+      if(!strcmp(e, "scalar")) limit = REDUCE_ISA_SCALAR;
+      else if(!strcmp(e, "avx2")) limit = REDUCE_ISA_AVX2;
+      else if(!strcmp(e, "avx512")) limit = REDUCE_ISA_AVX512;
+      if(limit < isa)
+	isa = limit;
+    }
+    return isa;
+  }
+
+#if defined(__x86_64__) || defined(__i386__)
+  template <typename T, int BYTES>
+  struct SimdVector {
+    typedef T type __attribute__((vector_size(BYTES)));
+  };
+
+  template <BuiltinReductionKind KIND>
+  struct VectorReduction;
+
+  template <>
+  struct VectorReduction<REDUCE_SUM> {
+    template <typename V>
+    static inline __attribute__((always_inline)) void combine(V& a, const V& b)
+    {
+      a += b;
+    }
+
+  };
+
+  template <>
+  struct VectorReduction<REDUCE_MAX> {
+    template <typename V>
+    static inline __attribute__((always_inline)) void combine(V& a, const V& b)
+    {
+      a = ((b > a) ? b : a);
+    }
+  };
+
+  template <>
+  struct VectorReduction<REDUCE_MIN> {
+    template <typename V>
+    static inline __attribute__((always_inline)) void combine(V& a, const V& b)
+    {
+      a = ((b < a) ? b : a);
+    }
+  };
+
+  template <BuiltinReductionKind KIND, typename T, int BYTES>
+  static inline __attribute__((always_inline))
+  void reduce_body(T *lhs, const T *rhs, size_t count)
+  {
+    typedef typename SimdVector<T, BYTES>::type V;
+    const size_t W = BYTES / sizeof(T);
+    size_t i = 0;
+    for(; (i + W) <= count; i += W) {
+      V a, b;
+      memcpy(&a, lhs + i, BYTES);
+      memcpy(&b, rhs + i, BYTES);
+      VectorReduction<KIND>::combine(a, b);
+      memcpy(lhs + i, &a, BYTES);
+    }
+    for(; i < count; i++)
+      lhs[i] = BuiltinReduction<KIND, T>::combine(lhs[i], rhs[i]);
+  }
+
+  // a non-exclusive apply works through the destination one lock block at
+  //  a time (see BuiltinReductionLocks), so there's one lock acquire per
+  //  BLOCK_BYTES rather than an atomic update per element
+  template <BuiltinReductionKind KIND, typename T, int BYTES>
+  static inline __attribute__((always_inline))
+  void reduce_blocked(T *lhs, const T *rhs, size_t count)
+  {
+    size_t i = 0;
+    while(i < count) {
+      size_t block = BuiltinReductionLocks::block_of(lhs + i);
+      // every element that starts in this block
+      size_t n = (((block + 1) * BuiltinReductionLocks::BLOCK_BYTES) -
+		  (uintptr_t)(lhs + i) + sizeof(T) - 1) / sizeof(T);
+      if(n > (count - i))
+	n = count - i;
+      BuiltinReductionLocks::lock_block(block);
+      reduce_body<KIND, T, BYTES>(lhs + i, rhs + i, n);
+      BuiltinReductionLocks::unlock_block(block);
+      i += n;
+    }
+  }
+
+  template <BuiltinReductionKind KIND, typename T, int BYTES>
+  static inline __attribute__((always_inline))
+  void reduce_any(T *lhs, const T *rhs, size_t count, bool exclusive)
+  {
+    if(exclusive)
+      reduce_body<KIND, T, BYTES>(lhs, rhs, count);
+    else
+      reduce_blocked<KIND, T, BYTES>(lhs, rhs, count);
+  }
+
+  template <BuiltinReductionKind KIND, typename T>
+  static void reduce_scalar(void *lhs, const void *rhs, size_t count,
+			    bool exclusive)
+  {
+    reduce_any<KIND, T, sizeof(T)>((T *)lhs, (const T *)rhs, count, exclusive);
+  }
+
+  template <BuiltinReductionKind KIND, typename T>
+  __attribute__((target("avx2")))
+  static void reduce_avx2(void *lhs, const void *rhs, size_t count,
+			  bool exclusive)
+  {
+    reduce_any<KIND, T, 32>((T *)lhs, (const T *)rhs, count, exclusive);
+  }
+
+  template <BuiltinReductionKind KIND, typename T>
+  __attribute__((target("avx512f")))
+  static void reduce_avx512(void *lhs, const void *rhs, size_t count,
+			    bool exclusive)
+  {
+    reduce_any<KIND, T, 64>((T *)lhs, (const T *)rhs, count, exclusive);
+  }
+
+  template <BuiltinReductionKind KIND, typename T>
+  static bool reduce_isa(ReductionISA isa, void *lhs, const void *rhs,
+			 size_t count, bool exclusive)
+  {
+    switch(isa) {
+    case REDUCE_ISA_AVX2:
+      reduce_avx2<KIND, T>(lhs, rhs, count, exclusive);
+      return true;
+    case REDUCE_ISA_AVX512:
+      reduce_avx512<KIND, T>(lhs, rhs, count, exclusive);
+      return true;
+    default:
+      // an exclusive scalar apply is no better than the generic loop, but
+      //  a non-exclusive one still saves the per-element lock
+      if(exclusive)
+	return false;
+      reduce_scalar<KIND, T>(lhs, rhs, count, exclusive);
+      return true;
+    }
+  }
+
+  template <typename T>
+  static bool reduce_kind(BuiltinReductionKind kind, ReductionISA isa,
+			  void *lhs, const void *rhs, size_t count,
+			  bool exclusive)
+  {
+    switch(kind) {
+    case REDUCE_SUM: return reduce_isa<REDUCE_SUM, T>(isa, lhs, rhs, count, exclusive);
+    case REDUCE_MAX: return reduce_isa<REDUCE_MAX, T>(isa, lhs, rhs, count, exclusive);
+    case REDUCE_MIN: return reduce_isa<REDUCE_MIN, T>(isa, lhs, rhs, count, exclusive);
+    }
+    return false;
+  }
+#endif
+
+  bool apply_builtin_reduction(BuiltinReductionKind kind, BuiltinReductionType type,
+			       void *lhs_ptr, const void *rhs_ptr, size_t count,
+			       bool exclusive)
+  {
+    static const ReductionISA isa = detect_reduction_isa();
+#if defined(__x86_64__) || defined(__i386__)
+    switch(type) {
+    case REDUCE_TYPE_INT32:
+      return reduce_kind<int32_t>(kind, isa, lhs_ptr, rhs_ptr, count, exclusive);
+    case REDUCE_TYPE_INT64:
+      return reduce_kind<int64_t>(kind, isa, lhs_ptr, rhs_ptr, count, exclusive);
+    case REDUCE_TYPE_FLOAT:
+      return reduce_kind<float>(kind, isa, lhs_ptr, rhs_ptr, count, exclusive);
+    case REDUCE_TYPE_DOUBLE:
+      return reduce_kind<double>(kind, isa, lhs_ptr, rhs_ptr, count, exclusive);
+    default:
+      break;
+    }
+#endif
+    return false;
+  }
+
+}; // namespace Realm
@@ -429,13 +429,10 @@ namespace Realm {
         int *payload = (int*)malloc(payload_size);
 	int *pos = payload;
 	*pos++ = waiter_count;
-	// TODO: switch to iterator
-        ReservationImpl::PackFunctor functor(pos);
-        copy_waiters.map(functor);
-        pos = functor.pos;
-	//for(int i = 0; i < MAX_NUM_NODES; i++)
-	//  if(copy_waiters.contains(i))
-	//    *pos++ = i;
+	for(NodeSet::const_iterator it = copy_waiters.begin();
+	    it != copy_waiters.end();
+	    ++it)
+	  *pos++ = *it;
         memcpy(pos, impl->local_data, impl->local_data_size);
 	LockGrantMessage::send_request(grant_target, args.lock,
 				       0, // always grant exclusive for now
@@ -840,9 +837,7 @@ namespace Realm {
 	// case 3: we can grant to a remote waiter (if any) if we don't expect any local retries
 	if(!remote_waiter_mask.empty() && retry_count.empty()) {
 	  // nobody local wants it, but another node does
-	  //HACK int new_owner = remote_waiter_mask.find_first_set();
-	  // TODO: use iterator - all we need is *begin()
-          int new_owner = 0;  while(!remote_waiter_mask.contains(new_owner)) new_owner++;
+	  int new_owner = *(remote_waiter_mask.begin());
           remote_waiter_mask.remove(new_owner);
 
 #ifdef RSRV_DEBUG_MSGS
@@ -886,13 +881,10 @@ namespace Realm {
         int *payload = (int*)malloc(payload_size);
 	int *pos = payload;
 	*pos++ = waiter_count;
-	// TODO: switch to iterator
-        PackFunctor functor(pos);
-        copy_waiters.map(functor);
-        pos = functor.pos;
-	//for(int i = 0; i < MAX_NUM_NODES; i++)
-	//  if(copy_waiters.contains(i))
-	//    *pos++ = i;
+	for(NodeSet::const_iterator it = copy_waiters.begin();
+	    it != copy_waiters.end();
+	    ++it)
+	  *pos++ = *it;
         memcpy(pos, local_data, local_data_size);
 	LockGrantMessage::send_request(grant_target, me,
 				       0, // TODO: figure out shared cases
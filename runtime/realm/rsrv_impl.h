@@ -24,6 +24,9 @@
 #include "activemsg.h"
 #include "nodeset.h"
 
+#include <deque>
+#include <map>
+
 //define REALM_RSRV_USE_CIRCQUEUE
 #ifdef REALM_RSRV_USE_CIRCQUEUE
 #include "circ_queue.h"
@@ -125,15 +128,6 @@ namespace Realm {
       bool is_locked(unsigned check_mode, bool excl_ok);
 
       void release_reservation(void);
-
-      struct PackFunctor {
-      public:
-        PackFunctor(int *p) : pos(p) { }
-      public:
-        inline void apply(int target) { *pos++ = target; }
-      public:
-        int *pos;
-      };
     };
 
     template <typename T>
@@ -737,6 +737,8 @@ namespace Realm {
       stack_size_in_mb = 2;
       //unsigned cpu_worker_threads = 1;
       unsigned dma_worker_threads = 1;
+      // 0 = size the partitioning pool from the core count
+      unsigned dp_worker_threads = 0;
       unsigned active_msg_worker_threads = 1;
       unsigned active_msg_handler_threads = 1;
 #ifdef EVENT_TRACING
@@ -753,6 +755,10 @@ namespace Realm {
       // are hyperthreads considered to share a physical core
       bool hyperthread_sharing = true;
       bool pin_dma_threads = false;
+      // parallel copy threads (per NUMA domain) for large local copies
+      int memcpy_threads = 0;
+      size_t memcpy_chunk_size = 1 << 20;
+      size_t memcpy_nt_threshold = 0; // 0 = size of last-level cache
 
       CommandLineParser cp;
       cp.add_option_int("-ll:gsize", gasnet_mem_size_in_mb)
@@ -761,7 +767,11 @@ namespace Realm {
 	.add_option_int("-ll:dsize", disk_mem_size_in_mb)
 	.add_option_int("-ll:stacksize", stack_size_in_mb)
 	.add_option_int("-ll:dma", dma_worker_threads)
+	.add_option_int("-ll:dpworkers", dp_worker_threads)
         .add_option_bool("-ll:pin_dma", pin_dma_threads)
+	.add_option_int("-ll:memcpy_threads", memcpy_threads)
+	.add_option_int("-ll:memcpy_chunk", memcpy_chunk_size)
+	.add_option_int("-ll:memcpy_nt", memcpy_nt_threshold)
 	.add_option_int("-ll:amsg", active_msg_worker_threads)
 	.add_option_int("-ll:ahandlers", active_msg_handler_threads)
 	.add_option_int("-ll:dummy_rsrv_ok", dummy_reservation_ok)
@@ -781,6 +791,12 @@ namespace Realm {
 #endif
 
       cp.add_option_int("-realm:eventloopcheck", Config::event_loop_detection_limit);
+      cp.add_option_bool("-ll:alloc_high", Config::mem_alloc_high);
+      cp.add_option_bool("-ll:group_steal", Config::group_work_stealing);
+      cp.add_option_int("-ll:batch_triggers", Config::batch_event_triggers);
+      cp.add_option_int("-ll:io_uring", Config::use_io_uring);
+      cp.add_option_bool("-ll:io_sqpoll", Config::io_uring_sqpoll);
+      cp.add_option_bool("-ll:io_fixed_sysmem", Config::io_uring_fixed_sysmem);
 
       // these are actually parsed in activemsg.cc, but consume them here for now
       size_t dummy = 0;
@@ -846,6 +862,9 @@ namespace Realm {
         gasnet_exit(1);
       }
 
+      // node sets only need to be able to name the nodes we actually have
+      NodeSet::configure(gasnet_nodes());
+
       core_map = CoreMap::discover_core_map(hyperthread_sharing);
       core_reservations = new CoreReservationSet(core_map);
 
@@ -864,6 +883,7 @@ namespace Realm {
       hcount += EventSubscribeMessage::Message::add_handler_entries(&handlers[hcount], "Event Subscribe AM");
       hcount += EventTriggerMessage::Message::add_handler_entries(&handlers[hcount], "Event Trigger AM");
       hcount += EventUpdateMessage::Message::add_handler_entries(&handlers[hcount], "Event Update AM");
+      hcount += EventUpdateBatchMessage::Message::add_handler_entries(&handlers[hcount], "Event Update Batch AM");
       hcount += RemoteMemAllocRequest::Request::add_handler_entries(&handlers[hcount], "Remote Memory Allocation Request AM");
       hcount += RemoteMemAllocRequest::Response::add_handler_entries(&handlers[hcount], "Remote Memory Allocation Response AM");
       hcount += CreateInstanceRequest::Request::add_handler_entries(&handlers[hcount], "Create Instance Request AM");
@@ -891,6 +911,8 @@ namespace Realm {
       hcount += BarrierSubscribeMessage::Message::add_handler_entries(&handlers[hcount], "Barrier Subscribe AM");
       hcount += BarrierTriggerMessage::Message::add_handler_entries(&handlers[hcount], "Barrier Trigger AM");
       hcount += BarrierMigrationMessage::Message::add_handler_entries(&handlers[hcount], "Barrier Migration AM");
+      hcount += BarrierCombineMessage::Message::add_handler_entries(&handlers[hcount], "Barrier Combine AM");
+      hcount += BarrierCombineAckMessage::Message::add_handler_entries(&handlers[hcount], "Barrier Combine Ack AM");
       hcount += MetadataRequestMessage::Message::add_handler_entries(&handlers[hcount], "Metadata Request AM");
       hcount += MetadataResponseMessage::Message::add_handler_entries(&handlers[hcount], "Metadata Response AM");
       hcount += MetadataInvalidateMessage::Message::add_handler_entries(&handlers[hcount], "Metadata Invalidate AM");
@@ -991,6 +1013,8 @@ namespace Realm {
       LegionRuntime::LowLevel::start_dma_worker_threads(dma_worker_threads,
                                                         *core_reservations);
 
+      start_partitioning_workers(dp_worker_threads, *core_reservations);
+
 #ifdef EVENT_TRACING
       // Always initialize even if we won't dump to file, otherwise segfaults happen
       // when we try to save event info
@@ -1094,7 +1118,10 @@ namespace Realm {
       // since we need list of local gpus to create channels
       LegionRuntime::LowLevel::start_dma_system(dma_worker_threads,
                                                 pin_dma_threads, 100
-                                                ,*core_reservations);
+                                                ,*core_reservations,
+                                                memcpy_threads,
+                                                memcpy_chunk_size,
+                                                memcpy_nt_threshold);
 
       // now that we've created all the processors/etc., we can try to come up with core
       //  allocations that satisfy everybody's requirements - this will also start up any
@@ -1760,6 +1787,7 @@ namespace Realm {
 
       // threads that cause inter-node communication have to stop first
       LegionRuntime::LowLevel::stop_dma_worker_threads();
+      stop_partitioning_workers();
       LegionRuntime::LowLevel::stop_dma_system();
       stop_activemsg_threads();
 
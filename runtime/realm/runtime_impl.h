@@ -82,8 +82,10 @@ namespace Realm {
       static Processor make_id(const ProcessorGroup& dummy, int owner, int index) { return ID::make_procgroup(owner, 0, index).convert<Processor>(); }
       static IndexSpace make_id(const IndexSpaceImpl& dummy, int owner, int index) { return ID::make_idxspace(owner, 0, index).convert<IndexSpace>(); }
       
+      // the table links a new leaf's entries into the free list (if any)
+      //  once it has been installed
       static LEAF_TYPE *new_leaf_node(IT first_index, IT last_index, 
-				      int owner, FreeList *free_list)
+				      int owner)
       {
 	LEAF_TYPE *leaf = new LEAF_TYPE(0, first_index, last_index);
 	IT last_ofs = (((IT)1) << LEAF_BITS) - 1;
@@ -91,20 +93,6 @@ namespace Realm {
 	  leaf->elems[i].init(make_id(leaf->elems[0], owner, first_index + i), owner);
 	  //leaf->elems[i].init(ID(ET::ID_TYPE, owner, first_index + i).convert<typeof(leaf->elems[0].me)>(), owner);
 
-	if(free_list) {
-	  // stitch all the new elements into the free list
-	  free_list->lock.lock();
-
-	  for(IT i = 0; i <= last_ofs; i++)
-	    leaf->elems[i].next_free = ((i < last_ofs) ? 
-					  &(leaf->elems[i+1]) :
-					  free_list->first_free);
-
-	  free_list->first_free = &(leaf->elems[first_index ? 0 : 1]);
-
-	  free_list->lock.unlock();
-	}
-
 	return leaf;
       }
     };
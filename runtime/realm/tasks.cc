@@ -24,6 +24,71 @@ namespace Realm {
   Logger log_task("task");
   Logger log_sched("sched");
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class TaskArgArena
+  //
+
+  TaskArgArena::TaskArgArena(void)
+  {}
+
+  TaskArgArena::~TaskArgArena(void)
+  {
+    for(int i = 0; i < NUM_SIZE_CLASSES; i++) {
+      while(classes[i].free_list) {
+	BlockHeader *h = classes[i].free_list;
+	classes[i].free_list = h->next_free;
+	::free(h);
+      }
+    }
+  }
+
+  void *TaskArgArena::alloc(size_t bytes)
+  {
+    int size_class = 0;
+    size_t block_size = MIN_BLOCK_SIZE;
+    while(block_size < bytes) {
+      if(++size_class >= NUM_SIZE_CLASSES)
+	return 0;
+      block_size <<= 1;
+    }
+
+    SizeClass& sc = classes[size_class];
+    BlockHeader *h = 0;
+    {
+      AutoHSLLock al(sc.mutex);
+      if(sc.free_list) {
+	h = sc.free_list;
+	sc.free_list = h->next_free;
+	sc.free_count--;
+      }
+    }
+    if(!h) {
+      h = (BlockHeader *)malloc(sizeof(BlockHeader) + block_size);
+      assert(h != 0);
+      h->size_class = size_class;
+    }
+    return (h + 1);
+  }
+
+  void TaskArgArena::free(void *ptr)
+  {
+    BlockHeader *h = ((BlockHeader *)ptr) - 1;
+    SizeClass& sc = classes[h->size_class];
+    {
+      AutoHSLLock al(sc.mutex);
+      if(sc.free_count < MAX_FREE_BLOCKS) {
+	h->next_free = sc.free_list;
+	sc.free_list = h;
+	sc.free_count++;
+	return;
+      }
+    }
+    // too many spare blocks of this size already
+    ::free(h);
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class Task
@@ -33,11 +98,27 @@ namespace Realm {
 	     const void *_args, size_t _arglen,
 	     const ProfilingRequestSet &reqs,
 	     Event _before_event,
-	     Event _finish_event, int _priority)
+	     Event _finish_event, int _priority,
+	     TaskArgArena *_arg_arena /*= 0*/)
     : Operation(_finish_event, reqs), proc(_proc), func_id(_func_id),
-      args(_args, _arglen), before_event(_before_event), priority(_priority),
-      executing_thread(0)
+      before_event(_before_event), priority(_priority),
+      executing_thread(0), arg_arena(_arg_arena), arena_args(0), heap_args(0)
   {
+    // small arguments (the common case) are copied into the Task itself, and
+    //  larger ones into the processor's arena if it has a block big enough
+    void *storage = inline_args.bytes;
+    if(_arglen > INLINE_ARG_BYTES) {
+      if(arg_arena)
+	storage = arena_args = arg_arena->alloc(_arglen);
+      if(!arena_args) {
+	storage = heap_args = malloc(_arglen);
+	assert(heap_args != 0);
+      }
+    }
+    if(_arglen > 0)
+      memcpy(storage, _args, _arglen);
+    args.changeref(storage, _arglen);
+
     log_task.info() << "task " << (void *)this << " created: func=" << func_id
 		    << " proc=" << _proc << " arglen=" << _arglen
 		    << " before=" << _before_event << " after=" << _finish_event;
@@ -45,6 +126,21 @@ namespace Realm {
 
   Task::~Task(void)
   {
+    // normally done at completion, but not every task gets that far
+    release_args();
+  }
+
+  void Task::release_args(void)
+  {
+    if(arena_args) {
+      arg_arena->free(arena_args);
+      arena_args = 0;
+    }
+    if(heap_args) {
+      free(heap_args);
+      heap_args = 0;
+    }
+    args.changeref(0, 0);
   }
 
   void Task::print(std::ostream& os) const
@@ -73,6 +169,9 @@ namespace Realm {
     log_task.info() << "task " << (void *)this << " completed: func=" << func_id
 		    << " proc=" << proc << " arglen=" << args.size()
 		    << " before=" << before_event << " after=" << finish_event;
+    // nothing looks at the arguments after this, so recycle them now rather
+    //  than waiting for the last reference to the task to go away
+    release_args();
     Operation::mark_completed();
   }
 
@@ -350,6 +449,17 @@ namespace Realm {
     queue->add_subscription(&wcu_task_queues);
   }
 
+  void ThreadedTaskScheduler::add_steal_queue(TaskQueue *queue)
+  {
+    AutoHSLLock al(lock);
+
+    steal_queues.push_back(queue);
+
+    // we want to hear about new work here too, so that an idle worker can
+    //  come and take it
+    queue->add_subscription(&wcu_task_queues);
+  }
+
   // helper for tracking/sanity-checking worker counts
   inline void ThreadedTaskScheduler::update_worker_count(int active_delta,
 							 int unassigned_delta,
@@ -565,6 +675,28 @@ namespace Realm {
 	  }
 	}
 
+	// then see if anybody we can steal from has something better - the
+	//  empty() check is lock-free, so we only touch another queue's lock
+	//  when it has work we actually want
+	for(std::vector<TaskQueue *>::const_iterator it = steal_queues.begin();
+	    it != steal_queues.end();
+	    it++) {
+	  if((*it)->empty(task_priority))
+	    continue;
+	  int new_priority;
+	  Task *new_task = (*it)->get(&new_priority, task_priority);
+	  if(new_task) {
+	    if(task)
+	      task_source->put(task, task_priority, false); // back on front of list
+
+	    log_sched.debug() << "task stolen: sched=" << this << " task=" << new_task
+			      << " priority=" << new_priority;
+	    task = new_task;
+	    task_source = *it;
+	    task_priority = new_priority;
+	  }
+	}
+
 	// did we find work to do?
 	if(task) {
 	  // we've now got some assigned work, so fire up a new idle worker if we were the last
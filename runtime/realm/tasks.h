@@ -30,6 +30,41 @@
 
 namespace Realm {
 
+    // a per-processor pool of buffers for task arguments that are too big to
+    //  be stored inline in a Task - buffers come in power-of-two size classes
+    //  and are handed back when the task completes rather than freed, so the
+    //  steady state of a processor's task stream does no heap allocation
+    class TaskArgArena {
+    public:
+      TaskArgArena(void);
+      ~TaskArgArena(void);
+
+      // returns 0 if 'bytes' is larger than the biggest size class
+      void *alloc(size_t bytes);
+      void free(void *ptr);
+
+      static const size_t MIN_BLOCK_SIZE = 128;
+      static const int NUM_SIZE_CLASSES = 6;  // 128B - 4KB
+      static const size_t MAX_FREE_BLOCKS = 256;  // kept per size class
+
+    protected:
+      // sits in front of every block - keeps the payload 16B-aligned
+      struct BlockHeader {
+	BlockHeader *next_free;
+	int size_class;
+	int pad;
+      };
+
+      struct SizeClass {
+	SizeClass(void) : free_list(0), free_count(0) {}
+	GASNetHSL mutex;
+	BlockHeader *free_list;
+	size_t free_count;
+      };
+
+      SizeClass classes[NUM_SIZE_CLASSES];
+    };
+
     // information for a task launch
     class Task : public Operation {
     public:
@@ -38,7 +73,8 @@ namespace Realm {
 	   const void *_args, size_t _arglen,
            const ProfilingRequestSet &reqs,
 	   Event _before_event,
-	   Event _finish_event, int _priority);
+	   Event _finish_event, int _priority,
+	   TaskArgArena *_arg_arena = 0);
 
     protected:
       // deletion performed when reference count goes to zero
@@ -56,14 +92,30 @@ namespace Realm {
 
       Processor proc;
       Processor::TaskFuncID func_id;
-      ByteArray args;
+      ByteArrayRef args;
       Event before_event;
       int priority;
 
+      // arguments up to this size are stored in the Task itself
+      static const size_t INLINE_ARG_BYTES = 64;
+
     protected:
       virtual void mark_completed(void);
 
+      // returns the argument storage once the task no longer needs it
+      void release_args(void);
+
       Thread *executing_thread;
+
+      // larger arguments live in an arena block (if the arena has a big
+      //  enough size class) or on the heap
+      TaskArgArena *arg_arena;
+      void *arena_args;
+      void *heap_args;
+      union {
+	char bytes[INLINE_ARG_BYTES];
+	long double align;  // same alignment as malloc would give us
+      } inline_args;
     };
 
     // a task scheduler in which one or more worker threads execute tasks from one
@@ -82,6 +134,11 @@ namespace Realm {
 
       virtual void add_task_queue(TaskQueue *queue);
 
+      // a steal queue belongs to some other scheduler - this scheduler only
+      //  takes work from it when it holds a higher-priority task than
+      //  anything in our own queues
+      virtual void add_steal_queue(TaskQueue *queue);
+
       virtual void start(void) = 0;
       virtual void shutdown(void) = 0;
 
@@ -107,6 +164,7 @@ namespace Realm {
 
       GASNetHSL lock;
       std::vector<TaskQueue *> task_queues;
+      std::vector<TaskQueue *> steal_queues;
       std::vector<Thread *> idle_workers;
       std::set<Thread *> blocked_workers;
 
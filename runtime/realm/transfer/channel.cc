@@ -18,6 +18,15 @@
 #include "channel_disk.h"
 #include "logger_message_descriptor.h"
 
+#include <time.h>
+#include <errno.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#else
+#include <sys/time.h>
+#endif
+
 namespace LegionRuntime {
   namespace LowLevel {
     Logger::Category log_new_dma("new_dma");
@@ -51,6 +60,16 @@ namespace LegionRuntime {
         }
       }
 
+      void XferDes::notify_progress()
+      {
+        // only the first notification since the DMA thread last looked at
+        // us needs to go in the queue
+        if (__sync_bool_compare_and_swap(&wakeup_state, (int)WAKEUP_IDLE, (int)WAKEUP_QUEUED)) {
+          assert(dma_thread != NULL);
+          dma_thread->post_wakeup(this);
+        }
+      }
+
       static inline off_t calc_mem_loc_ib(off_t alloc_offset,
                                           off_t field_start,
                                           int field_size,
@@ -318,6 +337,7 @@ namespace LegionRuntime {
         else
           simple_update_bytes_write(req->dst_off, req->nbytes * req->nlines);
         enqueue_request(req);
+        notify_progress();
       }
 
       template<unsigned DIM>
@@ -937,6 +957,7 @@ namespace LegionRuntime {
         H5Sclose(hdf_req->file_space_id);
         //pthread_rwlock_unlock(&hdf_metadata->hdf_memory->rwlock);
         enqueue_request(req);
+        notify_progress();
       }
 
       template<unsigned DIM>
@@ -996,12 +1017,13 @@ namespace LegionRuntime {
         channel->stop();
       }
 
-      MemcpyChannel::MemcpyChannel(long max_nr)
+      MemcpyChannel::MemcpyChannel(long max_nr, MemcpyEngine *_engine)
       {
         kind = XferDes::XFER_MEM_CPY;
         capacity = max_nr;
         is_stopped = false;
         sleep_threads = false;
+        engine = _engine;
         pthread_mutex_init(&pending_lock, NULL);
         pthread_mutex_init(&finished_lock, NULL);
         pthread_cond_init(&pending_cond, NULL);
@@ -1055,7 +1077,15 @@ namespace LegionRuntime {
         MemcpyRequest** mem_cpy_reqs = (MemcpyRequest**) requests;
         for (long i = 0; i < nr; i++) {
           MemcpyRequest* req = mem_cpy_reqs[i];
-          if (req->dim == Request::DIM_1D) {
+          if (engine) {
+            // let the engine split large copies across its threads
+            Memory dst_mem = req->xd->dst_buf.memory;
+            if (req->dim == Request::DIM_1D)
+              engine->copy_1d(dst_mem, req->dst_base, req->src_base, req->nbytes);
+            else
+              engine->copy_2d(dst_mem, req->dst_base, req->src_base, req->nbytes,
+                              req->dst_str, req->src_str, req->nlines);
+          } else if (req->dim == Request::DIM_1D) {
             memcpy(req->dst_base, req->src_base, req->nbytes);
           } else {
             assert(req->dim == Request::DIM_2D);
@@ -1320,6 +1350,11 @@ namespace LegionRuntime {
       {
         return capacity - pending_copies.size();
       }
+
+      bool GPUChannel::needs_pull()
+      {
+        return !pending_copies.empty();
+      }
 #endif
 
 #ifdef USE_HDF
@@ -1374,9 +1409,11 @@ namespace LegionRuntime {
       void XferDesRemoteWriteAckMessage::handle_request(RequestArgs args)
       {
         RemoteWriteRequest* req = args.req;
+        // give the slot back first - the notifications below wake up the
+        // DMA thread, which needs to see the slot as available
+        channel_manager->get_remote_write_channel()->notify_completion();
         req->xd->notify_request_read_done(req);
         req->xd->notify_request_write_done(req);
-        channel_manager->get_remote_write_channel()->notify_completion();
       }
 
       /*static*/
@@ -1442,72 +1479,272 @@ namespace LegionRuntime {
         xferDes_queue->update_next_bytes_read(args.guid, args.bytes_read);
       }
 
+      DMADoorbell::DMADoorbell()
+        : state(STATE_IDLE)
+      {
+#ifndef __linux__
+        pthread_mutex_init(&mutex, NULL);
+        pthread_cond_init(&cond, NULL);
+#endif
+      }
+
+      DMADoorbell::~DMADoorbell()
+      {
+#ifndef __linux__
+        pthread_mutex_destroy(&mutex);
+        pthread_cond_destroy(&cond);
+#endif
+      }
+
+      void DMADoorbell::ring()
+      {
+        int prev = __sync_lock_test_and_set(&state, (int)STATE_RUNG);
+        if (prev == STATE_SLEEPING) {
+#ifdef __linux__
+          syscall(SYS_futex, (int *)&state, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+          pthread_mutex_lock(&mutex);
+          pthread_cond_signal(&cond);
+          pthread_mutex_unlock(&mutex);
+#endif
+        }
+      }
+
+      void DMADoorbell::wait(long max_usec)
+      {
+        // a ring that came in while we were busy means don't sleep at all
+        if (__sync_bool_compare_and_swap(&state, (int)STATE_RUNG, (int)STATE_IDLE))
+          return;
+        if (!__sync_bool_compare_and_swap(&state, (int)STATE_IDLE, (int)STATE_SLEEPING)) {
+          // rung just now
+          __sync_lock_test_and_set(&state, (int)STATE_IDLE);
+          return;
+        }
+#ifdef __linux__
+        struct timespec ts, *tsp = NULL;
+        if (max_usec > 0) {
+          ts.tv_sec = max_usec / 1000000;
+          ts.tv_nsec = (max_usec % 1000000) * 1000;
+          tsp = &ts;
+        }
+        // returns right away if the state is no longer STATE_SLEEPING
+        syscall(SYS_futex, (int *)&state, FUTEX_WAIT_PRIVATE, (int)STATE_SLEEPING, tsp, NULL, 0);
+#else
+        pthread_mutex_lock(&mutex);
+        if (state == STATE_SLEEPING) {
+          if (max_usec > 0) {
+            struct timeval now;
+            gettimeofday(&now, NULL);
+            long long nsec = ((long long)now.tv_usec + max_usec) * 1000;
+            struct timespec abstime;
+            abstime.tv_sec = now.tv_sec + nsec / 1000000000LL;
+            abstime.tv_nsec = nsec % 1000000000LL;
+            pthread_cond_timedwait(&cond, &mutex, &abstime);
+          } else
+            pthread_cond_wait(&cond, &mutex);
+        }
+        pthread_mutex_unlock(&mutex);
+#endif
+        // rung or timed out, we're awake either way
+        __sync_lock_test_and_set(&state, (int)STATE_IDLE);
+      }
+
+      void XferDesReadyList::insert(XferDes* xd)
+      {
+        assert(!xd->in_ready_list);
+        // walk back from the tail past anything with a larger priority -
+        // usually everything has the same priority and this is O(1)
+        XferDes* prev = tail;
+        while ((prev != NULL) && (prev->priority > xd->priority))
+          prev = prev->ready_prev;
+        xd->ready_prev = prev;
+        xd->ready_next = (prev != NULL) ? prev->ready_next : head;
+        if (xd->ready_next != NULL)
+          xd->ready_next->ready_prev = xd;
+        else
+          tail = xd;
+        if (prev != NULL)
+          prev->ready_next = xd;
+        else
+          head = xd;
+        xd->in_ready_list = true;
+      }
+
+      void XferDesReadyList::remove(XferDes* xd)
+      {
+        assert(xd->in_ready_list);
+        if (xd->ready_prev != NULL)
+          xd->ready_prev->ready_next = xd->ready_next;
+        else
+          head = xd->ready_next;
+        if (xd->ready_next != NULL)
+          xd->ready_next->ready_prev = xd->ready_prev;
+        else
+          tail = xd->ready_prev;
+        xd->ready_prev = xd->ready_next = NULL;
+        xd->in_ready_list = false;
+      }
+
+      void DMAThread::post_wakeup(XferDes* xd)
+      {
+        XferDes* old_head = wakeup_head;
+        while (true) {
+          xd->wakeup_next = old_head;
+          XferDes* prev = __sync_val_compare_and_swap(&wakeup_head, old_head, xd);
+          if (prev == old_head)
+            break;
+          old_head = prev;
+        }
+        doorbell.ring();
+      }
+
+      bool DMAThread::drain_wakeups()
+      {
+        XferDes* xd = __sync_lock_test_and_set(&wakeup_head, (XferDes*)NULL);
+        if (xd == NULL)
+          return false;
+        // the queue is a stack, so reverse it to keep arrival order
+        XferDes* in_order = NULL;
+        while (xd != NULL) {
+          XferDes* next = xd->wakeup_next;
+          xd->wakeup_next = in_order;
+          in_order = xd;
+          xd = next;
+        }
+        while (in_order != NULL) {
+          xd = in_order;
+          // read the link before clearing the state - once it's idle, another
+          // thread can queue it again
+          in_order = xd->wakeup_next;
+          if (!__sync_bool_compare_and_swap(&xd->wakeup_state,
+                                            (int)XferDes::WAKEUP_QUEUED,
+                                            (int)XferDes::WAKEUP_IDLE)) {
+            // retired while queued - let finish_xferdes know we're done
+            // with it
+            assert(xd->wakeup_state == XferDes::WAKEUP_RETIRED);
+            xd->wakeup_state = XferDes::WAKEUP_DEQUEUED;
+            continue;
+          }
+          if (!xd->in_ready_list) {
+            std::map<Channel*, XferDesReadyList*>::iterator it;
+            it = channel_to_xd_pool.find(xd->channel);
+            assert(it != channel_to_xd_pool.end());
+            it->second->insert(xd);
+          }
+        }
+        return true;
+      }
+
+      void DMAThread::finish_xferdes(XferDes* xd)
+      {
+        // once retired, nobody can queue this XferDes again - if it's still
+        // in the wakeup queue, get it out of there before it gets destroyed
+        // the notifier marks it queued before pushing it, so it may not be
+        // on the stack yet - keep draining until we've actually popped it
+        // or post_wakeup would push a pointer to a deleted XferDes
+        int prev = __sync_lock_test_and_set(&xd->wakeup_state, (int)XferDes::WAKEUP_RETIRED);
+        if (prev == XferDes::WAKEUP_QUEUED) {
+          while (true) {
+            drain_wakeups();
+            __sync_synchronize();
+            if (xd->wakeup_state == XferDes::WAKEUP_DEQUEUED)
+              break;
+          }
+        }
+        // We flush all changes into destination before mark this XferDes as completed
+        xd->flush();
+        log_new_dma.info("Finish XferDes : id(" IDFMT ")", xd->guid);
+        // We eagerly free intermediate buffers here for better performance
+        if(xd->src_buf.is_ib) {
+          free_intermediate_buffer(xd->dma_request,
+                                   xd->src_buf.memory,
+                                   xd->src_buf.alloc_offset,
+                                   xd->src_buf.buf_size);
+        }
+        xd->mark_completed();
+      }
+
+      // number of passes that make no progress before a DMA thread sleeps
+      static const int DMA_IDLE_SPIN_PASSES = 4;
+      // longest a DMA thread sleeps between polls of a channel with requests
+      //  in flight
+      static const long DMA_MAX_POLL_USEC = 64;
+
       void DMAThread::dma_thread_loop()
       {
         log_new_dma.info("start dma thread loop");
+        int idle_passes = 0;
         while (!is_stopped) {
-          bool is_empty = true;
-          std::map<Channel*, PriorityXferDesQueue*>::iterator it;
-          for (it = channel_to_xd_pool.begin(); it != channel_to_xd_pool.end(); it++) {
-            if(!it->second->empty()) {
-              is_empty = false;
-              break;
-            }
-          }
-          xd_queue->dequeue_xferDes(this, is_empty);
+          // new XferDes and ones that might be able to move again
+          bool progress = drain_wakeups();
+          bool polling = false;
 
+          std::map<Channel*, XferDesReadyList*>::iterator it;
           for (it = channel_to_xd_pool.begin(); it != channel_to_xd_pool.end(); it++) {
-            it->first->pull();
-            long nr = it->first->available();
+            Channel* channel = it->first;
+            XferDesReadyList* ready = it->second;
+            // anything that completes here comes back via the wakeup queue
+            channel->pull();
+            if (channel->needs_pull())
+              polling = true;
+            if (ready->empty())
+              continue;
+            // a channel that's out of slots gets one back when a request
+            // finishes, which also wakes up that request's XferDes
+            long nr = channel->available();
             if (nr == 0)
               continue;
-            std::vector<XferDes*> finish_xferdes;
-            PriorityXferDesQueue::iterator it2;
-            for (it2 = it->second->begin(); it2 != it->second->end(); it2++) {
-              assert((*it2)->channel == it->first);
+            XferDes* xd = ready->head;
+            while ((xd != NULL) && (nr > 0)) {
+              XferDes* next_xd = xd->ready_next;
+              assert(xd->channel == channel);
               // If we haven't mark started and we are the first xd, mark start
-              if ((*it2)->mark_start) {
-                (*it2)->dma_request->mark_started();
-                (*it2)->mark_start = false;
+              if (xd->mark_start) {
+                xd->dma_request->mark_started();
+                xd->mark_start = false;
               }
               // Do nothing for empty copies
-              if ((*it2)->bytes_total ==0) {
-                finish_xferdes.push_back(*it2);
+              if (xd->bytes_total == 0) {
+                ready->remove(xd);
+                finish_xferdes(xd);
+                progress = true;
+                xd = next_xd;
                 continue;
               }
-              long nr_got = (*it2)->get_requests(requests, min(nr, max_nr));
-              long nr_submitted = it->first->submit(requests, nr_got);
+              long nr_got = xd->get_requests(requests, min(nr, max_nr));
+              long nr_submitted = channel->submit(requests, nr_got);
               nr -= nr_submitted;
               assert(nr_got == nr_submitted);
-              if ((*it2)->is_completed()) {
-                finish_xferdes.push_back(*it2);
-                //printf("finish_xferdes.size() = %lu\n", finish_xferdes.size());
-              }
-              if (nr == 0)
-                break;
-            }
-            while(!finish_xferdes.empty()) {
-              XferDes *xd = finish_xferdes.back();
-              finish_xferdes.pop_back();
-              it->second->erase(xd);
-              // We flush all changes into destination before mark this XferDes as completed
-              xd->flush();
-              log_new_dma.info("Finish XferDes : id(" IDFMT ")", xd->guid);
-              // We eagerly free intermediate buffers here for better performance
-              if(xd->src_buf.is_ib) {
-                free_intermediate_buffer(xd->dma_request,
-                                         xd->src_buf.memory,
-                                         xd->src_buf.alloc_offset,
-                                         xd->src_buf.buf_size);
-              }
-              xd->mark_completed();
-              /*bool need_to_delete_dma_request = xd->mark_completed();
-              if (need_to_delete_dma_request) {
-                DmaRequest* dma_request = xd->dma_request;
-                delete dma_request;
-              }*/
+              if (xd->is_completed()) {
+                ready->remove(xd);
+                finish_xferdes(xd);
+                progress = true;
+              } else if (nr_got == 0) {
+                // nothing to do until one of its requests finishes or a
+                // neighbor in the chain moves its counters, both of which
+                // will put it back on the list
+                ready->remove(xd);
+              } else
+                progress = true;
+              xd = next_xd;
             }
+            channel->flush_submissions();
+          }
+
+          if (progress) {
+            idle_passes = 0;
+            continue;
+          }
+          if (++idle_passes <= DMA_IDLE_SPIN_PASSES)
+            continue;
+          // nothing can move right now - sleep until somebody rings, or back
+          // off gradually if there's a channel that has to be polled
+          long max_usec = 0;
+          if (polling) {
+            int shift = idle_passes - DMA_IDLE_SPIN_PASSES - 1;
+            max_usec = ((shift < 6) ? (1L << shift) : DMA_MAX_POLL_USEC);
           }
+          doorbell.wait(max_usec);
         }
         log_new_dma.info("finish dma thread loop");
       }
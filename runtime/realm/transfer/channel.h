@@ -30,6 +30,7 @@
 #include <string.h>
 #include "lowlevel.h"
 #include "lowlevel_dma.h"
+#include "memcpy_engine.h"
 
 #ifdef USE_CUDA
 #include "realm/cuda/cuda_module.h"
@@ -45,6 +46,7 @@ namespace LegionRuntime{
   namespace LowLevel{
     class XferDes;
     class Channel;
+    class DMAThread;
     
 #ifdef USE_CUDA
     typedef Realm::Cuda::GPU GPU;
@@ -517,6 +519,24 @@ namespace LegionRuntime{
       LayoutIterator* li;
       MaskEnumerator* me;
       unsigned offset_idx;
+      // DMA thread responsible for this XferDes's channel - set when the
+      // XferDes is enqueued
+      DMAThread* dma_thread;
+      // links for the channel's ready list, only touched by the DMA thread
+      XferDes *ready_prev, *ready_next;
+      bool in_ready_list;
+      // link and state for the DMA thread's wakeup queue - an XferDes is
+      // in the queue at most once, and never after it has been retired
+      // (an XferDes retired while queued is RETIRED until the DMA thread
+      // has popped it off the queue, and DEQUEUED after that)
+      XferDes* wakeup_next;
+      volatile int wakeup_state;
+      enum {
+        WAKEUP_IDLE,
+        WAKEUP_QUEUED,
+        WAKEUP_RETIRED,
+        WAKEUP_DEQUEUED
+      };
     public:
       XferDes(DmaRequest* _dma_request, gasnet_node_t _launch_node,
               XferDesID _guid, XferDesID _pre_xd_guid, XferDesID _next_xd_guid,
@@ -529,7 +549,9 @@ namespace LegionRuntime{
           domain(_domain), src_buf(_src_buf), dst_buf(_dst_buf), oas_vec(_oas_vec),
           max_req_size(_max_req_size), priority(_priority),
           guid(_guid), pre_xd_guid(_pre_xd_guid), next_xd_guid(_next_xd_guid),
-          kind (_kind), order(_order), channel(NULL), complete_fence(_complete_fence)
+          kind (_kind), order(_order), channel(NULL), complete_fence(_complete_fence),
+          dma_thread(NULL), ready_prev(NULL), ready_next(NULL), in_ready_list(false),
+          wakeup_next(NULL), wakeup_state(WAKEUP_IDLE)
       {
         size_t total_field_size = 0;
         for (unsigned i = 0; i < oas_vec.size(); i++) {
@@ -603,26 +625,37 @@ namespace LegionRuntime{
 
       void mark_completed();
 
+      // tells the owning DMA thread that this XferDes may be able to make
+      // progress again (a request finished, or a neighbor in the chain
+      // moved its byte counters)
+      void notify_progress();
+
       void update_pre_bytes_write(size_t new_val) {
         pthread_mutex_lock(&update_write_lock);
-        if (pre_bytes_write < new_val)
+        bool changed = (pre_bytes_write < new_val);
+        if (changed)
           pre_bytes_write = new_val;
         /*uint64_t old_val = pre_bytes_write;
         while (old_val < new_val) {
           pre_bytes_write.compare_exchange_strong(old_val, new_val);
         }*/
         pthread_mutex_unlock(&update_write_lock);
+        if (changed)
+          notify_progress();
       }
 
       void update_next_bytes_read(size_t new_val) {
         pthread_mutex_lock(&update_read_lock);
-        if (next_bytes_read < new_val)
+        bool changed = (next_bytes_read < new_val);
+        if (changed)
           next_bytes_read = new_val;
         /*uint64_t old_val = next_bytes_read;
         while (old_val < new_val) {
           next_bytes_read.compare_exchange_strong(old_val, new_val);
         }*/
         pthread_mutex_unlock(&update_read_lock);
+        if (changed)
+          notify_progress();
       }
 
       Request* dequeue_request() {
@@ -808,6 +841,20 @@ namespace LegionRuntime{
        * submitting requests
        */
       virtual long available() = 0;
+
+      /*
+       * Return true if requests are in flight whose completion can
+       * only be discovered by calling pull() - the DMA thread will
+       * keep polling instead of sleeping while this is true
+       */
+      virtual bool needs_pull() { return false; }
+
+      /*
+       * Called once the DMA thread has submitted everything it can to
+       * this channel in a pass - channels that batch work up in submit()
+       * hand it off here
+       */
+      virtual void flush_submissions() {}
     protected:
       // std::deque<Copy_1D> copies_1D;
       // std::deque<Copy_2D> copies_2D;
@@ -828,7 +875,8 @@ namespace LegionRuntime{
 
     class MemcpyChannel : public Channel {
     public:
-      MemcpyChannel(long max_nr);
+      // copies are split across the engine's threads if one is given
+      MemcpyChannel(long max_nr, MemcpyEngine *_engine);
       ~MemcpyChannel();
       void stop();
       void get_request(std::deque<MemcpyRequest*>& thread_queue);
@@ -843,6 +891,7 @@ namespace LegionRuntime{
       pthread_cond_t pending_cond;
       long capacity;
       bool sleep_threads;
+      MemcpyEngine *engine;
       //std::vector<MemcpyRequest*> available_cb;
       //MemcpyRequest** cbs;
     };
@@ -883,6 +932,7 @@ namespace LegionRuntime{
       long submit(Request** requests, long nr);
       void pull();
       long available();
+      bool needs_pull();
     private:
       GPU* src_gpu;
       long capacity;
@@ -924,7 +974,7 @@ namespace LegionRuntime{
       ~ChannelManager(void);
       MemcpyChannel* create_memcpy_channel(long max_nr) {
         assert(memcpy_channel == NULL);
-        memcpy_channel = new MemcpyChannel(max_nr);
+        memcpy_channel = new MemcpyChannel(max_nr, get_memcpy_engine());
         return memcpy_channel;
       }
       GASNetChannel* create_gasnet_read_channel(long max_nr) {
@@ -1048,51 +1098,68 @@ namespace LegionRuntime{
 #endif
     };
 
-    class CompareXferDes {
+    // a doorbell that a DMA thread sleeps on when none of its channels can
+    // make progress - ringing it costs a single atomic op unless the thread
+    // is actually asleep (in which case it's a futex wake on Linux)
+    class DMADoorbell {
     public:
-      bool operator() (XferDes* a, XferDes* b) {
-        if(a->priority == b->priority)
-          return (a < b);
-        else 
-          return (a->priority < b->priority);
-      }
+      DMADoorbell();
+      ~DMADoorbell();
+      void ring();
+      // returns once the bell has been rung since the last wait (or after
+      // 'max_usec' microseconds, if non-zero)
+      void wait(long max_usec);
+    protected:
+      enum {
+        STATE_IDLE,
+        STATE_RUNG,
+        STATE_SLEEPING
+      };
+      volatile int state;
+#ifndef __linux__
+      pthread_mutex_t mutex;
+      pthread_cond_t cond;
+#endif
+    };
+
+    // an intrusive list of the XferDes that might be able to make progress
+    // on a channel, kept in increasing priority order (ties in arrival order)
+    class XferDesReadyList {
+    public:
+      XferDesReadyList() : head(NULL), tail(NULL) {}
+      bool empty() const { return head == NULL; }
+      void insert(XferDes* xd);
+      void remove(XferDes* xd);
+      XferDes *head, *tail;
     };
-    //typedef std::priority_queue<XferDes*, std::vector<XferDes*>, CompareXferDes> PriorityXferDesQueue;
-    typedef std::set<XferDes*, CompareXferDes> PriorityXferDesQueue;
 
     class XferDesQueue;
     class DMAThread {
     public:
       DMAThread(long _max_nr, XferDesQueue* _xd_queue, std::vector<Channel*>& _channels) {
         for (std::vector<Channel*>::iterator it = _channels.begin(); it != _channels.end(); it ++) {
-          channel_to_xd_pool[*it] = new PriorityXferDesQueue;
+          channel_to_xd_pool[*it] = new XferDesReadyList;
         }
         xd_queue = _xd_queue;
         max_nr = _max_nr;
         is_stopped = false;
         requests = (Request**) calloc(max_nr, sizeof(Request*));
-        sleep = false;
-        pthread_mutex_init(&enqueue_lock, NULL);
-        pthread_cond_init(&enqueue_cond, NULL);
+        wakeup_head = NULL;
       }
       DMAThread(long _max_nr, XferDesQueue* _xd_queue, Channel* _channel) {
-        channel_to_xd_pool[_channel] = new PriorityXferDesQueue;
+        channel_to_xd_pool[_channel] = new XferDesReadyList;
         xd_queue = _xd_queue;
         max_nr = _max_nr;
         is_stopped = false;
         requests = (Request**) calloc(max_nr, sizeof(Request*));
-        sleep = false;
-        pthread_mutex_init(&enqueue_lock, NULL);
-        pthread_cond_init(&enqueue_cond, NULL);
+        wakeup_head = NULL;
       }
       ~DMAThread() {
-        std::map<Channel*, PriorityXferDesQueue*>::iterator it;
+        std::map<Channel*, XferDesReadyList*>::iterator it;
         for (it = channel_to_xd_pool.begin(); it != channel_to_xd_pool.end(); it++) {
           delete it->second;
         }
         free(requests);
-        pthread_mutex_destroy(&enqueue_lock);
-        pthread_cond_destroy(&enqueue_cond);
       }
       void dma_thread_loop();
       // Thread start function that takes an input of DMAThread
@@ -1105,22 +1172,33 @@ namespace LegionRuntime{
       }
 
       void stop() {
-        pthread_mutex_lock(&enqueue_lock);
         is_stopped = true;
-        pthread_cond_signal(&enqueue_cond);
-        pthread_mutex_unlock(&enqueue_lock);
+        __sync_synchronize();
+        doorbell.ring();
       }
+
+      // pushes an XferDes onto this thread's wakeup queue - safe to call from
+      // any thread, use XferDes::notify_progress rather than calling directly
+      void post_wakeup(XferDes* xd);
+    protected:
+      // moves everything in the wakeup queue onto the ready lists, returning
+      // true if anything was found
+      bool drain_wakeups();
+      // removes a finished XferDes from the wakeup machinery and marks it
+      // completed
+      void finish_xferdes(XferDes* xd);
     public:
-      pthread_mutex_t enqueue_lock;
-      pthread_cond_t enqueue_cond;
-      std::map<Channel*, PriorityXferDesQueue*> channel_to_xd_pool;
-      bool sleep;
-      bool is_stopped;
+      std::map<Channel*, XferDesReadyList*> channel_to_xd_pool;
+      volatile bool is_stopped;
     private:
       // maximum allowed num of requests for a single
       long max_nr;
       Request** requests;
       XferDesQueue* xd_queue;
+      // lock-free (multi-producer, single-consumer) stack of XferDes
+      // that need another look
+      XferDes* volatile wakeup_head;
+      DMADoorbell doorbell;
     };
 
     struct NotifyXferDesCompleteMessage {
@@ -1356,7 +1434,6 @@ namespace LegionRuntime{
         } else {
           core_rsrv = new Realm::CoreReservation("DMA threads", crs, Realm::CoreReservationParameters());
         }
-        pthread_mutex_init(&queues_lock, NULL);
         pthread_rwlock_init(&guid_lock, NULL);
         // reserve the first several guid
         next_to_assign_idx = 10;
@@ -1367,14 +1444,6 @@ namespace LegionRuntime{
 
       ~XferDesQueue() {
         delete core_rsrv;
-        // clean up the priority queues
-        pthread_mutex_lock(&queues_lock);
-        std::map<Channel*, PriorityXferDesQueue*>::iterator it2;
-        for (it2 = queues.begin(); it2 != queues.end(); it2++) {
-          delete it2->second;
-        }
-        pthread_mutex_unlock(&queues_lock);
-        pthread_mutex_destroy(&queues_lock);
         pthread_rwlock_destroy(&guid_lock);
       }
 
@@ -1439,13 +1508,12 @@ namespace LegionRuntime{
 
       void register_dma_thread(DMAThread* dma_thread)
       {
-        std::map<Channel*, PriorityXferDesQueue*>::iterator it;
-        pthread_mutex_lock(&queues_lock);
+        // only called before the DMA threads start, so the map can be read
+        // without a lock afterwards
+        std::map<Channel*, XferDesReadyList*>::iterator it;
         for(it = dma_thread->channel_to_xd_pool.begin(); it != dma_thread->channel_to_xd_pool.end(); it++) {
           channel_to_dma_thread[it->first] = dma_thread;
-          queues[it->first] = new PriorityXferDesQueue;
         }
-        pthread_mutex_unlock(&queues_lock);
       }
 
       void destroy_xferDes(XferDesID guid) {
@@ -1460,6 +1528,12 @@ namespace LegionRuntime{
       }
 
       void enqueue_xferDes_local(XferDes* xd) {
+        // the DMA thread has to be known before anybody can find this
+        // XferDes through guid_to_xd and try to wake it up
+        std::map<Channel*, DMAThread*>::iterator it;
+        it = channel_to_dma_thread.find(xd->channel);
+        assert(it != channel_to_dma_thread.end());
+        xd->dma_thread = it->second;
         pthread_rwlock_wrlock(&guid_lock);
         std::map<XferDesID, XferDesWithUpdates>::iterator git = guid_to_xd.find(xd->guid);
         if (git != guid_to_xd.end()) {
@@ -1475,57 +1549,8 @@ namespace LegionRuntime{
           guid_to_xd[xd->guid] = xd_struct;
         }
         pthread_rwlock_unlock(&guid_lock);
-        std::map<Channel*, DMAThread*>::iterator it;
-        it = channel_to_dma_thread.find(xd->channel);
-        assert(it != channel_to_dma_thread.end());
-        DMAThread* dma_thread = it->second;
-        pthread_mutex_lock(&dma_thread->enqueue_lock);
-        pthread_mutex_lock(&queues_lock);
-        std::map<Channel*, PriorityXferDesQueue*>::iterator it2;
-        it2 = queues.find(xd->channel);
-        assert(it2 != queues.end());
-        // push ourself into the priority queue
-        it2->second->insert(xd);
-        pthread_mutex_unlock(&queues_lock);
-        if (dma_thread->sleep) {
-          dma_thread->sleep = false;
-          pthread_cond_signal(&dma_thread->enqueue_cond);
-        }
-        pthread_mutex_unlock(&dma_thread->enqueue_lock);
-      }
-
-      bool dequeue_xferDes(DMAThread* dma_thread, bool wait_on_empty) {
-        pthread_mutex_lock(&dma_thread->enqueue_lock);
-        std::map<Channel*, PriorityXferDesQueue*>::iterator it;
-        if (wait_on_empty) {
-          bool empty = true;
-          for(it = dma_thread->channel_to_xd_pool.begin(); it != dma_thread->channel_to_xd_pool.end(); it++) {
-            pthread_mutex_lock(&queues_lock);
-            std::map<Channel*, PriorityXferDesQueue*>::iterator it2;
-            it2 = queues.find(it->first);
-            assert(it2 != queues.end());
-            if (it2->second->size() > 0)
-              empty = false;
-            pthread_mutex_unlock(&queues_lock);
-          }
-
-          if (empty && !dma_thread->is_stopped) {
-            dma_thread->sleep = true;
-            pthread_cond_wait(&dma_thread->enqueue_cond, &dma_thread->enqueue_lock);
-          }
-        }
-
-        for(it = dma_thread->channel_to_xd_pool.begin(); it != dma_thread->channel_to_xd_pool.end(); it++) {
-          pthread_mutex_lock(&queues_lock);
-          std::map<Channel*, PriorityXferDesQueue*>::iterator it2;
-          it2 = queues.find(it->first);
-          assert(it2 != queues.end());
-          it->second->insert(it2->second->begin(), it2->second->end());
-          it2->second->clear();
-          pthread_mutex_unlock(&queues_lock);
-        }
-        pthread_mutex_unlock(&dma_thread->enqueue_lock);
-        return true;
+        // a new XferDes goes through the same wakeup queue as everything else
+        xd->notify_progress();
       }
 
       void start_worker(int count, int max_nr, ChannelManager* channel_manager);
@@ -1534,9 +1559,7 @@ namespace LegionRuntime{
 
     protected:
       std::map<Channel*, DMAThread*> channel_to_dma_thread;
-      std::map<Channel*, PriorityXferDesQueue*> queues;
       std::map<XferDesID, XferDesWithUpdates> guid_to_xd;
-      pthread_mutex_t queues_lock;
       pthread_rwlock_t guid_lock;
       XferDesID next_to_assign_idx;
       Realm::CoreReservation* core_rsrv;
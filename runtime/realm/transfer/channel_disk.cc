@@ -259,6 +259,17 @@ namespace LegionRuntime {
       return AsyncFileIOContext::get_singleton()->available();
     }
 
+    bool FileChannel::needs_pull()
+    {
+      return !AsyncFileIOContext::get_singleton()->empty();
+    }
+
+    void FileChannel::flush_submissions()
+    {
+      // everything enqueued by this pass goes to the kernel at once
+      AsyncFileIOContext::get_singleton()->submit_pending();
+    }
+
     DiskChannel::DiskChannel(long max_nr, XferDes::XferKind _kind)
     {
       kind = _kind;
@@ -299,6 +310,17 @@ namespace LegionRuntime {
       return AsyncFileIOContext::get_singleton()->available();
     }
 
+    bool DiskChannel::needs_pull()
+    {
+      return !AsyncFileIOContext::get_singleton()->empty();
+    }
+
+    void DiskChannel::flush_submissions()
+    {
+      // everything enqueued by this pass goes to the kernel at once
+      AsyncFileIOContext::get_singleton()->submit_pending();
+    }
+
     template class FileXferDes<0>;
     template class FileXferDes<1>;
     template class FileXferDes<2>;
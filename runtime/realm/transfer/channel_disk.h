@@ -92,6 +92,8 @@ namespace LegionRuntime {
       long submit(Request** requests, long nr);
       void pull();
       long available();
+      bool needs_pull();
+      void flush_submissions();
     };
 
     class DiskChannel : public Channel {
@@ -101,6 +103,8 @@ namespace LegionRuntime {
       long submit(Request** requests, long nr);
       void pull();
       long available();
+      bool needs_pull();
+      void flush_submissions();
     };
 
   } // namespace LowLevel
@@ -38,7 +38,7 @@ namespace Realm {
 #else
       assert(ret == 0);
 #endif
-      free_blocks[0] = _size;
+      free_blocks.add_range(0, _size);
     }
 
     DiskMemory::~DiskMemory(void)
@@ -28,6 +28,11 @@
 #else
 #include <aio.h>
 #endif
+#ifdef REALM_USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#endif
 
 #include <queue>
 #include <algorithm>
@@ -1719,6 +1724,9 @@ namespace LegionRuntime {
 	MemoryImpl *dst_impl = get_runtime()->get_memory_impl(_dst_mem);
 	dst_base = (char *)(dst_impl->get_direct_ptr(0, dst_impl->size));
 	assert(dst_base);
+
+	dst_mem = _dst_mem;
+	engine = get_memcpy_engine();
       }
 
       virtual ~MemcpyMemPairCopier(void) { }
@@ -1733,7 +1741,10 @@ namespace LegionRuntime {
       void copy_span(off_t src_offset, off_t dst_offset, size_t bytes)
       {
 	//printf("memcpy of %zd bytes\n", bytes);
-	memcpy(dst_base + dst_offset, src_base + src_offset, bytes);
+	if(engine)
+	  engine->copy_1d(dst_mem, dst_base + dst_offset, src_base + src_offset, bytes);
+	else
+	  memcpy(dst_base + dst_offset, src_base + src_offset, bytes);
         record_bytes(bytes);
       }
 
@@ -1741,6 +1752,12 @@ namespace LegionRuntime {
       void copy_span(off_t src_offset, off_t dst_offset, size_t bytes,
 		     off_t src_stride, off_t dst_stride, size_t lines)
       {
+	if(engine) {
+	  engine->copy_2d(dst_mem, dst_base + dst_offset, src_base + src_offset, bytes,
+			  dst_stride, src_stride, lines);
+	  record_bytes(bytes * lines);
+	  return;
+	}
 	while(lines-- > 0) {
 	  copy_span(src_offset, dst_offset, bytes);
 	  src_offset += src_stride;
@@ -1751,6 +1768,8 @@ namespace LegionRuntime {
     protected:
       const char *src_base;
       char *dst_base;
+      Memory dst_mem;
+      MemcpyEngine *engine;
     };
 
     class LocalReductionMemPairCopier : public MemPairCopier {
@@ -2543,6 +2562,355 @@ namespace LegionRuntime {
     }
 #endif
 
+#ifdef REALM_USE_IO_URING
+    inline int io_uring_setup(unsigned entries, struct io_uring_params *p)
+    {
+      return syscall(__NR_io_uring_setup, entries, p);
+    }
+
+    inline int io_uring_enter(int fd, unsigned to_submit,
+			      unsigned min_complete, unsigned flags)
+    {
+      return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+		     NULL, 0);
+    }
+
+    inline int io_uring_register(int fd, unsigned opcode,
+				 void *arg, unsigned nr_args)
+    {
+      return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+    }
+
+    // a minimal io_uring wrapper (no dependency on liburing) - all methods
+    //  are called with the owning AsyncFileIOContext's mutex held
+    class AsyncFileIOContext::IOUring {
+    public:
+      // returns NULL if the kernel can't give us a usable ring
+      static IOUring *create(unsigned entries, bool sqpoll);
+
+      ~IOUring(void);
+
+      bool register_buffers(const std::vector<std::pair<void *, size_t> >& ranges);
+
+      // fills in a submission queue entry - nothing is handed to the kernel
+      //  until the next call to submit() (unless the kernel is polling)
+      void prepare(bool write, int fd, size_t offset, size_t bytes,
+		   void *buffer, void *user_data);
+
+      // gives all prepared entries to the kernel with (at most) one syscall
+      void submit(void);
+
+      // pops the next completion, if there is one
+      bool next_completion(void *& user_data, int& result);
+
+    protected:
+      IOUring(void);
+
+      int ring_fd;
+      bool sqpoll;
+      unsigned sq_entries;
+      volatile unsigned *sq_head, *sq_tail, *sq_flags;
+      unsigned *sq_mask, *sq_array;
+      volatile unsigned *cq_head, *cq_tail;
+      unsigned *cq_mask;
+      struct io_uring_sqe *sqes;
+      struct io_uring_cqe *cqes;
+      void *sq_ring, *cq_ring;
+      size_t sq_ring_size, cq_ring_size;
+      unsigned local_tail;   // entries prepared (kernel sees it on submit)
+      unsigned unsubmitted;  // entries prepared but not yet io_uring_enter'd
+
+      // registered buffers, indexed by end address so that upper_bound finds
+      //  the only candidate range for a given pointer
+      struct FixedBuffer {
+	char *base;
+	unsigned index;
+      };
+      std::map<char *, FixedBuffer> fixed_buffers;
+    };
+
+    AsyncFileIOContext::IOUring::IOUring(void)
+      : ring_fd(-1), sqpoll(false), sqes(0), cqes(0), sq_ring(0), cq_ring(0)
+      , local_tail(0), unsubmitted(0)
+    {}
+
+    /*static*/ AsyncFileIOContext::IOUring *AsyncFileIOContext::IOUring::create(unsigned entries,
+										    bool sqpoll)
+    {
+      struct io_uring_params p;
+      memset(&p, 0, sizeof(p));
+      if(sqpoll) {
+	p.flags |= IORING_SETUP_SQPOLL;
+	p.sq_thread_idle = 1000;  // ms before the kernel thread goes to sleep
+      }
+      int fd = io_uring_setup(entries, &p);
+      if(fd < 0) {
+	log_aio.info("io_uring_setup failed (%s) - using fallback AIO path",
+		     strerror(errno));
+	return 0;
+      }
+
+      // plain (non-vectored) reads and writes showed up after the ring itself,
+      //  so make sure this kernel has them
+      {
+	size_t probe_size = (sizeof(struct io_uring_probe) +
+			     IORING_OP_LAST * sizeof(struct io_uring_probe_op));
+	struct io_uring_probe *probe = (struct io_uring_probe *)calloc(1, probe_size);
+	int ret = io_uring_register(fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST);
+	bool ok = ((ret == 0) &&
+		   (probe->last_op >= IORING_OP_WRITE) &&
+		   ((probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0) &&
+		   ((probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED) != 0));
+	free(probe);
+	if(!ok) {
+	  log_aio.info("io_uring lacks IORING_OP_READ/WRITE - using fallback AIO path");
+	  close(fd);
+	  return 0;
+	}
+      }
+
+      IOUring *ring = new IOUring;
+      ring->ring_fd = fd;
+      ring->sqpoll = sqpoll;
+      ring->sq_entries = p.sq_entries;
+      ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+      ring->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+      bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+      if(single_mmap)
+	ring->sq_ring_size = ring->cq_ring_size = std::max(ring->sq_ring_size,
+							   ring->cq_ring_size);
+
+      void *sq_ring = mmap(0, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+      void *cq_ring = (single_mmap ?
+		         sq_ring :
+		         mmap(0, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+			      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING));
+      void *sqes = mmap(0, p.sq_entries * sizeof(struct io_uring_sqe),
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			fd, IORING_OFF_SQES);
+      ring->sq_ring = (sq_ring == MAP_FAILED) ? 0 : sq_ring;
+      ring->cq_ring = (cq_ring == MAP_FAILED) ? 0 : cq_ring;
+      ring->sqes = (sqes == MAP_FAILED) ? 0 : (struct io_uring_sqe *)sqes;
+      if(!ring->sq_ring || !ring->cq_ring || !ring->sqes) {
+	log_aio.info("io_uring ring mmap failed (%s) - using fallback AIO path",
+		     strerror(errno));
+	delete ring;
+	return 0;
+      }
+
+      char *sq = (char *)(ring->sq_ring);
+      ring->sq_head = (unsigned *)(sq + p.sq_off.head);
+      ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+      ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+      ring->sq_flags = (unsigned *)(sq + p.sq_off.flags);
+      ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+      char *cq = (char *)(ring->cq_ring);
+      ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+      ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+      ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+      ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+      ring->local_tail = *(ring->sq_tail);
+
+      log_aio.info("using io_uring: entries=%d sqpoll=%d", p.sq_entries, sqpoll);
+      return ring;
+    }
+
+    AsyncFileIOContext::IOUring::~IOUring(void)
+    {
+      if(sqes)
+	munmap(sqes, sq_entries * sizeof(struct io_uring_sqe));
+      if(cq_ring && (cq_ring != sq_ring))
+	munmap(cq_ring, cq_ring_size);
+      if(sq_ring)
+	munmap(sq_ring, sq_ring_size);
+      if(ring_fd >= 0)
+	close(ring_fd);
+    }
+
+    bool AsyncFileIOContext::IOUring::register_buffers(const std::vector<std::pair<void *, size_t> >& ranges)
+    {
+      assert(fixed_buffers.empty());
+
+      // the kernel limits each fixed buffer to 1GB, so split big ranges up
+      const size_t MAX_FIXED_BUFFER = 1 << 30;
+      std::vector<struct iovec> iovs;
+      for(std::vector<std::pair<void *, size_t> >::const_iterator it = ranges.begin();
+	  it != ranges.end();
+	  it++) {
+	char *base = (char *)(it->first);
+	size_t left = it->second;
+	while(left > 0) {
+	  struct iovec iov;
+	  iov.iov_base = base;
+	  iov.iov_len = std::min(left, MAX_FIXED_BUFFER);
+	  iovs.push_back(iov);
+	  base += iov.iov_len;
+	  left -= iov.iov_len;
+	}
+      }
+      if(iovs.empty()) return true;
+
+      int ret = io_uring_register(ring_fd, IORING_REGISTER_BUFFERS,
+				  &iovs[0], iovs.size());
+      if(ret < 0) {
+	// usually RLIMIT_MEMLOCK - this costs performance, not correctness
+	log_aio.info("io_uring buffer registration failed (%s) - using unregistered buffers",
+		     strerror(errno));
+	return false;
+      }
+
+      for(size_t i = 0; i < iovs.size(); i++) {
+	FixedBuffer fb;
+	fb.base = (char *)(iovs[i].iov_base);
+	fb.index = i;
+	fixed_buffers[fb.base + iovs[i].iov_len] = fb;
+      }
+      log_aio.info("io_uring: %zd fixed buffers registered", iovs.size());
+      return true;
+    }
+
+    void AsyncFileIOContext::IOUring::prepare(bool write, int fd, size_t offset,
+					      size_t bytes, void *buffer,
+					      void *user_data)
+    {
+      // the caller (via max_depth) guarantees there's always room
+      assert((local_tail - *sq_head) < sq_entries);
+
+      unsigned idx = local_tail & *sq_mask;
+      struct io_uring_sqe *sqe = &sqes[idx];
+      memset(sqe, 0, sizeof(struct io_uring_sqe));
+      sqe->fd = fd;
+      sqe->off = offset;
+      sqe->addr = (uint64_t)buffer;
+      // the kernel does at most ~2GB per request anyway - anything left over
+      //  comes back as a short transfer and is resubmitted
+      sqe->len = std::min(bytes, (size_t)(1U << 30));
+      sqe->user_data = (uint64_t)user_data;
+
+      char *ptr = (char *)buffer;
+      std::map<char *, FixedBuffer>::const_iterator it = fixed_buffers.upper_bound(ptr);
+      if((it != fixed_buffers.end()) &&
+	 (it->second.base <= ptr) &&
+	 ((ptr + sqe->len) <= it->first)) {
+	sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+	sqe->buf_index = it->second.index;
+      } else
+	sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+
+      sq_array[idx] = idx;
+      local_tail++;
+      unsubmitted++;
+
+      // publish the new tail - a polling kernel thread may pick it up right
+      //  away, otherwise it waits for submit()
+      __sync_synchronize();
+      *sq_tail = local_tail;
+    }
+
+    void AsyncFileIOContext::IOUring::submit(void)
+    {
+      if(unsubmitted == 0) return;
+
+      if(sqpoll) {
+	// the kernel thread does the submitting - we only need to poke it if
+	//  it has gone to sleep
+	unsubmitted = 0;
+	__sync_synchronize();
+	if((*sq_flags & IORING_SQ_NEED_WAKEUP) != 0)
+	  io_uring_enter(ring_fd, 0, 0, IORING_ENTER_SQ_WAKEUP);
+	return;
+      }
+
+      while(unsubmitted > 0) {
+	int ret = io_uring_enter(ring_fd, unsubmitted, 0, 0);
+	if(ret < 0) {
+	  if(errno == EINTR) continue;
+	  // out of resources for now - try again on the next make_progress
+	  if((errno == EAGAIN) || (errno == EBUSY)) break;
+	  log_aio.fatal("io_uring_enter failed: %s", strerror(errno));
+	  assert(0);
+	}
+	log_aio.debug("io_uring_enter submitted %d of %d", ret, unsubmitted);
+	unsubmitted -= ret;
+      }
+    }
+
+    bool AsyncFileIOContext::IOUring::next_completion(void *& user_data, int& result)
+    {
+      unsigned head = *cq_head;
+      __sync_synchronize();
+      if(head == *cq_tail) return false;
+      struct io_uring_cqe *cqe = &cqes[head & *cq_mask];
+      user_data = (void *)(cqe->user_data);
+      result = cqe->res;
+      __sync_synchronize();
+      *cq_head = head + 1;
+      return true;
+    }
+
+    class UringAIOOperation : public AsyncFileIOContext::AIOOperation {
+    public:
+      UringAIOOperation(AsyncFileIOContext::IOUring *_ring, bool _write,
+			int _fd, size_t _offset, size_t _bytes,
+			const void *_buffer, Request* request = NULL);
+      virtual void launch(void);
+      virtual bool check_completion(void);
+
+      // handles a completion for this operation, resubmitting whatever is
+      //  left of a short transfer
+      void handle_result(int result);
+
+    public:
+      AsyncFileIOContext::IOUring *ring;
+      bool write;
+      int fd;
+      size_t offset, bytes;
+      char *buffer;
+    };
+
+    UringAIOOperation::UringAIOOperation(AsyncFileIOContext::IOUring *_ring,
+					 bool _write, int _fd, size_t _offset,
+					 size_t _bytes, const void *_buffer,
+					 Request* request)
+      : ring(_ring), write(_write), fd(_fd), offset(_offset), bytes(_bytes)
+      , buffer((char *)_buffer)
+    {
+      completed = false;
+      req = request;
+    }
+
+    void UringAIOOperation::launch(void)
+    {
+      log_aio.debug("%s prepared: op=%p", (write ? "write" : "read"), this);
+      ring->prepare(write, fd, offset, bytes, buffer, this);
+    }
+
+    bool UringAIOOperation::check_completion(void)
+    {
+      return completed;
+    }
+
+    void UringAIOOperation::handle_result(int result)
+    {
+      log_aio.debug("%s returned: op=%p ret=%d", (write ? "write" : "read"), this, result);
+      if(result < 0) {
+	log_aio.fatal("io_uring %s failed: fd=%d offset=%zd bytes=%zd: %s",
+		      (write ? "write" : "read"), fd, offset, bytes, strerror(-result));
+	assert(0);
+      }
+      // a read that hits EOF is done, just as it is with the other AIO paths
+      if((result == 0) || ((size_t)result == bytes)) {
+	completed = true;
+	return;
+      }
+      offset += result;
+      buffer += result;
+      bytes -= result;
+      launch();
+    }
+#endif
+
     class AIOFence : public Realm::Operation::AsyncWorkItem {
     public:
       AIOFence(Realm::Operation *_op) : Realm::Operation::AsyncWorkItem(_op) {}
@@ -2593,6 +2961,11 @@ namespace LegionRuntime {
 #endif
 	io_setup(max_depth, &aio_ctx);
       assert(ret == 0);
+#endif
+#ifdef REALM_USE_IO_URING
+      uring = 0;
+      if(Realm::Config::use_io_uring)
+	uring = IOUring::create(max_depth, Realm::Config::io_uring_sqpoll);
 #endif
     }
 
@@ -2600,6 +2973,9 @@ namespace LegionRuntime {
     {
       assert(pending_operations.empty());
       assert(launched_operations.empty());
+#ifdef REALM_USE_IO_URING
+      delete uring;
+#endif
 #ifdef REALM_USE_KERNEL_AIO
 #ifndef NDEBUG
       int ret =
@@ -2613,11 +2989,16 @@ namespace LegionRuntime {
 					   size_t bytes, const void *buffer,
                                            Request* req)
     {
+      AIOOperation *op;
+#ifdef REALM_USE_IO_URING
+      if(uring)
+	op = new UringAIOOperation(uring, true, fd, offset, bytes, buffer, req);
+      else
+#endif
 #ifdef REALM_USE_KERNEL_AIO
-      KernelAIOWrite *op = new KernelAIOWrite(aio_ctx,
-					      fd, offset, bytes, buffer, req);
+      op = new KernelAIOWrite(aio_ctx, fd, offset, bytes, buffer, req);
 #else
-      PosixAIOWrite *op = new PosixAIOWrite(fd, offset, bytes, buffer, req);
+      op = new PosixAIOWrite(fd, offset, bytes, buffer, req);
 #endif
       {
 	AutoHSLLock al(mutex);
@@ -2634,11 +3015,16 @@ namespace LegionRuntime {
 					  size_t bytes, void *buffer,
                                           Request* req)
     {
+      AIOOperation *op;
+#ifdef REALM_USE_IO_URING
+      if(uring)
+	op = new UringAIOOperation(uring, false, fd, offset, bytes, buffer, req);
+      else
+#endif
 #ifdef REALM_USE_KERNEL_AIO
-      KernelAIORead *op = new KernelAIORead(aio_ctx,
-					    fd, offset, bytes, buffer, req);
+      op = new KernelAIORead(aio_ctx, fd, offset, bytes, buffer, req);
 #else
-      PosixAIORead *op = new PosixAIORead(fd, offset, bytes, buffer, req);
+      op = new PosixAIORead(fd, offset, bytes, buffer, req);
 #endif
       {
 	AutoHSLLock al(mutex);
@@ -2665,6 +3051,24 @@ namespace LegionRuntime {
       }
     }
 
+    void AsyncFileIOContext::submit_pending(void)
+    {
+#ifdef REALM_USE_IO_URING
+      if(!uring) return;
+      AutoHSLLock al(mutex);
+      uring->submit();
+#endif
+    }
+
+    void AsyncFileIOContext::register_buffers(const std::vector<std::pair<void *, size_t> >& ranges)
+    {
+#ifdef REALM_USE_IO_URING
+      if(!uring) return;
+      AutoHSLLock al(mutex);
+      uring->register_buffers(ranges);
+#endif
+    }
+
     bool AsyncFileIOContext::empty(void)
     {
       AutoHSLLock al(mutex);
@@ -2698,6 +3102,17 @@ namespace LegionRuntime {
 	}
       }
 #endif
+#ifdef REALM_USE_IO_URING
+      if(uring) {
+	// anything launched since the last call still needs to go in
+	uring->submit();
+
+	void *user_data;
+	int result;
+	while(uring->next_completion(user_data, result))
+	  ((UringAIOOperation *)user_data)->handle_result(result);
+      }
+#endif
 
       // now actually mark events completed in oldest-first order
       while(!launched_operations.empty()) {
@@ -2723,6 +3138,12 @@ namespace LegionRuntime {
 	op->launch();
 	launched_operations.push_back(op);
       }
+
+#ifdef REALM_USE_IO_URING
+      // one syscall for any resubmitted short transfers and newly launched ops
+      if(uring)
+	uring->submit();
+#endif
     }
 
     /*static*/
@@ -5274,10 +5695,32 @@ namespace LegionRuntime {
     }
 
     void start_dma_system(int count, bool pinned, int max_nr,
-                          Realm::CoreReservationSet& crs)
+                          Realm::CoreReservationSet& crs,
+                          int memcpy_threads, size_t memcpy_chunk_size,
+                          size_t memcpy_nt_threshold)
     {
       //log_dma.add_stream(&std::cerr, Logger::Category::LEVEL_DEBUG, false, false);
       aio_context = new AsyncFileIOContext(256);
+      // file I/O into pinned memory (or any system memory, if requested) can
+      //  skip the per-request page pinning
+      {
+	std::vector<std::pair<void *, size_t> > ranges;
+	Node& n = get_runtime()->nodes[gasnet_mynode()];
+	for(int pass = 0; pass < 2; pass++) {
+	  const std::vector<MemoryImpl *>& mems = (pass == 0) ? n.memories : n.ib_memories;
+	  for(std::vector<MemoryImpl *>::const_iterator it = mems.begin();
+	      it != mems.end();
+	      it++) {
+	    Realm::LocalCPUMemory *m = dynamic_cast<Realm::LocalCPUMemory *>(*it);
+	    if(m && (m->registered || Realm::Config::io_uring_fixed_sysmem))
+	      ranges.push_back(std::make_pair((void *)(m->base), m->size));
+	  }
+	}
+	aio_context->register_buffers(ranges);
+      }
+      // the memcpy channel picks up the engine when it is created
+      start_memcpy_engine(memcpy_threads, memcpy_chunk_size,
+                          memcpy_nt_threshold, crs);
       start_channel_manager(count, pinned, max_nr, crs);
       ib_req_queue = new PendingIBQueue();
     }
@@ -5285,6 +5728,7 @@ namespace LegionRuntime {
     void stop_dma_system(void)
     {
       stop_channel_manager();
+      stop_memcpy_engine();
       delete ib_req_queue;
       ib_req_queue = 0;
       delete aio_context;
@@ -5295,6 +5739,12 @@ namespace LegionRuntime {
 
 namespace Realm {
 
+  namespace Config {
+    bool use_io_uring = true;
+    bool io_uring_sqpoll = false;
+    bool io_uring_fixed_sysmem = false;
+  };
+
   using namespace LegionRuntime::LowLevel;
 
     Event Domain::fill(const std::vector<CopySrcDstField> &dsts,
@@ -21,6 +21,16 @@
 
 namespace Realm {
   class CoreReservationSet;
+
+  namespace Config {
+    // use io_uring for async file I/O if the kernel supports it
+    extern bool use_io_uring;
+    // have a kernel thread poll the io_uring submission queue
+    extern bool io_uring_sqpoll;
+    // register all of system memory as io_uring fixed buffers (normally
+    //  only memory that's already pinned is registered)
+    extern bool io_uring_fixed_sysmem;
+  };
 };
 
 namespace LegionRuntime {
@@ -119,7 +129,9 @@ namespace LegionRuntime {
     extern void start_dma_worker_threads(int count, Realm::CoreReservationSet& crs);
     extern void stop_dma_worker_threads(void);
 
-    extern void start_dma_system(int count, bool pinned, int max_nr, Realm::CoreReservationSet& crs);
+    extern void start_dma_system(int count, bool pinned, int max_nr, Realm::CoreReservationSet& crs,
+                                 int memcpy_threads, size_t memcpy_chunk_size,
+                                 size_t memcpy_nt_threshold);
 
     extern void stop_dma_system(void);
     extern void create_builtin_dma_channels(Realm::RuntimeImpl *r);
@@ -344,6 +356,14 @@ namespace LegionRuntime {
       void enqueue_read(int fd, size_t offset, size_t bytes, void *buffer, Request* req = NULL);
       void enqueue_fence(DmaRequest *req);
 
+      // hands any operations that have been launched but not yet given to
+      //  the kernel over in a single syscall (a no-op unless io_uring is used)
+      void submit_pending(void);
+
+      // lets the io_uring path use fixed buffers for I/O to or from the given
+      //  (pinned) ranges - must be called before any I/O is enqueued
+      void register_buffers(const std::vector<std::pair<void *, size_t> >& ranges);
+
       bool empty(void);
       long available(void);
       void make_progress(void);
@@ -364,6 +384,11 @@ namespace LegionRuntime {
       GASNetHSL mutex;
 #ifdef REALM_USE_KERNEL_AIO
       aio_context_t aio_ctx;
+#endif
+#ifdef REALM_USE_IO_URING
+      class IOUring;
+      // NULL if io_uring is disabled or not supported by the kernel
+      IOUring *uring;
 #endif
     };
   };
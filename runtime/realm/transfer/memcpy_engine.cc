@@ -0,0 +1,393 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "memcpy_engine.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <assert.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace LegionRuntime {
+  namespace LowLevel {
+
+    Realm::Logger log_memcpy("memcpy");
+
+    static MemcpyEngine *memcpy_engine = 0;
+    // NUMA memories show up before the engine is created
+    static std::map<Realm::Memory, int> numa_memories;
+
+    ////////////////////////////////////////////////////////////////////////
+    //
+    // class MemcpyThreadPool
+    //
+
+    MemcpyThreadPool::MemcpyThreadPool(MemcpyEngine *_engine, int _numa_domain)
+      : numa_domain(_numa_domain), engine(_engine), core_rsrv(0)
+      , shutdown_flag(false)
+    {
+      pthread_mutex_init(&lock, NULL);
+      pthread_cond_init(&work_cond, NULL);
+      pthread_cond_init(&done_cond, NULL);
+    }
+
+    MemcpyThreadPool::~MemcpyThreadPool(void)
+    {
+      assert(worker_threads.empty());
+      delete core_rsrv;
+      pthread_mutex_destroy(&lock);
+      pthread_cond_destroy(&work_cond);
+      pthread_cond_destroy(&done_cond);
+    }
+
+    void MemcpyThreadPool::start_threads(int num_threads,
+					 Realm::CoreReservationSet& crs)
+    {
+      Realm::CoreReservationParameters params;
+      params.set_num_cores(num_threads);
+      params.set_numa_domain(numa_domain);
+      params.set_ldst_usage(params.CORE_USAGE_EXCLUSIVE);
+      core_rsrv = new Realm::CoreReservation("memcpy threads", crs, params);
+
+      Realm::ThreadLaunchParameters tlp;
+      for(int i = 0; i < num_threads; i++) {
+	Realm::Thread *t = Realm::Thread::create_kernel_thread<MemcpyThreadPool,
+					  &MemcpyThreadPool::worker_loop>(this,
+									  tlp,
+									  *core_rsrv,
+									  0 /* default scheduler*/);
+	worker_threads.push_back(t);
+      }
+    }
+
+    void MemcpyThreadPool::shutdown(void)
+    {
+      pthread_mutex_lock(&lock);
+      shutdown_flag = true;
+      pthread_cond_broadcast(&work_cond);
+      pthread_mutex_unlock(&lock);
+
+      for(std::vector<Realm::Thread *>::iterator it = worker_threads.begin();
+	  it != worker_threads.end();
+	  it++) {
+	(*it)->join();
+	delete (*it);
+      }
+      worker_threads.clear();
+    }
+
+    MemcpyJob *MemcpyThreadPool::claim_chunk(size_t& chunk)
+    {
+      if(jobs.empty())
+	return 0;
+      MemcpyJob *job = jobs.front();
+      chunk = job->next_chunk++;
+      // once every chunk has been handed out, nobody else needs to see it
+      if(job->next_chunk == job->num_chunks)
+	jobs.pop_front();
+      return job;
+    }
+
+    void MemcpyThreadPool::finish_chunk(MemcpyJob *job)
+    {
+      // the submitter may return as soon as the last chunk is counted, so
+      //  this is the last time we're allowed to touch the job
+      if(++job->chunks_done == job->num_chunks)
+	pthread_cond_broadcast(&done_cond);
+    }
+
+    void MemcpyThreadPool::perform_job(MemcpyJob& job)
+    {
+      pthread_mutex_lock(&lock);
+      jobs.push_back(&job);
+      pthread_cond_broadcast(&work_cond);
+      // the submitting thread helps out with its own job
+      while(job.next_chunk < job.num_chunks) {
+	// other jobs may be ahead of us - help with those too
+	size_t chunk;
+	MemcpyJob *j = claim_chunk(chunk);
+	assert(j != 0);
+	pthread_mutex_unlock(&lock);
+	engine->copy_chunk(*j, chunk);
+	pthread_mutex_lock(&lock);
+	finish_chunk(j);
+      }
+      while(job.chunks_done < job.num_chunks)
+	pthread_cond_wait(&done_cond, &lock);
+      pthread_mutex_unlock(&lock);
+    }
+
+    void MemcpyThreadPool::worker_loop(void)
+    {
+      pthread_mutex_lock(&lock);
+      while(true) {
+	while(jobs.empty() && !shutdown_flag)
+	  pthread_cond_wait(&work_cond, &lock);
+	if(shutdown_flag)
+	  break;
+	size_t chunk;
+	MemcpyJob *job = claim_chunk(chunk);
+	pthread_mutex_unlock(&lock);
+	engine->copy_chunk(*job, chunk);
+	pthread_mutex_lock(&lock);
+	finish_chunk(job);
+      }
+      pthread_mutex_unlock(&lock);
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+    //
+    // class MemcpyEngine
+    //
+
+    MemcpyEngine::MemcpyEngine(size_t _chunk_size, size_t _nontemporal_threshold)
+      : chunk_size(_chunk_size), nontemporal_threshold(_nontemporal_threshold)
+    {
+      assert(chunk_size > 0);
+    }
+
+    MemcpyEngine::~MemcpyEngine(void)
+    {
+      for(std::map<int, MemcpyThreadPool *>::iterator it = pools.begin();
+	  it != pools.end();
+	  it++)
+	delete it->second;
+    }
+
+    void MemcpyEngine::add_numa_memory(Realm::Memory m, int numa_domain)
+    {
+      assert(pools.empty());
+      memory_domains[m] = numa_domain;
+    }
+
+    void MemcpyEngine::start_threads(int threads_per_domain,
+				     Realm::CoreReservationSet& crs)
+    {
+      assert(threads_per_domain > 0);
+      for(std::map<Realm::Memory, int>::const_iterator it = memory_domains.begin();
+	  it != memory_domains.end();
+	  it++)
+	if(pools.count(it->second) == 0)
+	  pools[it->second] = new MemcpyThreadPool(this, it->second);
+      // without NUMA information, use a single pool that can run anywhere
+      if(pools.empty()) {
+	int domain = Realm::CoreReservationParameters::NUMA_DOMAIN_DONTCARE;
+	pools[domain] = new MemcpyThreadPool(this, domain);
+      }
+      for(std::map<int, MemcpyThreadPool *>::iterator it = pools.begin();
+	  it != pools.end();
+	  it++) {
+	log_memcpy.info() << "starting " << threads_per_domain
+			  << " memcpy threads for numa domain " << it->first;
+	it->second->start_threads(threads_per_domain, crs);
+      }
+    }
+
+    void MemcpyEngine::shutdown(void)
+    {
+      for(std::map<int, MemcpyThreadPool *>::iterator it = pools.begin();
+	  it != pools.end();
+	  it++)
+	it->second->shutdown();
+    }
+
+    MemcpyThreadPool *MemcpyEngine::find_pool(Realm::Memory dst_mem) const
+    {
+      std::map<Realm::Memory, int>::const_iterator finder = memory_domains.find(dst_mem);
+      if(finder != memory_domains.end()) {
+	std::map<int, MemcpyThreadPool *>::const_iterator pfinder = pools.find(finder->second);
+	if(pfinder != pools.end())
+	  return pfinder->second;
+      }
+      // not a NUMA memory - any pool will do
+      return pools.begin()->second;
+    }
+
+    void MemcpyEngine::copy_1d(Realm::Memory dst_mem, char *dst, const char *src,
+			       size_t bytes)
+    {
+      copy_2d(dst_mem, dst, src, bytes, bytes, bytes, 1);
+    }
+
+    void MemcpyEngine::copy_2d(Realm::Memory dst_mem, char *dst, const char *src,
+			       size_t bytes, off_t dst_stride, off_t src_stride,
+			       size_t lines)
+    {
+      if((bytes == 0) || (lines == 0))
+	return;
+
+      MemcpyJob job;
+      job.dst = dst;
+      job.src = src;
+      job.bytes = bytes;
+      job.lines = lines;
+      job.dst_stride = dst_stride;
+      job.src_stride = src_stride;
+      job.nontemporal = ((bytes * lines) >= nontemporal_threshold);
+      if(bytes >= chunk_size) {
+	// wide lines get split into pieces, one line at a time
+	job.lines_per_chunk = 1;
+	job.pieces_per_line = (bytes + chunk_size - 1) / chunk_size;
+	job.piece_bytes = (bytes + job.pieces_per_line - 1) / job.pieces_per_line;
+      } else {
+	// narrow lines get grouped together
+	job.lines_per_chunk = chunk_size / bytes;
+	job.pieces_per_line = 1;
+	job.piece_bytes = bytes;
+      }
+      job.num_chunks = (((lines + job.lines_per_chunk - 1) / job.lines_per_chunk) *
+			job.pieces_per_line);
+      job.next_chunk = 0;
+      job.chunks_done = 0;
+
+      // small copies aren't worth waking anybody up for
+      if(job.num_chunks == 1) {
+	copy_chunk(job, 0);
+	return;
+      }
+
+      find_pool(dst_mem)->perform_job(job);
+    }
+
+    void MemcpyEngine::copy_chunk(const MemcpyJob& job, size_t chunk) const
+    {
+      size_t line = (chunk / job.pieces_per_line) * job.lines_per_chunk;
+      size_t offset = (chunk % job.pieces_per_line) * job.piece_bytes;
+      if(offset >= job.bytes)
+	return;
+      size_t bytes = job.bytes - offset;
+      if(bytes > job.piece_bytes)
+	bytes = job.piece_bytes;
+      size_t lines = job.lines - line;
+      if(lines > job.lines_per_chunk)
+	lines = job.lines_per_chunk;
+
+      char *dst = job.dst + line * job.dst_stride + offset;
+      const char *src = job.src + line * job.src_stride + offset;
+      for(size_t i = 0; i < lines; i++) {
+	if(job.nontemporal)
+	  nontemporal_memcpy(dst, src, bytes);
+	else
+	  memcpy(dst, src, bytes);
+	dst += job.dst_stride;
+	src += job.src_stride;
+      }
+    }
+
+    /*static*/ void MemcpyEngine::nontemporal_memcpy(char *dst, const char *src,
+						     size_t bytes)
+    {
+#ifdef __SSE2__
+      // streaming stores need an aligned destination
+      size_t head = (16 - (((uintptr_t)dst) & 15)) & 15;
+      if(head >= bytes) {
+	memcpy(dst, src, bytes);
+	return;
+      }
+      if(head > 0) {
+	memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	bytes -= head;
+      }
+      while(bytes >= 64) {
+	__m128i a = _mm_loadu_si128((const __m128i *)(src));
+	__m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+	__m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+	__m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+	_mm_stream_si128((__m128i *)(dst), a);
+	_mm_stream_si128((__m128i *)(dst + 16), b);
+	_mm_stream_si128((__m128i *)(dst + 32), c);
+	_mm_stream_si128((__m128i *)(dst + 48), d);
+	dst += 64;
+	src += 64;
+	bytes -= 64;
+      }
+      while(bytes >= 16) {
+	_mm_stream_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+	dst += 16;
+	src += 16;
+	bytes -= 16;
+      }
+      if(bytes > 0)
+	memcpy(dst, src, bytes);
+      // make the streaming stores visible before anybody is told we're done
+      _mm_sfence();
+#else
+      memcpy(dst, src, bytes);
+#endif
+    }
+
+    MemcpyEngine *get_memcpy_engine(void)
+    {
+      return memcpy_engine;
+    }
+
+    void register_numa_memory_in_dma_systems(Realm::Memory m, int numa_domain)
+    {
+      assert(memcpy_engine == 0);
+      numa_memories[m] = numa_domain;
+    }
+
+    static size_t default_nontemporal_threshold(void)
+    {
+      // anything that won't fit in the last-level cache
+#ifdef _SC_LEVEL3_CACHE_SIZE
+      long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+      if(llc > 0)
+	return llc;
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+      long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+      if(l2 > 0)
+	return l2;
+#endif
+      return 8 << 20;
+    }
+
+    void start_memcpy_engine(int threads_per_domain, size_t chunk_size,
+			     size_t nontemporal_threshold,
+			     Realm::CoreReservationSet& crs)
+    {
+      assert(memcpy_engine == 0);
+      // zero threads means all copies are done by the dma threads themselves
+      if(threads_per_domain <= 0)
+	return;
+      if(nontemporal_threshold == 0)
+	nontemporal_threshold = default_nontemporal_threshold();
+      memcpy_engine = new MemcpyEngine(chunk_size, nontemporal_threshold);
+      for(std::map<Realm::Memory, int>::const_iterator it = numa_memories.begin();
+	  it != numa_memories.end();
+	  it++)
+	memcpy_engine->add_numa_memory(it->first, it->second);
+      memcpy_engine->start_threads(threads_per_domain, crs);
+    }
+
+    void stop_memcpy_engine(void)
+    {
+      if(memcpy_engine) {
+	memcpy_engine->shutdown();
+	delete memcpy_engine;
+	memcpy_engine = 0;
+      }
+      numa_memories.clear();
+    }
+
+  }; // namespace LowLevel
+}; // namespace LegionRuntime
@@ -0,0 +1,132 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// parallel copy engine for large local memcpy-style transfers
+
+#ifndef LOWLEVEL_MEMCPY_ENGINE
+#define LOWLEVEL_MEMCPY_ENGINE
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <pthread.h>
+#include <map>
+#include <vector>
+#include <deque>
+
+#include "realm/realm.h"
+#include "realm/threads.h"
+
+namespace LegionRuntime {
+  namespace LowLevel {
+
+    class MemcpyEngine;
+
+    // a single 1-D or 2-D copy that has been broken into chunks - jobs
+    //  live on the stack of the thread that submitted them and are only
+    //  touched by workers while holding the pool's lock
+    struct MemcpyJob {
+      char *dst;
+      const char *src;
+      size_t bytes, lines;
+      off_t dst_stride, src_stride;
+      bool nontemporal;
+      // a chunk is either a group of whole lines or a piece of one line
+      size_t lines_per_chunk, pieces_per_line, piece_bytes;
+      size_t num_chunks, next_chunk, chunks_done;
+    };
+
+    // a set of copy threads that share one NUMA domain
+    class MemcpyThreadPool {
+    public:
+      MemcpyThreadPool(MemcpyEngine *_engine, int _numa_domain);
+      ~MemcpyThreadPool(void);
+
+      void start_threads(int num_threads, Realm::CoreReservationSet& crs);
+      void shutdown(void);
+
+      // hands the job to the pool and helps with it until it's finished
+      void perform_job(MemcpyJob& job);
+
+      void worker_loop(void);
+
+      const int numa_domain;
+
+    protected:
+      // grabs the next chunk of the front job - must hold the lock
+      MemcpyJob *claim_chunk(size_t& chunk);
+      void finish_chunk(MemcpyJob *job);
+
+      MemcpyEngine *engine;
+      Realm::CoreReservation *core_rsrv;
+      std::vector<Realm::Thread *> worker_threads;
+      pthread_mutex_t lock;
+      pthread_cond_t work_cond, done_cond;
+      std::deque<MemcpyJob *> jobs;
+      bool shutdown_flag;
+    };
+
+    // The MemcpyEngine splits large copies between CPU-addressable
+    //  memories across a pool of copy threads.  There is one pool per
+    //  NUMA domain (as reported by the NUMA module), and a copy is handed
+    //  to the pool local to its destination memory.  Copies that are
+    //  larger than the last-level cache use non-temporal stores so that
+    //  they don't evict everybody else's working set.
+    class MemcpyEngine {
+    public:
+      MemcpyEngine(size_t _chunk_size, size_t _nontemporal_threshold);
+      ~MemcpyEngine(void);
+
+      // must be called before start_threads
+      void add_numa_memory(Realm::Memory m, int numa_domain);
+
+      void start_threads(int threads_per_domain, Realm::CoreReservationSet& crs);
+      void shutdown(void);
+
+      bool enabled(void) const { return !pools.empty(); }
+
+      // both copies return once all the data has been copied
+      void copy_1d(Realm::Memory dst_mem, char *dst, const char *src, size_t bytes);
+      void copy_2d(Realm::Memory dst_mem, char *dst, const char *src, size_t bytes,
+		   off_t dst_stride, off_t src_stride, size_t lines);
+
+      void copy_chunk(const MemcpyJob& job, size_t chunk) const;
+
+      static void nontemporal_memcpy(char *dst, const char *src, size_t bytes);
+
+      const size_t chunk_size;
+      const size_t nontemporal_threshold;
+
+    protected:
+      MemcpyThreadPool *find_pool(Realm::Memory dst_mem) const;
+
+      std::map<Realm::Memory, int> memory_domains;
+      std::map<int, MemcpyThreadPool *> pools;
+    };
+
+    // returns NULL if parallel copies have not been enabled
+    MemcpyEngine *get_memcpy_engine(void);
+
+    // memories are registered by the NUMA module before the engine starts
+    void register_numa_memory_in_dma_systems(Realm::Memory m, int numa_domain);
+
+    void start_memcpy_engine(int threads_per_domain, size_t chunk_size,
+			     size_t nontemporal_threshold,
+			     Realm::CoreReservationSet& crs);
+    void stop_memcpy_engine(void);
+
+  }; // namespace LowLevel
+}; // namespace LegionRuntime
+
+#endif
@@ -0,0 +1,174 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// checks the aggregation of batchable runtime messages - drives the
+//  DeferredFlush that each virtual channel uses with a stream of batchable
+//  messages and a flush task that polls the way MessageManager's does, on
+//  a simulated clock, and checks that the messages go out in fewer active
+//  messages than there are messages, that none of them waits much longer
+//  than -lg:message_delay, and that a non-batchable flush takes the held
+//  batch with it
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "legion_utilities.h"
+
+using namespace Legion;
+using namespace Legion::Internal;
+
+static int num_msgs = 1000;
+static long long msg_gap = 2000;      // ns between messages
+static long long delay = 50000;       // ns, i.e. -lg:message_delay 50
+static long long poll_interval = 1000; // ns between runs of the flush task
+
+// stands in for a virtual channel - counts the active messages it sends
+//  and how long each message sat in the buffer before going out
+struct Channel {
+  DeferredFlush deferred;
+  std::vector<long long> buffered;
+  int sends;
+  int delivered;
+  long long max_wait;
+
+  Channel(void) : sends(0), delivered(0), max_wait(0) {}
+
+  void send(long long now)
+  {
+    sends++;
+    for (unsigned idx = 0; idx < buffered.size(); idx++) {
+      long long wait = now - buffered[idx];
+      if (wait > max_wait) max_wait = wait;
+    }
+    delivered += buffered.size();
+    buffered.clear();
+    deferred.clear();
+  }
+
+  // mirrors VirtualChannel::package_message
+  void package(long long now, bool batchable)
+  {
+    buffered.push_back(now);
+    if (batchable && deferred.defer(now, delay, false/*response*/))
+      return;
+    send(now);
+  }
+
+  // mirrors VirtualChannel::flush_deferred
+  bool flush_deferred(long long now)
+  {
+    if (!deferred.is_pending())
+      return false;
+    if (!deferred.has_expired(now, delay))
+      return true;
+    send(now);
+    return false;
+  }
+};
+
+static bool check(bool cond, const char *what)
+{
+  printf("  %-60s %s\n", what, (cond ? "OK" : "FAILED"));
+  return cond;
+}
+
+// sends the messages on a channel, with every 'unbatched'-th message (if
+//  any) not batchable, and runs the flush task whenever one is scheduled
+static void run_stream(Channel& channel, int unbatched)
+{
+  bool flush_scheduled = false;
+  long long next_poll = 0;
+  long long now = 1;
+  for (int i = 0; i < num_msgs; i++, now += msg_gap) {
+    // let the flush task run at any polls that come due first
+    while (flush_scheduled && (next_poll <= now)) {
+      flush_scheduled = channel.flush_deferred(next_poll);
+      next_poll += poll_interval;
+    }
+    bool batchable = ((unbatched == 0) || ((i % unbatched) != (unbatched - 1)));
+    channel.package(now, batchable);
+    if (channel.deferred.is_pending() && !flush_scheduled) {
+      flush_scheduled = true;
+      next_poll = now + poll_interval;
+    }
+  }
+  // nothing else gets sent so the flush task has to finish the job
+  while (flush_scheduled) {
+    flush_scheduled = channel.flush_deferred(next_poll);
+    next_poll += poll_interval;
+  }
+}
+
+// every message is batchable and the flush task is the only thing that
+//  sends them
+static bool test_batchable(void)
+{
+  printf("batchable: %d messages, %lld ns apart, %lld ns delay\n",
+         num_msgs, msg_gap, delay);
+  Channel channel;
+  run_stream(channel, 0);
+  printf("  %d sends, %.1f messages/send, max wait %lld ns\n",
+         channel.sends, (double)num_msgs / channel.sends, channel.max_wait);
+  bool ok = true;
+  ok = check(channel.delivered == num_msgs, "all messages delivered") && ok;
+  // messages further apart than the delay have nothing to share a send with
+  if ((msg_gap < delay) && (num_msgs > 1))
+    ok = check(channel.sends < num_msgs, "fewer sends than messages") && ok;
+  ok = check(channel.max_wait <= (delay + poll_interval),
+             "no message waits past the deadline") && ok;
+  return ok;
+}
+
+// a non-batchable flush sends whatever is being held along with it
+static bool test_mixed(void)
+{
+  printf("mixed: every 10th message is not batchable\n");
+  Channel channel;
+  run_stream(channel, 10);
+  printf("  %d sends, max wait %lld ns\n", channel.sends, channel.max_wait);
+  bool ok = true;
+  ok = check(channel.delivered == num_msgs, "all messages delivered") && ok;
+  if ((10 * msg_gap) <= delay)
+    ok = check(channel.sends <= ((num_msgs + 9) / 10),
+               "non-batchable flushes take the held batch") && ok;
+  ok = check(channel.max_wait <= (delay + poll_interval),
+             "no message waits past the deadline") && ok;
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-msgs")) {
+      num_msgs = atoi(argv[++i]);
+      continue;
+    }
+    if (!strcmp(argv[i], "-gap")) {
+      msg_gap = atoll(argv[++i]);
+      continue;
+    }
+    if (!strcmp(argv[i], "-delay")) {
+      delay = atoll(argv[++i]);
+      continue;
+    }
+  }
+
+  bool ok = test_batchable();
+  ok = test_mixed() && ok;
+  printf("%s\n", (ok ? "PASSED" : "FAILED"));
+  return (ok ? 0 : 1);
+}
@@ -0,0 +1,194 @@
+/* Copyright 2017 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// measures file I/O bandwidth through an attached file (the same pattern as
+//  test/attach_file_mini, but big enough to time): a field in system memory
+//  is copied out to the file and then read back into system memory, in
+//  many independent pieces so that lots of file requests are in flight
+
+#include <cstdio>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include "legion.h"
+
+using namespace Legion;
+using namespace LegionRuntime::Accessor;
+using namespace LegionRuntime::Arrays;
+
+enum TaskIDs {
+  TOP_LEVEL_TASK_ID,
+};
+
+enum FieldIDs {
+  FID_X,
+  FID_Y,
+};
+
+static long long num_elements = 1 << 22;
+static int num_reps = 3;
+static int num_pieces = 64;
+static const char *file_name = "file_bandwidth.dat";
+
+static double current_time(Context ctx, Runtime *runtime)
+{
+  // the fence makes sure everything issued so far (i.e. the copy) is done
+  runtime->issue_execution_fence(ctx);
+  TimingLauncher tl(MEASURE_MICRO_SECONDS);
+  Future f = runtime->issue_timing_measurement(ctx, tl);
+  return 1e-6 * f.get_result<long long>();
+}
+
+static void fill_y(Context ctx, Runtime *runtime, LogicalRegion lr, bool zero)
+{
+  PhysicalRegion pr = runtime->map_region(ctx,
+					  RegionRequirement(lr, WRITE_DISCARD, EXCLUSIVE, lr)
+					  .add_field(FID_Y));
+  pr.wait_until_valid();
+  RegionAccessor<AccessorType::Generic, double> acc =
+    pr.get_field_accessor(FID_Y).typeify<double>();
+  for(long long i = 0; i < num_elements; i++)
+    acc.write(DomainPoint::from_point<1>(Point<1>(i)), zero ? 0.0 : (3.0 * i + 1));
+  runtime->unmap_region(ctx, pr);
+}
+
+static int check_y(Context ctx, Runtime *runtime, LogicalRegion lr)
+{
+  PhysicalRegion pr = runtime->map_region(ctx,
+					  RegionRequirement(lr, READ_ONLY, EXCLUSIVE, lr)
+					  .add_field(FID_Y));
+  pr.wait_until_valid();
+  RegionAccessor<AccessorType::Generic, double> acc =
+    pr.get_field_accessor(FID_Y).typeify<double>();
+  int errors = 0;
+  for(long long i = 0; i < num_elements; i++) {
+    double v = acc.read(DomainPoint::from_point<1>(Point<1>(i)));
+    if(v != (3.0 * i + 1)) {
+      if(errors++ < 10)
+	printf("ERROR: element %lld = %g (expected %g)\n", i, v, 3.0 * i + 1);
+    }
+  }
+  runtime->unmap_region(ctx, pr);
+  return errors;
+}
+
+// copies between the attached file (field X) and system memory (field Y),
+//  one copy per subregion
+static double file_copy(Context ctx, Runtime *runtime, LogicalRegion lr,
+			LogicalPartition lp, bool to_file)
+{
+  std::vector<FieldID> field_vec(1, FID_X);
+  AttachLauncher alr(EXTERNAL_POSIX_FILE, lr, lr);
+  alr.attach_file(file_name, field_vec,
+		  to_file ? LEGION_FILE_CREATE : LEGION_FILE_READ_ONLY);
+  PhysicalRegion pr = runtime->attach_external_resource(ctx, alr);
+
+  double t_start = current_time(ctx, runtime);
+  for(int i = 0; i < num_pieces; i++) {
+    LogicalRegion sub = runtime->get_logical_subregion_by_color(ctx, lp, i);
+    CopyLauncher clr;
+    if(to_file)
+      clr.add_copy_requirements(RegionRequirement(sub, READ_ONLY, EXCLUSIVE, lr).add_field(FID_Y),
+				RegionRequirement(sub, READ_WRITE, EXCLUSIVE, lr).add_field(FID_X));
+    else
+      clr.add_copy_requirements(RegionRequirement(sub, READ_ONLY, EXCLUSIVE, lr).add_field(FID_X),
+				RegionRequirement(sub, READ_WRITE, EXCLUSIVE, lr).add_field(FID_Y));
+    runtime->issue_copy_operation(ctx, clr);
+  }
+  double t_end = current_time(ctx, runtime);
+
+  runtime->detach_external_resource(ctx, pr);
+  return t_end - t_start;
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, Runtime *runtime)
+{
+  double mbytes = num_elements * sizeof(double) / 1048576.0;
+  printf("file bandwidth test - elements=%lld (%.1f MB) pieces=%d reps=%d file=%s\n",
+	 num_elements, mbytes, num_pieces, num_reps, file_name);
+  assert((num_elements % num_pieces) == 0);
+
+  Rect<1> rect_A(Point<1>(0), Point<1>(num_elements - 1));
+  IndexSpace is_A = runtime->create_index_space(ctx,
+                          Domain::from_rect<1>(rect_A));
+  FieldSpace fs_A = runtime->create_field_space(ctx);
+  {
+    FieldAllocator allocator =
+      runtime->create_field_allocator(ctx, fs_A);
+    allocator.allocate_field(sizeof(double),FID_X);
+    allocator.allocate_field(sizeof(double),FID_Y);
+  }
+  LogicalRegion lr_A = runtime->create_logical_region(ctx, is_A, fs_A);
+  IndexPartition ip_A = runtime->create_index_partition(ctx, is_A,
+					Blockify<1>(num_elements / num_pieces));
+  LogicalPartition lp_A = runtime->get_logical_partition(ctx, lr_A, ip_A);
+
+  double write_time = 0, read_time = 0;
+  int errors = 0;
+  for(int reps = 0; reps < num_reps; reps++) {
+    fill_y(ctx, runtime, lr_A, false /*!zero*/);
+    write_time += file_copy(ctx, runtime, lr_A, lp_A, true /*to_file*/);
+
+    fill_y(ctx, runtime, lr_A, true /*zero*/);
+    read_time += file_copy(ctx, runtime, lr_A, lp_A, false /*!to_file*/);
+    errors += check_y(ctx, runtime, lr_A);
+  }
+
+  printf("write: %8.1f MB/s (%.3f s)\n", mbytes * num_reps / write_time, write_time);
+  printf("read:  %8.1f MB/s (%.3f s)\n", mbytes * num_reps / read_time, read_time);
+
+  runtime->destroy_logical_region(ctx, lr_A);
+  runtime->destroy_field_space(ctx, fs_A);
+  runtime->destroy_index_space(ctx, is_A);
+  unlink(file_name);
+
+  if(errors > 0)
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-n")) {
+      num_elements = atoll(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-r")) {
+      num_reps = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-p")) {
+      num_pieces = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-f")) {
+      file_name = argv[++i];
+      continue;
+    }
+  }
+
+  Runtime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+
+  {
+    TaskVariantRegistrar registrar(TOP_LEVEL_TASK_ID, "top_level");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    Runtime::preregister_task_variant<top_level_task>(registrar, "top_level");
+  }
+
+  return Runtime::start(argc, argv);
+}
@@ -0,0 +1,185 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// microbenchmark for the runtime's message serializer - builds messages
+//  the way the runtime does (a few header fields and a payload, or a
+//  message assembled from nested serializers), packs them into a virtual
+//  channel-sized buffer the way VirtualChannel::package_message does, and
+//  reports the bytes copied and the time per message when payloads are
+//  copied into the serializer versus referenced by it
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "legion_utilities.h"
+#include "realm/timers.h"
+
+using namespace Legion;
+using namespace Legion::Internal;
+
+static int num_reps = 10000;
+static size_t channel_size = DEFAULT_MAX_MESSAGE_SIZE;
+
+// stands in for the virtual channel's sending buffer - the real one sends
+//  an active message whenever it fills up
+struct Channel {
+  std::vector<char> buffer;
+  size_t index;
+  size_t bytes_copied;
+
+  Channel(size_t size) : buffer(size), index(0), bytes_copied(0) {}
+
+  void package(Serializer &rez)
+  {
+    std::vector<std::pair<const void*,size_t> > pieces;
+    if (rez.has_segments())
+      rez.get_segments(pieces);
+    else
+      pieces.push_back(std::pair<const void*,size_t>(rez.get_buffer(),
+                                                     rez.get_used_bytes()));
+    for (unsigned idx = 0; idx < pieces.size(); idx++) {
+      const char *ptr = (const char *)pieces[idx].first;
+      size_t left = pieces[idx].second;
+      while (left > 0) {
+        if (index == buffer.size())
+          index = 0;  // "send" it
+        size_t amt = buffer.size() - index;
+        if (amt > left) amt = left;
+        memcpy(&buffer[index], ptr, amt);
+        index += amt;
+        ptr += amt;
+        left -= amt;
+        bytes_copied += amt;
+      }
+    }
+  }
+};
+
+// a task-like message: some header fields and one large argument buffer
+static void build_payload_message(Serializer &rez, const std::vector<char> &payload,
+                                  bool reference)
+{
+  for (int i = 0; i < 16; i++)
+    rez.serialize<unsigned long long>(i);
+  rez.serialize<size_t>(payload.size());
+  if (reference)
+    rez.serialize_reference(&payload[0], payload.size());
+  else
+    rez.serialize(&payload[0], payload.size());
+  rez.serialize<int>(42);
+}
+
+// a version-state-like message: nested serializers appended to the outer one
+static void build_nested_message(Serializer &rez, size_t entries, bool splice)
+{
+  rez.serialize<size_t>(entries);
+  Serializer child_rez;
+  for (size_t i = 0; i < entries; i++) {
+    Serializer state_rez;
+    for (size_t j = 0; j < 16; j++) {
+      state_rez.serialize<unsigned long long>(i * 16 + j);
+      state_rez.serialize<unsigned long long>(~(i * 16 + j));
+    }
+    if (splice)
+      child_rez.splice(state_rez);
+    else
+      child_rez.serialize(state_rez.get_buffer(), state_rez.get_used_bytes());
+  }
+  if (splice)
+    rez.splice(child_rez);
+  else
+    rez.serialize(child_rez.get_buffer(), child_rez.get_used_bytes());
+}
+
+static void report(const char *name, const char *mode, size_t msg_bytes,
+                   size_t rez_copied, size_t channel_copied, long long ns)
+{
+  printf("%-24s %-10s %9zd bytes/msg  copied: %10.1f bytes/msg (%4.2fx)  %9.1f ns/msg\n",
+         name, mode, msg_bytes,
+         (double)(rez_copied + channel_copied) / num_reps,
+         (double)(rez_copied + channel_copied) / ((double)msg_bytes * num_reps),
+         (double)ns / num_reps);
+}
+
+static void run_payload(size_t payload_size)
+{
+  std::vector<char> payload(payload_size);
+  for (size_t i = 0; i < payload_size; i++)
+    payload[i] = (char)i;
+  char name[64];
+  snprintf(name, sizeof(name), "payload %zd", payload_size);
+  for (int reference = 0; reference < 2; reference++) {
+    Channel channel(channel_size);
+    size_t rez_copied = 0, msg_bytes = 0;
+    long long t1 = Realm::Clock::current_time_in_nanoseconds();
+    for (int r = 0; r < num_reps; r++) {
+      Serializer rez;
+      build_payload_message(rez, payload, reference);
+      channel.package(rez);
+      rez_copied += rez.get_copied_bytes();
+      msg_bytes = rez.get_used_bytes();
+    }
+    long long t2 = Realm::Clock::current_time_in_nanoseconds();
+    report(name, (reference ? "reference" : "copy"), msg_bytes,
+           rez_copied, channel.bytes_copied, t2 - t1);
+  }
+}
+
+static void run_nested(size_t entries)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "nested %zd", entries);
+  for (int splice = 0; splice < 2; splice++) {
+    Channel channel(channel_size);
+    size_t rez_copied = 0, msg_bytes = 0;
+    long long t1 = Realm::Clock::current_time_in_nanoseconds();
+    for (int r = 0; r < num_reps; r++) {
+      Serializer rez;
+      build_nested_message(rez, entries, splice);
+      channel.package(rez);
+      rez_copied += rez.get_copied_bytes();
+      msg_bytes = rez.get_used_bytes();
+    }
+    long long t2 = Realm::Clock::current_time_in_nanoseconds();
+    report(name, (splice ? "splice" : "copy"), msg_bytes,
+           rez_copied, channel.bytes_copied, t2 - t1);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-reps")) {
+      num_reps = atoi(argv[++i]);
+      continue;
+    }
+    if (!strcmp(argv[i], "-channel")) {
+      channel_size = strtoull(argv[++i], 0, 10);
+      continue;
+    }
+  }
+
+  printf("serializer: %d reps, %zd byte channel buffer\n", num_reps, channel_size);
+  printf("(copied bytes count the serializer's bulk copies and the copy into the channel)\n");
+
+  size_t sizes[] = { 256, 4096, 65536, 1 << 20 };
+  for (unsigned i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++)
+    run_payload(sizes[i]);
+  run_nested(4);
+  run_nested(64);
+  return 0;
+}
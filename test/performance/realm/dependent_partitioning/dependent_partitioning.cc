@@ -0,0 +1,278 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// benchmark for Realm's dependent partitioning operations - builds a random
+//  graph with N nodes and N*D edges and then computes the usual partitions
+//  used by graph codes:
+//   1) owned nodes, by field (node -> color)
+//   2) owned edges, by preimage (edge -> source node)
+//   3) ghost nodes, by image (edge -> destination node), minus the owned nodes
+//
+// use -ll:dpworkers to control how many threads perform the operations
+
+#include "realm/realm.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+
+using namespace Realm;
+using namespace LegionRuntime::Accessor;
+
+Logger log_app("app");
+
+// Task IDs, some IDs are reserved so start at first available number
+enum {
+  TOP_LEVEL_TASK = Processor::TASK_ID_FIRST_AVAILABLE+0,
+};
+
+static size_t num_nodes = 10000000;
+static size_t edges_per_node = 1;
+static int num_pieces = 16;
+// fraction of edges that leave a node's piece
+static double cross_fraction = 0.05;
+static unsigned random_seed = 12345;
+
+static RegionInstance create_field_instance(Memory m, IndexSpace is, size_t elmt_size)
+{
+  RegionInstance inst = Domain(is).create_instance(m, elmt_size);
+  assert(inst.exists());
+  return inst;
+}
+
+static double elapsed_sec(long long t1, long long t2)
+{
+  return 1e-9 * (t2 - t1);
+}
+
+static size_t total_size(const std::map<IndexSpace, IndexSpace>& m)
+{
+  size_t total = 0;
+  for(std::map<IndexSpace, IndexSpace>::const_iterator it = m.begin(); it != m.end(); it++)
+    total += it->second.get_valid_mask().pop_count();
+  return total;
+}
+
+void top_level_task(const void *args, size_t arglen, 
+		    const void *userdata, size_t userlen, Processor p)
+{
+  size_t num_edges = num_nodes * edges_per_node;
+  log_app.print() << "dependent partitioning: nodes=" << num_nodes << " edges=" << num_edges
+		  << " pieces=" << num_pieces;
+
+  Memory m = Machine::MemoryQuery(Machine::get_machine())
+    .has_affinity_to(p)
+    .only_kind(Memory::SYSTEM_MEM)
+    .first();
+  assert(m.exists());
+
+  IndexSpace nodes = IndexSpace::create_index_space(num_nodes);
+  IndexSpace edges = IndexSpace::create_index_space(num_edges);
+  {
+    IndexSpaceAllocator a = nodes.create_allocator();
+    a.alloc(num_nodes);
+    a.destroy();
+  }
+  {
+    IndexSpaceAllocator a = edges.create_allocator();
+    a.alloc(num_edges);
+    a.destroy();
+  }
+
+  RegionInstance node_color = create_field_instance(m, nodes, sizeof(int));
+  RegionInstance edge_src = create_field_instance(m, edges, sizeof(coord_t));
+  RegionInstance edge_dst = create_field_instance(m, edges, sizeof(coord_t));
+
+  // nodes are colored in contiguous blocks, and most edges stay within a block
+  {
+    RegionAccessor<AccessorType::SOA<0>, int> ra_color =
+      node_color.get_accessor().typeify<int>().convert<AccessorType::SOA<0> >();
+    RegionAccessor<AccessorType::SOA<0>, coord_t> ra_src =
+      edge_src.get_accessor().typeify<coord_t>().convert<AccessorType::SOA<0> >();
+    RegionAccessor<AccessorType::SOA<0>, coord_t> ra_dst =
+      edge_dst.get_accessor().typeify<coord_t>().convert<AccessorType::SOA<0> >();
+
+    unsigned short xsubi[3] = { (unsigned short)random_seed, 0, 0 };
+    for(size_t i = 0; i < num_nodes; i++)
+      ra_color.write(ptr_t(i), (int)((i * num_pieces) / num_nodes));
+    coord_t block = (num_nodes + num_pieces - 1) / num_pieces;
+    for(size_t i = 0; i < num_edges; i++) {
+      coord_t src = i / edges_per_node;
+      coord_t dst;
+      if(erand48(xsubi) < cross_fraction) {
+	dst = (coord_t)(erand48(xsubi) * num_nodes);
+      } else {
+	coord_t base = (src / block) * block;
+	dst = base + (coord_t)(erand48(xsubi) * block);
+      }
+      if(dst >= (coord_t)num_nodes) dst = num_nodes - 1;
+      ra_src.write(ptr_t(i), src);
+      ra_dst.write(ptr_t(i), dst);
+    }
+  }
+
+  // 1) owned nodes by field
+  std::vector<IndexSpace::FieldDataDescriptor> color_data(1);
+  color_data[0].index_space = nodes;
+  color_data[0].inst = node_color;
+  color_data[0].field_offset = 0;
+  color_data[0].field_size = sizeof(int);
+
+  std::map<DomainPoint, IndexSpace> owned_nodes;
+  for(int i = 0; i < num_pieces; i++)
+    owned_nodes[DomainPoint(i)] = IndexSpace::NO_SPACE;
+
+  long long t1 = Clock::current_time_in_nanoseconds();
+  nodes.create_subspaces_by_field(color_data, owned_nodes, false).wait();
+  long long t2 = Clock::current_time_in_nanoseconds();
+
+  size_t owned_total = 0;
+  for(std::map<DomainPoint, IndexSpace>::const_iterator it = owned_nodes.begin();
+      it != owned_nodes.end();
+      it++)
+    owned_total += it->second.get_valid_mask().pop_count();
+  assert(owned_total == num_nodes);
+
+  // 2) owned edges by preimage of the source pointers
+  std::vector<IndexSpace::FieldDataDescriptor> src_data(1);
+  src_data[0].index_space = edges;
+  src_data[0].inst = edge_src;
+  src_data[0].field_offset = 0;
+  src_data[0].field_size = sizeof(coord_t);
+
+  std::map<IndexSpace, IndexSpace> owned_edges;
+  for(std::map<DomainPoint, IndexSpace>::const_iterator it = owned_nodes.begin();
+      it != owned_nodes.end();
+      it++)
+    owned_edges[it->second] = IndexSpace::NO_SPACE;
+
+  long long t3 = Clock::current_time_in_nanoseconds();
+  edges.create_subspaces_by_preimage(src_data, owned_edges, false).wait();
+  long long t4 = Clock::current_time_in_nanoseconds();
+  assert(total_size(owned_edges) == num_edges);
+
+  // 3) ghost nodes by image of the destination pointers, minus owned nodes
+  std::vector<IndexSpace::FieldDataDescriptor> dst_data(1);
+  dst_data[0].index_space = edges;
+  dst_data[0].inst = edge_dst;
+  dst_data[0].field_offset = 0;
+  dst_data[0].field_size = sizeof(coord_t);
+
+  std::map<IndexSpace, IndexSpace> reached_nodes;
+  for(std::map<IndexSpace, IndexSpace>::const_iterator it = owned_edges.begin();
+      it != owned_edges.end();
+      it++)
+    reached_nodes[it->second] = IndexSpace::NO_SPACE;
+
+  long long t5 = Clock::current_time_in_nanoseconds();
+  nodes.create_subspaces_by_image(dst_data, reached_nodes, false).wait();
+  long long t6 = Clock::current_time_in_nanoseconds();
+
+  std::vector<IndexSpace::BinaryOpDescriptor> ghost_ops;
+  for(std::map<IndexSpace, IndexSpace>::const_iterator it = owned_edges.begin();
+      it != owned_edges.end();
+      it++) {
+    IndexSpace::BinaryOpDescriptor bod;
+    bod.op = IndexSpace::ISO_SUBTRACT;
+    bod.parent = nodes;
+    bod.left_operand = reached_nodes[it->second];
+    bod.right_operand = it->first;
+    ghost_ops.push_back(bod);
+  }
+
+  long long t7 = Clock::current_time_in_nanoseconds();
+  IndexSpace::compute_index_spaces(ghost_ops, false).wait();
+  long long t8 = Clock::current_time_in_nanoseconds();
+
+  // all ghosts together, as a check on the reduction path
+  std::vector<IndexSpace> ghost_spaces;
+  for(size_t i = 0; i < ghost_ops.size(); i++)
+    ghost_spaces.push_back(ghost_ops[i].result);
+  IndexSpace all_ghosts;
+  long long t9 = Clock::current_time_in_nanoseconds();
+  IndexSpace::reduce_index_spaces(IndexSpace::ISO_UNION, ghost_spaces, all_ghosts,
+				  false, nodes).wait();
+  long long t10 = Clock::current_time_in_nanoseconds();
+
+  size_t ghost_total = 0;
+  for(size_t i = 0; i < ghost_spaces.size(); i++)
+    ghost_total += ghost_spaces[i].get_valid_mask().pop_count();
+  size_t ghost_union = all_ghosts.get_valid_mask().pop_count();
+  assert(ghost_union <= ghost_total);
+
+  log_app.print() << "by field:  " << elapsed_sec(t1, t2) << " s ("
+		  << (1e-6 * num_nodes / elapsed_sec(t1, t2)) << " M nodes/s)";
+  log_app.print() << "preimage:  " << elapsed_sec(t3, t4) << " s ("
+		  << (1e-6 * num_edges / elapsed_sec(t3, t4)) << " M edges/s)";
+  log_app.print() << "image:     " << elapsed_sec(t5, t6) << " s ("
+		  << (1e-6 * num_edges / elapsed_sec(t5, t6)) << " M edges/s)";
+  log_app.print() << "subtract:  " << elapsed_sec(t7, t8) << " s";
+  log_app.print() << "union:     " << elapsed_sec(t9, t10) << " s";
+  log_app.print() << "ghost nodes: " << ghost_total << " (" << ghost_union << " distinct)";
+
+  node_color.destroy();
+  edge_src.destroy();
+  edge_dst.destroy();
+}
+
+int main(int argc, char **argv)
+{
+  Runtime rt;
+
+  rt.init(&argc, &argv);
+
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-n")) {
+      num_nodes = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+    if(!strcmp(argv[i], "-d")) {
+      edges_per_node = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+    if(!strcmp(argv[i], "-p")) {
+      num_pieces = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-x")) {
+      cross_fraction = atof(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-seed")) {
+      random_seed = atoi(argv[++i]);
+      continue;
+    }
+  }
+
+  rt.register_task(TOP_LEVEL_TASK, top_level_task);
+
+  // select a processor to run the top level task on
+  Processor p = Machine::ProcessorQuery(Machine::get_machine())
+    .only_kind(Processor::LOC_PROC)
+    .first();
+  assert(p.exists());
+
+  // collective launch of a single task - everybody gets the same finish event
+  Event e = rt.collective_spawn(p, TOP_LEVEL_TASK, 0, 0);
+
+  // request shutdown once that task is complete
+  rt.shutdown(e);
+
+  // now sleep this thread until that shutdown actually happens
+  rt.wait_for_shutdown();
+  
+  return 0;
+}
@@ -0,0 +1,261 @@
+/* Copyright 2017 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// measures how the DMA threads behave under a mixed copy workload:
+//  - latency of small system memory copies, alone and while large disk
+//    copies are in flight
+//  - how much CPU the process burns while it's doing nothing but waiting
+//    on copies (ideally close to zero, since the DMA threads should sleep)
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+
+#include <set>
+#include <vector>
+
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "lowlevel.h"
+#include "realm/timers.h"
+
+using namespace LegionRuntime::LowLevel;
+using namespace LegionRuntime::Accessor;
+using namespace LegionRuntime::Arrays;
+
+// Task IDs, some IDs are reserved so start at first available number
+enum {
+  TOP_LEVEL_TASK = Processor::TASK_ID_FIRST_AVAILABLE+0,
+};
+
+static size_t small_elements = 4096;
+static size_t large_elements = 1 << 20;
+static int num_small_copies = 1000;
+static int num_large_copies = 8;
+
+static double process_cpu_time(void)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+	  1e-6 * (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec));
+}
+
+static Memory find_memory(Memory::Kind kind)
+{
+  std::set<Memory> mems;
+  Machine::get_machine().get_all_memories(mems);
+  for(std::set<Memory>::const_iterator it = mems.begin(); it != mems.end(); it++)
+    if(it->kind() == kind)
+      return *it;
+  return Memory::NO_MEMORY;
+}
+
+static Domain make_domain(size_t elements)
+{
+  Rect<1> r(make_point(0), make_point(elements - 1));
+  return Domain::from_rect<1>(r);
+}
+
+static RegionInstance make_instance(const Domain& d, Memory m, size_t elements)
+{
+  std::vector<size_t> field_sizes(1, sizeof(long long));
+  RegionInstance inst = d.create_instance(m, field_sizes, elements);
+  assert(inst.exists());
+  return inst;
+}
+
+static Event copy(const Domain& d, RegionInstance src, RegionInstance dst,
+		  Event wait_on = Event::NO_EVENT)
+{
+  std::vector<Domain::CopySrcDstField> srcs, dsts;
+  srcs.push_back(Domain::CopySrcDstField(src, 0, sizeof(long long)));
+  dsts.push_back(Domain::CopySrcDstField(dst, 0, sizeof(long long)));
+  return d.copy(srcs, dsts, wait_on);
+}
+
+// runs small copies one at a time, returning the average latency
+static double small_copy_latency(const Domain& d, RegionInstance src,
+				 RegionInstance dst, int count)
+{
+  double t_start = Realm::Clock::current_time();
+  for(int i = 0; i < count; i++)
+    copy(d, src, dst).wait();
+  double t_end = Realm::Clock::current_time();
+  return (t_end - t_start) / count;
+}
+
+void top_level_task(const void *args, size_t arglen,
+		    const void *userdata, size_t userlen, Processor p)
+{
+  Memory sysmem = find_memory(Memory::SYSTEM_MEM);
+  Memory diskmem = find_memory(Memory::DISK_MEM);
+  assert(sysmem.exists());
+
+  printf("Realm DMA progress test - small=%zd large=%zd x %d\n",
+	 small_elements, large_elements, num_large_copies);
+
+  Domain small_d = make_domain(small_elements);
+  RegionInstance small_src = make_instance(small_d, sysmem, small_elements);
+  RegionInstance small_dst = make_instance(small_d, sysmem, small_elements);
+
+  // warm up
+  small_copy_latency(small_d, small_src, small_dst, 10);
+
+  double alone = small_copy_latency(small_d, small_src, small_dst, num_small_copies);
+  printf("small copy latency (alone):        %8.1f us\n", 1e6 * alone);
+
+  if(!diskmem.exists()) {
+    printf("no disk memory (use -ll:dsize) - skipping mixed tests\n");
+    small_src.destroy();
+    small_dst.destroy();
+    return;
+  }
+
+  Domain large_d = make_domain(large_elements);
+  RegionInstance large_src = make_instance(large_d, sysmem, large_elements);
+  std::vector<RegionInstance> large_sys(num_large_copies), large_disk(num_large_copies);
+  for(int i = 0; i < num_large_copies; i++) {
+    large_sys[i] = make_instance(large_d, sysmem, large_elements);
+    large_disk[i] = make_instance(large_d, diskmem, large_elements);
+  }
+
+  {
+    RegionAccessor<AccessorType::Generic> acc = large_src.get_accessor();
+    for(size_t i = 0; i < large_elements; i++) {
+      long long v = 3 * i + 1;
+      acc.write_untyped(ptr_t(i), &v, sizeof(v));
+    }
+  }
+
+  // round trips through disk memory, with small copies running alongside
+  std::set<Event> done;
+  double cpu_start = process_cpu_time();
+  double t_start = Realm::Clock::current_time();
+  for(int i = 0; i < num_large_copies; i++) {
+    Event e = copy(large_d, large_src, large_disk[i]);
+    done.insert(copy(large_d, large_disk[i], large_sys[i], e));
+  }
+  Event all_done = Event::merge_events(done);
+  double mixed = small_copy_latency(small_d, small_src, small_dst, num_small_copies);
+  all_done.wait();
+  double t_end = Realm::Clock::current_time();
+  double cpu_end = process_cpu_time();
+  printf("small copy latency (mixed):        %8.1f us\n", 1e6 * mixed);
+  printf("mixed workload:                    %8.3f s wall, %.3f s cpu\n",
+	 t_end - t_start, cpu_end - cpu_start);
+
+  // now the same round trips, with nothing else to do but wait
+  done.clear();
+  cpu_start = process_cpu_time();
+  t_start = Realm::Clock::current_time();
+  for(int i = 0; i < num_large_copies; i++) {
+    Event e = copy(large_d, large_src, large_disk[i]);
+    done.insert(copy(large_d, large_disk[i], large_sys[i], e));
+  }
+  Event::merge_events(done).wait();
+  t_end = Realm::Clock::current_time();
+  cpu_end = process_cpu_time();
+  printf("disk round trips (waiting only):   %8.3f s wall, %.3f s cpu (%.0f%% of a core)\n",
+	 t_end - t_start, cpu_end - cpu_start,
+	 100.0 * (cpu_end - cpu_start) / (t_end - t_start));
+
+  // check the data made it there and back
+  int errors = 0;
+  for(int i = 0; i < num_large_copies; i++) {
+    RegionAccessor<AccessorType::Generic> acc = large_sys[i].get_accessor();
+    for(size_t j = 0; j < large_elements; j += 997) {
+      long long v;
+      acc.read_untyped(ptr_t(j), &v, sizeof(v));
+      if(v != (long long)(3 * j + 1)) {
+	if(errors++ < 10)
+	  printf("ERROR: copy %d element %zd = %lld (expected %lld)\n",
+		 i, j, v, (long long)(3 * j + 1));
+      }
+    }
+  }
+
+  for(int i = 0; i < num_large_copies; i++) {
+    large_sys[i].destroy();
+    large_disk[i].destroy();
+  }
+  large_src.destroy();
+  small_src.destroy();
+  small_dst.destroy();
+
+  if(errors > 0)
+    exit(1);
+
+  printf("all done!\n");
+}
+
+int main(int argc, char **argv)
+{
+  Runtime rt;
+
+  rt.init(&argc, &argv);
+
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-s")) {
+      small_elements = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-l")) {
+      large_elements = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-n")) {
+      num_large_copies = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-r")) {
+      num_small_copies = atoi(argv[++i]);
+      continue;
+    }
+  }
+
+  rt.register_task(TOP_LEVEL_TASK, top_level_task);
+
+  // select a processor to run the top level task on
+  Processor p = Processor::NO_PROC;
+  {
+    std::set<Processor> all_procs;
+    Machine::get_machine().get_all_processors(all_procs);
+    for(std::set<Processor>::const_iterator it = all_procs.begin();
+	it != all_procs.end();
+	it++)
+      if(it->kind() == Processor::LOC_PROC) {
+	p = *it;
+	break;
+      }
+  }
+  assert(p.exists());
+
+  // collective launch of a single task - everybody gets the same finish event
+  Event e = rt.collective_spawn(p, TOP_LEVEL_TASK, 0, 0);
+
+  // request shutdown once that task is complete
+  rt.shutdown(e);
+
+  // now sleep this thread until that shutdown actually happens
+  rt.wait_for_shutdown();
+
+  return 0;
+}
@@ -0,0 +1,225 @@
+/* Copyright 2017 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// stresses the runtime's ID tables from many threads at once:
+//  - event creation (free list allocation and growth of the table)
+//  - event lookup (walking the table for existing entries)
+//  - reservation create/destroy (allocation and return to the free list)
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+
+#include <vector>
+#include <set>
+
+#include <pthread.h>
+
+#include "realm/realm.h"
+#include "realm/timers.h"
+
+using namespace Realm;
+
+// Task IDs, some IDs are reserved so start at first available number
+enum {
+  TOP_LEVEL_TASK = Processor::TASK_ID_FIRST_AVAILABLE+0,
+};
+
+static int num_threads = 64;
+static int events_per_thread = 4096;
+static int lookups_per_thread = 100000;
+static int rsrvs_per_thread = 10000;
+
+enum Phase {
+  PHASE_CREATE,
+  PHASE_LOOKUP,
+  PHASE_RSRV,
+};
+
+struct ThreadArgs {
+  int index;
+  Phase phase;
+  pthread_barrier_t *start_barrier;
+  std::vector<UserEvent> *events;  // all events, indexed by thread first
+  int bad_lookups;
+};
+
+static void *worker_thread(void *data)
+{
+  ThreadArgs *args = (ThreadArgs *)data;
+
+  // everybody starts at once to maximize contention
+  pthread_barrier_wait(args->start_barrier);
+
+  switch(args->phase) {
+  case PHASE_CREATE:
+    {
+      int base = args->index * events_per_thread;
+      for(int i = 0; i < events_per_thread; i++)
+	(*args->events)[base + i] = UserEvent::create_user_event();
+      break;
+    }
+
+  case PHASE_LOOKUP:
+    {
+      // a cheap LCG so threads look at different (and other threads') entries
+      unsigned seed = 12345 + args->index;
+      size_t total = args->events->size();
+      for(int i = 0; i < lookups_per_thread; i++) {
+	seed = seed * 1103515245 + 12345;
+	if((*args->events)[(seed >> 8) % total].has_triggered())
+	  args->bad_lookups++;
+      }
+      break;
+    }
+
+  case PHASE_RSRV:
+    {
+      for(int i = 0; i < rsrvs_per_thread; i++) {
+	Reservation r = Reservation::create_reservation();
+	r.destroy_reservation();
+      }
+      break;
+    }
+  }
+
+  return 0;
+}
+
+static double run_phase(Phase phase, std::vector<UserEvent>& events,
+			int& bad_lookups)
+{
+  pthread_barrier_t start_barrier;
+  pthread_barrier_init(&start_barrier, 0, num_threads + 1);
+
+  std::vector<ThreadArgs> args(num_threads);
+  std::vector<pthread_t> threads(num_threads);
+  for(int i = 0; i < num_threads; i++) {
+    args[i].index = i;
+    args[i].phase = phase;
+    args[i].start_barrier = &start_barrier;
+    args[i].events = &events;
+    args[i].bad_lookups = 0;
+    int ret = pthread_create(&threads[i], 0, worker_thread, &args[i]);
+    assert(ret == 0);
+  }
+
+  pthread_barrier_wait(&start_barrier);
+  double t_start = Clock::current_time();
+  for(int i = 0; i < num_threads; i++) {
+    pthread_join(threads[i], 0);
+    bad_lookups += args[i].bad_lookups;
+  }
+  double t_end = Clock::current_time();
+
+  pthread_barrier_destroy(&start_barrier);
+  return t_end - t_start;
+}
+
+void top_level_task(const void *args, size_t arglen,
+		    const void *userdata, size_t userlen, Processor p)
+{
+  printf("Realm dynamic table test - threads=%d events/thread=%d lookups/thread=%d rsrvs/thread=%d\n",
+	 num_threads, events_per_thread, lookups_per_thread, rsrvs_per_thread);
+
+  std::vector<UserEvent> events(num_threads * events_per_thread);
+  int bad_lookups = 0;
+
+  double create_time = run_phase(PHASE_CREATE, events, bad_lookups);
+  double lookup_time = run_phase(PHASE_LOOKUP, events, bad_lookups);
+  double rsrv_time = run_phase(PHASE_RSRV, events, bad_lookups);
+
+  // every event should be distinct
+  std::set<Event> unique(events.begin(), events.end());
+  if(unique.size() != events.size()) {
+    printf("ERROR: %zd events created, but only %zd unique\n",
+	   events.size(), unique.size());
+    exit(1);
+  }
+  if(bad_lookups > 0) {
+    printf("ERROR: %d lookups found a triggered event\n", bad_lookups);
+    exit(1);
+  }
+
+  for(size_t i = 0; i < events.size(); i++)
+    events[i].trigger();
+
+  printf("event create:       %8.1f ns/op (%.3f s)\n",
+	 1e9 * create_time / ((double)num_threads * events_per_thread), create_time);
+  printf("event lookup:       %8.1f ns/op (%.3f s)\n",
+	 1e9 * lookup_time / ((double)num_threads * lookups_per_thread), lookup_time);
+  printf("rsrv create/destroy:%8.1f ns/op (%.3f s)\n",
+	 1e9 * rsrv_time / ((double)num_threads * rsrvs_per_thread), rsrv_time);
+
+  printf("all done!\n");
+}
+
+int main(int argc, char **argv)
+{
+  Runtime rt;
+
+  rt.init(&argc, &argv);
+
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-t")) {
+      num_threads = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-e")) {
+      events_per_thread = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-l")) {
+      lookups_per_thread = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-r")) {
+      rsrvs_per_thread = atoi(argv[++i]);
+      continue;
+    }
+  }
+
+  rt.register_task(TOP_LEVEL_TASK, top_level_task);
+
+  // select a processor to run the top level task on
+  Processor p = Processor::NO_PROC;
+  {
+    std::set<Processor> all_procs;
+    Machine::get_machine().get_all_processors(all_procs);
+    for(std::set<Processor>::const_iterator it = all_procs.begin();
+	it != all_procs.end();
+	it++)
+      if(it->kind() == Processor::LOC_PROC) {
+	p = *it;
+	break;
+      }
+  }
+  assert(p.exists());
+
+  // collective launch of a single task - everybody gets the same finish event
+  Event e = rt.collective_spawn(p, TOP_LEVEL_TASK, 0, 0);
+
+  // request shutdown once that task is complete
+  rt.shutdown(e);
+
+  // now sleep this thread until that shutdown actually happens
+  rt.wait_for_shutdown();
+
+  return 0;
+}
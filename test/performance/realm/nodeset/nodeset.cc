@@ -0,0 +1,142 @@
+/* Copyright 2017 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// measures the cost of the node sets that events, reservations and metadata
+//  use to track remote waiters/copies, for a range of set sizes:
+//  - memory per set (the object itself plus anything it allocates)
+//  - time to build a set
+//  - time to walk the set, as a broadcast to all members does
+// this exercises the data structure directly, so no runtime is started and
+//  the machine size is whatever -n says
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+
+#include <vector>
+
+#include <malloc.h>
+
+#include "realm/nodeset.h"
+#include "realm/timers.h"
+
+using namespace Realm;
+
+static int num_nodes = 1024;
+static int num_sets = 100000;
+static int num_reps = 10;
+
+static size_t heap_in_use(void)
+{
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 33))
+  struct mallinfo2 mi = mallinfo2();
+#else
+  struct mallinfo mi = mallinfo();
+#endif
+  // big blocks (e.g. the array of sets) come from mmap instead of the heap
+  return mi.uordblks + mi.hblkhd;
+}
+
+// stands in for sending a message to each member
+struct BroadcastFunctor {
+  BroadcastFunctor(void) : sum(0) {}
+  inline void apply(int target) { sum += target; }
+  long long sum;
+};
+
+static void test_members(int members)
+{
+  // pick the members ahead of time so only the set operations are timed
+  std::vector<int> picks(members * (size_t)num_sets);
+  unsigned seed = 12345 + members;
+  for(size_t i = 0; i < picks.size(); i++) {
+    seed = seed * 1103515245 + 12345;
+    picks[i] = (seed >> 8) % num_nodes;
+  }
+
+  size_t heap_before = heap_in_use();
+  double t_start = Clock::current_time();
+  std::vector<NodeSet> *sets = new std::vector<NodeSet>(num_sets);
+  for(int s = 0; s < num_sets; s++)
+    for(int i = 0; i < members; i++)
+      (*sets)[s].add(picks[s * (size_t)members + i]);
+  double t_build = Clock::current_time() - t_start;
+  size_t heap_after = heap_in_use();
+
+  size_t total_members = 0;
+  for(int s = 0; s < num_sets; s++)
+    total_members += (*sets)[s].size();
+
+  BroadcastFunctor bf;
+  t_start = Clock::current_time();
+  for(int r = 0; r < num_reps; r++)
+    for(int s = 0; s < num_sets; s++)
+      (*sets)[s].map(bf);
+  double t_map = Clock::current_time() - t_start;
+
+  // count the members we saw, to keep the broadcast loop honest
+  if(bf.sum < 0)
+    printf("impossible\n");
+
+  double bytes = (double)(heap_after - heap_before) / num_sets;
+  printf("%8d %10.1f %12.1f %14.1f %14.2f\n",
+	 members,
+	 (double)total_members / num_sets,
+	 bytes,
+	 1e9 * t_build / num_sets,
+	 1e9 * t_map / ((double)num_reps * num_sets));
+
+  delete sets;
+}
+
+int main(int argc, char **argv)
+{
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-n")) {
+      num_nodes = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-s")) {
+      num_sets = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-r")) {
+      num_reps = atoi(argv[++i]);
+      continue;
+    }
+  }
+
+  NodeSet::configure(num_nodes);
+
+  printf("Realm node set test - nodes=%d sets=%d reps=%d sizeof(NodeSet)=%zd\n",
+	 num_nodes, num_sets, num_reps, sizeof(NodeSet));
+  printf(" members   distinct  bytes/set(*)  build ns/set  walk ns/set\n");
+
+  int sizes[] = { 0, 1, 3, 8, 32, 256, 1024 };
+  for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    // each set gets its members from a pick-with-replacement of the nodes,
+    //  so don't bother asking for more picks than the set can hold
+    if((sizes[i] > num_nodes) || ((size_t)sizes[i] * num_sets > ((size_t)1 << 28)))
+      continue;
+    test_members(sizes[i]);
+  }
+  printf("(*) includes sizeof(NodeSet)\n");
+
+  printf("all done!\n");
+  return 0;
+}
@@ -0,0 +1,316 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// microbenchmark for the vectorized apply/fold kernels of the built-in
+//  reduction operators - each operator is compared against an equivalent
+//  user-defined operator that goes through the scalar ReductionOp path
+//  (set REALM_REDOP_ISA=scalar/avx2 to compare instruction sets)
+// with -dma, the same comparison is made with reduction copies between
+//  system memory instances, which apply non-exclusively through the DMA
+//  system's reduction copiers
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+#include <set>
+#include <vector>
+
+#include "lowlevel.h"
+#include "realm/redop.h"
+#include "realm/timers.h"
+
+using namespace Realm;
+using namespace LegionRuntime::Accessor;
+using namespace LegionRuntime::Arrays;
+
+// Task IDs, some IDs are reserved so start at first available number
+enum {
+  TOP_LEVEL_TASK = Processor::TASK_ID_FIRST_AVAILABLE+0,
+};
+
+// reduction op IDs for the -dma cases - each built-in operator is
+//  registered next to its scalar equivalent
+enum {
+  REDOP_SUM_DOUBLE = 1,
+  REDOP_SUM_DOUBLE_SCALAR,
+  REDOP_MAX_DOUBLE,
+  REDOP_MAX_DOUBLE_SCALAR,
+  REDOP_SUM_FLOAT,
+  REDOP_SUM_FLOAT_SCALAR,
+  REDOP_SUM_INT64,
+  REDOP_SUM_INT64_SCALAR,
+};
+
+// same operator as the built-in, but without the vectorized kernels
+template <BuiltinReductionKind KIND, typename T>
+struct ScalarReduction {
+  typedef T LHS;
+  typedef T RHS;
+  static const RHS identity;
+  template <bool EXCL>
+  static void apply(LHS& lhs, RHS rhs)
+  {
+    BuiltinReduction<KIND,T>::template apply<EXCL>(lhs, rhs);
+  }
+  template <bool EXCL>
+  static void fold(RHS& rhs1, RHS rhs2)
+  {
+    BuiltinReduction<KIND,T>::template fold<EXCL>(rhs1, rhs2);
+  }
+};
+
+template <BuiltinReductionKind KIND, typename T>
+/*static*/ const T ScalarReduction<KIND,T>::identity = BuiltinReduction<KIND,T>::identity;
+
+static size_t num_elements = 1 << 22;
+static int num_reps = 10;
+
+template <typename T>
+static void init_values(std::vector<T>& v, unsigned seed)
+{
+  srand48(seed);
+  for(size_t i = 0; i < v.size(); i++)
+    v[i] = (T)(lrand48() % 1000) - (T)500;
+}
+
+// returns bandwidth in GB/s (counting both the lhs and rhs reads)
+template <typename T>
+static double time_apply(const ReductionOpUntyped *redop, std::vector<T>& lhs,
+			 const std::vector<T>& rhs, bool exclusive)
+{
+  long long t1 = Clock::current_time_in_nanoseconds();
+  for(int r = 0; r < num_reps; r++)
+    redop->apply(&lhs[0], &rhs[0], lhs.size(), exclusive);
+  long long t2 = Clock::current_time_in_nanoseconds();
+  return (2.0 * num_reps * lhs.size() * sizeof(T) / (t2 - t1));
+}
+
+template <BuiltinReductionKind KIND, typename T>
+static bool run_case(const char *name)
+{
+  ReductionOpUntyped *vec_op;
+  ReductionOpUntyped *scalar_op;
+  switch(KIND) {
+  case REDUCE_SUM:
+    vec_op = ReductionOpUntyped::create_reduction_op<SumReduction<T> >();
+    break;
+  case REDUCE_MAX:
+    vec_op = ReductionOpUntyped::create_reduction_op<MaxReduction<T> >();
+    break;
+  default:
+    vec_op = ReductionOpUntyped::create_reduction_op<MinReduction<T> >();
+    break;
+  }
+  scalar_op = ReductionOpUntyped::create_reduction_op<ScalarReduction<KIND,T> >();
+
+  std::vector<T> rhs(num_elements), lhs_vec(num_elements), lhs_scalar(num_elements);
+  init_values(rhs, 12345);
+  bool ok = true;
+  for(int excl = 1; excl >= 0; excl--) {
+    init_values(lhs_vec, 54321);
+    init_values(lhs_scalar, 54321);
+    double scalar_bw = time_apply(scalar_op, lhs_scalar, rhs, excl);
+    double vec_bw = time_apply(vec_op, lhs_vec, rhs, excl);
+    // every element sees the same sequence of updates, so results must be
+    //  bitwise identical
+    bool match = (memcmp(&lhs_vec[0], &lhs_scalar[0], num_elements * sizeof(T)) == 0);
+    printf("%-12s %-13s scalar: %7.3f GB/s  vectorized: %7.3f GB/s  speedup: %5.2fx %s\n",
+	   name, (excl ? "exclusive" : "non-exclusive"),
+	   scalar_bw, vec_bw, vec_bw / scalar_bw, (match ? "" : "MISMATCH"));
+    if(!match) ok = false;
+  }
+  delete vec_op;
+  delete scalar_op;
+  return ok;
+}
+
+static Memory find_memory(Memory::Kind kind)
+{
+  std::set<Memory> mems;
+  Machine::get_machine().get_all_memories(mems);
+  for(std::set<Memory>::const_iterator it = mems.begin(); it != mems.end(); it++)
+    if(it->kind() == kind)
+      return *it;
+  return Memory::NO_MEMORY;
+}
+
+template <typename T>
+static RegionInstance make_instance(const Domain& d, Memory m, const std::vector<T>& values)
+{
+  std::vector<size_t> field_sizes(1, sizeof(T));
+  RegionInstance inst = d.create_instance(m, field_sizes, values.size());
+  assert(inst.exists());
+  RegionAccessor<AccessorType::Generic> acc = inst.get_accessor();
+  for(size_t i = 0; i < values.size(); i++)
+    acc.write_untyped(ptr_t(i), &values[i], sizeof(T));
+  return inst;
+}
+
+// returns bandwidth in GB/s of reduction copies from 'src' into 'dst'
+template <typename T>
+static double time_reduce_copy(const Domain& d, RegionInstance src, RegionInstance dst,
+			       ReductionOpID redop_id)
+{
+  std::vector<Domain::CopySrcDstField> srcs, dsts;
+  srcs.push_back(Domain::CopySrcDstField(src, 0, sizeof(T)));
+  dsts.push_back(Domain::CopySrcDstField(dst, 0, sizeof(T)));
+  long long t1 = Clock::current_time_in_nanoseconds();
+  for(int r = 0; r < num_reps; r++)
+    d.copy(srcs, dsts, Event::NO_EVENT, redop_id, false /*!fold*/).wait();
+  long long t2 = Clock::current_time_in_nanoseconds();
+  return (2.0 * num_reps * num_elements * sizeof(T) / (t2 - t1));
+}
+
+template <typename T>
+static bool run_dma_case(const char *name, Memory m,
+			 ReductionOpID vec_id, ReductionOpID scalar_id)
+{
+  Domain d = Domain::from_rect<1>(Rect<1>(make_point(0), make_point(num_elements - 1)));
+  std::vector<T> rhs(num_elements), lhs(num_elements);
+  init_values(rhs, 12345);
+  init_values(lhs, 54321);
+  RegionInstance src = make_instance(d, m, rhs);
+  RegionInstance dst_vec = make_instance(d, m, lhs);
+  RegionInstance dst_scalar = make_instance(d, m, lhs);
+
+  double scalar_bw = time_reduce_copy<T>(d, src, dst_scalar, scalar_id);
+  double vec_bw = time_reduce_copy<T>(d, src, dst_vec, vec_id);
+
+  bool match = true;
+  RegionAccessor<AccessorType::Generic> acc_vec = dst_vec.get_accessor();
+  RegionAccessor<AccessorType::Generic> acc_scalar = dst_scalar.get_accessor();
+  for(size_t i = 0; match && (i < num_elements); i++) {
+    T v1, v2;
+    acc_vec.read_untyped(ptr_t(i), &v1, sizeof(T));
+    acc_scalar.read_untyped(ptr_t(i), &v2, sizeof(T));
+    match = (memcmp(&v1, &v2, sizeof(T)) == 0);
+  }
+  printf("%-12s %-13s scalar: %7.3f GB/s  vectorized: %7.3f GB/s  speedup: %5.2fx %s\n",
+	 name, "reduce copy", scalar_bw, vec_bw, vec_bw / scalar_bw,
+	 (match ? "" : "MISMATCH"));
+
+  src.destroy();
+  dst_vec.destroy();
+  dst_scalar.destroy();
+  return match;
+}
+
+void top_level_task(const void *args, size_t arglen,
+		    const void *userdata, size_t userlen, Processor p)
+{
+  Memory sysmem = find_memory(Memory::SYSTEM_MEM);
+  assert(sysmem.exists());
+
+  printf("reduction copies: %zd elements, %d reps\n", num_elements, num_reps);
+
+  bool ok = true;
+  ok &= run_dma_case<double>("sum double", sysmem, REDOP_SUM_DOUBLE, REDOP_SUM_DOUBLE_SCALAR);
+  ok &= run_dma_case<double>("max double", sysmem, REDOP_MAX_DOUBLE, REDOP_MAX_DOUBLE_SCALAR);
+  ok &= run_dma_case<float>("sum float", sysmem, REDOP_SUM_FLOAT, REDOP_SUM_FLOAT_SCALAR);
+  ok &= run_dma_case<int64_t>("sum int64", sysmem, REDOP_SUM_INT64, REDOP_SUM_INT64_SCALAR);
+
+  if(!ok)
+    exit(1);
+}
+
+static int run_dma(int argc, char **argv)
+{
+  Runtime rt;
+
+  rt.init(&argc, &argv);
+
+  rt.register_task(TOP_LEVEL_TASK, top_level_task);
+  rt.register_reduction(REDOP_SUM_DOUBLE,
+			ReductionOpUntyped::create_reduction_op<SumReduction<double> >());
+  rt.register_reduction(REDOP_SUM_DOUBLE_SCALAR,
+			ReductionOpUntyped::create_reduction_op<ScalarReduction<REDUCE_SUM, double> >());
+  rt.register_reduction(REDOP_MAX_DOUBLE,
+			ReductionOpUntyped::create_reduction_op<MaxReduction<double> >());
+  rt.register_reduction(REDOP_MAX_DOUBLE_SCALAR,
+			ReductionOpUntyped::create_reduction_op<ScalarReduction<REDUCE_MAX, double> >());
+  rt.register_reduction(REDOP_SUM_FLOAT,
+			ReductionOpUntyped::create_reduction_op<SumReduction<float> >());
+  rt.register_reduction(REDOP_SUM_FLOAT_SCALAR,
+			ReductionOpUntyped::create_reduction_op<ScalarReduction<REDUCE_SUM, float> >());
+  rt.register_reduction(REDOP_SUM_INT64,
+			ReductionOpUntyped::create_reduction_op<SumReduction<int64_t> >());
+  rt.register_reduction(REDOP_SUM_INT64_SCALAR,
+			ReductionOpUntyped::create_reduction_op<ScalarReduction<REDUCE_SUM, int64_t> >());
+
+  // select a processor to run the top level task on
+  Processor p = Processor::NO_PROC;
+  {
+    std::set<Processor> all_procs;
+    Machine::get_machine().get_all_processors(all_procs);
+    for(std::set<Processor>::const_iterator it = all_procs.begin();
+	it != all_procs.end();
+	it++)
+      if(it->kind() == Processor::LOC_PROC) {
+	p = *it;
+	break;
+      }
+  }
+  assert(p.exists());
+
+  // collective launch of a single task - everybody gets the same finish event
+  Event e = rt.collective_spawn(p, TOP_LEVEL_TASK, 0, 0);
+
+  // request shutdown once that task is complete
+  rt.shutdown(e);
+
+  // now sleep this thread until that shutdown actually happens
+  rt.wait_for_shutdown();
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  bool dma = false;
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-dma")) {
+      dma = true;
+      continue;
+    }
+    if(!strcmp(argv[i], "-n")) {
+      num_elements = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+    if(!strcmp(argv[i], "-reps")) {
+      num_reps = atoi(argv[++i]);
+      continue;
+    }
+  }
+
+  if(dma)
+    return run_dma(argc, argv);
+
+  printf("reduction kernels: %zd elements, %d reps\n", num_elements, num_reps);
+
+  bool ok = true;
+  ok &= run_case<REDUCE_SUM, int32_t>("sum int32");
+  ok &= run_case<REDUCE_SUM, int64_t>("sum int64");
+  ok &= run_case<REDUCE_SUM, float>("sum float");
+  ok &= run_case<REDUCE_SUM, double>("sum double");
+  ok &= run_case<REDUCE_MAX, int32_t>("max int32");
+  ok &= run_case<REDUCE_MAX, int64_t>("max int64");
+  ok &= run_case<REDUCE_MAX, float>("max float");
+  ok &= run_case<REDUCE_MAX, double>("max double");
+  ok &= run_case<REDUCE_MIN, int32_t>("min int32");
+  ok &= run_case<REDUCE_MIN, double>("min double");
+
+  return (ok ? 0 : 1);
+}
@@ -27,6 +27,7 @@
 
 using namespace Realm;
 using namespace LegionRuntime::Accessor;
+using namespace LegionRuntime::Arrays;
 
 namespace TestConfig {
   int tasks_per_processor = 256;
@@ -34,6 +35,7 @@ namespace TestConfig {
   int task_argument_size = 0;
   bool remote_tasks = false;
   bool with_profiling = false;
+  bool use_groups = false;
 };
 
 // TASK IDs
@@ -51,6 +53,7 @@ enum TaskOrder {
   FIRST_TASK = 10,
   MIDDLE_TASK = 9,
   LAST_TASK = 8,
+  GROUP_TASK = 7,  // tasks spawned onto a processor group (-group)
 };
 
 struct TestTaskArgs {
@@ -77,6 +80,24 @@ void dummy_task(const void *args, size_t arglen,
   RegionAccessor<AccessorType::Affine<1>, TestTaskData> ra = ta.instance.get_accessor().typeify<TestTaskData>().convert<AccessorType::Affine<1> >();
   TestTaskData& mydata = ra[0];
 
+  if(task_type == GROUP_TASK) {
+    // group tasks run concurrently on all the members, so there's no
+    //  "first" or "last" - the first to start records the time and the
+    //  last to finish reports
+    if(__sync_bool_compare_and_swap(&mydata.first_count, 0, 1))
+      mydata.start_time = Clock::current_time();
+    int done = __sync_add_and_fetch(&mydata.last_count, 1);
+    if(done == mydata.total_tasks) {
+      double elapsed = Clock::current_time() - mydata.start_time;
+      double per_task = elapsed / done;
+      log_app.print() << "group tasks complete (last on " << p << "): "
+		      << (1e6 * per_task) << " us/task, "
+		      << (1.0 / per_task) << " tasks/s";
+      ta.finish_barrier.arrive();
+    }
+    return;
+  }
+
   if(task_type == FIRST_TASK) {
     double t = Clock::current_time();
     log_app.debug() << "first task on " << p << ": " << t;
@@ -145,6 +166,32 @@ void task_launcher(const void *args, size_t arglen,
     argsize = TestConfig::task_argument_size;
   TestTaskArgs *tta = (TestTaskArgs *)(alloca(argsize));
 
+  // in group mode, all the tasks go to one group made of the processors we'd
+  //  otherwise target individually, and they all share one counter
+  if(TestConfig::use_groups) {
+    std::vector<Processor> members(pq.begin(), pq.end());
+    Processor group = Processor::create_group(members);
+
+    RegionAccessor<AccessorType::Affine<1>, TestTaskData> ra = la.instances[p].get_accessor().typeify<TestTaskData>().convert<AccessorType::Affine<1> >();
+    ra[0].total_tasks = TestConfig::tasks_per_processor * members.size();
+
+    tta->which_task = GROUP_TASK;
+    tta->instance = la.instances[p];
+    tta->finish_barrier = la.finish_barrier;
+
+    double t1 = Clock::current_time();
+    for(int i = 0; i < ra[0].total_tasks; i++)
+      group.spawn(DUMMY_TASK, tta, argsize, prs, la.start_barrier, GROUP_TASK);
+    double t2 = Clock::current_time();
+
+    double spawn_rate = ra[0].total_tasks / (t2 - t1);
+    log_app.print() << "spawn rate on " << p << " (group of " << members.size()
+		    << "): " << spawn_rate << " tasks/s";
+
+    la.start_barrier.arrive();
+    return;
+  }
+
   // time how long this takes us
   double t1 = Clock::current_time();
   int total_tasks = 0;
@@ -216,7 +263,11 @@ void top_level_task(const void *args, size_t arglen,
   // 2) one triggered by each processor when all task launches have been seen
   launch_args.start_barrier = Barrier::create_barrier(all_procs.size() * 
 						      TestConfig::launching_processors);
-  launch_args.finish_barrier = Barrier::create_barrier(total_procs);
+  // (in group mode, each launcher's group arrives once)
+  launch_args.finish_barrier = Barrier::create_barrier(TestConfig::use_groups ?
+						         (all_procs.size() *
+							  TestConfig::launching_processors) :
+						         total_procs);
 
   // serialize the launcher args
   void *args_data;
@@ -259,10 +310,14 @@ int main(int argc, char **argv)
     .add_option_int("-lp", TestConfig::launching_processors)
     .add_option_int("-args", TestConfig::task_argument_size)
     .add_option_bool("-remote", TestConfig::remote_tasks)
-    .add_option_bool("-prof", TestConfig::with_profiling);
+    .add_option_bool("-prof", TestConfig::with_profiling)
+    .add_option_bool("-group", TestConfig::use_groups);
   ok = cp.parse_command_line(argc, (const char **)argv);
   assert(ok);
 
+  // processor groups can only be made of local processors
+  assert(!(TestConfig::use_groups && TestConfig::remote_tasks));
+
   r.register_task(TOP_LEVEL_TASK, top_level_task);
   r.register_task(TASK_LAUNCHER, task_launcher);
   r.register_task(DUMMY_TASK, dummy_task);
@@ -8,6 +8,8 @@
 #include <time.h>
 
 #include "realm/realm.h"
+#include "realm/timers.h"
+#include "realm/barrier_tree.h"
 
 using namespace Realm;
 
@@ -47,6 +49,17 @@ static const int BARRIER_INITIAL_VALUE = 42;
 
 static int errors = 0;
 
+// the number of arriving tasks defaults to one per CPU (across all nodes) -
+//  using more than that stands in for more nodes than we actually have
+static int num_children = 0;
+// non-zero selects tree-based combining of arrivals with the given fan-in
+static unsigned arrival_radix = 0;
+// how long each child waits before arriving (except in the first iteration)
+static int sleep_useconds = 1000000;
+// non-zero runs the tree combine/broadcast logic for this many simulated
+//  nodes before the real barrier test (a multi-node launch isn't needed)
+static unsigned sim_nodes = 0;
+
 // we're going to use alarm() as a watchdog to detect deadlocks
 void sigalrm_handler(int sig)
 {
@@ -64,7 +77,7 @@ void child_task(const void *args, size_t arglen,
   Barrier b = child_args.b;  // so we can advance it
   for(size_t i = 0; i < child_args.num_iters; i++) {
     // make one task slower than all the others
-    if(i != 0) sleep(1);
+    if((i != 0) && (sleep_useconds > 0)) usleep(sleep_useconds);
 
     int reduce_val = (i+1)*(child_args.index+1);
     b.arrive(1, Event::NO_EVENT, &reduce_val, sizeof(reduce_val));
@@ -122,9 +135,237 @@ void check_task(const void *args, size_t arglen,
   }
 }
 
+// a message between simulated nodes - arrivals go up the tree, acks come back
+//  down one level, and triggers are broadcast from the root to all nodes
+struct SimMessage {
+  enum Kind { LOCAL_ARRIVAL, COMBINE, ACK, TRIGGER };
+  Kind kind;
+  unsigned src, dst;
+  unsigned gen, previous_gen;  // previous_gen only for triggers
+  int delta;
+  std::vector<int> values;     // one for arrivals, one per generation for triggers
+};
+
+struct SimNode {
+  Realm::BarrierArrivalCombiner<unsigned> combiner;
+  // results as stored by the trigger path
+  char *final_values;
+  unsigned value_capacity;
+  std::vector<int> triggers_seen;  // per generation
+};
+
+// drives the same topology, combining and result-storing code as a real
+//  tree-mode barrier through 'num_nodes' simulated nodes, delivering messages
+//  in a random order, and checks that the root sees every arrival exactly once
+//  with the right reduction value and that every node gets every result
+static int simulate_tree_barrier(unsigned num_nodes, unsigned radix,
+				 unsigned num_gens, unsigned arrivals_per_node,
+				 const ReductionOpUntyped *redop)
+{
+  int sim_errors = 0;
+  // use a root other than node 0 so the relative numbering wraps around
+  unsigned root = num_nodes / 2;
+  unsigned first_gen = 0;
+  int expected_delta = num_nodes * arrivals_per_node;
+
+  std::vector<SimNode> nodes(num_nodes);
+  for(unsigned i = 0; i < num_nodes; i++) {
+    nodes[i].final_values = 0;
+    nodes[i].value_capacity = 0;
+    nodes[i].triggers_seen.assign(num_gens + 1, 0);
+  }
+
+  // root state: arrivals and folded values per generation
+  std::vector<int> root_delta(num_gens + 1, 0);
+  std::vector<int> root_value(num_gens + 1, BARRIER_INITIAL_VALUE);
+  unsigned root_generation = first_gen;
+
+  std::vector<SimMessage> in_flight;
+  for(unsigned g = 1; g <= num_gens; g++)
+    for(unsigned n = 0; n < num_nodes; n++)
+      for(unsigned k = 0; k < arrivals_per_node; k++) {
+	SimMessage m;
+	m.kind = SimMessage::LOCAL_ARRIVAL;
+	m.src = m.dst = n;
+	m.gen = g;
+	m.previous_gen = 0;
+	m.delta = 1;
+	m.values.push_back(g * (n + 1) * (k + 1));
+	in_flight.push_back(m);
+      }
+  size_t local_arrivals = in_flight.size();
+  size_t combine_messages = 0;
+
+  srand48(num_nodes * 1000 + radix);
+  while(!in_flight.empty()) {
+    // pick a random message to deliver next
+    size_t idx = lrand48() % in_flight.size();
+    SimMessage m = in_flight[idx];
+    in_flight[idx] = in_flight.back();
+    in_flight.pop_back();
+
+    switch(m.kind) {
+    case SimMessage::LOCAL_ARRIVAL:
+    case SimMessage::COMBINE:
+      {
+	if(m.kind == SimMessage::COMBINE) {
+	  // our parent (us) is now responsible for this arrival
+	  SimMessage ack;
+	  ack.kind = SimMessage::ACK;
+	  ack.src = m.dst;
+	  ack.dst = m.src;
+	  ack.gen = ack.previous_gen = 0;
+	  ack.delta = 0;
+	  in_flight.push_back(ack);
+	}
+
+	if(m.dst == root) {
+	  root_delta[m.gen] += m.delta;
+	  redop->fold(&root_value[m.gen], &m.values[0], 1, true /*exclusive*/);
+	  if(root_delta[m.gen] > expected_delta) {
+	    printf("sim: gen %d saw %d arrivals (expected %d)\n",
+		   m.gen, root_delta[m.gen], expected_delta);
+	    sim_errors++;
+	  }
+	  // trigger (and broadcast) every contiguous completed generation
+	  unsigned trigger_gen = root_generation;
+	  while((trigger_gen < num_gens) &&
+		(root_delta[trigger_gen + 1] == expected_delta))
+	    trigger_gen++;
+	  if(trigger_gen > root_generation) {
+	    std::vector<unsigned> children;
+	    Realm::BarrierTree::children(root, root, radix, num_nodes, children);
+	    for(size_t i = 0; i < children.size(); i++) {
+	      SimMessage t;
+	      t.kind = SimMessage::TRIGGER;
+	      t.src = root;
+	      t.dst = children[i];
+	      t.gen = trigger_gen;
+	      t.previous_gen = root_generation;
+	      t.delta = 0;
+	      t.values.assign(root_value.begin() + root_generation + 1,
+			      root_value.begin() + trigger_gen + 1);
+	      in_flight.push_back(t);
+	    }
+	    for(unsigned g = root_generation + 1; g <= trigger_gen; g++)
+	      nodes[root].triggers_seen[g]++;
+	    root_generation = trigger_gen;
+	  }
+	} else {
+	  bool send_now = nodes[m.dst].combiner.add_arrival(m.gen, m.delta, REDOP_ADD, redop,
+							    &m.values[0], sizeof(int));
+	  if(send_now) {
+	    SimMessage c = m;
+	    c.kind = SimMessage::COMBINE;
+	    c.src = m.dst;
+	    c.dst = Realm::BarrierTree::parent(m.dst, root, radix, num_nodes);
+	    in_flight.push_back(c);
+	    combine_messages++;
+	  }
+	}
+	break;
+      }
+
+    case SimMessage::ACK:
+      {
+	Realm::BarrierArrivalCombiner<unsigned>::PendingMap to_send;
+	nodes[m.dst].combiner.acknowledged(to_send);
+	for(Realm::BarrierArrivalCombiner<unsigned>::PendingMap::iterator it = to_send.begin();
+	    it != to_send.end();
+	    it++) {
+	  assert(it->second.value_size == sizeof(int));
+	  SimMessage c;
+	  c.kind = SimMessage::COMBINE;
+	  c.src = m.dst;
+	  c.dst = Realm::BarrierTree::parent(m.dst, root, radix, num_nodes);
+	  c.gen = it->first;
+	  c.previous_gen = 0;
+	  c.delta = it->second.delta;
+	  c.values.push_back(*(const int *)(it->second.value));
+	  in_flight.push_back(c);
+	  combine_messages++;
+	  free(it->second.value);
+	}
+	break;
+      }
+
+    case SimMessage::TRIGGER:
+      {
+	SimNode& n = nodes[m.dst];
+	for(unsigned g = m.previous_gen + 1; g <= m.gen; g++)
+	  n.triggers_seen[g]++;
+	Realm::BarrierTree::store_values(n.final_values, n.value_capacity,
+					 first_gen, m.previous_gen, m.gen,
+					 &m.values[0], sizeof(int));
+	// relay the same range to our children
+	std::vector<unsigned> children;
+	Realm::BarrierTree::children(m.dst, root, radix, num_nodes, children);
+	for(size_t i = 0; i < children.size(); i++) {
+	  SimMessage t = m;
+	  t.src = m.dst;
+	  t.dst = children[i];
+	  in_flight.push_back(t);
+	}
+	break;
+      }
+    }
+  }
+
+  // check results
+  for(unsigned g = 1; g <= num_gens; g++) {
+    int exp_value = BARRIER_INITIAL_VALUE;
+    for(unsigned n = 0; n < num_nodes; n++)
+      for(unsigned k = 0; k < arrivals_per_node; k++)
+	exp_value += g * (n + 1) * (k + 1);
+
+    if(root_delta[g] != expected_delta) {
+      printf("sim: gen %d root saw %d arrivals (expected %d)\n",
+	     g, root_delta[g], expected_delta);
+      sim_errors++;
+    }
+    if(root_value[g] != exp_value) {
+      printf("sim: gen %d root value = %d (expected %d)\n",
+	     g, root_value[g], exp_value);
+      sim_errors++;
+    }
+    for(unsigned n = 0; n < num_nodes; n++) {
+      if(nodes[n].triggers_seen[g] != 1) {
+	printf("sim: gen %d node %d saw %d triggers (expected 1)\n",
+	       g, n, nodes[n].triggers_seen[g]);
+	sim_errors++;
+	continue;
+      }
+      if(n == root) continue;
+      int result = ((int *)(nodes[n].final_values))[g - first_gen - 1];
+      if(result != exp_value) {
+	printf("sim: gen %d node %d result = %d (expected %d)\n",
+	       g, n, result, exp_value);
+	sim_errors++;
+      }
+    }
+  }
+
+  for(unsigned n = 0; n < num_nodes; n++)
+    free(nodes[n].final_values);
+
+  printf("sim: %d nodes, radix %d: %zd arrivals in %zd combined messages, %d errors\n",
+	 num_nodes, radix, local_arrivals, combine_messages, sim_errors);
+  return sim_errors;
+}
+
 void top_level_task(const void *args, size_t arglen, 
 		    const void *userdata, size_t userlen, Processor p)
 {
+  if(sim_nodes > 0) {
+    ReductionOpUntyped *redop = ReductionOpUntyped::create_reduction_op<ReductionOpIntAdd>();
+    // radix 1 is a chain, which has the most combining in flight
+    errors += simulate_tree_barrier(sim_nodes, 1, 8, 3, redop);
+    errors += simulate_tree_barrier(sim_nodes, ((arrival_radix > 0) ? arrival_radix : 2),
+				    8, 3, redop);
+    errors += simulate_tree_barrier(sim_nodes, sim_nodes, 8, 3, redop);
+    delete redop;
+  }
+
   printf("top level task - getting machine and list of CPUs\n");
 
   Machine machine = Machine::get_machine();
@@ -139,47 +380,53 @@ void top_level_task(const void *args, size_t arglen,
 	all_cpus.push_back(*it);
   }
 
-  printf("top level task - creating barrier\n");
+  size_t num_tasks = ((num_children > 0) ? num_children : all_cpus.size());
 
-  Barrier b = Barrier::create_barrier(all_cpus.size(), REDOP_ADD,
-				      &BARRIER_INITIAL_VALUE, sizeof(BARRIER_INITIAL_VALUE));
+  printf("top level task - creating barrier (%zd arrivals, radix=%d)\n",
+	 num_tasks, arrival_radix);
+
+  Barrier b = Barrier::create_barrier(num_tasks, REDOP_ADD,
+				      &BARRIER_INITIAL_VALUE, sizeof(BARRIER_INITIAL_VALUE),
+				      arrival_radix);
 
   std::set<Event> task_events;
 
   // set an alarm so that we turn hangs into error messages
-  alarm(10);
+  alarm(10 + (num_tasks * sleep_useconds) / 1000000);
 
   // spawn the check tasks before the arriving tasks
   {
     Barrier check_barrier = b;
-    for(size_t i = 0; i < all_cpus.size(); i++) {
+    for(size_t i = 0; i < num_tasks; i++) {
       ChildTaskArgs args;
-      args.num_iters = all_cpus.size();
+      args.num_iters = num_tasks;
       args.index = i;
       args.b = check_barrier;
 
-      Event e = all_cpus[i].spawn(CHECK_TASK, &args, sizeof(args),
-				  ProfilingRequestSet(),
-				  check_barrier);
+      Event e = all_cpus[i % all_cpus.size()].spawn(CHECK_TASK, &args, sizeof(args),
+						    ProfilingRequestSet(),
+						    check_barrier);
       task_events.insert(e);
 
       check_barrier = check_barrier.advance_barrier();
     }
   }
 
-  for(size_t i = 0; i < all_cpus.size(); i++) {
+  double t_start = Clock::current_time();
+
+  for(size_t i = 0; i < num_tasks; i++) {
     ChildTaskArgs args;
-    args.num_iters = all_cpus.size();
+    args.num_iters = num_tasks;
     args.index = i;
     args.b = b;
 
-    Event e = all_cpus[i].spawn(CHILD_TASK, &args, sizeof(args));
+    Event e = all_cpus[i % all_cpus.size()].spawn(CHILD_TASK, &args, sizeof(args));
     task_events.insert(e);
   }
   printf("%zd tasks launched\n", task_events.size());;
 
   // now wait on each generation of the barrier and report the result
-  for(size_t i = 0; i < all_cpus.size(); i++) {
+  for(size_t i = 0; i < num_tasks; i++) {
     int result;
     bool ready = b.get_result(&result, sizeof(result));
     if(!ready) {
@@ -192,7 +439,7 @@ void top_level_task(const void *args, size_t arglen,
 	continue;
       }
     }
-    int exp_result = BARRIER_INITIAL_VALUE + (i+1)*all_cpus.size()*(all_cpus.size() + 1) / 2;
+    int exp_result = BARRIER_INITIAL_VALUE + (i+1)*num_tasks*(num_tasks + 1) / 2;
     if(result == exp_result)
       printf("parent: iter %zd = %d (%d) OK\n", i, result, ready);
     else {
@@ -203,6 +450,11 @@ void top_level_task(const void *args, size_t arglen,
     b = b.advance_barrier();
   }
 
+  double t_end = Clock::current_time();
+  printf("%zd generations of %zd arrivals in %.3f ms (%.1f us/generation)\n",
+	 num_tasks, num_tasks, 1e3 * (t_end - t_start),
+	 1e6 * (t_end - t_start) / num_tasks);
+
   // wait on all child tasks to finish before destroying barrier
   Event merged = Event::merge_events(task_events);
   printf("merged event ID is " IDFMT " - waiting on it...\n",
@@ -227,6 +479,28 @@ int main(int argc, char **argv)
 
   rt.init(&argc, &argv);
 
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-c")) {
+      num_children = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-radix")) {
+      arrival_radix = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-s")) {
+      sleep_useconds = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-simnodes")) {
+      sim_nodes = atoi(argv[++i]);
+      continue;
+    }
+  }
+
   rt.register_task(TOP_LEVEL_TASK, top_level_task);
   rt.register_task(CHILD_TASK, child_task);
   rt.register_task(CHECK_TASK, check_task);
@@ -0,0 +1,173 @@
+#include "realm/realm.h"
+#include "realm/timers.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+#include <csignal>
+
+#include <vector>
+#include <set>
+
+#include <unistd.h>
+
+using namespace Realm;
+
+// Task IDs, some IDs are reserved so start at first available number
+enum {
+  TOP_LEVEL_TASK = Processor::TASK_ID_FIRST_AVAILABLE+0,
+};
+
+// we're going to use alarm() as a watchdog to detect deadlocks
+void sigalrm_handler(int sig)
+{
+  fprintf(stderr, "HELP!  Alarm triggered - likely deadlock!\n");
+  exit(1);
+}
+
+static int chain_length = 1000;
+static int num_repetitions = 100;
+static int merge_width = 64;
+static int timeout_seconds = 60;
+
+// a chain of user events, each one triggered when the one before it does
+static double deferred_trigger_chain(void)
+{
+  std::vector<UserEvent> events(chain_length);
+  for(int i = 0; i < chain_length; i++)
+    events[i] = UserEvent::create_user_event();
+
+  double t_start = Clock::current_time();
+  for(int i = 1; i < chain_length; i++)
+    events[i].trigger(events[i - 1]);
+  events[0].trigger();
+  events[chain_length - 1].wait();
+  double t_end = Clock::current_time();
+
+  return t_end - t_start;
+}
+
+// the same, but each step is a fault-ignoring copy of the previous event
+static double ignorefaults_chain(void)
+{
+  UserEvent head = UserEvent::create_user_event();
+
+  double t_start = Clock::current_time();
+  Event e = head;
+  for(int i = 1; i < chain_length; i++)
+    e = Event::ignorefaults(e);
+  head.trigger();
+  e.wait();
+  double t_end = Clock::current_time();
+
+  return t_end - t_start;
+}
+
+// a merge of many user events, triggered one at a time
+static double merge_fan_in(void)
+{
+  std::vector<UserEvent> inputs(merge_width);
+  std::set<Event> wait_for;
+  for(int i = 0; i < merge_width; i++) {
+    inputs[i] = UserEvent::create_user_event();
+    wait_for.insert(inputs[i]);
+  }
+
+  double t_start = Clock::current_time();
+  Event merged = Event::merge_events(wait_for);
+  for(int i = 0; i < merge_width; i++)
+    inputs[i].trigger();
+  merged.wait();
+  double t_end = Clock::current_time();
+
+  return t_end - t_start;
+}
+
+void top_level_task(const void *args, size_t arglen,
+		    const void *userdata, size_t userlen, Processor p)
+{
+  printf("Realm event latency test - chain=%d merge=%d reps=%d\n",
+	 chain_length, merge_width, num_repetitions);
+
+  // set the watchdog timeout before we do anything that could get stuck
+  alarm(timeout_seconds);
+
+  double chain_time = 0, ignore_time = 0, merge_time = 0;
+  for(int r = 0; r < num_repetitions; r++) {
+    chain_time += deferred_trigger_chain();
+    ignore_time += ignorefaults_chain();
+    merge_time += merge_fan_in();
+  }
+
+  // turn off the watchdog timer
+  alarm(0);
+
+  printf("deferred trigger chain: time/hop=%6.0fns\n",
+	 1e9 * chain_time / num_repetitions / chain_length);
+  printf("ignorefaults chain:     time/hop=%6.0fns\n",
+	 1e9 * ignore_time / num_repetitions / chain_length);
+  printf("merge fan-in:           time/input=%6.0fns\n",
+	 1e9 * merge_time / num_repetitions / merge_width);
+
+  printf("all done!\n");
+}
+
+int main(int argc, char **argv)
+{
+  Runtime rt;
+
+  rt.init(&argc, &argv);
+
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-l")) {
+      chain_length = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-m")) {
+      merge_width = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-r")) {
+      num_repetitions = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-t")) {
+      timeout_seconds = atoi(argv[++i]);
+      continue;
+    }
+  }
+
+  rt.register_task(TOP_LEVEL_TASK, top_level_task);
+
+  signal(SIGALRM, sigalrm_handler);
+
+  // select a processor to run the top level task on
+  Processor p = Processor::NO_PROC;
+  {
+    std::set<Processor> all_procs;
+    Machine::get_machine().get_all_processors(all_procs);
+    for(std::set<Processor>::const_iterator it = all_procs.begin();
+	it != all_procs.end();
+	it++)
+      if(it->kind() == Processor::LOC_PROC) {
+	p = *it;
+	break;
+      }
+  }
+  assert(p.exists());
+
+  // collective launch of a single task - everybody gets the same finish event
+  Event e = rt.collective_spawn(p, TOP_LEVEL_TASK, 0, 0);
+
+  // request shutdown once that task is complete
+  rt.shutdown(e);
+
+  // now sleep this thread until that shutdown actually happens
+  rt.wait_for_shutdown();
+
+  return 0;
+}
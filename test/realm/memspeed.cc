@@ -33,6 +33,7 @@ struct SpeedTestArgs {
 };
 
 static size_t buffer_size = 64 << 20; // should be bigger than any cache in system
+static int copy_reps = 4; // number of copies per memory pair (0 = skip copy tests)
 
 void memspeed_cpu_task(const void *args, size_t arglen, 
 		       const void *userdata, size_t userlen, Processor p)
@@ -186,6 +187,72 @@ void memspeed_gpu_task(const void *args, size_t arglen,
 
 std::set<Processor::Kind> supported_proc_kinds;
 
+static bool is_cpu_memory(Memory m)
+{
+  switch(m.kind()) {
+  case Memory::SYSTEM_MEM:
+  case Memory::REGDMA_MEM:
+  case Memory::SOCKET_MEM:
+  case Memory::Z_COPY_MEM:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// measures the bandwidth of DMA copies between each pair of CPU-visible
+//  memories (use -ll:memcpy_threads to compare against the parallel copy engine)
+void copy_speed_test(Domain d, size_t elements)
+{
+  std::vector<Memory> mems;
+  Machine machine = Machine::get_machine();
+  for(Machine::MemoryQuery::iterator it = Machine::MemoryQuery(machine).begin(); it; ++it)
+    if(is_cpu_memory(*it))
+      mems.push_back(*it);
+
+  std::vector<size_t> field_sizes(1, sizeof(void *));
+  for(size_t i = 0; i < mems.size(); i++)
+    for(size_t j = 0; j < mems.size(); j++) {
+      Memory src_mem = mems[i];
+      Memory dst_mem = mems[j];
+      // copies within a memory need room for two buffers
+      size_t needed = ((i == j) ? 2 : 1) * buffer_size;
+      if((src_mem.capacity() < needed) || (dst_mem.capacity() < needed)) {
+	log_app.info() << "skipping copy " << src_mem << " -> " << dst_mem << " - insufficient capacity";
+	continue;
+      }
+
+      RegionInstance src_inst = d.create_instance(src_mem, field_sizes, elements);
+      RegionInstance dst_inst = d.create_instance(dst_mem, field_sizes, elements);
+      assert(src_inst.exists() && dst_inst.exists());
+
+      std::vector<Domain::CopySrcDstField> srcs(1), dsts(1);
+      srcs[0].inst = src_inst;
+      srcs[0].offset = 0;
+      srcs[0].size = sizeof(void *);
+      dsts[0].inst = dst_inst;
+      dsts[0].offset = 0;
+      dsts[0].size = sizeof(void *);
+
+      // fault both instances in before we start timing
+      void *fill_value = 0;
+      d.fill(srcs, &fill_value, sizeof(fill_value)).wait();
+      d.fill(dsts, &fill_value, sizeof(fill_value)).wait();
+
+      long long t1 = Clock::current_time_in_nanoseconds();
+      for(int r = 0; r < copy_reps; r++)
+	d.copy(srcs, dsts).wait();
+      long long t2 = Clock::current_time_in_nanoseconds();
+      double copy_bw = 1.0 * copy_reps * elements * sizeof(void *) / (t2 - t1);
+
+      log_app.print() << "Copy: " << src_mem << " (kind=" << src_mem.kind() << ") -> "
+		      << dst_mem << " (kind=" << dst_mem.kind() << ") BW: " << copy_bw << " GB/s";
+
+      src_inst.destroy();
+      dst_inst.destroy();
+    }
+}
+
 void top_level_task(const void *args, size_t arglen, 
 		    const void *userdata, size_t userlen, Processor p)
 {
@@ -250,6 +317,9 @@ void top_level_task(const void *args, size_t arglen,
 
     inst.destroy();
   }
+
+  if(copy_reps > 0)
+    copy_speed_test(d, elements);
 }
 
 int main(int argc, char **argv)
@@ -264,6 +334,11 @@ int main(int argc, char **argv)
       continue;
     }
 
+    if(!strcmp(argv[i], "-c")) {
+      copy_reps = strtol(argv[++i], 0, 10);
+      continue;
+    }
+
   }
 
   rt.register_task(TOP_LEVEL_TASK, top_level_task);
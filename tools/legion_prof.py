@@ -1293,6 +1293,41 @@ class Instance(Base, TimeRange, HasInitiationDependencies):
                 .format(str(hex(self.inst_id)),
                         size_pretty))
 
+# Must match VirtualChannelKind in legion_types.h
+virtual_channel_names = (
+    'Default', 'Index Space', 'Field Space', 'Logical Tree', 'Mapper',
+    'Semantic Info', 'Layout Constraint', 'Context', 'Manager', 'View',
+    'Update', 'Variant', 'Version', 'Version Manager', 'Analysis', 'Future')
+
+class VirtualChannelStats(object):
+    def __init__(self, channel):
+        self.channel = channel
+        self.messages = 0
+        self.total_bytes = 0
+        self.first_start = None
+        self.last_stop = None
+
+    def add_message(self, size, start, stop):
+        self.messages += 1
+        self.total_bytes += size
+        if self.first_start is None or start < self.first_start:
+            self.first_start = start
+        if self.last_stop is None or stop > self.last_stop:
+            self.last_stop = stop
+
+    def name(self):
+        if self.channel < len(virtual_channel_names):
+            return virtual_channel_names[self.channel]
+        return 'Channel %d' % self.channel
+
+    def print_stats(self, verbose):
+        # times are in microseconds
+        elapsed = self.last_stop - self.first_start
+        rate = (self.messages * 1e6 / elapsed) if elapsed > 0 else 0.0
+        print('%-20s %10d messages %12.1f messages/s %10.1f bytes/message' %
+              (self.name(), self.messages, rate,
+               float(self.total_bytes) / self.messages))
+
 class MessageKind(StatObject):
     def __init__(self, message_id, name):
         StatObject.__init__(self)
@@ -1607,6 +1642,7 @@ class State(object):
         self.last_time = 0L
         self.message_kinds = {}
         self.messages = {}
+        self.virtual_channel_stats = {}
         self.mapper_call_kinds = {}
         self.mapper_calls = {}
         self.runtime_call_kinds = {}
@@ -1733,11 +1769,14 @@ class State(object):
     def log_kind(self, task_id, name, overwrite):
         if task_id not in self.task_kinds:
             self.task_kinds[task_id] = TaskKind(task_id, name)
-        elif overwrite == 1:
+        elif overwrite == 1 or self.task_kinds[task_id].name is None:
             self.task_kinds[task_id].name = name
 
     def log_variant(self, task_id, variant_id, name):
-        assert task_id in self.task_kinds
+        # streaming profiles are written in chunks, so a variant can
+        # show up before the kind it belongs to
+        if task_id not in self.task_kinds:
+            self.task_kinds[task_id] = TaskKind(task_id, None)
         task_kind = self.task_kinds[task_id]
         if variant_id not in self.variants:
             self.variants[variant_id] = Variant(variant_id, name)
@@ -1796,11 +1835,14 @@ class State(object):
         if kind not in self.message_kinds:
             self.message_kinds[kind] = MessageKind(kind, name) 
 
-    def log_message_info(self, kind, proc_id, start, stop):
+    def log_message_info(self, kind, proc_id, start, stop, channel, size):
         assert start <= stop
         assert kind in self.message_kinds
         if stop > self.last_time:
             self.last_time = stop
+        if channel not in self.virtual_channel_stats:
+            self.virtual_channel_stats[channel] = VirtualChannelStats(channel)
+        self.virtual_channel_stats[channel].add_message(size, start, stop)
         message = Message(self.message_kinds[kind], start, stop)
         proc = self.find_processor(proc_id)
         proc.add_message(message)
@@ -1976,6 +2018,14 @@ class State(object):
             channel.print_stats(verbose)
         print
 
+    def print_virtual_channel_stats(self, verbose):
+        print('****************************************************')
+        print('   VIRTUAL CHANNEL MESSAGE STATS')
+        print('****************************************************')
+        for channel in sorted(self.virtual_channel_stats.iterkeys()):
+            self.virtual_channel_stats[channel].print_stats(verbose)
+        print
+
     def print_task_stats(self, verbose):
         print('****************************************************')
         print('   TASK STATS')
@@ -1988,6 +2038,7 @@ class State(object):
         self.print_processor_stats(verbose)
         self.print_memory_stats(verbose)
         self.print_channel_stats(verbose)
+        self.print_virtual_channel_stats(verbose)
         self.print_task_stats(verbose)
 
     def assign_colors(self):
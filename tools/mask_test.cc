@@ -333,7 +333,8 @@ void print_mask(const char *name, BITMASK &rhs, const int max)
 template<typename BITMASK, int MAX>
 inline void initialize_random_mask(BITMASK &mask, BaseMask &base)
 {
-  const int num_set = lrand48() % MAX;
+  // Half the masks only get a few bits so sparse encodings get tested too
+  const int num_set = (lrand48() & 1) ? (lrand48() % 16) : (lrand48() % MAX);
   for (int i = 0; i < num_set; i++)
   {
     int bit = lrand48() % MAX;
@@ -730,11 +731,10 @@ void test_shift_right_assign(const int num_iterations, const char *name)
   printf("SUCCESS!\n");
 }
 
-template<typename BITMASK>
-void test_mask(const int num_iterations, const char *name)
+template<typename BITMASK, int MAX>
+void test_mask_operations(const int num_iterations, const char *name)
 {
   printf("Running tests for mask %s...\n", name);
-  const int MAX = BITMASK::ELEMENTS * BITMASK::ELEMENT_SIZE;
   test_equality<BITMASK,MAX>(num_iterations, name);
   test_negation<BITMASK,MAX>(num_iterations, name);
   test_or<BITMASK,MAX>(num_iterations, name);
@@ -753,6 +753,24 @@ void test_mask(const int num_iterations, const char *name)
   test_shift_right_assign<BITMASK,MAX>(num_iterations, name);
 }
 
+template<typename BITMASK>
+void test_mask(const int num_iterations, const char *name)
+{
+  const int MAX = BITMASK::ELEMENTS * BITMASK::ELEMENT_SIZE;
+  test_mask_operations<BITMASK,MAX>(num_iterations, name);
+}
+
+// The width of a DynamicBitMask comes from set_max_bits, not its type,
+// so one type covers every size we test
+typedef DynamicBitMask<512> DynamicMask;
+
+template<int MAX>
+void test_dynamic_mask(const int num_iterations, const char *name)
+{
+  DynamicMask::set_max_bits(MAX);
+  test_mask_operations<DynamicMask,MAX>(num_iterations, name);
+}
+
 template<int MAX, int SCALE, typename BITMASK>
 void initialize_perf_masks(BITMASK *masks, const int num_masks)
 {
@@ -789,7 +807,7 @@ inline unsigned long long current_time_in_nanoseconds(void)
   mach_port_deallocate(mach_task_self(), cclock);
 #else
   struct timespec ts;
-  clock_gettime(absolute ? CLOCK_REALTIME : CLOCK_MONOTONIC, &ts);
+  clock_gettime(CLOCK_MONOTONIC, &ts);
 #endif
   long long t = (1000000000LL * ts.tv_sec) + ts.tv_nsec;
   return t;
@@ -1131,6 +1149,8 @@ void test_operation_64(const int num_iterations)
     BitMask<uint64_t,MAX,6,0x3F> >(num_iterations, "BitMask");
   test_mask_operation<MAX,SCALE,OP,
     TLBitMask<uint64_t,MAX,6,0x3F> >(num_iterations, "TLBitMask");
+  DynamicMask::set_max_bits(MAX);
+  test_mask_operation<MAX,SCALE,OP,DynamicMask>(num_iterations,"DynamicBitMask");
 
   test_mask_operation<MAX,SCALE,OP,
     CompoundBitMask<BitMask<uint64_t,MAX,6,0x3F>,MAX,2> >(
@@ -1168,6 +1188,8 @@ void test_operation_128(const int num_iterations)
     BitMask<uint64_t,MAX,6,0x3F> >(num_iterations, "BitMask");
   test_mask_operation<MAX,SCALE,OP,
     TLBitMask<uint64_t,MAX,6,0x3F> >(num_iterations, "TLBitMask");
+  DynamicMask::set_max_bits(MAX);
+  test_mask_operation<MAX,SCALE,OP,DynamicMask>(num_iterations,"DynamicBitMask");
 #ifdef __SSE2__
   test_mask_operation<MAX,SCALE,OP,SSEBitMask<MAX> >(num_iterations, "SSEBitMask");
   test_mask_operation<MAX,SCALE,OP,SSETLBitMask<MAX> >(num_iterations, "SSETLBitMask");
@@ -1235,6 +1257,8 @@ void test_operation(const int num_iterations)
     BitMask<uint64_t,MAX,6,0x3F> >(num_iterations, "BitMask");
   test_mask_operation<MAX,SCALE,OP,
     TLBitMask<uint64_t,MAX,6,0x3F> >(num_iterations, "TLBitMask");
+  DynamicMask::set_max_bits(MAX);
+  test_mask_operation<MAX,SCALE,OP,DynamicMask>(num_iterations,"DynamicBitMask");
 #ifdef __SSE2__
   test_mask_operation<MAX,SCALE,OP,SSEBitMask<MAX> >(num_iterations, "SSEBitMask");
   test_mask_operation<MAX,SCALE,OP,SSETLBitMask<MAX> >(num_iterations, "SSETLBitMask");
@@ -1391,6 +1415,38 @@ void test_perf(const int num_iterations)
   test_operation<MAX,SCALE,SRA_OP>(num_iterations);
 }
 
+template<int MAX>
+void report_dynamic_size(void)
+{
+  DynamicMask::set_max_bits(MAX);
+  DynamicMask sparse, dense;
+  for (int i = 0; i < MAX; i += 2)
+    dense.set_bit(i);
+  assert(!sparse.is_dense() && dense.is_dense());
+  // Dense words are allocated in whole AVX vectors
+  const size_t words = (((MAX + 63) / 64) + 3) & ~3;
+  printf("  DynamicBitMask<%d>: %zd sparse, %zd dense\n", MAX,
+         sizeof(DynamicMask), sizeof(DynamicMask) + words * sizeof(uint64_t));
+}
+
+void report_mask_sizes(void)
+{
+  printf("\nMask Sizes (bytes, including any heap allocation)\n");
+  printf("  BitMask<512>: %zd\n", sizeof(BitMask<uint64_t,512,6,0x3F>));
+  printf("  TLBitMask<512>: %zd\n", sizeof(TLBitMask<uint64_t,512,6,0x3F>));
+#ifdef __SSE2__
+  printf("  SSEBitMask<512>: %zd\n", sizeof(SSEBitMask<512>));
+  printf("  SSETLBitMask<512>: %zd\n", sizeof(SSETLBitMask<512>));
+#endif
+#ifdef __AVX__
+  printf("  AVXBitMask<512>: %zd\n", sizeof(AVXBitMask<512>));
+  printf("  AVXTLBitMask<512>: %zd\n", sizeof(AVXTLBitMask<512>));
+#endif
+  report_dynamic_size<64>();
+  report_dynamic_size<512>();
+  report_dynamic_size<4096>();
+}
+
 int main(int argc, const char **argv)
 {
   int num_iterations = 1024;
@@ -1462,6 +1518,20 @@ int main(int argc, const char **argv)
   test_mask<AVXTLBitMask<2048> >(num_iterations,"AVXTLBitMask<2048>");
 #endif
 
+  printf("\nDynamicBitMask Tests\n");
+  test_dynamic_mask<64>(num_iterations,"DynamicBitMask<64>");
+  test_dynamic_mask<128>(num_iterations,"DynamicBitMask<128>");
+  test_dynamic_mask<192>(num_iterations,"DynamicBitMask<192>");
+  test_dynamic_mask<256>(num_iterations,"DynamicBitMask<256>");
+  test_dynamic_mask<384>(num_iterations,"DynamicBitMask<384>");
+  test_dynamic_mask<512>(num_iterations,"DynamicBitMask<512>");
+  test_dynamic_mask<768>(num_iterations,"DynamicBitMask<768>");
+  test_dynamic_mask<1024>(num_iterations,"DynamicBitMask<1024>");
+  test_dynamic_mask<1536>(num_iterations,"DynamicBitMask<1536>");
+  test_dynamic_mask<2048>(num_iterations,"DynamicBitMask<2048>");
+  test_dynamic_mask<4096>(num_iterations,"DynamicBitMask<4096>");
+  test_dynamic_mask<8192>(num_iterations,"DynamicBitMask<8192>");
+
   printf("\nCompoundBitMask Tests\n");
   test_mask<CompoundBitMask<BitMask<uint64_t,64,6,0x3F>,64,2> >(
                               num_iterations,"CompoundBitMask<64,2>");
@@ -1553,6 +1623,8 @@ int main(int argc, const char **argv)
   test_mask<CompoundBitMask<BitMask<uint64_t,1024,6,0x3F>,1024,8> >(
                               num_iterations,"CompoundBitMask<1024,8>");
 
+  report_mask_sizes();
+
 #if 0
   test_perf_64<8>(num_iterations);
   test_perf_64<4>(num_iterations);
@@ -1580,6 +1652,8 @@ int main(int argc, const char **argv)
   test_perf<512,2>(num_iterations);
 #endif
   test_perf<512,1>(num_iterations);
+  // Only 0-3 bits set, which is what most field masks look like
+  test_perf<512,128>(num_iterations);
 
 #if 0
   test_perf<1024,8>(num_iterations);
@@ -1594,6 +1668,7 @@ int main(int argc, const char **argv)
   test_perf<2048,2>(num_iterations);
 #endif
   test_perf<2048,1>(num_iterations);
+  test_perf<2048,512>(num_iterations);
 
   return 0;
 }
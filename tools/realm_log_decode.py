@@ -0,0 +1,164 @@
+#!/usr/bin/env python
+
+# Copyright 2017 Stanford University, NVIDIA Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Converts the binary logs written by Realm's -logbinary option back into
+#  the usual text format.  Every message in the output has the same
+#  "[node - thread] {level}{category}: " prefix as a text log.
+
+from __future__ import print_function
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = b'RLOGBIN1'
+
+REC_TEXT = 1
+REC_STRING = 2
+REC_MESSAGE = 3
+REC_DROPPED = 4
+
+LEVEL_WARNING = 4
+
+# a printf conversion: flags, width, precision, length modifier, conversion
+conversion_pat = re.compile(r"%([-+ #0']*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|q|z|t|j)?([diouxXeEfFgGaAcsp%])")
+
+def format_message(fmt, args):
+    args = list(args)
+    out = []
+    pos = 0
+    for m in conversion_pat.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, lmod, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        flags = flags.replace("'", '')
+        if width == '*':
+            width = str(args.pop(0))
+        if prec == '*':
+            prec = str(args.pop(0))
+        spec = '%' + flags + (width or '') + ('.' + prec if prec is not None else '')
+        value = args.pop(0)
+        if conv == 'p':
+            out.append((spec + 's') % ('0x%x' % value if value else '(nil)'))
+        elif conv in 'aA':
+            text = float.hex(value)
+            out.append((spec + 's') % (text.upper() if conv == 'A' else text))
+        elif conv in 'ouxX' and value < 0:
+            out.append((spec + conv) % (value & 0xffffffffffffffff))
+        elif conv == 'c':
+            out.append((spec + 'c') % chr(value & 0xff))
+        elif conv == 'F':
+            out.append((spec + 'f') % value)
+        elif conv == 'u':
+            out.append((spec + 'd') % value)
+        else:
+            out.append((spec + conv) % value)
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+def decode_args(payload, pos):
+    args = []
+    while pos < len(payload):
+        tag = payload[pos:pos+1]
+        pos += 1
+        if tag == b'i':
+            args.append(struct.unpack_from('=q', payload, pos)[0])
+            pos += 8
+        elif tag == b'u':
+            args.append(struct.unpack_from('=Q', payload, pos)[0])
+            pos += 8
+        elif tag == b'f':
+            args.append(struct.unpack_from('=d', payload, pos)[0])
+            pos += 8
+        elif tag == b's':
+            slen = struct.unpack_from('=I', payload, pos)[0]
+            pos += 4
+            args.append(payload[pos:pos+slen].decode('utf-8', 'replace'))
+            pos += slen
+        elif tag == b'p':
+            args.append(struct.unpack_from('=Q', payload, pos)[0])
+            pos += 8
+        else:
+            raise ValueError('unknown argument tag %r' % tag)
+    return args
+
+def decode(infile, outfile):
+    data = infile.read()
+    pos = 0
+    node = 0
+    strings = {}
+    dropped = 0
+    while pos < len(data):
+        # logs from several ranks can be appended to the same file
+        if data[pos:pos+len(MAGIC)] == MAGIC:
+            node = struct.unpack_from('=I', data, pos + len(MAGIC))[0]
+            pos += len(MAGIC) + 8
+            continue
+        rtype, rlen = struct.unpack_from('=BI', data, pos)
+        pos += 5
+        payload = data[pos:pos+rlen]
+        pos += rlen
+        if len(payload) < rlen:
+            print('WARNING: log is truncated', file=sys.stderr)
+            break
+        if rtype == REC_TEXT:
+            outfile.write(payload.decode('utf-8', 'replace'))
+        elif rtype == REC_STRING:
+            sid = struct.unpack_from('=Q', payload, 0)[0]
+            strings[sid] = payload[8:].decode('utf-8', 'replace')
+        elif rtype == REC_MESSAGE:
+            thread, name_id, fmt_id, level = struct.unpack_from('=QQQB', payload, 0)
+            fmt = strings[fmt_id]
+            args = decode_args(payload, 25)
+            try:
+                msg = format_message(fmt, args)
+            except (TypeError, ValueError, IndexError):
+                msg = '%s %r' % (fmt, args)
+            outfile.write('[%d - %x] {%d}{%s}: %s\n' %
+                          (node, thread, level, strings[name_id], msg))
+        elif rtype == REC_DROPPED:
+            thread, count = struct.unpack_from('=QQ', payload, 0)
+            dropped += count
+            outfile.write('[%d - %x] {%d}{logging}: %d messages dropped\n' %
+                          (node, thread, LEVEL_WARNING, count))
+        else:
+            raise ValueError('unknown record type %d at offset %d' % (rtype, pos - rlen - 5))
+    return dropped
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode binary Realm logs.')
+    parser.add_argument('logs', nargs='+', help='binary log files')
+    parser.add_argument('-o', '--output', help='output file (default: stdout)')
+    args = parser.parse_args()
+
+    outfile = open(args.output, 'w') if args.output else sys.stdout
+    total_dropped = 0
+    for filename in args.logs:
+        with open(filename, 'rb') as f:
+            if f.read(len(MAGIC)) != MAGIC:
+                print('%s is not a binary Realm log' % filename, file=sys.stderr)
+                sys.exit(1)
+            f.seek(0)
+            total_dropped += decode(f, outfile)
+    if total_dropped > 0:
+        print('WARNING: %d messages were dropped' % total_dropped, file=sys.stderr)
+
+if __name__ == '__main__':
+    main()